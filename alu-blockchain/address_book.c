@@ -0,0 +1,162 @@
+/* address_book.c */
+#include "alu_blockchain.h"
+#include "address_book.h"
+
+/*
+ * Dense account IDs for wallet addresses. IDs are assigned in the order
+ * addresses first appear in the transaction log, which also records each
+ * assignment, so the table is rebuilt by replaying the log. Writers are
+ * serialised by the log; lookups are a single hash probe sequence.
+ */
+static char (*addresses)[HASH_LENGTH + 1] = NULL;
+static uint32_t count = 0;
+static uint32_t capacity = 0;
+
+/* Open-addressing index: slot holds id + 1, 0 marks an empty slot */
+static uint32_t *slots = NULL;
+static uint32_t slot_count = 0;
+
+/**
+ * hash_address - FNV-1a hash of an address string
+ * @address: Address to hash
+ * Return: 32-bit hash
+ */
+static uint32_t hash_address(const char *address)
+{
+        uint32_t hash = 2166136261u;
+
+        while (*address)
+        {
+                hash ^= (unsigned char)*address++;
+                hash *= 16777619u;
+        }
+        return hash;
+}
+
+/**
+ * find_slot - Find the slot holding @address or the empty slot for it
+ * @address: Address to find
+ * Return: Slot index (slot_count must be non-zero)
+ */
+static uint32_t find_slot(const char *address)
+{
+        uint32_t mask = slot_count - 1;
+        uint32_t i = hash_address(address) & mask;
+
+        while (slots[i] && strcmp(addresses[slots[i] - 1], address) != 0)
+                i = (i + 1) & mask;
+        return i;
+}
+
+/**
+ * grow_index - Double the hash index and reinsert every address
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int grow_index(void)
+{
+        uint32_t *old_slots = slots;
+        uint32_t new_count = slot_count ? slot_count * 2 : 256;
+        uint32_t id;
+
+        slots = calloc(new_count, sizeof(uint32_t));
+        if (!slots)
+        {
+                slots = old_slots;
+                return 0;
+        }
+
+        slot_count = new_count;
+        for (id = 0; id < count; id++)
+                slots[find_slot(addresses[id])] = id + 1;
+
+        free(old_slots);
+        return 1;
+}
+
+/**
+ * address_lookup - Find the account ID of an address
+ * @address: Wallet address
+ * Return: Account ID, or ADDRESS_ID_NONE if the address was never interned
+ */
+uint32_t address_lookup(const char *address)
+{
+        uint32_t slot;
+
+        if (!address || !slot_count)
+                return ADDRESS_ID_NONE;
+
+        slot = slots[find_slot(address)];
+        return slot ? slot - 1 : ADDRESS_ID_NONE;
+}
+
+/**
+ * address_of - Find the address for an account ID
+ * @id: Account ID
+ * Return: Address string, or NULL if @id is unknown
+ */
+const char *address_of(uint32_t id)
+{
+        if (id >= count)
+                return NULL;
+        return addresses[id];
+}
+
+/**
+ * address_book_define - Assign the next account ID to an address
+ * @address: Wallet address not yet in the book
+ *
+ * Only the transaction log calls this, either while replaying or right
+ * after it has logged the assignment; use wal_intern_address() elsewhere.
+ *
+ * Return: New account ID, or ADDRESS_ID_NONE on failure
+ */
+uint32_t address_book_define(const char *address)
+{
+        char (*grown)[HASH_LENGTH + 1];
+        uint32_t new_capacity;
+
+        if (!address || !*address)
+                return ADDRESS_ID_NONE;
+
+        if (count == capacity)
+        {
+                new_capacity = capacity ? capacity * 2 : 128;
+                grown = realloc(addresses, new_capacity * sizeof(*addresses));
+                if (!grown)
+                        return ADDRESS_ID_NONE;
+                addresses = grown;
+                capacity = new_capacity;
+        }
+
+        /* Keep the index at most 70% full */
+        if ((count + 1) * 10 > slot_count * 7 && !grow_index())
+                return ADDRESS_ID_NONE;
+
+        strncpy(addresses[count], address, HASH_LENGTH);
+        addresses[count][HASH_LENGTH] = '\0';
+        slots[find_slot(addresses[count])] = count + 1;
+        return count++;
+}
+
+/**
+ * address_count - Number of interned addresses
+ * Return: One more than the highest account ID
+ */
+uint32_t address_count(void)
+{
+        return count;
+}
+
+/**
+ * address_book_clear - Forget every address (before a log replay)
+ */
+void address_book_clear(void)
+{
+        free(addresses);
+        free(slots);
+        addresses = NULL;
+        slots = NULL;
+        count = 0;
+        capacity = 0;
+        slot_count = 0;
+}
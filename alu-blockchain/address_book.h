@@ -0,0 +1,16 @@
+/* address_book.h */
+#ifndef ADDRESS_BOOK_H
+#define ADDRESS_BOOK_H
+
+#include "alu_blockchain.h"
+#include <stdint.h>
+
+#define ADDRESS_ID_NONE 0xffffffffu
+
+uint32_t address_lookup(const char *address);
+const char *address_of(uint32_t id);
+uint32_t address_book_define(const char *address);
+uint32_t address_count(void);
+void address_book_clear(void);
+
+#endif /* ADDRESS_BOOK_H */
@@ -1,9 +1,89 @@
 /* alu_blockchain.c */
 #include "alu_blockchain.h"
 #include "config.h"
+#include "wal.h"
+#include "txlog.h"
+#include "legacy.h"
+#include "txcolumns.h"
+#include "snapshot.h"
 
 int tx_count = 0;
 
+/**
+ * generate_digest - Compute the raw SHA-256 digest of a string
+ * @input: Input string
+ * @digest: Output buffer of SIGNATURE_LENGTH bytes
+ */
+void generate_digest(const char *input, unsigned char *digest)
+{
+        EVP_MD_CTX *mdctx;
+        unsigned int digest_len;
+
+        mdctx = EVP_MD_CTX_new();
+        EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL);
+        EVP_DigestUpdate(mdctx, input, strlen(input));
+        EVP_DigestFinal_ex(mdctx, digest, &digest_len);
+        EVP_MD_CTX_free(mdctx);
+}
+
+/**
+ * hex_encode - Format bytes as lowercase hex
+ * @bytes: Input bytes
+ * @len: Number of bytes
+ * @output: Buffer of at least 2 * @len + 1 characters
+ */
+void hex_encode(const unsigned char *bytes, size_t len, char *output)
+{
+        static const char digits[] = "0123456789abcdef";
+        size_t i;
+
+        for (i = 0; i < len; i++)
+        {
+                output[i * 2] = digits[bytes[i] >> 4];
+                output[i * 2 + 1] = digits[bytes[i] & 0x0f];
+        }
+        output[len * 2] = '\0';
+}
+
+/**
+ * hex_value - Value of one hex digit
+ * @c: Character
+ * Return: 0-15, or -1 if @c is not a hex digit
+ */
+static int hex_value(char c)
+{
+        if (c >= '0' && c <= '9')
+                return c - '0';
+        if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+        return -1;
+}
+
+/**
+ * hex_decode - Parse exactly 2 * @len hex digits into bytes
+ * @hex: Hex string
+ * @bytes: Output buffer of @len bytes
+ * @len: Number of bytes to decode
+ * Return: 1 on success, 0 if @hex is too short or not hex
+ */
+int hex_decode(const char *hex, unsigned char *bytes, size_t len)
+{
+        size_t i;
+        int high, low;
+
+        for (i = 0; i < len; i++)
+        {
+                high = hex_value(hex[i * 2]);
+                low = high < 0 ? -1 : hex_value(hex[i * 2 + 1]);
+                if (low < 0)
+                        return 0;
+                bytes[i] = (unsigned char)(high << 4 | low);
+        }
+        return 1;
+}
+
 /**
  * generate_hash - Generate SHA-256 hash
  * @input: Input string
@@ -11,24 +91,68 @@ int tx_count = 0;
  */
 void generate_hash(const char *input, char *output)
 {
-        EVP_MD_CTX *mdctx;
-        const EVP_MD *md;
-        unsigned char hash[EVP_MAX_MD_SIZE];
-        unsigned int hash_len;
-        unsigned int i;
+        unsigned char digest[SIGNATURE_LENGTH];
 
-        mdctx = EVP_MD_CTX_new();
-        md = EVP_sha256();
+        generate_digest(input, digest);
+        hex_encode(digest, SIGNATURE_LENGTH, output);
+}
 
-        EVP_DigestInit_ex(mdctx, md, NULL);
-        EVP_DigestUpdate(mdctx, input, strlen(input));
-        EVP_DigestFinal_ex(mdctx, hash, &hash_len);
+/**
+ * transaction_from_legacy - Convert a pre-compact transaction record
+ * @legacy: Record in the old layout
+ * @from_id: Account ID of legacy->from_address
+ * @to_id: Account ID of legacy->to_address
+ * @transaction: Compact record to fill
+ */
+void transaction_from_legacy(const LegacyTransaction *legacy, uint32_t from_id,
+                             uint32_t to_id, Transaction *transaction)
+{
+        memset(transaction, 0, sizeof(Transaction));
+        transaction->from_id = from_id;
+        transaction->to_id = to_id;
+        transaction->amount = LT_TO_MICRO(legacy->amount);
+        transaction->timestamp = (int64_t)legacy->timestamp;
+        transaction->type = (uint8_t)legacy->type;
+        if (!hex_decode(legacy->signature, transaction->signature, SIGNATURE_LENGTH))
+                memset(transaction->signature, 0, SIGNATURE_LENGTH);
+}
 
-        for (i = 0; i < hash_len; i++)
-                sprintf(output + (i * 2), "%02x", hash[i]);
-        output[64] = '\0';
+/**
+ * stamp_block - Set a block's creation time to now
+ * @block: Block
+ */
+static void stamp_block(Block *block)
+{
+        block->timestamp = (int64_t)time(NULL);
+        block->utc_offset = local_utc_offset(block->timestamp);
+}
 
-        EVP_MD_CTX_free(mdctx);
+/**
+ * format_block_time - Format a block's creation time in its own time zone
+ * @block: Block
+ * @text: Output buffer of TIME_TEXT_SIZE bytes, "%Y-%m-%d %H:%M:%S"
+ *
+ * This is the text block hashes cover, so it must not change for a block
+ * once hashed.
+ */
+void format_block_time(const Block *block, char *text)
+{
+        format_epoch(block->timestamp, block->utc_offset, text);
+}
+
+/**
+ * hash_block - Compute a block's hash from its header fields
+ * @block: Block
+ * @hash: Output buffer of HASH_LENGTH + 1 bytes
+ */
+static void hash_block(const Block *block, char *hash)
+{
+        char timestamp[TIME_TEXT_SIZE];
+        char temp[512];
+
+        format_block_time(block, timestamp);
+        sprintf(temp, "%u%s%s%u", block->index, block->previous_hash, timestamp, block->nonce);
+        generate_hash(temp, hash);
 }
 
 /**
@@ -38,19 +162,30 @@ void generate_hash(const char *input, char *output)
 Blockchain *initialize_blockchain(void)
 {
         Blockchain *chain = NULL;
-        time_t now;
-        int block_idx = 0;
-        int block_cnt = 0;
-        char temp[512];
+        Block genesis;
 
         /* Load configuration */
-        Config *config = load_config();
+        const Config *config = get_config();
         if (!config)
         {
                 printf("Error: Failed to load config. Exiting...\n");
                 return NULL;
         }
 
+        /* Replaying the log compares against the stored wallet balances */
+        if (!migrate_legacy_wallets())
+                return NULL;
+
+        /*
+         * Open the log first: it owns the address book, which converting a
+         * legacy backup needs
+         */
+        if (!wal_open())
+        {
+                printf("Error: Failed to open transaction log.\n");
+                return NULL;
+        }
+
         /* Try to restore from backup */
         if (restore_blockchain(&chain))
         {
@@ -61,43 +196,32 @@ Blockchain *initialize_blockchain(void)
                 /* No backup found, create new blockchain */
                 printf("No backup found. Creating new blockchain...\n");
 
-                chain = malloc(sizeof(Blockchain));
+                chain = calloc(1, sizeof(Blockchain));
                 if (!chain)
                 {
                         printf("Error: Memory allocation failed.\n");
-                        free(config);
-                        return NULL;
-                }
-
-                /* Initialize genesis block */
-                chain->genesis = malloc(sizeof(Block));
-                if (!chain->genesis)
-                {
-                        printf("Error: Memory allocation failed.\n");
-                        free(chain);
-                        free(config);
                         return NULL;
                 }
 
                 /* Set genesis block properties */
-                chain->block_count = ++block_cnt;
-                chain->latest = chain->genesis;
-                chain->genesis->index = block_idx++;
-                strcpy(chain->genesis->previous_hash,
+                memset(&genesis, 0, sizeof(genesis));
+                genesis.index = 0;
+                strcpy(genesis.previous_hash,
                        "0000000000000000000000000000000000000000000000000000000000000000");
-                time(&now);
-                strftime(chain->genesis->timestamp, 30, "%Y-%m-%d %H:%M:%S", localtime(&now));
-                chain->genesis->reward = config->block_reward;
-                chain->genesis->transaction_count = 1;
-                chain->genesis->next = NULL;
-
-                /* Set genesis as latest */
-                chain->latest = chain->genesis;
+                stamp_block(&genesis);
+                genesis.reward = config->block_reward;
+                seal_block_body(&genesis);
 
                 /* Generate block hash */
-                sprintf(temp, "%u%s%s%u", chain->genesis->index, chain->genesis->previous_hash,
-                        chain->genesis->timestamp, chain->genesis->nonce);
-                generate_hash(temp, chain->genesis->current_hash);
+                hash_block(&genesis, genesis.current_hash);
+
+                /* Store genesis; it is also the latest block */
+                if (!append_block(chain, &genesis))
+                {
+                        printf("Error: Memory allocation failed.\n");
+                        cleanup_blockchain(chain);
+                        return NULL;
+                }
 
                 /* Set initial token supply */
                 printf("Total Supply: %u\n", config->initial_supply);
@@ -113,7 +237,9 @@ Blockchain *initialize_blockchain(void)
                 backup_blockchain(chain);
         }
 
-        free(config);
+        /* The pool was recovered from the log */
+        tx_count = wal_pending_count();
+
         return chain;
 }
 
@@ -150,19 +276,26 @@ int verify_email_domain(const char *email)
  * @type: Transaction type
  * Return: 1 on success, 0 on failure
  */
-int initiate_transaction(Blockchain *chain, Wallet *from, const char *to_address, double amount, TransactionType type)
+int initiate_transaction(Blockchain *chain, Wallet *from, const char *to_address, int64_t amount, TransactionType type)
 {
         Transaction transaction;
         Wallet *recipient;
-        char temp[256];
-        FILE *file;
-        FILE *tx_pool;
+        uint32_t from_id, to_id;
+
+        if (!chain || !from || !to_address || amount <= 0 || !lt_valid(amount) ||
+            from->balance < amount)
+                return 0;
 
-        if (!chain || !from || !to_address || amount <= 0 || from->balance < amount)
+        /* Unsigned transactions are never logged */
+        if (!wallet_has_signing_key(from))
+        {
+                printf("This wallet predates key pairs and cannot sign payments.\n");
+                printf("Load it again to upgrade it to a new key pair.\n");
                 return 0;
+        }
 
         /* Check unspent balance to prevent double-spending */
-        double available_balance = get_unspent_balance(from->address);
+        int64_t available_balance = get_unspent_balance(from->address);
         if (available_balance < amount)
         {
                 printf("Double-spending detected! Not enough unspent balance.\n");
@@ -170,51 +303,54 @@ int initiate_transaction(Blockchain *chain, Wallet *from, const char *to_address
         }
 
         recipient = load_wallet_by_public_key(to_address);
+
+        /* A rotated address forwards to the account that replaced it */
+        to_id = address_lookup(to_address);
+        while (!recipient && (to_id = wal_rotated_to(to_id)) != ADDRESS_ID_NONE)
+                recipient = load_wallet_by_public_key(address_of(to_id));
         if (!recipient)
         {
                 printf("Recipient wallet not found\n");
                 return 0;
         }
 
-        /* Prepare transaction record */
-        strncpy(transaction.from_address, from->address, HASH_LENGTH - 1);
-        transaction.from_address[HASH_LENGTH - 1] = '\0';
-
-        strncpy(transaction.to_address, to_address, HASH_LENGTH - 1);
-        transaction.to_address[HASH_LENGTH - 1] = '\0';
+        from_id = wal_intern_address(from->address);
+        to_id = wal_intern_address(recipient->address);
+        if (from_id == ADDRESS_ID_NONE || to_id == ADDRESS_ID_NONE)
+        {
+                printf("Error writing transaction log.\n");
+                free(recipient);
+                return 0;
+        }
 
+        /* Prepare transaction record */
+        memset(&transaction, 0, sizeof(transaction));
+        transaction.from_id = from_id;
+        transaction.to_id = to_id;
         transaction.amount = amount;
-        transaction.type = type;
-        time(&transaction.timestamp);
+        transaction.type = (uint8_t)type;
+        transaction.timestamp = (int64_t)time(NULL);
 
-        /* Generate transaction signature */
-        sprintf(temp, "%s%s%.2f%ld", transaction.from_address, transaction.to_address, amount, transaction.timestamp);
-        generate_hash(temp, transaction.signature);
-
-        /* Append transaction to TX_FILE */
-        file = fopen(TX_FILE, "ab");
-        if (!file)
+        /* Sign with the sender's key */
+        if (!sign_transaction(&transaction, from->private_key, from->address, recipient->address))
         {
-                printf("Error opening transactions file.\n");
+                printf("Error signing transaction.\n");
+                free(recipient);
                 return 0;
         }
 
-        /* Append transaction to TX_POOL */
-        tx_pool = fopen(TX_POOL, "ab");
-        if (!tx_pool)
+        /* Log the transaction; this also places it in the pool */
+        if (!wal_append_transaction(&transaction))
         {
-                printf("Error opening transactions pool file.\n");
+                printf("Error writing transaction log.\n");
+                free(recipient);
                 return 0;
         }
 
-        fwrite(&transaction, sizeof(Transaction), 1, file);
-        fclose(file);
-        fwrite(&transaction, sizeof(Transaction), 1, tx_pool);
-        fclose(tx_pool);
-
         /* Save updated wallets */
         update_wallet_record(from);
         update_wallet_record(recipient);
+        free(recipient);
 
         printf("\nTransaction successfully recorded.\n");
 
@@ -231,63 +367,150 @@ int initiate_transaction(Blockchain *chain, Wallet *from, const char *to_address
         return 1;
 }
 
+/**
+ * verify_block_body - Verify the transaction signatures in a block's body
+ * @block: Block, with its body resident or archived
+ * @unsigned_count: Receives the number of migrated transactions carrying a digest
+ * Return: 1 if every signature verifies, 0 if one fails or the body cannot be read
+ */
+static int verify_block_body(const Block *block, int *unsigned_count)
+{
+        Transaction *body;
+        int ok;
+
+        *unsigned_count = 0;
+        if (block->transaction_count <= 0)
+                return 1;
+
+        body = block->transactions ? block->transactions : load_block_body(block);
+        ok = body && verify_signatures(body, block->transaction_count, unsigned_count);
+        if (body != block->transactions)
+                free(body);
+        return ok;
+}
+
 /**
  * validate_chain - Validate blockchain integrity
  * @chain: Blockchain to validate
+ *
+ * Besides the hash links, every transaction must carry a valid signature
+ * by its sender, or be a migrated one whose legacy digest still matches;
+ * each block's signatures are checked on several threads.
+ *
  * Return: 1 if valid, 0 if compromised
  */
 int validate_chain(Blockchain *chain)
 {
         Block *current;
-        char temp[512];
+        Block *previous = NULL;
         char calc_hash[HASH_LENGTH + 1];
-        unsigned int i;
+        unsigned int height;
+        int unsigned_count;
+        long total_unsigned = 0;
 
         if (!chain || !chain->genesis)
                 return 0;
 
-        current = chain->genesis;
-        while (current->next != NULL)
+        for (height = 0; (current = get_block_by_index(chain, height)); height++)
         {
-                /* Verify link to next block */
-                if (strcmp(current->next->previous_hash, current->current_hash) != 0)
+                /* Verify link to the previous block */
+                if (previous && strcmp(current->previous_hash, previous->current_hash) != 0)
                         return 0;
 
                 /* Verify current block's hash */
-                sprintf(temp, "%u%s%s%u",
-                        current->index, current->previous_hash,
-                        current->timestamp, current->nonce);
-                generate_hash(temp, calc_hash);
+                hash_block(current, calc_hash);
 
                 if (strcmp(calc_hash, current->current_hash) != 0)
                         return 0;
 
-                /* Verify transactions in block */
-                for (i = 0; i < (unsigned int)current->transaction_count; i++)
+                if (!verify_block_body(current, &unsigned_count))
                 {
-                        (void)i; /* Suppress unused variable warning */
+                        printf("Block #%u has a transaction with a bad signature.\n", current->index);
+                        return 0;
                 }
+                total_unsigned += unsigned_count;
 
-                current = current->next;
+                previous = current;
         }
+
+        if (total_unsigned)
+                printf("%ld migrated transaction(s) carry a legacy digest instead of a signature.\n",
+                       total_unsigned);
         return 1;
 }
 
+/**
+ * print_transaction_summary - Print per-type and recent totals for an account
+ * @id: Account ID
+ */
+static void print_transaction_summary(uint32_t id)
+{
+        static const char *const type_names[] = {
+            "Tuition Fee", "Cafeteria Payment", "Library Fine",
+            "Health Insurance", "Token Transfer"};
+        TxColumns *columns = txcolumns_shared();
+        TxFilter filter;
+        TxTotals totals;
+        char sent[LT_FORMAT_SIZE];
+        char received[LT_FORMAT_SIZE];
+        int type;
+
+        if (!columns)
+                return;
+
+        printf("\n--- Summary ---\n");
+        txfilter_init(&filter, id);
+        for (type = TUITION_FEE; type <= TOKEN_TRANSFER; type++)
+        {
+                filter.type = type;
+                if (!txcolumns_sum(columns, &filter, &totals) ||
+                    (totals.sent == 0 && totals.received == 0))
+                        continue;
+                printf("%-18s sent %s, received %s %s\n", type_names[type],
+                       lt_format(totals.sent, sent), lt_format(totals.received, received),
+                       TOKEN_SYMBOL);
+        }
+
+        txfilter_init(&filter, id);
+        filter.start = (int64_t)time(NULL) - 24 * 60 * 60;
+        if (txcolumns_sum(columns, &filter, &totals))
+                printf("Last 24 hours:     sent %s, received %s %s\n",
+                       lt_format(totals.sent, sent), lt_format(totals.received, received),
+                       TOKEN_SYMBOL);
+}
+
+/**
+ * transaction_type_name - Display name of a TransactionType
+ * @type: TransactionType value
+ * Return: Name
+ */
+static const char *transaction_type_name(uint8_t type)
+{
+        return type == TUITION_FEE ? "Tuition Fee" : type == CAFETERIA_PAYMENT ? "Cafeteria Payment"
+                                                 : type == LIBRARY_FINE        ? "Library Fine"
+                                                 : type == HEALTH_INSURANCE    ? "Health Insurance"
+                                                                               : "Token Transfer";
+}
+
 /**
  * print_transaction_history - Print transaction history for a wallet
  * @wallet: Wallet to check transactions for
  */
 void print_transaction_history(Wallet *wallet)
 {
-        FILE *file;
-        Transaction transaction;
+        TxLog *log;
+        TxCursor cursor;
+        const Transaction *transaction;
+        uint32_t id;
+        time_t when;
+        char amount[LT_FORMAT_SIZE];
         int found = 0;
 
         if (!wallet)
                 return;
 
-        file = fopen(TX_FILE, "rb");
-        if (!file)
+        log = txlog_shared();
+        if (!log)
         {
                 printf("No transaction history available.\n");
                 return;
@@ -295,27 +518,91 @@ void print_transaction_history(Wallet *wallet)
 
         printf("\nWallet Address: %s\n", wallet->address);
 
-        while (fread(&transaction, sizeof(Transaction), 1, file))
+        /* A wallet that was never interned has no transactions */
+        id = address_lookup(wallet->address);
+        txcursor_begin(&cursor, log);
+        while (id != ADDRESS_ID_NONE && (transaction = txcursor_next_transaction(&cursor)))
         {
-                if (strcmp(transaction.from_address, wallet->address) == 0 || strcmp(transaction.to_address, wallet->address) == 0)
+                if (transaction->from_id == id || transaction->to_id == id)
                 {
                         found = 1;
-                        printf("\nTransaction Type: %s\n",
-                               transaction.type == TUITION_FEE ? "Tuition Fee" : transaction.type == CAFETERIA_PAYMENT ? "Cafeteria Payment"
-                                                                             : transaction.type == LIBRARY_FINE        ? "Library Fine"
-                                                                             : transaction.type == HEALTH_INSURANCE    ? "Health Insurance"
-                                                                                                                       : "Token Transfer");
-                        printf("Amount: %.2f %s\n", transaction.amount, TOKEN_SYMBOL);
-                        printf("From: %s\n", transaction.from_address);
-                        printf("To: %s\n", transaction.to_address);
-                        printf("Time: %s", ctime(&transaction.timestamp));
-                        printf("Status: %s\n", strcmp(transaction.from_address, wallet->address) == 0 ? "Sent" : "Received");
+                        printf("\nTransaction Type: %s\n", transaction_type_name(transaction->type));
+                        when = (time_t)transaction->timestamp;
+                        printf("Amount: %s %s\n", lt_format(transaction->amount, amount), TOKEN_SYMBOL);
+                        printf("From: %s\n", address_of(transaction->from_id));
+                        printf("To: %s\n", address_of(transaction->to_id));
+                        printf("Time: %s", ctime(&when));
+                        printf("Status: %s\n", transaction->from_id == id ? "Sent" : "Received");
                 }
         }
-        fclose(file);
 
         if (!found)
                 printf("No transactions found for this wallet.\n");
+        else
+                print_transaction_summary(id);
+}
+
+/**
+ * print_activity_between - Print the transactions and blocks of a time window
+ * @chain: Blockchain
+ * @start: First time included, in seconds since the epoch
+ * @end: First time excluded
+ *
+ * The time indexes narrow the log and the chain down to the entries
+ * around the window, so this does not scan the whole history.
+ *
+ * Return: 1 on success, 0 if the transaction log cannot be read
+ */
+int print_activity_between(const Blockchain *chain, int64_t start, int64_t end)
+{
+        TxColumns *columns = txcolumns_shared();
+        TxCursor cursor;
+        const Transaction *transaction;
+        const Block *block;
+        size_t row, last, frame;
+        unsigned int height, last_height;
+        char when[TIME_TEXT_SIZE], amount[LT_FORMAT_SIZE];
+        int found = 0;
+
+        if (!columns || !txcolumns_time_range(columns, start, end, &row, &last, &frame))
+        {
+                printf("No transaction history available.\n");
+                return 0;
+        }
+
+        printf("\n=== Transactions ===\n");
+        txcursor_begin(&cursor, txlog_shared());
+        txcursor_seek(&cursor, frame);
+        for (; row < last && (transaction = txcursor_next_transaction(&cursor)); row++)
+        {
+                if (transaction->timestamp < start || transaction->timestamp >= end)
+                        continue;
+                found = 1;
+                format_epoch(transaction->timestamp, local_utc_offset(transaction->timestamp), when);
+                printf("%s  %-17s %14s %s\n  From: %s\n  To:   %s\n", when,
+                       transaction_type_name(transaction->type),
+                       lt_format(transaction->amount, amount), TOKEN_SYMBOL,
+                       address_of(transaction->from_id), address_of(transaction->to_id));
+        }
+        if (!found)
+                printf("No transactions in this period.\n");
+
+        printf("\n=== Blocks ===\n");
+        if (!get_blocks_between(chain, start, end, &height, &last_height))
+        {
+                printf("No blocks in this period.\n");
+                return 1;
+        }
+        for (; height <= last_height; height++)
+        {
+                block = get_block_by_index(chain, height);
+                if (block->timestamp < start || block->timestamp >= end)
+                        continue;
+                format_block_time(block, when);
+                printf("Block #%u  %s  %d transaction(s)\n", block->index + 1, when,
+                       block->transaction_count);
+        }
+        return 1;
 }
 
 /**
@@ -324,20 +611,19 @@ void print_transaction_history(Wallet *wallet)
  */
 void cleanup_blockchain(Blockchain *chain)
 {
-        Block *current;
-        Block *next;
+        unsigned int height;
+        size_t i;
 
         if (!chain)
                 return;
 
-        current = chain->genesis;
-        while (current)
-        {
-                next = current->next;
-                free(current);
-                current = next;
-        }
-
+        for (height = 0; height < (unsigned int)chain->block_count; height++)
+                free_block_body(get_block_by_index(chain, height));
+        for (i = 0; i < chain->chunk_capacity; i++)
+                free(chain->chunks[i]);
+        free(chain->chunks);
+        free(chain->hash_slots);
+        time_index_free(&chain->block_times);
         free(chain);
 }
 
@@ -367,32 +653,35 @@ int add_transaction(Block *new_block, Transaction *transaction)
 Block *create_block(Blockchain *chain)
 {
         Block *new_block, *latest;
-        time_t now;
-        char temp[512];
 
         if (!chain || !chain->latest)
                 return NULL;
 
-        new_block = malloc(sizeof(Block));
+        new_block = calloc(1, sizeof(Block));
         if (!new_block)
                 return NULL;
 
+        /* Room for a full block; mine_block() trims it when sealing */
+        new_block->transactions = calloc(MAX_TRANSACTIONS, sizeof(Transaction));
+        if (!new_block->transactions)
+        {
+                free(new_block);
+                return NULL;
+        }
+        new_block->archive_offset = -1;
+
         latest = chain->latest;
         new_block->index = latest->index + 1;
         strncpy(new_block->previous_hash, latest->current_hash, HASH_LENGTH - 1);
         new_block->previous_hash[HASH_LENGTH - 1] = '\0'; // Ensure null termination
 
-        time(&now);
-        strftime(new_block->timestamp, 30, "%Y-%m-%d %H:%M:%S", localtime(&now));
+        stamp_block(new_block);
         new_block->nonce = 0;
         new_block->transaction_count = 0;
-        new_block->next = NULL;
         new_block->reward = BLOCK_REWARD;
 
         /* Generate block hash */
-        sprintf(temp, "%u%s%s%u", new_block->index, new_block->previous_hash,
-                new_block->timestamp, new_block->nonce);
-        generate_hash(temp, new_block->current_hash);
+        hash_block(new_block, new_block->current_hash);
 
         return new_block;
 }
@@ -405,8 +694,8 @@ Block *create_block(Blockchain *chain)
  */
 int validate_block(Blockchain *chain, Block *block)
 {
-        char temp[512];
         char computed_hash[HASH_LENGTH + 1];
+        int unsigned_count;
 
         if (!chain || !block)
                 return 0;
@@ -420,9 +709,7 @@ int validate_block(Blockchain *chain, Block *block)
         }
 
         /* Recompute hash */
-        sprintf(temp, "%u%s%s%u", block->index, block->previous_hash,
-                block->timestamp, block->nonce);
-        generate_hash(temp, computed_hash);
+        hash_block(block, computed_hash);
 
         if (strcmp(computed_hash, block->current_hash) != 0)
         {
@@ -431,6 +718,13 @@ int validate_block(Blockchain *chain, Block *block)
                 return 0;
         }
 
+        /* Check every transaction signature, fanned out over several threads */
+        if (!verify_block_body(block, &unsigned_count))
+        {
+                printf("Signature verification failed!\n");
+                return 0;
+        }
+
         printf("✅ Block validation successful!\n");
         return 1;
 }
@@ -443,7 +737,7 @@ int validate_block(Blockchain *chain, Block *block)
 Wallet *select_validator()
 {
         Wallet *selected_wallet = NULL;
-        double total_balance = 0, random_value, cumulative_weight = 0;
+        int64_t total_balance = 0, random_value, cumulative_weight = 0;
         FILE *file;
         StoredWallet stored_wallet;
 
@@ -455,7 +749,11 @@ Wallet *select_validator()
         // Calculate total balance of all wallets
         while (fread(&stored_wallet, sizeof(StoredWallet), 1, file))
         {
-                total_balance += stored_wallet.balance;
+                if (!lt_add(total_balance, stored_wallet.balance, &total_balance))
+                {
+                        fclose(file);
+                        return NULL;
+                }
         }
         fclose(file);
 
@@ -464,7 +762,7 @@ Wallet *select_validator()
 
         // Generate a random value within the total balance
         srand(time(NULL));
-        random_value = ((double)rand() / RAND_MAX) * total_balance;
+        random_value = (int64_t)(((double)rand() / RAND_MAX) * (double)total_balance);
 
         // Reopen the file to traverse it again and select wallet
         file = fopen(WALLETS_FILE, "rb");
@@ -505,10 +803,13 @@ Wallet *select_validator()
  */
 Block *mine_block(Blockchain *chain)
 {
-        Block *new_block, *latest;
+        Block *new_block, *stored;
         Transaction *tx_pool;
         Wallet *validator;
-        double mining_reward = 2.0; /* Adjust reward as needed */
+        int64_t mining_reward = (int64_t)BLOCK_REWARD * MICRO_LT_PER_LT; /* Adjust reward as needed */
+        char reward[LT_FORMAT_SIZE];
+        const Config *config;
+        unsigned int snapshot_height;
 
         if (!chain)
         {
@@ -516,8 +817,6 @@ Block *mine_block(Blockchain *chain)
                 return NULL;
         }
 
-        latest = chain->latest;
-
         printf("\n⛏️    Mining new block...\n");
         sleep(1.5);
 
@@ -528,20 +827,13 @@ Block *mine_block(Blockchain *chain)
                 return NULL;
         }
 
-        sleep(1.0);
-        if (!validate_block(chain, new_block))
-        {
-                printf("❌ Block validation failed. Discarding block.\n");
-                return NULL;
-        }
-
         /* Extract transactions from TX_POOL */
         sleep(1.0);
         tx_pool = extract_transactions();
         if (tx_pool)
         {
                 int i = 0;
-                while (i < tx_count && strlen(tx_pool[i].from_address) > 0)
+                while (i < tx_count && i < MAX_TRANSACTIONS)
                 {
                         /* Add transactions */
                         if (!add_transaction(new_block, &tx_pool[i]))
@@ -552,32 +844,70 @@ Block *mine_block(Blockchain *chain)
                 }
                 free(tx_pool);
         }
+        seal_block_body(new_block);
+
+        /* Validate the sealed block, transaction signatures included */
+        sleep(1.0);
+        if (!validate_block(chain, new_block))
+        {
+                printf("❌ Block validation failed. Discarding block.\n");
+                free_block_body(new_block);
+                free(new_block);
+                return NULL;
+        }
 
         /* Select a validator */
         validator = select_validator(chain);
+
+        /* Log the block before touching balances so recovery can replay it */
+        if (!reserve_block(chain) ||
+            !wal_append_block(new_block->index, new_block->transaction_count,
+                              validator ? wal_intern_address(validator->address) : ADDRESS_ID_NONE,
+                              mining_reward))
+        {
+                printf("Error writing transaction log. Discarding block.\n");
+                free(validator);
+                free_block_body(new_block);
+                free(new_block);
+                return NULL;
+        }
+
         if (!validator)
         {
                 printf("No validator selected. Block reward skipped.\n");
         }
         else
         {
-                validator->balance += mining_reward;
-                update_wallet_record(validator);
-                printf("\nBlock mined by %s %s. Reward: %.2f\n", validator->email, validator->address, mining_reward);
+                if (lt_add(validator->balance, mining_reward, &validator->balance))
+                        update_wallet_record(validator);
+                printf("\nBlock mined by %s %s. Reward: %s\n", validator->email, validator->address,
+                       lt_format(mining_reward, reward));
+                free(validator);
         }
 
-        /* Link new block to blockchain first */
-        latest->next = new_block;
-        chain->latest = new_block;
-        chain->block_count++;
+        /* Storage was reserved above, so appending cannot fail; the chain owns the body */
+        stored = append_block(chain, new_block);
+        free(new_block);
+        new_block = stored;
+
+        /* Periodic state snapshot, so restarts replay only later blocks */
+        config = get_config();
+        if (config && config->snapshot_interval && new_block->index % config->snapshot_interval == 0)
+        {
+                if (!snapshot_take(new_block->index))
+                        printf("Warning: could not write the state snapshot at height %u.\n", new_block->index);
+                else if (config->block_pruning &&
+                         (!snapshot_latest_height(&snapshot_height) || !prune_blocks(chain, snapshot_height)))
+                        printf("Warning: could not archive old block bodies.\n");
+        }
 
         /* Backup blockchain */
         backup_blockchain(chain);
 
         printf("New block #%d created with %d transaction(s)\n", new_block->index + 1, new_block->transaction_count);
 
-        /* Reset tx_count for next pool */
-        tx_count = 0;
+        /* Transactions beyond this block's capacity stay in the pool */
+        tx_count = wal_pending_count();
 
         /* Return mined block */
         return new_block;
@@ -590,7 +920,8 @@ Block *mine_block(Blockchain *chain)
 void print_blockchain(const Blockchain *chain)
 {
         Block *current;
-        int i;
+        char timestamp[TIME_TEXT_SIZE];
+        unsigned int height;
 
         if (!chain)
         {
@@ -605,89 +936,111 @@ void print_blockchain(const Blockchain *chain)
         printf("Circulating Supply: %u\n", chain->token.circulating_supply);
         printf("=====================================\n\n");
 
-        current = chain->genesis;
-        for (i = 0; current; i++)
+        for (height = 0; (current = get_block_by_index(chain, height)); height++)
         {
                 printf("----- Block #%d -----\n", current->index + 1);
-                printf("Timestamp: %s\n", current->timestamp);
+                format_block_time(current, timestamp);
+                printf("Timestamp: %s\n", timestamp);
                 printf("Previous Hash: %s\n", current->previous_hash);
                 printf("Transactions: %d\n", current->transaction_count);
                 printf("Reward: %u\n", current->reward);
                 printf("Hash: %s\n", current->current_hash);
                 printf("---------------------\n\n");
-
-                current = current->next;
         }
 }
 
 /**
- * extract_transactions - Extracts transactions from TX_POOL and returns an array
+ * extract_transactions - Copies the oldest pooled transactions into an array
+ *
+ * The pool lives in the transaction log; transactions leave it when
+ * mine_block() logs the block that includes them.
+ *
  * Return: Pointer to an array of transactions (must be freed after use), NULL on failure
  */
 Transaction *extract_transactions()
 {
-        FILE *file;
         Transaction *transactions;
-        int count = 0;
+        int count;
 
         /* Allocate memory for transactions */
-        transactions = malloc(MAX_TRANSACTIONS * sizeof(Transaction));
+        transactions = calloc(MAX_TRANSACTIONS, sizeof(Transaction));
         if (!transactions)
                 return NULL;
 
-        file = fopen(TX_POOL, "rb");
-        if (!file)
-        {
-                free(transactions);
-                return NULL;
-        }
+        count = wal_copy_pending(transactions, MAX_TRANSACTIONS);
+        printf("Extracted %d transactions from pool\n", count);
+
+        return transactions;
+}
+
+/**
+ * add_account_history - Apply one account's logged transactions to a balance
+ * @log: Shared transaction log
+ * @columns: Columnar copy of the log, or NULL to scan @log
+ * @id: Account ID
+ * @balance: Balance to update
+ * Return: 1 on success, 0 if the balance overflows
+ */
+static int add_account_history(TxLog *log, TxColumns *columns, uint32_t id, int64_t *balance)
+{
+        const Transaction *tx;
+        TxCursor cursor;
+        TxFilter filter;
+        TxTotals totals;
 
-        /* Read transactions from the file */
-        while (fread(&transactions[count], sizeof(Transaction), 1, file) == 1)
+        /* Sum the amount column with SIMD kernels */
+        if (columns)
         {
-                count++;
-                if (count >= MAX_TRANSACTIONS)
-                        break; /* Prevent overflow */
+                txfilter_init(&filter, id);
+                return txcolumns_sum(columns, &filter, &totals) &&
+                       lt_sub(*balance, totals.sent, balance) &&
+                       lt_add(*balance, totals.received, balance);
         }
-        printf("Extracted %d transactions from pool\n", count);
-
-        fclose(file);
 
-        /* Clear TX_POOL file after extraction */
-        file = fopen(TX_POOL, "wb");
-        if (file)
-                fclose(file);
+        /* Scan all transactions in place, comparing IDs instead of strings */
+        txcursor_begin(&cursor, log);
+        while ((tx = txcursor_next_transaction(&cursor)))
+        {
+                if (tx->from_id == id && !lt_sub(*balance, tx->amount, balance))
+                        return 0; // Deduct spent amount
 
-        return transactions;
+                if (tx->to_id == id && !lt_add(*balance, tx->amount, balance))
+                        return 0; // Add received amount
+        }
+        return 1;
 }
 
 /**
  * get_unspent_balance - Checks the unspent balance of a wallet
  * @address: Wallet address to check
- * Return: Available balance including initial balance
+ *
+ * An account created by a key rotation carries on the history of the
+ * account it replaced.
+ *
+ * Return: Available balance in micro-LT, including the initial balance
  */
-double get_unspent_balance(const char *address)
+int64_t get_unspent_balance(const char *address)
 {
-        FILE *file = fopen(TX_FILE, "rb");
-        if (!file)
+        TxLog *log = txlog_shared();
+        if (!log)
         {
                 printf("Error opening transaction history file.\n");
-                return 100.00; // Default balance for new wallets
+                return INITIAL_WALLET_BALANCE; // Default balance for new wallets
         }
 
-        double balance = 100.00; // Start with initial balance
-        Transaction tx;
+        int64_t balance = INITIAL_WALLET_BALANCE; // Start with initial balance
+        uint32_t id = address_lookup(address);
+        const Config *config = get_config();
+        TxColumns *columns;
 
-        /* Read all transactions from history */
-        while (fread(&tx, sizeof(Transaction), 1, file))
-        {
-                if (strcmp(tx.from_address, address) == 0)
-                        balance -= tx.amount; // Deduct spent amount
+        if (id == ADDRESS_ID_NONE)
+                return INITIAL_WALLET_BALANCE;
 
-                if (strcmp(tx.to_address, address) == 0)
-                        balance += tx.amount; // Add received amount
+        columns = config && config->columnar_scan ? txcolumns_shared() : NULL;
+        for (; id != ADDRESS_ID_NONE; id = wal_rotated_from(id))
+        {
+                if (!add_account_history(log, columns, id, &balance))
+                        return 0;
         }
-
-        fclose(file);
         return balance;
 }
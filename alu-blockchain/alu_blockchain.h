@@ -9,17 +9,28 @@
 #include <openssl/evp.h>
 #include <openssl/sha.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "amount.h"
+#include "time_index.h"
 
 /* Constants */
 #define MAX_EMAIL 100
 #define MAX_NAME 100
 #define HASH_LENGTH 65
+#define SIGNATURE_LENGTH 32
+#define TX_SIGNATURE_LENGTH 64
 #define MAX_TRANSACTIONS 100
+#define BLOCK_CHUNK_SIZE 64
+#define BLOCK_ARCHIVE_FILE "block_archive.dat"
 #define PROFILES_FILE "profiles.dat"
-#define WALLETS_FILE "wallets.dat"
+#define PROFILES_JOURNAL "profiles.journal"
+#define WALLETS_FILE "wallets_v2.dat"
+#define LEGACY_WALLETS_FILE "wallets.dat"
 #define TX_FILE "transactions.dat"
 #define TX_POOL "txpool.dat"
 #define NUM_KITCHENS 10
+#define KITCHENS_FILE "kitchens.txt"
 
 /* Token definitions */
 #define TOKEN_NAME "Leaders Token"
@@ -28,6 +39,11 @@
 #define CIRCULATING_SUPPLY 1000000
 #define BLOCK_REWARD 2
 
+/* Ledger amounts are integer micro-LT (see amount.h) */
+#define MICRO_LT_PER_LT 1000000
+#define INITIAL_WALLET_BALANCE ((int64_t)100 * MICRO_LT_PER_LT)
+#define LT_TO_MICRO(x) ((int64_t)((x) * MICRO_LT_PER_LT + ((x) < 0 ? -0.5 : 0.5)))
+
 /* Domain definitions */
 #define STUDENT_DOMAIN "@alustudent.com"
 #define STAFF_DOMAIN "@alueducation.com"
@@ -38,15 +54,10 @@
 #define Joshua_Kitchen "Joshua's Kitchen"
 #define Pascal_Kitchen "Pascal's Kitchen"
 
-/* Vendor Address */
-#define Pius_Cuisine_ADDRESS "0x000pius000000cuisine000000"
-#define Joshua_Kitchen_ADDRESS "0x000joshua000000kitchen000000"
-#define Pascal_Kitchen_ADDRESS "0x000pascal000000kitchen000000"
-
-/* Institutional addresses */
-#define SCHOOL_TUITION_ADDRESS "0000000000000000000000000000000000000000000000000000000000000001"
-#define SCHOOL_LIBRARY_ADDRESS "0000000000000000000000000000000000000000000000000000000000000002"
-#define HEALTH_INSURANCE_ADDRESS "0000000000000000000000000000000000000000000000000000000000000003"
+/* Institutional wallets; their key pairs are generated on first start */
+#define SCHOOL_TUITION_EMAIL "tuition@alu.edu"
+#define SCHOOL_LIBRARY_EMAIL "library@alu.edu"
+#define HEALTH_INSURANCE_EMAIL "insurance@alu.edu"
 
 /* Enums */
 typedef enum
@@ -94,11 +105,11 @@ typedef struct VendorProfile
         char kitchen_name[50];
         char email[50];
         char wallet_address[HASH_LENGTH];
-        double balance;
+        int64_t balance;
         struct VendorProfile *next;
 } VendorProfile;
 
-extern VendorProfile *vendor_list; // Declare, but don't initialize
+extern VendorProfile *vendor_list; /* Registered kitchens, in KITCHENS_FILE order */
 
 /* Token Structure */
 typedef struct
@@ -110,29 +121,93 @@ typedef struct
 } Token;
 
 /* Blockchain related structures */
+
+/* How a transaction was signed (Transaction.signature_type) */
+typedef enum
+{
+        TX_SIGNED_DIGEST,
+        TX_SIGNED_ED25519
+} SignatureType;
+
+/**
+ * struct Transaction - Fixed-size 96-byte transaction record
+ * @from_id: Sender account ID (see address_book.h)
+ * @to_id: Recipient account ID
+ * @amount: Amount in micro-LT
+ * @timestamp: Seconds since the epoch
+ * @type: TransactionType
+ * @signature_type: SignatureType
+ * @reserved: Always zero
+ * @signature: Ed25519 signature by the sender's key (see sign_transaction());
+ *             for TX_SIGNED_DIGEST, a SHA-256 digest in the first
+ *             SIGNATURE_LENGTH bytes that anyone could have computed, only
+ *             accepted for transactions migrated from the pre-WAL files
+ *
+ * Addresses are only turned back into hex strings for display.
+ */
 typedef struct
 {
-        char from_address[HASH_LENGTH + 1];
-        char to_address[HASH_LENGTH + 1];
-        double amount;
-        TransactionType type;
-        time_t timestamp;
-        char signature[HASH_LENGTH + 1];
+        uint32_t from_id;
+        uint32_t to_id;
+        int64_t amount;
+        int64_t timestamp;
+        uint8_t type;
+        uint8_t signature_type;
+        uint8_t reserved[6];
+        unsigned char signature[TX_SIGNATURE_LENGTH];
 } Transaction;
 
+/**
+ * struct Block - Block header plus a separately allocated body
+ * @index: Height
+ * @previous_hash: current_hash of the block before
+ * @timestamp: Creation time, seconds since the epoch
+ * @utc_offset: Seconds east of UTC where the block was created; the hash
+ *              covers the time formatted in that zone (see format_block_time())
+ * @nonce: Nonce
+ * @transaction_count: Number of transactions in the body
+ * @current_hash: Block hash
+ * @reward: Validator reward in LT
+ * @merkle_root: Merkle root of the body, kept when the body is pruned
+ * @archive_offset: Offset of the body in BLOCK_ARCHIVE_FILE, -1 if resident
+ * @transactions: Body, NULL once archived or when empty
+ *
+ * Everything before @transactions is the header (BLOCK_HEADER_SIZE bytes)
+ * and is what backups store for each block.
+ */
 typedef struct Block
 {
         unsigned int index;
         char previous_hash[HASH_LENGTH + 1];
-        char timestamp[30];
+        int64_t timestamp;
+        int32_t utc_offset;
         unsigned int nonce;
-        Transaction transactions[MAX_TRANSACTIONS];
         int transaction_count;
         char current_hash[HASH_LENGTH + 1];
-        struct Block *next;
         unsigned int reward;
+        unsigned char merkle_root[SIGNATURE_LENGTH];
+        int64_t archive_offset;
+        Transaction *transactions;
 } Block;
 
+#define BLOCK_HEADER_SIZE offsetof(Block, transactions)
+
+/**
+ * struct Blockchain - The chain and its block storage
+ * @genesis: Block at height 0
+ * @latest: Block at height block_count - 1
+ * @block_count: Number of blocks
+ * @token: Token metadata
+ * @chunks: Block storage, BLOCK_CHUNK_SIZE consecutive heights per chunk
+ * @chunk_capacity: Length of @chunks
+ * @hash_slots: current_hash -> height + 1, 0 marks an empty slot
+ * @hash_slot_count: Length of @hash_slots, a power of two
+ * @pruned_count: Leading heights whose bodies prune_blocks() has archived
+ * @block_times: Time index over block timestamps, positions are heights
+ *
+ * Allocate with calloc() and add blocks with append_block(); block
+ * pointers stay valid until cleanup_blockchain().
+ */
 typedef struct
 {
         Block *genesis;
@@ -145,6 +220,12 @@ typedef struct
                 unsigned int total_supply;
                 unsigned int circulating_supply;
         } token;
+        Block **chunks;
+        size_t chunk_capacity;
+        unsigned int *hash_slots;
+        size_t hash_slot_count;
+        unsigned int pruned_count;
+        TimeIndex block_times;
 } Blockchain;
 
 /* Wallet structures */
@@ -153,7 +234,7 @@ typedef struct
         char address[HASH_LENGTH + 1];
         char private_key[HASH_LENGTH + 1];
         char email[MAX_EMAIL];
-        double balance;
+        int64_t balance;
         char name[MAX_NAME];
         UserType user_type;
 } Wallet;
@@ -163,7 +244,7 @@ typedef struct
         char email[MAX_EMAIL];
         char private_key[HASH_LENGTH + 1];
         char address[HASH_LENGTH + 1];
-        double balance;
+        int64_t balance;
         UserType user_type;
         char kitchen_name[MAX_NAME];
         char name[MAX_NAME];
@@ -189,12 +270,22 @@ typedef struct
 
 /* Function prototypes */
 void generate_hash(const char *input, char *output);
+void generate_digest(const char *input, unsigned char *digest);
+int generate_wallet_keys(char *address, char *private_key);
+int wallet_has_signing_key(const Wallet *wallet);
+int sign_transaction(Transaction *transaction, const char *private_key,
+                     const char *from_address, const char *to_address);
+int verify_signature(const Transaction *transaction);
+int verify_signatures(const Transaction *transactions, int count, int *unsigned_count);
+void hex_encode(const unsigned char *bytes, size_t len, char *output);
+int hex_decode(const char *hex, unsigned char *bytes, size_t len);
 Blockchain *initialize_blockchain(void);
 int verify_email_domain(const char *email);
 Wallet *create_wallet(const char *email, const char *kitchen_name);
 Wallet *load_wallet_by_key(const char *private_key);
+int upgrade_wallet_keys(Wallet *wallet);
 int initiate_transaction(Blockchain *chain, Wallet *from,
-                         const char *to_address, double amount,
+                         const char *to_address, int64_t amount,
                          TransactionType type);
 int validate_chain(Blockchain *chain);
 void cleanup_blockchain(Blockchain *chain);
@@ -204,21 +295,47 @@ int update_wallet_record(const Wallet *updated_wallet);
 int create_institutional_wallets(void);
 int add_transaction(Block *new_block, Transaction *transaction);
 Block *create_block(Blockchain *chain);
+int reserve_block(Blockchain *chain);
+Block *append_block(Blockchain *chain, const Block *block);
+Block *get_block_by_index(const Blockchain *chain, unsigned int index);
+Block *get_block_by_hash(const Blockchain *chain, const char *hash);
+int get_blocks_between(const Blockchain *chain, int64_t start, int64_t end,
+                       unsigned int *first, unsigned int *last);
+void format_block_time(const Block *block, char *text);
+void compute_merkle_root(const Transaction *transactions, int count, unsigned char *root);
+void seal_block_body(Block *block);
+void free_block_body(Block *block);
+int prune_blocks(Blockchain *chain, unsigned int height);
+Transaction *load_block_body(const Block *block);
 int validate_block(Blockchain *chain, Block *block);
 Wallet *select_validator();
 void print_blockchain(const Blockchain *chain);
+int print_activity_between(const Blockchain *chain, int64_t start, int64_t end);
 Transaction *extract_transactions();
 Wallet *reload_wallet(Wallet *current_wallet);
 int create_vendor_wallets(void);
-double get_unspent_balance(const char *address);
+int64_t get_unspent_balance(const char *address);
+int migrate_legacy_wallets(void);
 Block *mine_block(Blockchain *chain);
 void add_kitchen(const char *kitchen_name, const char *email, const char *wallet_address);
 VendorProfile *get_kitchen_vendor(int kitchen_index);
+int load_vendor_registry(void);
+void release_vendor_registry(void);
+int vendor_registry_count(void);
+VendorProfile *get_vendor_by_id(int vendor_id);
+VendorProfile *get_vendor_by_name(const char *kitchen_name);
+VendorProfile *get_vendor_by_address(const char *wallet_address);
 StudentProfileWithWallet *create_student_profile(const char *email);
 StaffProfileWithWallet *create_staff_profile(const char *email);
 VendorProfileWithWallet *create_vendor_profile(const char *name, const char *email);
 int save_profiles_to_file(void);
+int add_enrolled_profiles(const StoredWallet *wallets, int count);
+int parse_enroll_line(const char *line, char *email);
+int enroll_from_csv(const char *csv_path, const char *keys_path);
 int load_profiles_from_file(void);
+void release_profiles(void);
+void *get_profile_by_email(const char *email, UserType *type);
+void *get_profile_by_id(UserType type, unsigned int id);
 int check_email_exists(const char *email);
 UserType get_user_type_from_email(const char *email);
 int save_wallet(const char *email, const char *private_key,
@@ -230,6 +347,7 @@ void get_string_input(const char *prompt, char *buffer, size_t size);
 void clear_input_buffer(void);
 int process_payment(Blockchain *chain, Wallet *wallet);
 int get_recipient_address(char *to_address, const char **recipient_name);
+int get_institution_address(const char *email, char *to_address);
 Wallet *load_wallet_by_email(const char *email);
 
 #endif /* ALU_BLOCKCHAIN_H */
\ No newline at end of file
@@ -0,0 +1,161 @@
+/* amount.c */
+#include "alu_blockchain.h"
+#include "amount.h"
+#include <ctype.h>
+
+/**
+ * lt_add - Add two amounts, detecting overflow
+ * @a: First amount
+ * @b: Second amount
+ * @sum: Receives a + b; untouched on overflow
+ * Return: 1 on success, 0 on overflow
+ */
+int lt_add(int64_t a, int64_t b, int64_t *sum)
+{
+        int64_t result;
+
+        if (__builtin_add_overflow(a, b, &result))
+                return 0;
+        *sum = result;
+        return 1;
+}
+
+/**
+ * lt_sub - Subtract two amounts, detecting overflow
+ * @a: Amount
+ * @b: Amount to subtract
+ * @difference: Receives a - b; untouched on overflow
+ * Return: 1 on success, 0 on overflow
+ */
+int lt_sub(int64_t a, int64_t b, int64_t *difference)
+{
+        int64_t result;
+
+        if (__builtin_sub_overflow(a, b, &result))
+                return 0;
+        *difference = result;
+        return 1;
+}
+
+/**
+ * lt_valid - Check that an amount is within the range the ledger accepts
+ * @amount: Amount in micro-LT
+ * Return: 1 if |amount| <= LT_AMOUNT_MAX, 0 otherwise
+ */
+int lt_valid(int64_t amount)
+{
+        return amount >= -LT_AMOUNT_MAX && amount <= LT_AMOUNT_MAX;
+}
+
+/**
+ * lt_sum - Exactly sum an array of amounts
+ * @amounts: Amounts, each within +/- LT_AMOUNT_MAX
+ * @count: Number of amounts
+ * @sum: Receives the total; untouched on overflow
+ *
+ * Each chunk is summed with plain additions that cannot overflow, which
+ * the compiler is free to vectorise; only the chunk totals are checked.
+ *
+ * Return: 1 on success, 0 on overflow
+ */
+int lt_sum(const int64_t *amounts, size_t count, int64_t *sum)
+{
+        int64_t total = 0;
+        int64_t chunk;
+        size_t start, end, i;
+
+        for (start = 0; start < count; start = end)
+        {
+                end = count - start > LT_SUM_CHUNK ? start + LT_SUM_CHUNK : count;
+                chunk = 0;
+                for (i = start; i < end; i++)
+                        chunk += amounts[i];
+                if (!lt_add(total, chunk, &total))
+                        return 0;
+        }
+
+        *sum = total;
+        return 1;
+}
+
+/**
+ * lt_parse - Parse a decimal LT amount such as "12", "2.5" or "0.000001"
+ * @text: Text to parse; surrounding whitespace is ignored
+ * @amount: Receives the amount in micro-LT
+ *
+ * Parsing is exact: more than six decimal places, or a value outside
+ * +/- LT_AMOUNT_MAX, is rejected rather than rounded.
+ *
+ * Return: 1 on success, 0 on malformed or out-of-range input
+ */
+int lt_parse(const char *text, int64_t *amount)
+{
+        int64_t whole = 0;
+        int64_t fraction = 0;
+        int64_t scale = MICRO_LT_PER_LT;
+        int negative = 0;
+        int digits = 0;
+
+        if (!text || !amount)
+                return 0;
+
+        while (isspace((unsigned char)*text))
+                text++;
+        if (*text == '-' || *text == '+')
+                negative = *text++ == '-';
+
+        for (; isdigit((unsigned char)*text); text++, digits++)
+        {
+                whole = whole * 10 + (*text - '0');
+                if (whole > LT_AMOUNT_MAX / MICRO_LT_PER_LT)
+                        return 0;
+        }
+
+        if (*text == '.')
+        {
+                for (text++; isdigit((unsigned char)*text); text++, digits++)
+                {
+                        if (scale == 1)
+                                return 0;
+                        scale /= 10;
+                        fraction += (*text - '0') * scale;
+                }
+        }
+
+        while (isspace((unsigned char)*text))
+                text++;
+        if (*text || !digits)
+                return 0;
+
+        whole = whole * MICRO_LT_PER_LT + fraction;
+        if (whole > LT_AMOUNT_MAX)
+                return 0;
+
+        *amount = negative ? -whole : whole;
+        return 1;
+}
+
+/**
+ * lt_format - Format an amount for display, e.g. "82.50" or "0.000001"
+ * @amount: Amount in micro-LT
+ * @buffer: Buffer of at least LT_FORMAT_SIZE bytes
+ *
+ * Shows at least two decimal places and as many more as the amount needs,
+ * so no value is ever rounded.
+ *
+ * Return: @buffer
+ */
+const char *lt_format(int64_t amount, char *buffer)
+{
+        uint64_t magnitude = amount < 0 ? -(uint64_t)amount : (uint64_t)amount;
+        unsigned long fraction = (unsigned long)(magnitude % MICRO_LT_PER_LT);
+        int length;
+
+        length = sprintf(buffer, "%s%llu.%06lu", amount < 0 ? "-" : "",
+                         (unsigned long long)(magnitude / MICRO_LT_PER_LT), fraction);
+
+        /* Trim trailing zeros down to two decimal places */
+        while (buffer[length - 1] == '0' && buffer[length - 3] != '.')
+                buffer[--length] = '\0';
+        return buffer;
+}
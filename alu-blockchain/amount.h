@@ -0,0 +1,30 @@
+/* amount.h */
+#ifndef AMOUNT_H
+#define AMOUNT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Token amounts are signed 64-bit counts of micro-LT (MICRO_LT_PER_LT per
+ * LT). Integer addition is associative, so a balance computed by splitting
+ * the work across threads or SIMD lanes is bit-identical to a serial scan.
+ */
+
+/* Largest magnitude the ledger accepts for one amount (~8.8 million LT) */
+#define LT_AMOUNT_MAX INT64_C(0x7ffffffffff)
+
+/* Amounts lt_sum() adds without checks: LT_SUM_CHUNK * LT_AMOUNT_MAX < INT64_MAX */
+#define LT_SUM_CHUNK 65536
+
+/* Buffer size for lt_format(), enough for any int64_t amount */
+#define LT_FORMAT_SIZE 32
+
+int lt_add(int64_t a, int64_t b, int64_t *sum);
+int lt_sub(int64_t a, int64_t b, int64_t *difference);
+int lt_valid(int64_t amount);
+int lt_sum(const int64_t *amounts, size_t count, int64_t *sum);
+int lt_parse(const char *text, int64_t *amount);
+const char *lt_format(int64_t amount, char *buffer);
+
+#endif /* AMOUNT_H */
@@ -0,0 +1,210 @@
+/* bench_tx_scan.c */
+#define _XOPEN_SOURCE 700
+#include "alu_blockchain.h"
+#include "config.h"
+#include "wal.h"
+#include "txlog.h"
+#include "txcolumns.h"
+
+/*
+ * Compares per-account balance sums over a synthetic transaction log:
+ * the row scan over mapped log frames against the column store with each
+ * kernel the CPU supports. Every method must produce identical totals.
+ *
+ * Usage: bench_tx_scan [transactions] [accounts] [queries]
+ */
+
+#define BENCH_DEFAULT_TRANSACTIONS 1000000
+#define BENCH_DEFAULT_ACCOUNTS 1000
+#define BENCH_DEFAULT_QUERIES 50
+
+/**
+ * now_seconds - Monotonic clock reading
+ * Return: Seconds
+ */
+static double now_seconds(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * next_random - xorshift64 generator, reproducible across runs
+ * @state: Generator state
+ * Return: Next value
+ */
+static uint64_t next_random(uint64_t *state)
+{
+        *state ^= *state << 13;
+        *state ^= *state >> 7;
+        *state ^= *state << 17;
+        return *state;
+}
+
+/**
+ * fill_log - Write the synthetic log
+ * @transactions: Number of transactions
+ * @accounts: Number of distinct accounts
+ * Return: 1 on success, 0 on failure
+ */
+static int fill_log(long transactions, long accounts)
+{
+        Transaction tx;
+        uint64_t seed = 88172645463325252ULL;
+        char address[HASH_LENGTH + 1];
+        long i;
+
+        for (i = 0; i < accounts; i++)
+        {
+                sprintf(address, "%064lx", i + 1);
+                if (wal_intern_address(address) != (uint32_t)i)
+                        return 0;
+        }
+
+        /* The log only takes signed records; the scans never check them */
+        memset(&tx, 0, sizeof(tx));
+        tx.signature_type = TX_SIGNED_ED25519;
+        for (i = 0; i < transactions; i++)
+        {
+                tx.from_id = (uint32_t)(next_random(&seed) % accounts);
+                tx.to_id = (uint32_t)(next_random(&seed) % accounts);
+                tx.amount = (int64_t)(next_random(&seed) % (100 * MICRO_LT_PER_LT)) + 1;
+                tx.timestamp = 1700000000 + i;
+                tx.type = (uint8_t)(next_random(&seed) % (TOKEN_TRANSFER + 1));
+                if (!wal_append_transaction(&tx))
+                        return 0;
+        }
+        return 1;
+}
+
+/**
+ * row_scan - Current method: walk every log frame for one account
+ * @log: Mapped log
+ * @id: Account ID
+ * @totals: Receives the totals
+ */
+static void row_scan(TxLog *log, uint32_t id, TxTotals *totals)
+{
+        const Transaction *tx;
+        TxCursor cursor;
+
+        totals->sent = 0;
+        totals->received = 0;
+        txcursor_begin(&cursor, log);
+        while ((tx = txcursor_next_transaction(&cursor)))
+        {
+                if (tx->from_id == id)
+                        totals->sent += tx->amount;
+                if (tx->to_id == id)
+                        totals->received += tx->amount;
+        }
+}
+
+/**
+ * main - Run the benchmark
+ * @argc: Argument count
+ * @argv: Optional transaction, account and query counts
+ * Return: 0 on success, 1 on failure or mismatching totals
+ */
+int main(int argc, char **argv)
+{
+        static const struct
+        {
+                TxKernel kernel;
+                const char *name;
+        } kernels[] = {{TX_KERNEL_SCALAR, "columns/scalar"},
+                       {TX_KERNEL_SSE42, "columns/sse4.2"},
+                       {TX_KERNEL_AVX2, "columns/avx2"}};
+        long transactions = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_TRANSACTIONS;
+        long accounts = argc > 2 ? atol(argv[2]) : BENCH_DEFAULT_ACCOUNTS;
+        long queries = argc > 3 ? atol(argv[3]) : BENCH_DEFAULT_QUERIES;
+        char directory[] = "/tmp/bench_tx_scanXXXXXX";
+        TxColumns columns = {NULL, NULL, NULL, NULL, NULL, 0, 0, 0};
+        TxTotals *expected;
+        TxTotals totals;
+        TxFilter filter;
+        TxLog log;
+        FILE *config;
+        double start, elapsed, row_time;
+        size_t k;
+        long q;
+        int ok = 1;
+
+        if (transactions < 1 || accounts < 1 || queries < 1)
+        {
+                printf("Usage: %s [transactions] [accounts] [queries]\n", argv[0]);
+                return 1;
+        }
+
+        if (!mkdtemp(directory) || chdir(directory) != 0)
+        {
+                printf("Error: cannot create a scratch directory.\n");
+                return 1;
+        }
+
+        config = fopen("config.txt", "w");
+        if (!config)
+                return 1;
+        fprintf(config, "wal_durability=none\n");
+        fclose(config);
+
+        printf("Writing %ld transactions over %ld accounts...\n", transactions, accounts);
+        if (!wal_open() || !fill_log(transactions, accounts) || !txlog_map(&log))
+        {
+                printf("Error: cannot build the benchmark log.\n");
+                return 1;
+        }
+
+        expected = calloc(queries, sizeof(TxTotals));
+        if (!expected)
+                return 1;
+
+        start = now_seconds();
+        for (q = 0; q < queries; q++)
+                row_scan(&log, (uint32_t)(q % accounts), &expected[q]);
+        row_time = now_seconds() - start;
+        printf("\n%-16s %12s %12s\n", "method", "ms/query", "speedup");
+        printf("%-16s %12.3f %12.2f\n", "rows (log scan)", row_time * 1000 / queries, 1.0);
+
+        start = now_seconds();
+        if (!txcolumns_sync(&columns, &log))
+                return 1;
+        printf("%-16s %12.3f  (one-off)\n", "columns/build", (now_seconds() - start) * 1000);
+
+        for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+        {
+                if (!txkernel_select(kernels[k].kernel))
+                {
+                        printf("%-16s %12s\n", kernels[k].name, "unsupported");
+                        continue;
+                }
+
+                start = now_seconds();
+                for (q = 0; q < queries; q++)
+                {
+                        txfilter_init(&filter, (uint32_t)(q % accounts));
+                        if (!txcolumns_sum(&columns, &filter, &totals) ||
+                            totals.sent != expected[q].sent ||
+                            totals.received != expected[q].received)
+                                ok = 0;
+                }
+                elapsed = now_seconds() - start;
+                printf("%-16s %12.3f %12.2f\n", kernels[k].name, elapsed * 1000 / queries,
+                       row_time / elapsed);
+        }
+
+        printf("\nTotals %s across all methods.\n", ok ? "match" : "DO NOT match");
+
+        free(expected);
+        txcolumns_free(&columns);
+        txlog_unmap(&log);
+        wal_close();
+        release_config();
+        unlink(TX_FILE);
+        unlink("config.txt");
+        if (chdir("/") == 0)
+                rmdir(directory);
+        return ok ? 0 : 1;
+}
@@ -0,0 +1,446 @@
+/* block_store.c */
+#define _XOPEN_SOURCE 700
+#include "alu_blockchain.h"
+#include "config.h"
+
+/*
+ * Blocks live in fixed-size chunks indexed by height, so a block never
+ * moves once appended and block N is two array lookups away. A separate
+ * open-addressing table maps current_hash to height.
+ *
+ * Only block headers stay in memory for good. Bodies are allocated
+ * separately and, in pruning mode, appended to BLOCK_ARCHIVE_FILE and
+ * freed once a verified state snapshot covers them.
+ */
+
+#define ARCHIVE_MAGIC 0x52414c42u /* "BLAR" */
+
+/**
+ * struct ArchiveEntry - Header of one block body in BLOCK_ARCHIVE_FILE
+ * @magic: ARCHIVE_MAGIC
+ * @index: Height of the block
+ * @transaction_count: Number of Transaction records that follow
+ * @reserved: Always zero
+ * @merkle_root: Merkle root of the records, as in the block header
+ */
+typedef struct
+{
+        uint32_t magic;
+        uint32_t index;
+        int32_t transaction_count;
+        uint32_t reserved;
+        unsigned char merkle_root[SIGNATURE_LENGTH];
+} ArchiveEntry;
+
+/**
+ * hash_key - FNV-1a hash of a block hash string
+ * @hash: Hex block hash
+ * Return: 32-bit hash
+ */
+static uint32_t hash_key(const char *hash)
+{
+        uint32_t key = 2166136261u;
+
+        while (*hash)
+        {
+                key ^= (unsigned char)*hash++;
+                key *= 16777619u;
+        }
+        return key;
+}
+
+/**
+ * find_hash_slot - Find the slot holding @hash or the empty slot for it
+ * @chain: Blockchain with a non-empty hash table
+ * @hash: Block hash
+ * Return: Slot index
+ */
+static size_t find_hash_slot(const Blockchain *chain, const char *hash)
+{
+        size_t mask = chain->hash_slot_count - 1;
+        size_t i = hash_key(hash) & mask;
+        unsigned int slot;
+
+        while ((slot = chain->hash_slots[i]) &&
+               strcmp(get_block_by_index(chain, slot - 1)->current_hash, hash) != 0)
+                i = (i + 1) & mask;
+        return i;
+}
+
+/**
+ * grow_hash_index - Double the hash table and reinsert every block
+ * @chain: Blockchain
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int grow_hash_index(Blockchain *chain)
+{
+        unsigned int *old_slots = chain->hash_slots;
+        size_t old_count = chain->hash_slot_count;
+        size_t new_count = old_count ? old_count * 2 : 256;
+        unsigned int height;
+
+        chain->hash_slots = calloc(new_count, sizeof(unsigned int));
+        if (!chain->hash_slots)
+        {
+                chain->hash_slots = old_slots;
+                return 0;
+        }
+
+        chain->hash_slot_count = new_count;
+        for (height = 0; height < (unsigned int)chain->block_count; height++)
+                chain->hash_slots[find_hash_slot(chain, get_block_by_index(chain, height)->current_hash)] =
+                    height + 1;
+
+        free(old_slots);
+        return 1;
+}
+
+/**
+ * reserve_block - Make sure the next append cannot fail
+ * @chain: Blockchain
+ *
+ * Allocates the chunk and hash-table room for the next block ahead of
+ * time, so callers can reserve, log, then append without a failure path
+ * after the log write.
+ *
+ * Return: 1 on success, 0 on allocation failure
+ */
+int reserve_block(Blockchain *chain)
+{
+        size_t chunk = (size_t)chain->block_count / BLOCK_CHUNK_SIZE;
+        size_t capacity;
+        Block **grown;
+
+        if (chunk >= chain->chunk_capacity)
+        {
+                capacity = chain->chunk_capacity ? chain->chunk_capacity * 2 : 16;
+                grown = realloc(chain->chunks, capacity * sizeof(Block *));
+                if (!grown)
+                        return 0;
+                memset(grown + chain->chunk_capacity, 0,
+                       (capacity - chain->chunk_capacity) * sizeof(Block *));
+                chain->chunks = grown;
+                chain->chunk_capacity = capacity;
+        }
+
+        if (!chain->chunks[chunk])
+        {
+                chain->chunks[chunk] = calloc(BLOCK_CHUNK_SIZE, sizeof(Block));
+                if (!chain->chunks[chunk])
+                        return 0;
+        }
+
+        if (!time_index_reserve(&chain->block_times))
+                return 0;
+
+        /* Keep the hash table at most half full */
+        if (((size_t)chain->block_count + 1) * 2 > chain->hash_slot_count)
+                return grow_hash_index(chain);
+        return 1;
+}
+
+/**
+ * append_block - Copy a block onto the end of the chain
+ * @chain: Blockchain
+ * @block: Block whose index is the next height
+ * Return: The stored block, or NULL on failure
+ */
+Block *append_block(Blockchain *chain, const Block *block)
+{
+        Block *stored;
+        unsigned int height;
+
+        if (!chain || !block || block->index != (unsigned int)chain->block_count)
+                return NULL;
+        if (!reserve_block(chain))
+                return NULL;
+
+        height = (unsigned int)chain->block_count;
+        stored = &chain->chunks[height / BLOCK_CHUNK_SIZE][height % BLOCK_CHUNK_SIZE];
+        *stored = *block;
+
+        chain->block_count++;
+        chain->hash_slots[find_hash_slot(chain, stored->current_hash)] = height + 1;
+        time_index_add(&chain->block_times, stored->timestamp, height);
+
+        if (!chain->genesis)
+                chain->genesis = stored;
+        chain->latest = stored;
+        return stored;
+}
+
+/**
+ * get_block_by_index - Find a block by height
+ * @chain: Blockchain
+ * @index: Height, 0 for the genesis block
+ * Return: Block, or NULL if out of range
+ */
+Block *get_block_by_index(const Blockchain *chain, unsigned int index)
+{
+        if (!chain || index >= (unsigned int)chain->block_count || !chain->chunks)
+                return NULL;
+        return &chain->chunks[index / BLOCK_CHUNK_SIZE][index % BLOCK_CHUNK_SIZE];
+}
+
+/**
+ * get_block_by_hash - Find a block by its current_hash
+ * @chain: Blockchain
+ * @hash: Hex block hash
+ * Return: Block, or NULL if no block has that hash
+ */
+Block *get_block_by_hash(const Blockchain *chain, const char *hash)
+{
+        unsigned int slot;
+
+        if (!chain || !hash || !chain->hash_slot_count)
+                return NULL;
+
+        slot = chain->hash_slots[find_hash_slot(chain, hash)];
+        return slot ? get_block_by_index(chain, slot - 1) : NULL;
+}
+
+/**
+ * get_blocks_between - Heights of the blocks created in a time window
+ * @chain: Blockchain
+ * @start: First time included, in seconds since the epoch
+ * @end: First time excluded
+ * @first: Receives the lowest matching height
+ * @last: Receives the highest matching height
+ *
+ * Only the blocks the time index cannot rule out are looked at.
+ *
+ * Return: 1 if any block matches, 0 otherwise
+ */
+int get_blocks_between(const Blockchain *chain, int64_t start, int64_t end,
+                       unsigned int *first, unsigned int *last)
+{
+        const Block *block;
+        size_t height, scan_end;
+        int found = 0;
+
+        if (!chain || !first || !last)
+                return 0;
+
+        time_index_range(&chain->block_times, start, end, &height, &scan_end);
+        for (; height < scan_end; height++)
+        {
+                block = get_block_by_index(chain, (unsigned int)height);
+                if (block->timestamp < start || block->timestamp >= end)
+                        continue;
+                if (!found)
+                        *first = (unsigned int)height;
+                *last = (unsigned int)height;
+                found = 1;
+        }
+        return found;
+}
+
+/**
+ * compute_merkle_root - Merkle root of a block body
+ * @transactions: Transactions
+ * @count: Number of transactions
+ * @root: Output buffer of SIGNATURE_LENGTH bytes; all zero for no transactions
+ *
+ * Leaves are SHA-256 digests of the whole records, signatures included;
+ * an odd node at any level is paired with itself.
+ */
+void compute_merkle_root(const Transaction *transactions, int count, unsigned char *root)
+{
+        unsigned char (*level)[SIGNATURE_LENGTH];
+        unsigned char pair[2 * SIGNATURE_LENGTH];
+        int width, i;
+
+        memset(root, 0, SIGNATURE_LENGTH);
+        if (count <= 0)
+                return;
+
+        level = malloc((size_t)count * SIGNATURE_LENGTH);
+        if (!level)
+                return;
+
+        for (i = 0; i < count; i++)
+                EVP_Digest(&transactions[i], sizeof(Transaction), level[i], NULL, EVP_sha256(), NULL);
+
+        for (width = count; width > 1; width = (width + 1) / 2)
+        {
+                for (i = 0; i < width; i += 2)
+                {
+                        memcpy(pair, level[i], SIGNATURE_LENGTH);
+                        memcpy(pair + SIGNATURE_LENGTH, level[i + 1 < width ? i + 1 : i], SIGNATURE_LENGTH);
+                        EVP_Digest(pair, sizeof(pair), level[i / 2], NULL, EVP_sha256(), NULL);
+                }
+        }
+
+        memcpy(root, level[0], SIGNATURE_LENGTH);
+        free(level);
+}
+
+/**
+ * seal_block_body - Finish a block body once no more transactions are added
+ * @block: Block whose body holds transaction_count transactions
+ *
+ * Trims the body to its exact size and records its Merkle root.
+ */
+void seal_block_body(Block *block)
+{
+        Transaction *trimmed;
+
+        block->archive_offset = -1;
+        if (block->transaction_count <= 0)
+        {
+                free(block->transactions);
+                block->transactions = NULL;
+        }
+        else
+        {
+                trimmed = realloc(block->transactions,
+                                  (size_t)block->transaction_count * sizeof(Transaction));
+                if (trimmed)
+                        block->transactions = trimmed;
+        }
+        compute_merkle_root(block->transactions, block->transaction_count, block->merkle_root);
+}
+
+/**
+ * free_block_body - Release a block's resident body
+ * @block: Block
+ */
+void free_block_body(Block *block)
+{
+        free(block->transactions);
+        block->transactions = NULL;
+}
+
+/**
+ * archive_path - Path of BLOCK_ARCHIVE_FILE in the backup directory
+ * @path: Buffer of at least 512 bytes
+ * Return: 1 on success, 0 if there is no configuration
+ */
+static int archive_path(char *path)
+{
+        const Config *config = get_config();
+
+        if (!config)
+                return 0;
+        sprintf(path, "%s/%s", config->backup_directory, BLOCK_ARCHIVE_FILE);
+        return 1;
+}
+
+/**
+ * prune_blocks - Archive and free the bodies of blocks up to a height
+ * @chain: Blockchain
+ * @height: Last height to prune, normally that of a verified snapshot
+ *
+ * Bodies are appended to BLOCK_ARCHIVE_FILE and synced before any is
+ * freed, so a body is always either resident or safely archived.
+ *
+ * Return: 1 on success, 0 on failure (every body is then still resident)
+ */
+int prune_blocks(Blockchain *chain, unsigned int height)
+{
+        ArchiveEntry entry;
+        Block *block;
+        char path[512];
+        unsigned int h, first;
+        FILE *file;
+        long offset;
+        int ok = 1;
+
+        if (!chain || !archive_path(path))
+                return 0;
+        if (chain->pruned_count > height)
+                return 1;
+
+        file = fopen(path, "ab");
+        if (!file)
+                return 0;
+        fseek(file, 0, SEEK_END);
+
+        first = chain->pruned_count;
+        for (h = first; ok && h <= height && (block = get_block_by_index(chain, h)); h++)
+        {
+                if (!block->transactions || block->archive_offset >= 0)
+                        continue;
+
+                offset = ftell(file);
+                memset(&entry, 0, sizeof(entry));
+                entry.magic = ARCHIVE_MAGIC;
+                entry.index = block->index;
+                entry.transaction_count = block->transaction_count;
+                memcpy(entry.merkle_root, block->merkle_root, SIGNATURE_LENGTH);
+                ok = offset >= 0 && fwrite(&entry, sizeof(entry), 1, file) == 1 &&
+                     fwrite(block->transactions, sizeof(Transaction), block->transaction_count, file) ==
+                         (size_t)block->transaction_count;
+                block->archive_offset = offset;
+        }
+        ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+        ok = fclose(file) == 0 && ok;
+
+        /* Free only what is known to be on disk */
+        for (h = first; h <= height && (block = get_block_by_index(chain, h)); h++)
+        {
+                if (!block->transactions || block->archive_offset < 0)
+                        continue;
+                if (ok)
+                        free_block_body(block);
+                else
+                        block->archive_offset = -1;
+        }
+
+        if (ok)
+                chain->pruned_count = h;
+        return ok;
+}
+
+/**
+ * load_block_body - Read a block's body, from memory or the archive
+ * @block: Block with transactions
+ *
+ * Archived bodies are checked against the Merkle root in the header.
+ *
+ * Return: Newly allocated copy of the body (caller frees), or NULL if the
+ * block is empty or the body cannot be read or fails verification
+ */
+Transaction *load_block_body(const Block *block)
+{
+        ArchiveEntry entry;
+        Transaction *body;
+        unsigned char root[SIGNATURE_LENGTH];
+        char path[512];
+        FILE *file;
+        int ok;
+
+        if (!block || block->transaction_count <= 0 || block->transaction_count > MAX_TRANSACTIONS)
+                return NULL;
+
+        body = malloc((size_t)block->transaction_count * sizeof(Transaction));
+        if (!body)
+                return NULL;
+
+        if (block->transactions)
+        {
+                memcpy(body, block->transactions, (size_t)block->transaction_count * sizeof(Transaction));
+                return body;
+        }
+
+        file = block->archive_offset >= 0 && archive_path(path) ? fopen(path, "rb") : NULL;
+        ok = file && fseek(file, (long)block->archive_offset, SEEK_SET) == 0 &&
+             fread(&entry, sizeof(entry), 1, file) == 1 && entry.magic == ARCHIVE_MAGIC &&
+             entry.index == block->index && entry.transaction_count == block->transaction_count &&
+             fread(body, sizeof(Transaction), block->transaction_count, file) ==
+                 (size_t)block->transaction_count;
+        if (file)
+                fclose(file);
+
+        if (ok)
+        {
+                compute_merkle_root(body, block->transaction_count, root);
+                ok = memcmp(root, block->merkle_root, SIGNATURE_LENGTH) == 0;
+        }
+        if (!ok)
+        {
+                free(body);
+                return NULL;
+        }
+        return body;
+}
@@ -1,3 +1,3 @@
-rm -r ./backups ./wallets.dat ./transactions.dat ./txpool.dat ./kitchens.txt ./profiles.dat
-gcc -Wall -Werror -Wextra -pedantic -std=c99 main.c alu_blockchain.c config.c wallet.c profile.c -o alu_payment.exe -lssl -lcrypto
+rm -r ./backups ./wallets.dat ./wallets_v2.dat ./transactions.dat ./transactions.dat.migrating ./txpool.dat ./kitchens.txt ./profiles.dat ./profiles.journal
+gcc -Wall -Werror -Wextra -pedantic -std=c99 main.c alu_blockchain.c config.c wallet.c profile.c wal.c txlog.c address_book.c amount.c txcolumns.c block_store.c snapshot.c enroll.c vendor_registry.c settlement.c time_index.c export.c signature.c -o alu_payment.exe -lssl -lcrypto -pthread
 ./alu_payment.exe
\ No newline at end of file
@@ -1,6 +1,10 @@
 /* config.c */
+#define _XOPEN_SOURCE 700
 #include "alu_blockchain.h"
 #include "config.h"
+#include "wal.h"
+#include "legacy.h"
+#include <signal.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
@@ -9,6 +13,29 @@
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * struct ConfigSnapshot - Immutable configuration published to readers
+ * @config: Parsed and validated configuration values
+ * @mtime: Modification time of CONFIG_FILE when it was parsed
+ * @size: Size of CONFIG_FILE when it was parsed
+ * @retired: Next snapshot on the retired list
+ *
+ * Superseded snapshots are kept on the retired list rather than freed,
+ * so a pointer obtained from get_config() stays valid until the next
+ * config_poll(), which frees them, or release_config() at shutdown.
+ */
+typedef struct ConfigSnapshot
+{
+        Config config;
+        time_t mtime;
+        off_t size;
+        struct ConfigSnapshot *retired;
+} ConfigSnapshot;
+
+static ConfigSnapshot *active_snapshot = NULL;
+static ConfigSnapshot *retired_snapshots = NULL;
+static volatile sig_atomic_t reload_requested = 0;
+
 /**
  * create_default_config - Create default configuration file
  */
@@ -27,13 +54,183 @@ void create_default_config(void)
         fprintf(file, "backup_directory=./backups\n");
         fprintf(file, "auto_backup=1\n");
         fprintf(file, "backup_interval=10\n");
+        fprintf(file, "wal_durability=batched\n");
+        fprintf(file, "wal_batch_window_us=1000\n");
+        fprintf(file, "columnar_scan=1\n");
+        fprintf(file, "snapshot_interval=10\n");
+        fprintf(file, "block_pruning=0\n");
 
         fclose(file);
 }
 
+/**
+ * set_default_config - Fill a Config with the built-in defaults
+ * @config: Configuration to fill
+ */
+static void set_default_config(Config *config)
+{
+        config->initial_supply = INITIAL_SUPPLY;
+        config->circulating_supply = CIRCULATING_SUPPLY;
+        config->block_reward = BLOCK_REWARD;
+        config->max_transactions = 100;
+        strcpy(config->backup_directory, "./backups");
+        config->auto_backup = 1;
+        config->backup_interval = 10;
+        config->wal_durability = WAL_DURABILITY_BATCHED;
+        config->wal_batch_window_us = 1000;
+        config->columnar_scan = 1;
+        config->snapshot_interval = 10;
+        config->block_pruning = 0;
+}
+
+/**
+ * parse_config_number - Parse a non-negative decimal config value
+ * @value: Text after the '=' sign
+ * @out: Where to store the parsed number
+ * Return: 1 on success, 0 if the value is not a plain number
+ */
+static int parse_config_number(const char *value, long *out)
+{
+        char *end;
+        long number;
+
+        if (!value || !*value)
+                return 0;
+
+        number = strtol(value, &end, 10);
+        while (*end == ' ' || *end == '\t' || *end == '\r')
+                end++;
+        if (*end != '\0' || number < 0)
+                return 0;
+
+        *out = number;
+        return 1;
+}
+
+/**
+ * validate_config - Check that configuration values are usable
+ * @config: Configuration to check
+ * Return: 1 if valid, 0 otherwise
+ */
+int validate_config(const Config *config)
+{
+        if (!config)
+                return 0;
+
+        if (config->initial_supply == 0)
+        {
+                printf("Config: initial_supply must be greater than 0\n");
+                return 0;
+        }
+        if (config->block_reward == 0 || config->block_reward > config->initial_supply)
+        {
+                printf("Config: block_reward must be between 1 and initial_supply\n");
+                return 0;
+        }
+        if (config->max_transactions == 0 || config->max_transactions > MAX_TRANSACTIONS)
+        {
+                printf("Config: max_transactions must be between 1 and %d\n", MAX_TRANSACTIONS);
+                return 0;
+        }
+        if (config->backup_directory[0] == '\0')
+        {
+                printf("Config: backup_directory must not be empty\n");
+                return 0;
+        }
+        if (config->auto_backup != 0 && config->auto_backup != 1)
+        {
+                printf("Config: auto_backup must be 0 or 1\n");
+                return 0;
+        }
+        if (config->backup_interval < 1)
+        {
+                printf("Config: backup_interval must be at least 1\n");
+                return 0;
+        }
+        if (config->wal_batch_window_us > 1000000)
+        {
+                printf("Config: wal_batch_window_us must not exceed 1000000\n");
+                return 0;
+        }
+        if (config->columnar_scan != 0 && config->columnar_scan != 1)
+        {
+                printf("Config: columnar_scan must be 0 or 1\n");
+                return 0;
+        }
+        if (config->block_pruning != 0 && config->block_pruning != 1)
+        {
+                printf("Config: block_pruning must be 0 or 1\n");
+                return 0;
+        }
+
+        return 1;
+}
+
+/**
+ * struct ConfigNumber - Numeric setting and the Config field it fills
+ * @key: Key in CONFIG_FILE
+ * @offset: Offset of the field in Config
+ * @is_signed: 1 if the field is an int, 0 if it is an unsigned int
+ */
+typedef struct
+{
+        const char *key;
+        size_t offset;
+        int is_signed;
+} ConfigNumber;
+
+static const ConfigNumber config_numbers[] = {
+        {"initial_supply", offsetof(Config, initial_supply), 0},
+        {"block_reward", offsetof(Config, block_reward), 0},
+        {"max_transactions", offsetof(Config, max_transactions), 0},
+        {"auto_backup", offsetof(Config, auto_backup), 1},
+        {"backup_interval", offsetof(Config, backup_interval), 1},
+        {"wal_batch_window_us", offsetof(Config, wal_batch_window_us), 0},
+        {"columnar_scan", offsetof(Config, columnar_scan), 1},
+        {"snapshot_interval", offsetof(Config, snapshot_interval), 0},
+        {"block_pruning", offsetof(Config, block_pruning), 1}
+};
+
+/**
+ * find_number_key - Look up a numeric setting
+ * @key: Key read from the config file
+ * Return: The setting, or NULL if @key is not a numeric setting
+ */
+static const ConfigNumber *find_number_key(const char *key)
+{
+        size_t i;
+
+        for (i = 0; i < sizeof(config_numbers) / sizeof(config_numbers[0]); i++)
+        {
+                if (strcmp(key, config_numbers[i].key) == 0)
+                        return &config_numbers[i];
+        }
+        return NULL;
+}
+
+/**
+ * set_config_number - Store a parsed number in the field of a setting
+ * @config: Configuration to update
+ * @setting: Numeric setting
+ * @number: Parsed value
+ */
+static void set_config_number(Config *config, const ConfigNumber *setting, long number)
+{
+        char *field = (char *)config + setting->offset;
+
+        if (setting->is_signed)
+                *(int *)field = (int)number;
+        else
+                *(unsigned int *)field = (unsigned int)number;
+}
+
 /**
  * load_config - Load configuration from file
- * Return: Config structure or NULL on failure
+ *
+ * Parses CONFIG_FILE into a freshly allocated Config. Most callers want
+ * get_config() instead, which returns the cached snapshot.
+ *
+ * Return: Config structure (caller frees) or NULL on failure
  */
 Config *load_config(void)
 {
@@ -41,19 +238,16 @@ Config *load_config(void)
         Config *config;
         char line[256];
         char *value;
+        const ConfigNumber *setting;
+        long number;
+        int valid = 1;
 
         config = malloc(sizeof(Config));
         if (!config)
                 return NULL;
 
         /* Set default values */
-        config->initial_supply = INITIAL_SUPPLY;
-        config->circulating_supply = CIRCULATING_SUPPLY;
-        config->block_reward = BLOCK_REWARD;
-        config->max_transactions = 100;
-        strcpy(config->backup_directory, "./backups");
-        config->auto_backup = 1;
-        config->backup_interval = 10;
+        set_default_config(config);
 
         file = fopen(CONFIG_FILE, "r");
         if (!file)
@@ -64,37 +258,252 @@ Config *load_config(void)
 
         while (fgets(line, sizeof(line), file))
         {
+                /* Remove line ending (LF or CRLF) */
+                line[strcspn(line, "\r\n")] = 0;
+
                 /* Skip comments and empty lines */
-                if (line[0] == '#' || line[0] == '\n')
+                if (line[0] == '#' || line[0] == '\0')
                         continue;
 
-                /* Remove newline */
-                line[strcspn(line, "\n")] = 0;
-
                 value = strchr(line, '=');
                 if (!value)
                         continue;
                 *value = '\0';
                 value++;
 
-                if (strcmp(line, "initial_supply") == 0)
-                        config->initial_supply = (unsigned int)atoi(value);
-                else if (strcmp(line, "block_reward") == 0)
-                        config->block_reward = (unsigned int)atoi(value);
-                else if (strcmp(line, "max_transactions") == 0)
-                        config->max_transactions = (unsigned int)atoi(value);
-                else if (strcmp(line, "backup_directory") == 0)
+                if (strcmp(line, "backup_directory") == 0)
+                {
                         strncpy(config->backup_directory, value, 255);
-                else if (strcmp(line, "auto_backup") == 0)
-                        config->auto_backup = atoi(value);
-                else if (strcmp(line, "backup_interval") == 0)
-                        config->backup_interval = atoi(value);
+                        config->backup_directory[255] = '\0';
+                        continue;
+                }
+
+                if (strcmp(line, "wal_durability") == 0)
+                {
+                        if (strcmp(value, "none") == 0)
+                                config->wal_durability = WAL_DURABILITY_NONE;
+                        else if (strcmp(value, "batched") == 0)
+                                config->wal_durability = WAL_DURABILITY_BATCHED;
+                        else if (strcmp(value, "per-transaction") == 0)
+                                config->wal_durability = WAL_DURABILITY_PER_TX;
+                        else
+                        {
+                                printf("Config: wal_durability must be none, batched or per-transaction\n");
+                                valid = 0;
+                        }
+                        continue;
+                }
+
+                setting = find_number_key(line);
+                if (!setting)
+                {
+                        printf("Config: ignoring unknown key '%s'\n", line);
+                        continue;
+                }
+
+                if (!parse_config_number(value, &number))
+                {
+                        printf("Config: invalid value for %s: '%s'\n", line, value);
+                        valid = 0;
+                        continue;
+                }
+                set_config_number(config, setting, number);
         }
 
         fclose(file);
+
+        if (!valid || !validate_config(config))
+        {
+                free(config);
+                return NULL;
+        }
+
         return config;
 }
 
+/**
+ * publish_config - Make a copy of @config the active snapshot
+ * @config: Validated configuration to publish
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int publish_config(const Config *config)
+{
+        ConfigSnapshot *snapshot;
+        struct stat st;
+
+        snapshot = malloc(sizeof(ConfigSnapshot));
+        if (!snapshot)
+                return 0;
+
+        snapshot->config = *config;
+        if (stat(CONFIG_FILE, &st) == 0)
+        {
+                snapshot->mtime = st.st_mtime;
+                snapshot->size = st.st_size;
+        }
+        else
+        {
+                snapshot->mtime = 0;
+                snapshot->size = 0;
+        }
+
+        snapshot->retired = NULL;
+        if (active_snapshot)
+        {
+                active_snapshot->retired = retired_snapshots;
+                retired_snapshots = active_snapshot;
+        }
+
+        /* Readers only ever see a fully initialised snapshot */
+        __atomic_store_n(&active_snapshot, snapshot, __ATOMIC_RELEASE);
+        return 1;
+}
+
+/**
+ * get_config - Get the process-wide configuration snapshot
+ *
+ * The first call parses CONFIG_FILE; later calls are a pointer load.
+ * The snapshot is immutable and is only replaced by reload_config(),
+ * which runs when SIGHUP was received or config_poll() saw the file change.
+ *
+ * Return: Active configuration, or NULL if memory is exhausted
+ */
+const Config *get_config(void)
+{
+        ConfigSnapshot *snapshot;
+        Config *config;
+        Config defaults;
+
+        if (reload_requested)
+        {
+                reload_requested = 0;
+                reload_config();
+        }
+
+        snapshot = __atomic_load_n(&active_snapshot, __ATOMIC_ACQUIRE);
+        if (snapshot)
+                return &snapshot->config;
+
+        config = load_config();
+        if (config)
+        {
+                publish_config(config);
+                free(config);
+        }
+        else
+        {
+                /* Unusable config file: run on the built-in defaults */
+                printf("Config: using built-in defaults\n");
+                set_default_config(&defaults);
+                publish_config(&defaults);
+        }
+
+        return active_snapshot ? &active_snapshot->config : NULL;
+}
+
+/**
+ * reload_config - Re-parse CONFIG_FILE and swap in the new snapshot
+ * Return: 1 if the new configuration is active, 0 if it was rejected
+ */
+int reload_config(void)
+{
+        Config *config;
+        int published;
+
+        config = load_config();
+        if (!config)
+        {
+                printf("Config: reload rejected, keeping previous settings\n");
+                return 0;
+        }
+
+        published = publish_config(config);
+        free(config);
+        if (published)
+                printf("Config: reloaded %s\n", CONFIG_FILE);
+        return published;
+}
+
+/**
+ * free_retired_snapshots - Free the snapshots superseded by reloads
+ */
+static void free_retired_snapshots(void)
+{
+        ConfigSnapshot *snapshot;
+        ConfigSnapshot *next;
+
+        for (snapshot = retired_snapshots; snapshot; snapshot = next)
+        {
+                next = snapshot->retired;
+                free(snapshot);
+        }
+        retired_snapshots = NULL;
+}
+
+/**
+ * config_poll - Reload the configuration if CONFIG_FILE changed on disk
+ *
+ * Costs one stat() call; intended to be called once per menu iteration
+ * rather than on every configuration read. Also services a pending SIGHUP.
+ *
+ * Callers hold no pointer from get_config() here, so the snapshots
+ * retired since the last poll are freed first.
+ */
+void config_poll(void)
+{
+        struct stat st;
+        ConfigSnapshot *snapshot = active_snapshot;
+
+        free_retired_snapshots();
+
+        if (reload_requested)
+        {
+                reload_requested = 0;
+                reload_config();
+                return;
+        }
+
+        if (!snapshot || stat(CONFIG_FILE, &st) != 0)
+                return;
+
+        if (st.st_mtime != snapshot->mtime || st.st_size != snapshot->size)
+                reload_config();
+}
+
+/**
+ * handle_reload_signal - SIGHUP handler; defers the reload to get_config()
+ * @signum: Signal number (unused)
+ */
+static void handle_reload_signal(int signum)
+{
+        (void)signum;
+        reload_requested = 1;
+}
+
+/**
+ * install_config_reload_handler - Reload the configuration on SIGHUP
+ */
+void install_config_reload_handler(void)
+{
+        struct sigaction action;
+
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = handle_reload_signal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        sigaction(SIGHUP, &action, NULL);
+}
+
+/**
+ * release_config - Free the active and all retired snapshots
+ */
+void release_config(void)
+{
+        free(active_snapshot);
+        active_snapshot = NULL;
+        free_retired_snapshots();
+}
+
 /**
  * save_config - Save configuration to file
  * @config: Configuration to save
@@ -117,6 +526,14 @@ void save_config(Config *config)
         fprintf(file, "backup_directory=%s\n", config->backup_directory);
         fprintf(file, "auto_backup=%d\n", config->auto_backup);
         fprintf(file, "backup_interval=%d\n", config->backup_interval);
+        fprintf(file, "wal_durability=%s\n",
+                config->wal_durability == WAL_DURABILITY_NONE     ? "none"
+                : config->wal_durability == WAL_DURABILITY_PER_TX ? "per-transaction"
+                                                                  : "batched");
+        fprintf(file, "wal_batch_window_us=%u\n", config->wal_batch_window_us);
+        fprintf(file, "columnar_scan=%d\n", config->columnar_scan);
+        fprintf(file, "snapshot_interval=%u\n", config->snapshot_interval);
+        fprintf(file, "block_pruning=%d\n", config->block_pruning);
 
         fclose(file);
 }
@@ -130,15 +547,17 @@ int backup_blockchain(const Blockchain *chain)
 {
         FILE *file;
         Block *current;
+        BackupHeader header;
+        unsigned int height;
         char backup_path[512];
         time_t now;
         struct tm *timeinfo;
-        Config *config;
+        const Config *config;
 
         if (!chain)
                 return 0;
 
-        config = load_config();
+        config = get_config();
         if (!config)
                 return 0;
 
@@ -159,28 +578,170 @@ int backup_blockchain(const Blockchain *chain)
 
         file = fopen(backup_path, "wb");
         if (!file)
-        {
-                free(config);
                 return 0;
-        }
 
         /* Write blockchain metadata */
+        memset(&header, 0, sizeof(header));
+        header.magic = BACKUP_MAGIC;
+        header.version = BACKUP_VERSION;
+        header.block_size = BLOCK_HEADER_SIZE;
+        fwrite(&header, sizeof(header), 1, file);
         fwrite(&chain->block_count, sizeof(int), 1, file);
         fwrite(&chain->token, sizeof(Token), 1, file);
 
-        /* Write all blocks */
-        current = chain->genesis;
-        while (current)
+        /* Write every header; archived bodies stay in the block archive */
+        for (height = 0; (current = get_block_by_index(chain, height)); height++)
         {
-                fwrite(current, sizeof(Block), 1, file);
-                current = current->next;
+                fwrite(current, BLOCK_HEADER_SIZE, 1, file);
+                if (current->transactions)
+                        fwrite(current->transactions, sizeof(Transaction), current->transaction_count, file);
         }
 
         fclose(file);
-        free(config);
         return 1;
 }
 
+/**
+ * block_time_from_text - Set a block's time from an older backup's text
+ * @text: Timestamp field of TIME_TEXT_SIZE bytes, "%Y-%m-%d %H:%M:%S"
+ * @block: Block to set
+ * Return: 1 on success, 0 if the text is not a block time
+ */
+static int block_time_from_text(const char *text, Block *block)
+{
+        char copy[TIME_TEXT_SIZE + 1];
+
+        memcpy(copy, text, TIME_TEXT_SIZE);
+        copy[TIME_TEXT_SIZE] = '\0';
+        return parse_block_time(copy, &block->timestamp, &block->utc_offset);
+}
+
+/**
+ * block_from_legacy - Convert a block from a pre-compact backup
+ * @legacy: Block in the old layout
+ * @block: Block to fill
+ *
+ * Addresses are interned through the transaction log, so it must be open.
+ *
+ * Return: 1 on success, 0 on failure
+ */
+static int block_from_legacy(LegacyBlock *legacy, Block *block)
+{
+        LegacyTransaction *old;
+        uint32_t from_id, to_id;
+        int i;
+
+        memset(block, 0, sizeof(Block));
+        block->index = legacy->index;
+        memcpy(block->previous_hash, legacy->previous_hash, sizeof(block->previous_hash));
+        block->nonce = legacy->nonce;
+        memcpy(block->current_hash, legacy->current_hash, sizeof(block->current_hash));
+        block->reward = legacy->reward;
+
+        if (!block_time_from_text(legacy->timestamp, block) ||
+            legacy->transaction_count < 0 || legacy->transaction_count > MAX_TRANSACTIONS)
+                return 0;
+        block->transactions = calloc(MAX_TRANSACTIONS, sizeof(Transaction));
+        if (!block->transactions)
+                return 0;
+
+        for (i = 0; i < legacy->transaction_count; i++)
+        {
+                old = &legacy->transactions[i];
+                old->from_address[HASH_LENGTH] = '\0';
+                old->to_address[HASH_LENGTH] = '\0';
+
+                /* Old genesis blocks count one blank transaction; it moved nothing */
+                if (!old->from_address[0] || !old->to_address[0])
+                        continue;
+
+                from_id = wal_intern_address(old->from_address);
+                to_id = wal_intern_address(old->to_address);
+                if (from_id == ADDRESS_ID_NONE || to_id == ADDRESS_ID_NONE)
+                {
+                        free_block_body(block);
+                        return 0;
+                }
+                transaction_from_legacy(old, from_id, to_id,
+                                        &block->transactions[block->transaction_count++]);
+        }
+        seal_block_body(block);
+        return 1;
+}
+
+/**
+ * read_block_body - Read the body that follows a block header in a backup
+ * @file: Backup file, positioned after the header
+ * @block: Block whose header has been read
+ * Return: 1 on success, 0 on failure
+ */
+static int read_block_body(FILE *file, Block *block)
+{
+        if (block->transaction_count < 0 || block->transaction_count > MAX_TRANSACTIONS)
+                return 0;
+
+        /* Archived bodies are loaded on demand by load_block_body() */
+        block->transactions = NULL;
+        if (block->archive_offset >= 0 || block->transaction_count == 0)
+                return 1;
+
+        block->transactions = malloc((size_t)block->transaction_count * sizeof(Transaction));
+        if (!block->transactions ||
+            fread(block->transactions, sizeof(Transaction), block->transaction_count, file) !=
+                (size_t)block->transaction_count)
+        {
+                free_block_body(block);
+                return 0;
+        }
+        return 1;
+}
+
+/**
+ * read_block - Read a block header and its body from a current backup
+ * @file: Backup file
+ * @block: Block to fill
+ * Return: 1 on success, 0 on failure
+ */
+static int read_block(FILE *file, Block *block)
+{
+        memset(block, 0, sizeof(Block));
+        if (fread(block, BLOCK_HEADER_SIZE, 1, file) != 1)
+                return 0;
+        return read_block_body(file, block);
+}
+
+/**
+ * backup_block_size - On-disk block size of a backup version
+ * @version: Backup version, 0 for backups without a header
+ * Return: Size in bytes, or 0 if the version is not supported
+ */
+static size_t backup_block_size(uint32_t version)
+{
+        if (version == 0)
+                return sizeof(LegacyBlock);
+        if (version == BACKUP_VERSION)
+                return BLOCK_HEADER_SIZE;
+        return 0;
+}
+
+/**
+ * read_backup_block - Read the next block from a backup file
+ * @file: Backup file
+ * @version: Backup version, 0 for backups without a header
+ * @scratch: Buffer of backup_block_size(@version) bytes
+ * @block: Block to fill; the caller owns its body on success
+ * Return: 1 on success, 0 on failure
+ */
+static int read_backup_block(FILE *file, uint32_t version, void *scratch, Block *block)
+{
+        if (version == BACKUP_VERSION)
+                return read_block(file, block);
+
+        if (fread(scratch, sizeof(LegacyBlock), 1, file) != 1)
+                return 0;
+        return block_from_legacy(scratch, block);
+}
+
 /**
  * restore_blockchain - Restore blockchain from backup
  * @chain: Pointer to blockchain pointer
@@ -189,11 +750,13 @@ int backup_blockchain(const Blockchain *chain)
 int restore_blockchain(Blockchain **chain)
 {
         FILE *file;
-        Block *current;
-        Block *next;
+        Blockchain *restored;
+        Block *scratch;
+        BackupHeader header;
         int block_count;
         int i;
-        Config *config;
+        int ok = 1;
+        const Config *config;
         char latest_backup[512] = {0};
         DIR *dir;
         struct dirent *entry;
@@ -201,17 +764,14 @@ int restore_blockchain(Blockchain **chain)
         char backup_path[512];
         struct stat st;
 
-        config = load_config();
+        config = get_config();
         if (!config)
                 return 0;
 
         /* Find latest backup file */
         dir = opendir(config->backup_directory);
         if (!dir)
-        {
-                free(config);
                 return 0;
-        }
 
         while ((entry = readdir(dir)))
         {
@@ -231,77 +791,73 @@ int restore_blockchain(Blockchain **chain)
         closedir(dir);
 
         if (!latest_backup[0])
-        {
-                free(config);
                 return 0;
-        }
 
         file = fopen(latest_backup, "rb");
         if (!file)
+                return 0;
+
+        /* Backups without a header hold blocks in the original layout */
+        if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != BACKUP_MAGIC)
         {
-                free(config);
+                memset(&header, 0, sizeof(header));
+                header.block_size = sizeof(LegacyBlock);
+                rewind(file);
+        }
+
+        if (!backup_block_size(header.version) || header.block_size != backup_block_size(header.version))
+        {
+                printf("Error: backup %s was written by an unsupported version.\n", latest_backup);
+                fclose(file);
                 return 0;
         }
+        if (header.version != BACKUP_VERSION)
+                printf("Converting backup %s to the current block format.\n", latest_backup);
 
-        /* Free existing blockchain if any */
-        if (*chain)
+        /* The scratch block also holds an older layout while converting */
+        scratch = malloc(sizeof(Block) + backup_block_size(header.version));
+        if (!scratch)
         {
-                current = (*chain)->genesis;
-                while (current)
-                {
-                        next = current->next;
-                        free(current);
-                        current = next;
-                }
-                free(*chain);
+                fclose(file);
+                return 0;
         }
 
-        /* Create new blockchain */
-        *chain = malloc(sizeof(Blockchain));
-        if (!*chain)
+        /* Build the new chain aside so a bad backup leaves the current one intact */
+        restored = calloc(1, sizeof(Blockchain));
+        if (!restored)
         {
+                free(scratch);
                 fclose(file);
-                free(config);
                 return 0;
         }
 
         /* Read blockchain metadata */
-        fread(&block_count, sizeof(int), 1, file);
-        fread(&(*chain)->token, sizeof(Token), 1, file);
+        if (fread(&block_count, sizeof(int), 1, file) != 1 ||
+            fread(&restored->token, sizeof(Token), 1, file) != 1)
+                block_count = -1;
 
         /* Read all blocks */
-        (*chain)->genesis = NULL;
-        (*chain)->latest = NULL;
-        (*chain)->block_count = 0;
-
-        for (i = 0; i < block_count; i++)
+        for (i = 0; ok && i < block_count; i++)
         {
-                current = malloc(sizeof(Block));
-                if (!current)
+                ok = read_backup_block(file, header.version, scratch + 1, scratch);
+                if (ok && !append_block(restored, scratch))
                 {
-                        fclose(file);
-                        free(config);
-                        /* TODO: Cleanup partial blockchain */
-                        return 0;
+                        free_block_body(scratch);
+                        ok = 0;
                 }
+        }
 
-                fread(current, sizeof(Block), 1, file);
-                current->next = NULL;
+        free(scratch);
+        fclose(file);
 
-                if (!(*chain)->genesis)
-                {
-                        (*chain)->genesis = current;
-                        (*chain)->latest = current;
-                }
-                else
-                {
-                        (*chain)->latest->next = current;
-                        (*chain)->latest = current;
-                }
-                (*chain)->block_count++;
+        if (!ok || block_count < 1)
+        {
+                printf("Error: backup %s is incomplete.\n", latest_backup);
+                cleanup_blockchain(restored);
+                return 0;
         }
 
-        fclose(file);
-        free(config);
+        cleanup_blockchain(*chain);
+        *chain = restored;
         return 1;
-}
\ No newline at end of file
+}
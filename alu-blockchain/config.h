@@ -3,6 +3,7 @@
 #define CONFIG_H
 
 #include "alu_blockchain.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +13,16 @@
 
 #define CONFIG_FILE "config.txt"
 #define BACKUP_FILE "blockchain_backup.dat"
+#define BACKUP_MAGIC 0x4b42554cu /* "LUBK" */
+#define BACKUP_VERSION 1
+
+/* Transaction log durability (wal_durability in CONFIG_FILE) */
+typedef enum
+{
+        WAL_DURABILITY_NONE,
+        WAL_DURABILITY_BATCHED,
+        WAL_DURABILITY_PER_TX
+} WalDurability;
 
 typedef struct
 {
@@ -22,9 +33,36 @@ typedef struct
         char backup_directory[256];
         int auto_backup;
         int backup_interval;
+        WalDurability wal_durability;
+        unsigned int wal_batch_window_us;
+        int columnar_scan;
+        unsigned int snapshot_interval;
+        int block_pruning;
 } Config;
 
+/**
+ * struct BackupHeader - First bytes of a backup file
+ * @magic: BACKUP_MAGIC; backups written before it existed start with the
+ *         block count instead
+ * @version: BACKUP_VERSION
+ * @block_size: On-disk size of one block header
+ * @reserved: Always zero
+ */
+typedef struct
+{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t block_size;
+        uint32_t reserved;
+} BackupHeader;
+
 Config *load_config(void);
+const Config *get_config(void);
+int reload_config(void);
+void config_poll(void);
+int validate_config(const Config *config);
+void install_config_reload_handler(void);
+void release_config(void);
 void save_config(Config *config);
 int backup_blockchain(const Blockchain *chain);
 int restore_blockchain(Blockchain **chain);
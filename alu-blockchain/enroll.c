@@ -0,0 +1,482 @@
+/* enroll.c */
+#define _XOPEN_SOURCE 700
+#include "alu_blockchain.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+/*
+ * Bulk enrollment creates student and staff wallets from a CSV of emails in
+ * one pass: existing emails are read once into a hash set, duplicates are
+ * dropped in memory, the wallet key pairs are generated on several threads,
+ * and the wallet and profile files are each written once for the whole batch.
+ */
+
+#define ENROLL_MAX_THREADS 8
+#define ENROLL_LINE_SIZE 512
+#define EMAIL_SET_MIN_SLOTS 1024
+
+/**
+ * struct EmailSet - Emails with an open-addressing index
+ * @emails: Emails in insertion order
+ * @count: Number of emails
+ * @capacity: Allocated length of @emails
+ * @slots: Index into @emails plus one, 0 for an empty slot
+ * @slot_count: Number of slots, a power of two
+ */
+typedef struct
+{
+        char (*emails)[MAX_EMAIL];
+        size_t count;
+        size_t capacity;
+        uint32_t *slots;
+        size_t slot_count;
+} EmailSet;
+
+/**
+ * struct EnrollWorker - Range of wallets one thread derives keys for
+ * @wallets: Batch of wallets with their emails filled in
+ * @begin: First wallet of the range
+ * @end: One past the last wallet of the range
+ * @failed: Set if a key pair could not be generated
+ */
+typedef struct
+{
+        StoredWallet *wallets;
+        size_t begin;
+        size_t end;
+        int failed;
+} EnrollWorker;
+
+/**
+ * email_hash - FNV-1a hash of an email
+ * @email: Email
+ * Return: Hash
+ */
+static uint32_t email_hash(const char *email)
+{
+        uint32_t hash = 2166136261u;
+
+        while (*email)
+        {
+                hash ^= (unsigned char)*email++;
+                hash *= 16777619u;
+        }
+        return hash;
+}
+
+/**
+ * email_set_grow - Double the slot table and reinsert every email
+ * @set: Email set
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int email_set_grow(EmailSet *set)
+{
+        size_t slot_count = set->slot_count ? set->slot_count * 2 : EMAIL_SET_MIN_SLOTS;
+        size_t i, slot;
+        uint32_t *slots;
+
+        slots = calloc(slot_count, sizeof(uint32_t));
+        if (!slots)
+                return 0;
+
+        for (i = 0; i < set->count; i++)
+        {
+                slot = email_hash(set->emails[i]) & (slot_count - 1);
+                while (slots[slot])
+                        slot = (slot + 1) & (slot_count - 1);
+                slots[slot] = (uint32_t)(i + 1);
+        }
+
+        free(set->slots);
+        set->slots = slots;
+        set->slot_count = slot_count;
+        return 1;
+}
+
+/**
+ * email_set_add - Add an email unless it is already present
+ * @set: Email set
+ * @email: Email, shorter than MAX_EMAIL
+ * Return: 1 if added, 0 if already present, -1 on allocation failure
+ */
+static int email_set_add(EmailSet *set, const char *email)
+{
+        char (*emails)[MAX_EMAIL];
+        size_t slot;
+
+        /* Keep the load factor at or below one half */
+        if ((set->count + 1) * 2 > set->slot_count && !email_set_grow(set))
+                return -1;
+
+        slot = email_hash(email) & (set->slot_count - 1);
+        while (set->slots[slot])
+        {
+                if (strcmp(set->emails[set->slots[slot] - 1], email) == 0)
+                        return 0;
+                slot = (slot + 1) & (set->slot_count - 1);
+        }
+
+        if (set->count == set->capacity)
+        {
+                emails = realloc(set->emails, (set->capacity ? set->capacity * 2 : 256) * MAX_EMAIL);
+                if (!emails)
+                        return -1;
+                set->emails = emails;
+                set->capacity = set->capacity ? set->capacity * 2 : 256;
+        }
+
+        strcpy(set->emails[set->count], email);
+        set->slots[slot] = (uint32_t)(++set->count);
+        return 1;
+}
+
+/**
+ * email_set_free - Release an email set
+ * @set: Email set
+ */
+static void email_set_free(EmailSet *set)
+{
+        free(set->emails);
+        free(set->slots);
+        memset(set, 0, sizeof(*set));
+}
+
+/**
+ * load_registered_emails - Add every email in WALLETS_FILE to a set
+ * @set: Email set
+ * Return: 1 on success or if there are no wallets yet, 0 on failure
+ */
+static int load_registered_emails(EmailSet *set)
+{
+        StoredWallet *chunk;
+        size_t n, i;
+        FILE *file;
+        int ok = 1;
+
+        file = fopen(WALLETS_FILE, "rb");
+        if (!file)
+                return 1;
+
+        chunk = malloc(256 * sizeof(StoredWallet));
+        if (!chunk)
+        {
+                fclose(file);
+                return 0;
+        }
+
+        while (ok && (n = fread(chunk, sizeof(StoredWallet), 256, file)) > 0)
+        {
+                for (i = 0; ok && i < n; i++)
+                {
+                        chunk[i].email[MAX_EMAIL - 1] = '\0';
+                        ok = email_set_add(set, chunk[i].email) >= 0;
+                }
+        }
+
+        free(chunk);
+        fclose(file);
+        return ok;
+}
+
+/**
+ * parse_enroll_line - Extract the email from one CSV line
+ * @line: Line; the email is the first field
+ * @email: Output buffer of MAX_EMAIL bytes
+ *
+ * Surrounding whitespace and double quotes are removed.
+ *
+ * Return: 1 if the line holds an email, 0 if it is blank, -1 if the first
+ * field is not an email (no '@', or too long to be one)
+ */
+int parse_enroll_line(const char *line, char *email)
+{
+        const char *start = line;
+        const char *end;
+
+        while (isspace((unsigned char)*start) || *start == '"')
+                start++;
+        end = start;
+        while (*end && *end != ',' && *end != '\n' && *end != '\r')
+                end++;
+        while (end > start && (isspace((unsigned char)end[-1]) || end[-1] == '"'))
+                end--;
+
+        if (end == start)
+                return 0;
+        if (!memchr(start, '@', end - start) || end - start >= MAX_EMAIL)
+                return -1;
+
+        memcpy(email, start, end - start);
+        email[end - start] = '\0';
+        return 1;
+}
+
+/**
+ * key_wallets - Generate the key pair of each wallet in a range
+ * @arg: EnrollWorker
+ * Return: NULL
+ */
+static void *key_wallets(void *arg)
+{
+        EnrollWorker *worker = arg;
+        StoredWallet *wallet;
+        size_t i;
+
+        for (i = worker->begin; i < worker->end && !worker->failed; i++)
+        {
+                wallet = &worker->wallets[i];
+                worker->failed = !generate_wallet_keys(wallet->address, wallet->private_key);
+        }
+        return NULL;
+}
+
+/**
+ * key_wallets_parallel - Run key_wallets() over a batch on several threads
+ * @wallets: Batch of wallets
+ * @count: Number of wallets
+ *
+ * Falls back to the calling thread for any range a thread cannot be
+ * started for.
+ *
+ * Return: 1 on success, 0 if a key pair could not be generated
+ */
+static int key_wallets_parallel(StoredWallet *wallets, size_t count)
+{
+        EnrollWorker workers[ENROLL_MAX_THREADS];
+        pthread_t threads[ENROLL_MAX_THREADS];
+        int started[ENROLL_MAX_THREADS];
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        size_t thread_count, t;
+        int ok = 1;
+
+        thread_count = cpus < 1 ? 1 : (size_t)cpus;
+        if (thread_count > ENROLL_MAX_THREADS)
+                thread_count = ENROLL_MAX_THREADS;
+        if (thread_count > count)
+                thread_count = count ? count : 1;
+
+        for (t = 0; t < thread_count; t++)
+        {
+                workers[t].wallets = wallets;
+                workers[t].begin = count * t / thread_count;
+                workers[t].end = count * (t + 1) / thread_count;
+                workers[t].failed = 0;
+                started[t] = t > 0 && pthread_create(&threads[t], NULL, key_wallets, &workers[t]) == 0;
+        }
+
+        /* The calling thread takes the first range and any that failed to start */
+        for (t = 0; t < thread_count; t++)
+        {
+                if (!started[t])
+                        key_wallets(&workers[t]);
+        }
+        for (t = 0; t < thread_count; t++)
+        {
+                if (started[t])
+                        pthread_join(threads[t], NULL);
+                if (workers[t].failed)
+                        ok = 0;
+        }
+        return ok;
+}
+
+/**
+ * append_wallets - Append a batch of wallets to WALLETS_FILE in one write
+ * @wallets: Batch of wallets
+ * @count: Number of wallets
+ * Return: 1 on success, 0 on failure
+ */
+static int append_wallets(const StoredWallet *wallets, size_t count)
+{
+        FILE *file;
+        int ok;
+
+        file = fopen(WALLETS_FILE, "ab");
+        if (!file)
+                return 0;
+
+        ok = fwrite(wallets, sizeof(StoredWallet), count, file) == count;
+        ok = fflush(file) == 0 && fsync(fileno(file)) == 0 && ok;
+        ok = fclose(file) == 0 && ok;
+        return ok;
+}
+
+/**
+ * write_enrolled_keys - Write the email, address and key of each new wallet
+ * @path: Output CSV, created readable by its owner only
+ * @wallets: Batch of wallets
+ * @count: Number of wallets
+ * Return: 1 on success, 0 on failure
+ */
+static int write_enrolled_keys(const char *path, const StoredWallet *wallets, size_t count)
+{
+        FILE *file;
+        size_t i;
+        int fd, ok;
+
+        fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        file = fd < 0 ? NULL : fdopen(fd, "w");
+        if (!file)
+        {
+                if (fd >= 0)
+                        close(fd);
+                return 0;
+        }
+
+        ok = fprintf(file, "email,address,private_key\n") > 0;
+        for (i = 0; ok && i < count; i++)
+                ok = fprintf(file, "%s,%s,%s\n", wallets[i].email, wallets[i].address,
+                             wallets[i].private_key) > 0;
+        ok = fclose(file) == 0 && ok;
+        return ok;
+}
+
+/**
+ * read_enrollment - Read new student and staff wallets from a CSV of emails
+ * @csv_path: CSV file, one email per line in the first field
+ * @registered: Set of registered emails; new emails are added to it
+ * @count: Receives the number of wallets in the batch
+ * Return: Batch with emails, types and balances filled in (caller frees),
+ * or NULL on failure
+ */
+static StoredWallet *read_enrollment(const char *csv_path, EmailSet *registered, size_t *count)
+{
+        char line[ENROLL_LINE_SIZE];
+        char email[MAX_EMAIL];
+        StoredWallet *wallets = NULL, *grown;
+        size_t capacity = 0;
+        long line_number = 0, duplicates = 0, rejected = 0;
+        FILE *file;
+        int parsed, added;
+
+        *count = 0;
+        file = fopen(csv_path, "r");
+        if (!file)
+        {
+                printf("Error: cannot open %s.\n", csv_path);
+                return NULL;
+        }
+
+        while (fgets(line, sizeof(line), file))
+        {
+                line_number++;
+                parsed = parse_enroll_line(line, email);
+                if (parsed == 0)
+                        continue;
+                if (parsed < 0)
+                {
+                        /* Only the first line may be a header row */
+                        if (line_number == 1)
+                                continue;
+                        printf("Line %ld: first field is not an email.\n", line_number);
+                        rejected++;
+                        continue;
+                }
+                if (!strstr(email, STUDENT_DOMAIN) && !strstr(email, STAFF_DOMAIN))
+                {
+                        printf("Line %ld: %s is not a student or staff email.\n", line_number, email);
+                        rejected++;
+                        continue;
+                }
+
+                added = email_set_add(registered, email);
+                if (added < 0)
+                        break;
+                if (added == 0)
+                {
+                        duplicates++;
+                        continue;
+                }
+
+                if (*count == capacity)
+                {
+                        grown = realloc(wallets, (capacity ? capacity * 2 : 256) * sizeof(StoredWallet));
+                        if (!grown)
+                                break;
+                        wallets = grown;
+                        capacity = capacity ? capacity * 2 : 256;
+                }
+
+                memset(&wallets[*count], 0, sizeof(StoredWallet));
+                strcpy(wallets[*count].email, email);
+                wallets[*count].balance = INITIAL_WALLET_BALANCE;
+                wallets[*count].user_type = get_user_type_from_email(email);
+                (*count)++;
+        }
+
+        if (ferror(file) || !feof(file))
+        {
+                printf("Error: could not read all of %s.\n", csv_path);
+                free(wallets);
+                wallets = NULL;
+        }
+        else
+        {
+                printf("Read %ld line(s): %lu new, %ld already registered or repeated, %ld rejected.\n",
+                       line_number, (unsigned long)*count, duplicates, rejected);
+                if (!wallets)
+                        wallets = malloc(sizeof(StoredWallet));
+        }
+        fclose(file);
+        return wallets;
+}
+
+/**
+ * enroll_from_csv - Create wallets and profiles for a CSV of emails
+ * @csv_path: CSV file, one student or staff email per line in the first field
+ * @keys_path: CSV file to receive each new wallet's address and private key
+ *
+ * Emails that are already registered or repeated in the file are skipped.
+ * Wallets are appended to WALLETS_FILE before their profiles are saved.
+ *
+ * Return: 1 on success, 0 on failure
+ */
+int enroll_from_csv(const char *csv_path, const char *keys_path)
+{
+        EmailSet registered = {NULL, 0, 0, NULL, 0};
+        StoredWallet *wallets;
+        size_t count = 0;
+        int ok;
+
+        if (!csv_path || !keys_path)
+                return 0;
+
+        if (!load_registered_emails(&registered))
+        {
+                printf("Error: cannot read %s.\n", WALLETS_FILE);
+                email_set_free(&registered);
+                return 0;
+        }
+
+        wallets = read_enrollment(csv_path, &registered, &count);
+        email_set_free(&registered);
+        if (!wallets)
+                return 0;
+        if (count == 0)
+        {
+                free(wallets);
+                return 1;
+        }
+
+        if (!key_wallets_parallel(wallets, count))
+        {
+                printf("Error: could not generate wallet keys.\n");
+                free(wallets);
+                return 0;
+        }
+
+        /* Keys go out first so no wallet is created that nobody can log in to */
+        ok = write_enrolled_keys(keys_path, wallets, count);
+        if (!ok)
+                printf("Error: cannot write %s.\n", keys_path);
+        else if (!(ok = append_wallets(wallets, count)))
+                printf("Error: cannot append to %s.\n", WALLETS_FILE);
+        else if (!(ok = add_enrolled_profiles(wallets, (int)count)))
+                printf("Error: wallets were created but profiles could not be saved.\n");
+
+        if (ok)
+                printf("Enrolled %lu wallet(s); private keys are in %s.\n", (unsigned long)count, keys_path);
+        free(wallets);
+        return ok;
+}
@@ -0,0 +1,547 @@
+/* export.c */
+#define _XOPEN_SOURCE 700
+#include "alu_blockchain.h"
+#include "export.h"
+#include "snapshot.h"
+#include "wal.h"
+#include <pthread.h>
+
+/*
+ * The exporter streams blocks, transactions and balances to CSV or JSON
+ * Lines. The chain is split into contiguous height ranges, one per thread;
+ * each thread reads the headers already in memory, loads archived bodies
+ * one block at a time, and writes its rows to its own part file. The parts
+ * are then appended to the output in height order, so memory use does not
+ * grow with the chain and the chain is only read once.
+ *
+ * Every field is a number, a hex or vendor address, or a fixed name, so
+ * none needs quoting or escaping.
+ */
+
+#define EXPORT_MAX_THREADS 8
+#define EXPORT_MIN_SEGMENT 64
+#define EXPORT_BUFFER_SIZE 65536
+
+static const char *const type_names[] = {
+    "tuition_fee", "cafeteria_payment", "library_fine", "health_insurance", "token_transfer"};
+
+/**
+ * struct ExportWorker - Height range one thread exports
+ * @chain: Blockchain
+ * @options: Export options
+ * @account: Account ID to match, when @by_account is set
+ * @by_account: Whether only @account's transactions are exported
+ * @begin: First height of the range
+ * @end: One past the last height of the range
+ * @blocks: Output for block rows
+ * @transactions: Output for transaction rows
+ * @block_rows: Receives the number of block rows written
+ * @transaction_rows: Receives the number of transaction rows written
+ * @ok: Receives 1 on success, 0 if a body could not be read
+ */
+typedef struct
+{
+        const Blockchain *chain;
+        const ExportOptions *options;
+        uint32_t account;
+        int by_account;
+        unsigned int begin;
+        unsigned int end;
+        FILE *blocks;
+        FILE *transactions;
+        uint64_t block_rows;
+        uint64_t transaction_rows;
+        int ok;
+} ExportWorker;
+
+/**
+ * export_options_init - Options that export everything as CSV
+ * @options: Options to initialise
+ */
+void export_options_init(ExportOptions *options)
+{
+        options->format = EXPORT_CSV;
+        options->prefix = NULL;
+        options->address = NULL;
+        options->type = EXPORT_ANY_TYPE;
+        options->start = INT64_MIN;
+        options->end = INT64_MAX;
+}
+
+/**
+ * parse_export_type - Parse a TransactionType given by number or name
+ * @text: "0" to "4", or a name such as "cafeteria_payment"
+ * Return: TransactionType, or -1 if @text is neither
+ */
+static int parse_export_type(const char *text)
+{
+        int type;
+
+        for (type = 0; type <= TOKEN_TRANSFER; type++)
+        {
+                if (strcmp(text, type_names[type]) == 0)
+                        return type;
+        }
+        if (text[0] >= '0' && text[0] <= '0' + TOKEN_TRANSFER && !text[1])
+                return text[0] - '0';
+        return -1;
+}
+
+/**
+ * parse_export_args - Parse the arguments of the --export command
+ * @argc: Number of arguments
+ * @argv: "csv" or "jsonl", the output prefix, then any of address=<wallet>,
+ *        type=<type>, from=<local time> and to=<local time>
+ * @options: Receives the options; @argv must outlive them
+ * Return: 1 on success, 0 on a bad argument (reported)
+ */
+int parse_export_args(int argc, char **argv, ExportOptions *options)
+{
+        int i, ok = 1;
+
+        export_options_init(options);
+        if (argc < 2)
+        {
+                printf("Export needs a format (csv or jsonl) and an output prefix.\n");
+                return 0;
+        }
+
+        if (strcmp(argv[0], "csv") == 0)
+                options->format = EXPORT_CSV;
+        else if (strcmp(argv[0], "jsonl") == 0)
+                options->format = EXPORT_JSONL;
+        else
+        {
+                printf("Unknown export format %s; use csv or jsonl.\n", argv[0]);
+                return 0;
+        }
+        options->prefix = argv[1];
+
+        for (i = 2; i < argc; i++)
+        {
+                if (strncmp(argv[i], "address=", 8) == 0 && argv[i][8])
+                        options->address = argv[i] + 8;
+                else if (strncmp(argv[i], "type=", 5) == 0)
+                        ok = (options->type = parse_export_type(argv[i] + 5)) >= 0;
+                else if (strncmp(argv[i], "from=", 5) == 0)
+                        ok = parse_local_time(argv[i] + 5, &options->start);
+                else if (strncmp(argv[i], "to=", 3) == 0)
+                        ok = parse_local_time(argv[i] + 3, &options->end);
+                else
+                        ok = 0;
+
+                if (!ok)
+                {
+                        printf("Invalid export filter %s.\n", argv[i]);
+                        return 0;
+                }
+        }
+        return 1;
+}
+
+/**
+ * export_time - Format a time as ISO 8601 in UTC, "2024-03-01T12:00:00Z"
+ * @time: Seconds since the epoch
+ * @text: Output buffer of TIME_TEXT_SIZE bytes
+ * Return: @text
+ */
+static const char *export_time(int64_t time, char *text)
+{
+        format_epoch(time, 0, text);
+        if (strlen(text) == 19)
+        {
+                text[10] = 'T';
+                strcpy(text + 19, "Z");
+        }
+        return text;
+}
+
+/**
+ * write_block_row - Write one block
+ * @file: Output
+ * @format: Output format
+ * @block: Block
+ */
+static void write_block_row(FILE *file, ExportFormat format, const Block *block)
+{
+        char when[TIME_TEXT_SIZE];
+
+        export_time(block->timestamp, when);
+        if (format == EXPORT_CSV)
+                fprintf(file, "%u,%s,%s,%s,%d,%u\n", block->index, when, block->current_hash,
+                        block->previous_hash, block->transaction_count, block->reward);
+        else
+                fprintf(file, "{\"height\":%u,\"time\":\"%s\",\"hash\":\"%s\",\"previous_hash\":\"%s\","
+                              "\"transactions\":%d,\"reward\":%u}\n",
+                        block->index, when, block->current_hash, block->previous_hash,
+                        block->transaction_count, block->reward);
+}
+
+/**
+ * write_transaction_row - Write one transaction
+ * @file: Output
+ * @format: Output format
+ * @height: Height of the block holding it
+ * @transaction: Transaction
+ */
+static void write_transaction_row(FILE *file, ExportFormat format, unsigned int height,
+                                  const Transaction *transaction)
+{
+        char when[TIME_TEXT_SIZE], amount[LT_FORMAT_SIZE];
+        const char *from = address_of(transaction->from_id);
+        const char *to = address_of(transaction->to_id);
+        const char *type = transaction->type <= TOKEN_TRANSFER ? type_names[transaction->type] : "unknown";
+
+        export_time(transaction->timestamp, when);
+        lt_format(transaction->amount, amount);
+        if (format == EXPORT_CSV)
+                fprintf(file, "%u,%s,%s,%s,%s,%s\n", height, when, type, from ? from : "",
+                        to ? to : "", amount);
+        else
+                fprintf(file, "{\"block\":%u,\"time\":\"%s\",\"type\":\"%s\",\"from\":\"%s\","
+                              "\"to\":\"%s\",\"amount\":%s}\n",
+                        height, when, type, from ? from : "", to ? to : "", amount);
+}
+
+/**
+ * transaction_matches - Whether a transaction passes the export filters
+ * @worker: Worker with the resolved filters
+ * @transaction: Transaction
+ * Return: 1 if it is exported, 0 otherwise
+ */
+static int transaction_matches(const ExportWorker *worker, const Transaction *transaction)
+{
+        const ExportOptions *options = worker->options;
+
+        if (worker->by_account && transaction->from_id != worker->account &&
+            transaction->to_id != worker->account)
+                return 0;
+        if (options->type != EXPORT_ANY_TYPE && transaction->type != options->type)
+                return 0;
+        return transaction->timestamp >= options->start && transaction->timestamp < options->end;
+}
+
+/**
+ * export_segment - Write the blocks and transactions of one height range
+ * @arg: ExportWorker
+ * Return: NULL
+ */
+static void *export_segment(void *arg)
+{
+        ExportWorker *worker = arg;
+        const ExportOptions *options = worker->options;
+        const Block *block;
+        const Transaction *body;
+        Transaction *loaded;
+        unsigned int height;
+        int filtered, i, matched;
+
+        filtered = worker->by_account || options->type != EXPORT_ANY_TYPE ||
+                   options->start != INT64_MIN || options->end != INT64_MAX;
+        worker->ok = 1;
+
+        for (height = worker->begin; height < worker->end; height++)
+        {
+                block = get_block_by_index(worker->chain, height);
+
+                /* Only pruned bodies are read back, one block at a time */
+                body = block->transactions;
+                loaded = NULL;
+                if (!body && block->transaction_count > 0)
+                {
+                        body = loaded = load_block_body(block);
+                        if (!loaded)
+                        {
+                                printf("Error: body of block #%u could not be read.\n", height + 1);
+                                worker->ok = 0;
+                                return NULL;
+                        }
+                }
+
+                matched = 0;
+                for (i = 0; i < block->transaction_count; i++)
+                {
+                        if (!transaction_matches(worker, &body[i]))
+                                continue;
+                        write_transaction_row(worker->transactions, options->format, block->index, &body[i]);
+                        matched++;
+                }
+                free(loaded);
+
+                worker->transaction_rows += matched;
+                if (!filtered || matched)
+                {
+                        write_block_row(worker->blocks, options->format, block);
+                        worker->block_rows++;
+                }
+        }
+        return NULL;
+}
+
+/**
+ * write_balance_row - Write one address and balance
+ * @file: Output
+ * @format: EXPORT_CSV or EXPORT_JSONL
+ * @address: Wallet address
+ * @amount: Balance in micro-LT
+ */
+static void write_balance_row(FILE *file, int format, const char *address, int64_t amount)
+{
+        char balance[LT_FORMAT_SIZE];
+
+        lt_format(amount, balance);
+        if (format == EXPORT_CSV)
+                fprintf(file, "%s,%s\n", address, balance);
+        else
+                fprintf(file, "{\"address\":\"%s\",\"balance\":%s}\n", address, balance);
+}
+
+/**
+ * export_balances - Write every account's balance as of the latest block
+ * @chain: Blockchain
+ * @options: Export options; only the address filter applies
+ * @file: Output
+ * @rows: Receives the number of rows written
+ *
+ * Covers every address in the address book, then every registered wallet
+ * that has never been part of a transaction and so still holds the
+ * initial balance.
+ *
+ * Return: 1 on success, 0 if the ledger or wallet file cannot be read
+ */
+static int export_balances(const Blockchain *chain, const ExportOptions *options, FILE *file,
+                           uint64_t *rows)
+{
+        LedgerState state;
+        StoredWallet wallet;
+        const char *address;
+        uint32_t id, count;
+        FILE *wallets;
+        int ok;
+
+        if (!ledger_state_at(chain->latest->index, &state))
+                return 0;
+
+        count = address_count();
+        for (id = 0; id < count; id++)
+        {
+                address = address_of(id);
+                if (!address || (options->address && strcmp(address, options->address) != 0))
+                        continue;
+                write_balance_row(file, options->format, address, ledger_balance(&state, id));
+                (*rows)++;
+        }
+        ledger_free(&state);
+
+        wallets = fopen(WALLETS_FILE, "rb");
+        if (!wallets)
+                return 1;
+        while (fread(&wallet, sizeof(StoredWallet), 1, wallets))
+        {
+                wallet.address[HASH_LENGTH] = '\0';
+                if (address_lookup(wallet.address) != ADDRESS_ID_NONE ||
+                    (options->address && strcmp(wallet.address, options->address) != 0))
+                        continue;
+                write_balance_row(file, options->format, wallet.address, INITIAL_WALLET_BALANCE);
+                (*rows)++;
+        }
+        ok = !ferror(wallets);
+        fclose(wallets);
+        if (!ok)
+                printf("Error: cannot read %s.\n", WALLETS_FILE);
+        return ok;
+}
+
+/**
+ * open_output - Create an output file with a large stdio buffer
+ * @path: Path
+ * @mode: "w", or "w+" for a part file that is read back
+ * @header: CSV header line, or NULL
+ * Return: Open file, or NULL on failure (reported)
+ */
+static FILE *open_output(const char *path, const char *mode, const char *header)
+{
+        FILE *file = fopen(path, mode);
+
+        if (!file)
+        {
+                printf("Error: cannot create %s.\n", path);
+                return NULL;
+        }
+        setvbuf(file, NULL, _IOFBF, EXPORT_BUFFER_SIZE);
+        if (header)
+                fputs(header, file);
+        return file;
+}
+
+/**
+ * append_part - Append a part file to an output and delete it
+ * @output: Output
+ * @part: Part file, open for reading and writing
+ * @path: Path of @part
+ * @buffer: Copy buffer of EXPORT_BUFFER_SIZE bytes
+ * Return: 1 on success, 0 on a read or write error
+ */
+static int append_part(FILE *output, FILE *part, const char *path, char *buffer)
+{
+        size_t length;
+        int ok = fflush(part) == 0 && fseek(part, 0, SEEK_SET) == 0;
+
+        while (ok && (length = fread(buffer, 1, EXPORT_BUFFER_SIZE, part)) > 0)
+                ok = fwrite(buffer, 1, length, output) == length;
+        ok = ok && !ferror(part);
+        fclose(part);
+        unlink(path);
+        return ok;
+}
+
+/**
+ * close_output - Close an output file
+ * @file: Output, or NULL
+ * @ok: Result so far
+ * Return: @ok, or 0 if the file had a write error
+ */
+static int close_output(FILE *file, int ok)
+{
+        if (!file)
+                return 0;
+        if (ferror(file))
+                ok = 0;
+        return fclose(file) == 0 && ok;
+}
+
+/**
+ * export_ledger - Export blocks, transactions and balances
+ * @chain: Blockchain
+ * @options: Format, output prefix and filters
+ *
+ * Transactions are those in mined blocks; balances are as of the latest
+ * block. Rows come out in height order whatever the thread count.
+ *
+ * Return: 1 on success, 0 on failure (reported)
+ */
+int export_ledger(const Blockchain *chain, const ExportOptions *options)
+{
+        ExportWorker workers[EXPORT_MAX_THREADS];
+        pthread_t threads[EXPORT_MAX_THREADS];
+        int started[EXPORT_MAX_THREADS];
+        char paths[3][512], part_paths[EXPORT_MAX_THREADS][2][540];
+        const char *extension = options->format == EXPORT_CSV ? "csv" : "jsonl";
+        const char *headers[3] = {"height,time,hash,previous_hash,transactions,reward\n",
+                                  "block,time,type,from,to,amount\n", "address,balance\n"};
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        FILE *outputs[3] = {NULL, NULL, NULL};
+        uint64_t block_rows = 0, transaction_rows = 0, balance_rows = 0;
+        size_t thread_count, segments, t;
+        char *buffer;
+        int ok = 1, i;
+
+        if (!chain || !chain->latest || !options || !options->prefix || !wal_open())
+                return 0;
+
+        sprintf(paths[0], "%.480s_blocks.%s", options->prefix, extension);
+        sprintf(paths[1], "%.480s_transactions.%s", options->prefix, extension);
+        sprintf(paths[2], "%.480s_balances.%s", options->prefix, extension);
+        for (i = 0; ok && i < 3; i++)
+        {
+                outputs[i] = open_output(paths[i], "w", options->format == EXPORT_CSV ? headers[i] : NULL);
+                ok = outputs[i] != NULL;
+        }
+
+        /* Each thread gets at least EXPORT_MIN_SEGMENT blocks */
+        thread_count = cpus < 1 ? 1 : (size_t)cpus;
+        if (thread_count > EXPORT_MAX_THREADS)
+                thread_count = EXPORT_MAX_THREADS;
+        segments = (size_t)chain->block_count / EXPORT_MIN_SEGMENT;
+        if (thread_count > segments)
+                thread_count = segments ? segments : 1;
+
+        /* The first range writes straight to the outputs, the others to part files */
+        memset(workers, 0, sizeof(workers));
+        for (t = 0; ok && t < thread_count; t++)
+        {
+                workers[t].chain = chain;
+                workers[t].options = options;
+                workers[t].by_account = options->address != NULL;
+                workers[t].account = options->address ? address_lookup(options->address) : ADDRESS_ID_NONE;
+                workers[t].begin = (unsigned int)((size_t)chain->block_count * t / thread_count);
+                workers[t].end = (unsigned int)((size_t)chain->block_count * (t + 1) / thread_count);
+                workers[t].blocks = outputs[0];
+                workers[t].transactions = outputs[1];
+                if (t == 0)
+                        continue;
+
+                sprintf(part_paths[t][0], "%s.part%u", paths[0], (unsigned int)t);
+                sprintf(part_paths[t][1], "%s.part%u", paths[1], (unsigned int)t);
+                workers[t].blocks = open_output(part_paths[t][0], "w+", NULL);
+                workers[t].transactions = open_output(part_paths[t][1], "w+", NULL);
+                ok = workers[t].blocks && workers[t].transactions;
+        }
+
+        if (ok)
+        {
+                for (t = 0; t < thread_count; t++)
+                        started[t] = t > 0 && pthread_create(&threads[t], NULL, export_segment, &workers[t]) == 0;
+
+                /* The calling thread takes the first range and any that failed to start */
+                for (t = 0; t < thread_count; t++)
+                {
+                        if (!started[t])
+                                export_segment(&workers[t]);
+                }
+
+                /* The workers only read blocks, so the ledger can be rebuilt meanwhile */
+                if (!export_balances(chain, options, outputs[2], &balance_rows))
+                {
+                        printf("Error: balances could not be rebuilt from the transaction log.\n");
+                        ok = 0;
+                }
+
+                for (t = 0; t < thread_count; t++)
+                {
+                        if (started[t])
+                                pthread_join(threads[t], NULL);
+                }
+        }
+
+        /* Append the parts in height order, whether or not everything succeeded */
+        buffer = malloc(EXPORT_BUFFER_SIZE);
+        ok = ok && buffer;
+        for (t = 0; t < thread_count; t++)
+        {
+                ok = ok && workers[t].ok;
+                block_rows += workers[t].block_rows;
+                transaction_rows += workers[t].transaction_rows;
+                if (t == 0)
+                        continue;
+                for (i = 0; i < 2; i++)
+                {
+                        if (i == 0 ? !workers[t].blocks : !workers[t].transactions)
+                                continue;
+                        if (!buffer)
+                        {
+                                fclose(i == 0 ? workers[t].blocks : workers[t].transactions);
+                                unlink(part_paths[t][i]);
+                                continue;
+                        }
+                        ok = append_part(outputs[i], i == 0 ? workers[t].blocks : workers[t].transactions,
+                                         part_paths[t][i], buffer) && ok;
+                }
+        }
+        free(buffer);
+
+        for (i = 0; i < 3; i++)
+                ok = close_output(outputs[i], ok);
+        if (!ok)
+        {
+                for (i = 0; i < 3; i++)
+                        unlink(paths[i]);
+                printf("Error: export to %s_* failed.\n", options->prefix);
+                return 0;
+        }
+
+        printf("Exported %llu block(s), %llu transaction(s) and %llu balance(s) to %s_*.%s\n",
+               (unsigned long long)block_rows, (unsigned long long)transaction_rows,
+               (unsigned long long)balance_rows, options->prefix, extension);
+        return 1;
+}
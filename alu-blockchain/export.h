@@ -0,0 +1,46 @@
+/* export.h */
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "alu_blockchain.h"
+#include <stdint.h>
+
+/* ExportOptions.type value that matches every TransactionType */
+#define EXPORT_ANY_TYPE -1
+
+/* Output formats */
+typedef enum
+{
+        EXPORT_CSV,
+        EXPORT_JSONL
+} ExportFormat;
+
+/**
+ * struct ExportOptions - What export_ledger() writes and where
+ * @format: EXPORT_CSV or EXPORT_JSONL
+ * @prefix: Output path prefix; the files are <prefix>_blocks,
+ *          <prefix>_transactions and <prefix>_balances, with a .csv or
+ *          .jsonl extension
+ * @address: Only this wallet's transactions and balance, or NULL for all
+ * @type: TransactionType to export, or EXPORT_ANY_TYPE
+ * @start: First transaction time included, in seconds since the epoch
+ * @end: First transaction time excluded
+ *
+ * With any filter set, a block is only exported if it holds at least one
+ * exported transaction.
+ */
+typedef struct
+{
+        ExportFormat format;
+        const char *prefix;
+        const char *address;
+        int type;
+        int64_t start;
+        int64_t end;
+} ExportOptions;
+
+void export_options_init(ExportOptions *options);
+int parse_export_args(int argc, char **argv, ExportOptions *options);
+int export_ledger(const Blockchain *chain, const ExportOptions *options);
+
+#endif /* EXPORT_H */
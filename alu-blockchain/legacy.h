@@ -0,0 +1,50 @@
+/* legacy.h */
+#ifndef LEGACY_H
+#define LEGACY_H
+
+#include "alu_blockchain.h"
+
+/*
+ * On-disk layouts written before compact transactions and integer amounts.
+ * They are only read, to migrate old transactions.dat, txpool.dat,
+ * wallets.dat and backup files.
+ */
+
+typedef struct
+{
+        char from_address[HASH_LENGTH + 1];
+        char to_address[HASH_LENGTH + 1];
+        double amount;
+        TransactionType type;
+        time_t timestamp;
+        char signature[HASH_LENGTH + 1];
+} LegacyTransaction;
+
+typedef struct LegacyBlock
+{
+        unsigned int index;
+        char previous_hash[HASH_LENGTH + 1];
+        char timestamp[30];
+        unsigned int nonce;
+        LegacyTransaction transactions[MAX_TRANSACTIONS];
+        int transaction_count;
+        char current_hash[HASH_LENGTH + 1];
+        struct LegacyBlock *next;
+        unsigned int reward;
+} LegacyBlock;
+
+typedef struct
+{
+        char email[MAX_EMAIL];
+        char private_key[HASH_LENGTH + 1];
+        char address[HASH_LENGTH + 1];
+        double balance;
+        UserType user_type;
+        char kitchen_name[MAX_NAME];
+        char name[MAX_NAME];
+} LegacyStoredWallet;
+
+void transaction_from_legacy(const LegacyTransaction *legacy, uint32_t from_id,
+                             uint32_t to_id, Transaction *transaction);
+
+#endif /* LEGACY_H */
@@ -1,35 +1,75 @@
 /* main.c */
 #include "alu_blockchain.h"
 #include "config.h"
+#include "wal.h"
+#include "txlog.h"
+#include "txcolumns.h"
+#include "settlement.h"
+#include "export.h"
 
 /**
  * main - Entry point
+ * @argc: Argument count
+ * @argv: No arguments for the interactive menu, or one batch command:
+ *        --enroll <emails.csv> <keys.csv> to enroll a batch and exit, or
+ *        --settle [YYYY-MM-DD] to print every kitchen's takings that UTC day, or
+ *        --between <from> <to> to print the transactions and blocks in a
+ *        local-time window, each bound as "YYYY-MM-DD HH:MM[:SS]", or
+ *        --export <csv|jsonl> <prefix> [filters] to export the ledger, with
+ *        filters address=<wallet>, type=<type>, from=<time> and to=<time>
  * Return: 0 on success, 1 on failure
  */
-int main(void)
+int main(int argc, char **argv)
 {
         Blockchain *chain;
         Wallet *current_wallet = NULL;
         char email[MAX_EMAIL];
         char private_key[HASH_LENGTH + 1];
+        char amount[LT_FORMAT_SIZE];
         int choice;
-        Config *config;
+        const Config *config;
+        uint32_t day = (uint32_t)(time(NULL) / SECONDS_PER_DAY);
+        int64_t start = 0, end = 0;
+        ExportOptions export_options;
+        int batch_ok;
+
+        if (argc != 1 && !(argc == 4 && strcmp(argv[1], "--enroll") == 0) &&
+            !((argc == 2 || argc == 3) && strcmp(argv[1], "--settle") == 0) &&
+            !(argc == 4 && strcmp(argv[1], "--between") == 0) &&
+            !(argc >= 4 && strcmp(argv[1], "--export") == 0))
+        {
+                printf("Usage: %s [--enroll <emails.csv> <keys.csv> | --settle [YYYY-MM-DD] |\n"
+                       "        --between \"YYYY-MM-DD HH:MM\" \"YYYY-MM-DD HH:MM\" |\n"
+                       "        --export <csv|jsonl> <prefix> [address=<wallet>] [type=<type>]\n"
+                       "                 [from=\"YYYY-MM-DD HH:MM\"] [to=\"YYYY-MM-DD HH:MM\"]]\n",
+                       argv[0]);
+                return 1;
+        }
+        if (argc > 1 && strcmp(argv[1], "--export") == 0 &&
+            !parse_export_args(argc - 2, argv + 2, &export_options))
+                return 1;
+        if (argc == 3 && strcmp(argv[1], "--settle") == 0 && !parse_settlement_day(argv[2], &day))
+        {
+                printf("Invalid date %s; expected YYYY-MM-DD.\n", argv[2]);
+                return 1;
+        }
+        if (argc == 4 && strcmp(argv[1], "--between") == 0 &&
+            (!parse_local_time(argv[2], &start) || !parse_local_time(argv[3], &end)))
+        {
+                printf("Invalid time; expected \"YYYY-MM-DD HH:MM\" in local time.\n");
+                return 1;
+        }
 
         printf("\nALU Private Blockchain Network\n\n");
 
-        /* Load configuration */
-        config = load_config();
+        /* Load configuration once; SIGHUP or an edit to the file reloads it */
+        config = get_config();
         if (!config)
         {
-                printf("Failed to load configuration. Creating default configuration.\n");
-                create_default_config();
-                config = load_config();
-                if (!config)
-                {
-                        printf("Failed to create configuration. Exiting.\n");
-                        return 1;
-                }
+                printf("Failed to load configuration. Exiting.\n");
+                return 1;
         }
+        install_config_reload_handler();
 
         /* Initialize blockchain */
         chain = initialize_blockchain();
@@ -37,7 +77,7 @@ int main(void)
         if (!chain)
         {
                 printf("Failed to initialize blockchain\n");
-                free(config);
+                release_config();
                 return 1;
         }
 
@@ -56,12 +96,38 @@ int main(void)
                 sleep(1.5);
         }
 
+        /* Kitchens are looked up in memory from here on */
+        if (!load_vendor_registry())
+                printf("Warning: could not load all kitchens from %s.\n", KITCHENS_FILE);
+
+        /* Batch commands run once and exit instead of showing the menu */
+        if (argc > 1)
+        {
+                if (strcmp(argv[1], "--enroll") == 0)
+                        batch_ok = enroll_from_csv(argv[2], argv[3]);
+                else if (strcmp(argv[1], "--between") == 0)
+                        batch_ok = print_activity_between(chain, start, end);
+                else if (strcmp(argv[1], "--export") == 0)
+                        batch_ok = export_ledger(chain, &export_options);
+                else
+                        batch_ok = print_settlement_report(day);
+                cleanup_blockchain(chain);
+                release_vendor_registry();
+                release_profiles();
+                txcolumns_close_shared();
+                txlog_close_shared();
+                wal_close();
+                release_config();
+                return batch_ok ? 0 : 1;
+        }
+
         printf("\nWelcome to ALU Payment System\n");
         printf("Token: %s (%s)\n", chain->token.token_name, chain->token.symbol);
         printf("Total Supply: %u %s\n", chain->token.total_supply, chain->token.symbol);
 
         while (1)
         {
+                config_poll();
                 display_menu();
                 if (scanf("%d", &choice) != 1)
                 {
@@ -137,7 +203,7 @@ int main(void)
                                 printf("Address: %s\n", current_wallet->address);
                                 printf("Private Key: %s\n", current_wallet->private_key);
                                 printf("IMPORTANT: Save your private key to access your wallet later!\n");
-                                printf("Initial balance: %.2f LT\n", current_wallet->balance);
+                                printf("Initial balance: %s LT\n", lt_format(current_wallet->balance, amount));
                         }
                         else
                                 printf("Failed to create wallet.\n");
@@ -160,6 +226,24 @@ int main(void)
                                 printf("Wallet loaded successfully!\n");
                         else
                                 printf("Failed to load wallet. Check your private key.\n");
+
+                        /* Wallets from before key pairs must move to one to send */
+                        if (current_wallet && !wallet_has_signing_key(current_wallet))
+                        {
+                                printf("\nThis wallet was created before key pairs and cannot send payments.\n");
+                                printf("Upgrade it to a new key pair now? (y/n): ");
+                                char confirm;
+                                scanf(" %c", &confirm);
+                                clear_input_buffer();
+                                if ((confirm == 'y' || confirm == 'Y') &&
+                                    upgrade_wallet_keys(current_wallet))
+                                {
+                                        printf("Wallet upgraded; its balance moved to the new address.\n");
+                                        printf("Address: %s\n", current_wallet->address);
+                                        printf("Private Key: %s\n", current_wallet->private_key);
+                                        printf("IMPORTANT: Your old private key no longer works. Save the new one!\n");
+                                }
+                        }
                         break;
 
                 case 3: /* Initiate Transaction */
@@ -174,6 +258,7 @@ int main(void)
                         if (process_payment(chain, current_wallet))
                         {
                                 printf("Payment completed successfully!\n");
+                                config = get_config();
                                 if (config->auto_backup &&
                                     chain->block_count % config->backup_interval == 0)
                                 {
@@ -197,7 +282,7 @@ int main(void)
                         printf("\n=== Wallet Balance ===\n");
                         printf("Email: %s\n", current_wallet->email);
                         printf("Address: %s\n", current_wallet->address);
-                        printf("Balance: %.2f %s\n", current_wallet->balance,
+                        printf("Balance: %s %s\n", lt_format(current_wallet->balance, amount),
                                chain->token.symbol);
                         break;
 
@@ -264,7 +349,12 @@ int main(void)
                         if (current_wallet)
                                 free(current_wallet);
                         cleanup_blockchain(chain);
-                        free(config);
+                        release_vendor_registry();
+                        release_profiles();
+                        txcolumns_close_shared();
+                        txlog_close_shared();
+                        wal_close();
+                        release_config();
                         return 0;
 
                 default:
@@ -309,32 +399,25 @@ void display_payment_menu(void)
         printf("\nSelect payment type (1-5): ");
 }
 
-// /**
-//  * display_cafeteria_menu - Show available kitchens
-//  */
+/**
+ * display_cafeteria_menu - Show available kitchens
+ */
 void display_cafeteria_menu(void)
 {
-        FILE *file = fopen("kitchens.txt", "r"); // Open the file in read mode
-        if (!file)
+        VendorProfile *kitchen;
+        int index = 0;
+
+        if (!vendor_list)
         {
                 printf("\nNo kitchens available at the moment.\n");
                 return;
         }
 
         printf("\n=== Select Kitchen ===\n");
+        for (kitchen = vendor_list; kitchen; kitchen = kitchen->next)
+                printf("%d. %s\n", ++index, kitchen->kitchen_name);
 
-        char line[256];
-        int index = 1;
-        while (fgets(line, sizeof(line), file))
-        {
-                char kitchen_name[MAX_NAME];
-                sscanf(line, "%99[^,]", kitchen_name); // Read the kitchen name before the first comma
-                printf("%d. %s\n", index++, kitchen_name);
-        }
-
-        fclose(file);
-
-        printf("\nSelect kitchen (1-%d): ", index - 1);
+        printf("\nSelect kitchen (1-%d): ", index);
 }
 
 /**
@@ -371,7 +454,7 @@ void clear_input_buffer(void)
  * @amount: Amount to be transferred
  * Return: 1 if valid, 0 if invalid
  */
-int verify_transaction(const Wallet *wallet, const char *to_address, double amount)
+int verify_transaction(const Wallet *wallet, const char *to_address, int64_t amount)
 {
         if (!wallet || !to_address || amount <= 0)
         {
@@ -414,7 +497,8 @@ int process_payment(Blockchain *chain, Wallet *wallet)
 {
         int type_choice;
         char to_address[HASH_LENGTH + 1];
-        double amount;
+        char amount_text[LT_FORMAT_SIZE];
+        int64_t amount;
         TransactionType trans_type;
         const char *recipient_name;
 
@@ -433,7 +517,8 @@ int process_payment(Blockchain *chain, Wallet *wallet)
         {
         case 1: /* Tuition Fee */
                 trans_type = TUITION_FEE;
-                strcpy(to_address, SCHOOL_TUITION_ADDRESS);
+                if (!get_institution_address(SCHOOL_TUITION_EMAIL, to_address))
+                        return 0;
                 recipient_name = "ALU Tuition Account";
                 break;
 
@@ -451,30 +536,31 @@ int process_payment(Blockchain *chain, Wallet *wallet)
                 }
                 clear_input_buffer();
 
-                VendorProfile *kitchen = get_kitchen_vendor(kitchen_choice - 1); // Get the kitchen based on the selection
-                printf("Selected kitchen: %s\n", kitchen->kitchen_name);
-                printf("Wallet Address: %s\n", kitchen->wallet_address);
+                VendorProfile *kitchen = get_kitchen_vendor(kitchen_choice - 1); // Owned by the vendor registry
                 if (!kitchen)
                 {
                         printf("Failed to get kitchen information.\n");
                         return 0;
                 }
+                printf("Selected kitchen: %s\n", kitchen->kitchen_name);
+                printf("Wallet Address: %s\n", kitchen->wallet_address);
 
                 strcpy(to_address, kitchen->wallet_address);
                 recipient_name = kitchen->kitchen_name;
-                free(kitchen); // Don't forget to free the memory after usage
                 break;
         }
 
         case 3: /* Library Fine */
                 trans_type = LIBRARY_FINE;
-                strcpy(to_address, SCHOOL_LIBRARY_ADDRESS);
+                if (!get_institution_address(SCHOOL_LIBRARY_EMAIL, to_address))
+                        return 0;
                 recipient_name = "ALU Library";
                 break;
 
         case 4: /* Health Insurance */
                 trans_type = HEALTH_INSURANCE;
-                strcpy(to_address, HEALTH_INSURANCE_ADDRESS);
+                if (!get_institution_address(HEALTH_INSURANCE_EMAIL, to_address))
+                        return 0;
                 recipient_name = "ALU Health Insurance";
                 break;
 
@@ -492,13 +578,19 @@ int process_payment(Blockchain *chain, Wallet *wallet)
         }
 
         printf("Enter amount in %s: ", chain->token.symbol);
-        if (scanf("%lf", &amount) != 1)
+        if (scanf("%31s", amount_text) != 1)
         {
                 clear_input_buffer();
                 return 0;
         }
         clear_input_buffer();
 
+        if (!lt_parse(amount_text, &amount))
+        {
+                printf("Invalid amount (at most 6 decimal places).\n");
+                return 0;
+        }
+
         /* Verify the transaction */
         if (!verify_transaction(wallet, to_address, amount))
                 return 0;
@@ -510,7 +602,7 @@ int process_payment(Blockchain *chain, Wallet *wallet)
                                               : type_choice == 4   ? "Health Insurance"
                                                                    : "Token Transfer");
         printf("Recipient: %s\n", recipient_name);
-        printf("Amount: %.2f %s\n", amount, chain->token.symbol);
+        printf("Amount: %s %s\n", lt_format(amount, amount_text), chain->token.symbol);
         printf("\nConfirm payment? (y/n): ");
 
         char confirm;
@@ -527,20 +619,20 @@ int process_payment(Blockchain *chain, Wallet *wallet)
         if (initiate_transaction(chain, wallet, to_address, amount, trans_type))
         {
                 wallet = load_wallet_by_public_key(wallet->address);
-                wallet->balance -= amount;
 
                 // Load recipient's wallet and update balance
                 Wallet *recipient_wallet = load_wallet_by_public_key(to_address);
-                if (recipient_wallet)
+                if (recipient_wallet &&
+                    lt_sub(wallet->balance, amount, &wallet->balance) &&
+                    lt_add(recipient_wallet->balance, amount, &recipient_wallet->balance))
                 {
-                        recipient_wallet->balance += amount;
                         update_wallet_record(wallet);
                         update_wallet_record(recipient_wallet);
-                        free(recipient_wallet);
                 }
+                free(recipient_wallet);
 
                 printf("\nPayment successful!\n");
-                printf("New balance: %.2f %s\n", wallet->balance, chain->token.symbol);
+                printf("New balance: %s %s\n", lt_format(wallet->balance, amount_text), chain->token.symbol);
                 return 1;
         }
         else
@@ -552,35 +644,35 @@ int process_payment(Blockchain *chain, Wallet *wallet)
 
 /**
  * create_institutional_wallets - Create wallets for institutions
+ *
+ * Each institution gets its own key pair the first time it is created;
+ * wallets that already exist are found by email and kept as they are.
+ *
  * Return: 1 on success, 0 on failure
  */
 int create_institutional_wallets(void)
 {
         printf("\nPreloading school wallets...\n");
-        const struct
-        {
-                const char *address;
-                const char *email;
-                const char *private_key;
-        } institutions[] = {
-            {SCHOOL_TUITION_ADDRESS, "tuition@alu.edu", "tuition_key_placeholder"},
-            {SCHOOL_LIBRARY_ADDRESS, "library@alu.edu", "library_key_placeholder"},
-            {HEALTH_INSURANCE_ADDRESS, "insurance@alu.edu", "insurance_key_placeholder"}};
+        const char *institutions[] = {SCHOOL_TUITION_EMAIL, SCHOOL_LIBRARY_EMAIL,
+                                      HEALTH_INSURANCE_EMAIL};
+        char address[HASH_LENGTH + 1];
+        char private_key[HASH_LENGTH + 1];
 
         for (size_t i = 0; i < sizeof(institutions) / sizeof(institutions[0]); i++)
         {
                 // Check if wallet already exists
-                Wallet *existing_wallet = load_wallet_by_public_key(institutions[i].address);
+                Wallet *existing_wallet = load_wallet_by_email(institutions[i]);
                 if (existing_wallet)
                 {
                         free(existing_wallet);
                         continue;
                 }
 
-                // Save wallet
-                if (!save_wallet(institutions[i].email, institutions[i].private_key, institutions[i].address, NULL))
+                // Generate a key pair and save the wallet
+                if (!generate_wallet_keys(address, private_key) ||
+                    !save_wallet(institutions[i], private_key, address, NULL))
                 {
-                        printf("Failed to save wallet for %s\n", institutions[i].email);
+                        printf("Failed to save wallet for %s\n", institutions[i]);
                         return 0;
                 }
         }
@@ -589,7 +681,10 @@ int create_institutional_wallets(void)
 }
 
 /**
- * create_vendor_wallets - Create wallets for kitchen vendors with predefined addresses
+ * create_vendor_wallets - Create wallets and kitchen entries for the preloaded vendors
+ *
+ * As with institutions, each vendor gets a key pair on first start.
+ *
  * Return: 1 on success, 0 on failure
  */
 int create_vendor_wallets(void)
@@ -601,32 +696,54 @@ int create_vendor_wallets(void)
         {
                 const char *kitchen_name;
                 const char *email;
-                const char *public_key;
-                const char *private_key;
         } vendors[] = {
-            {Pius_Cuisine, "pius@vendor.com", Pius_Cuisine_ADDRESS, "pius_key_placeholder"},
-            {Joshua_Kitchen, "joshua@vendor.com", Joshua_Kitchen_ADDRESS, "joshua_key_placeholder"},
-            {Pascal_Kitchen, "pascal@vendor.com", Pascal_Kitchen_ADDRESS, "pascal_key_placeholder"}};
+            {Pius_Cuisine, "pius@vendor.com"},
+            {Joshua_Kitchen, "joshua@vendor.com"},
+            {Pascal_Kitchen, "pascal@vendor.com"}};
+        char address[HASH_LENGTH + 1];
+        char private_key[HASH_LENGTH + 1];
 
         for (size_t i = 0; i < sizeof(vendors) / sizeof(vendors[0]); i++)
         {
                 // Check if wallet already exists
-                Wallet *existing_wallet = load_wallet_by_public_key(vendors[i].public_key);
+                Wallet *existing_wallet = load_wallet_by_email(vendors[i].email);
                 if (existing_wallet)
                 {
                         free(existing_wallet);
                         continue;
                 }
 
-                add_kitchen(vendors[i].kitchen_name, vendors[i].email, vendors[i].public_key);
-
-                if (!save_wallet(vendors[i].email, vendors[i].private_key, vendors[i].public_key, vendors[i].kitchen_name))
+                if (!generate_wallet_keys(address, private_key) ||
+                    !save_wallet(vendors[i].email, private_key, address, vendors[i].kitchen_name))
                 {
                         printf("Failed to save wallet for %s\n", vendors[i].kitchen_name);
                         return 0;
                 }
+
+                add_kitchen(vendors[i].kitchen_name, vendors[i].email, address);
+        }
+
+        return 1;
+}
+
+/**
+ * get_institution_address - Look up an institutional wallet's address
+ * @email: Institution's email, e.g. SCHOOL_TUITION_EMAIL
+ * @to_address: Buffer of HASH_LENGTH + 1 bytes for the address
+ * Return: 1 if successful, 0 otherwise.
+ */
+int get_institution_address(const char *email, char *to_address)
+{
+        Wallet *institution = load_wallet_by_email(email);
+
+        if (!institution)
+        {
+                printf("Error: no wallet found for %s.\n", email);
+                return 0;
         }
 
+        strcpy(to_address, institution->address);
+        free(institution);
         return 1;
 }
 
@@ -1,27 +1,386 @@
 /* profile.c */
+#define _XOPEN_SOURCE 700
 #include "alu_blockchain.h"
 
-/* Static profile storage */
-static StudentProfile students[MAX_TRANSACTIONS];
-static StaffProfile staff[MAX_TRANSACTIONS];
-static VendorProfile vendors[MAX_TRANSACTIONS];
+/*
+ * Profiles live in growable arrays, one per user type, with two
+ * open-addressing indexes over all of them: one by email and one by
+ * (type, ID). Each slot holds PROFILE_REF(type, index), 0 when empty.
+ *
+ * PROFILES_FILE holds a compacted copy of every profile. New profiles are
+ * appended to PROFILES_JOURNAL; the journal is folded back into
+ * PROFILES_FILE once it reaches PROFILE_COMPACT_RECORDS records and at
+ * every start.
+ */
+
+#define PROFILE_JOURNAL_MAGIC 0x4a52504cu /* "LPRJ" */
+#define PROFILE_COMPACT_RECORDS 256
+#define PROFILE_INDEX_MIN_SLOTS 256
+#define PROFILE_REF(type, index) (((uint32_t)(index) + 1) << 2 | (uint32_t)(type))
+#define REF_TYPE(ref) ((UserType)((ref) & 3))
+#define REF_INDEX(ref) ((int)((ref) >> 2) - 1)
+
+/**
+ * struct ProfileRecord - One profile in PROFILES_JOURNAL
+ * @magic: PROFILE_JOURNAL_MAGIC
+ * @type: STUDENT, STAFF or VENDOR
+ * @profile: Profile of that type
+ */
+typedef struct
+{
+        uint32_t magic;
+        uint32_t type;
+        union
+        {
+                StudentProfile student;
+                StaffProfile staff;
+                VendorProfile vendor;
+        } profile;
+} ProfileRecord;
+
+/* Profile storage */
+static StudentProfile *students = NULL;
+static StaffProfile *staff = NULL;
+static VendorProfile *vendors = NULL;
 static int student_count = 0;
 static int staff_count = 0;
 static int vendor_count = 0;
+static int student_capacity = 0;
+static int staff_capacity = 0;
+static int vendor_capacity = 0;
 
 static unsigned int next_student_id = 1000;
 static unsigned int next_staff_id = 5000;
 static unsigned int next_vendor_id = 9000;
 
+/* Indexes over all profiles */
+static uint32_t *email_slots = NULL;
+static uint32_t *id_slots = NULL;
+static size_t index_slot_count = 0;
+
+static int journal_records = 0;
+
+/**
+ * profile_email - Email of an indexed profile
+ * @ref: PROFILE_REF of the profile
+ * Return: Email
+ */
+static const char *profile_email(uint32_t ref)
+{
+        if (REF_TYPE(ref) == STUDENT)
+                return students[REF_INDEX(ref)].email;
+        if (REF_TYPE(ref) == STAFF)
+                return staff[REF_INDEX(ref)].email;
+        return vendors[REF_INDEX(ref)].email;
+}
+
+/**
+ * profile_id - ID of an indexed profile
+ * @ref: PROFILE_REF of the profile
+ * Return: Student, staff or vendor ID
+ */
+static unsigned int profile_id(uint32_t ref)
+{
+        if (REF_TYPE(ref) == STUDENT)
+                return students[REF_INDEX(ref)].student_id;
+        if (REF_TYPE(ref) == STAFF)
+                return staff[REF_INDEX(ref)].staff_id;
+        return (unsigned int)vendors[REF_INDEX(ref)].vendor_id;
+}
+
+/**
+ * email_key - FNV-1a hash of an email
+ * @email: Email
+ * Return: 32-bit hash
+ */
+static uint32_t email_key(const char *email)
+{
+        uint32_t key = 2166136261u;
+
+        while (*email)
+        {
+                key ^= (unsigned char)*email++;
+                key *= 16777619u;
+        }
+        return key;
+}
+
+/**
+ * id_key - Hash of a profile type and ID
+ * @type: User type
+ * @id: Profile ID
+ * Return: 32-bit hash
+ */
+static uint32_t id_key(UserType type, unsigned int id)
+{
+        uint32_t key = (id ^ (uint32_t)type << 30) * 2654435761u;
+
+        return key ^ key >> 16;
+}
+
+/**
+ * find_email_slot - Find the slot holding @email or the empty slot for it
+ * @slots: Email index with index_slot_count slots
+ * @email: Email
+ * Return: Slot number
+ */
+static size_t find_email_slot(const uint32_t *slots, const char *email)
+{
+        size_t mask = index_slot_count - 1;
+        size_t i = email_key(email) & mask;
+
+        while (slots[i] && strcmp(profile_email(slots[i]), email) != 0)
+                i = (i + 1) & mask;
+        return i;
+}
+
+/**
+ * find_id_slot - Find the slot holding a profile ID or the empty slot for it
+ * @slots: ID index with index_slot_count slots
+ * @type: User type
+ * @id: Profile ID
+ * Return: Slot number
+ */
+static size_t find_id_slot(const uint32_t *slots, UserType type, unsigned int id)
+{
+        size_t mask = index_slot_count - 1;
+        size_t i = id_key(type, id) & mask;
+
+        while (slots[i] && (REF_TYPE(slots[i]) != type || profile_id(slots[i]) != id))
+                i = (i + 1) & mask;
+        return i;
+}
+
+/**
+ * insert_ref - Add a profile to both indexes
+ * @ref: PROFILE_REF of the profile
+ */
+static void insert_ref(uint32_t ref)
+{
+        email_slots[find_email_slot(email_slots, profile_email(ref))] = ref;
+        id_slots[find_id_slot(id_slots, REF_TYPE(ref), profile_id(ref))] = ref;
+}
+
+/**
+ * grow_indexes - Double both indexes and reinsert every profile
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int grow_indexes(void)
+{
+        size_t slot_count = index_slot_count ? index_slot_count * 2 : PROFILE_INDEX_MIN_SLOTS;
+        uint32_t *emails, *ids;
+        int i;
+
+        emails = calloc(slot_count, sizeof(uint32_t));
+        ids = calloc(slot_count, sizeof(uint32_t));
+        if (!emails || !ids)
+        {
+                free(emails);
+                free(ids);
+                return 0;
+        }
+
+        free(email_slots);
+        free(id_slots);
+        email_slots = emails;
+        id_slots = ids;
+        index_slot_count = slot_count;
+
+        for (i = 0; i < student_count; i++)
+                insert_ref(PROFILE_REF(STUDENT, i));
+        for (i = 0; i < staff_count; i++)
+                insert_ref(PROFILE_REF(STAFF, i));
+        for (i = 0; i < vendor_count; i++)
+                insert_ref(PROFILE_REF(VENDOR, i));
+        return 1;
+}
+
+/**
+ * find_profile_by_email - Look up a profile in the email index
+ * @email: Email
+ * Return: PROFILE_REF of the profile, or 0 if there is none
+ */
+static uint32_t find_profile_by_email(const char *email)
+{
+        if (!index_slot_count)
+                return 0;
+        return email_slots[find_email_slot(email_slots, email)];
+}
+
+/**
+ * grow_array - Make room for one more element
+ * @array: Pointer to the array
+ * @count: Elements in use
+ * @capacity: Pointer to the allocated length
+ * @size: Element size
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int grow_array(void **array, int count, int *capacity, size_t size)
+{
+        int new_capacity;
+        void *grown;
+
+        if (count < *capacity)
+                return 1;
+
+        new_capacity = *capacity ? *capacity * 2 : 64;
+        grown = realloc(*array, (size_t)new_capacity * size);
+        if (!grown)
+                return 0;
+        *array = grown;
+        *capacity = new_capacity;
+        return 1;
+}
+
+/**
+ * store_profile - Add a profile to memory and both indexes
+ * @type: STUDENT, STAFF or VENDOR
+ * @profile: Profile of that type
+ * Return: 1 on success, 0 on failure
+ */
+static int store_profile(UserType type, const void *profile)
+{
+        int total = student_count + staff_count + vendor_count;
+        uint32_t ref;
+
+        if ((size_t)(total + 1) * 2 > index_slot_count && !grow_indexes())
+                return 0;
+
+        if (type == STUDENT)
+        {
+                if (!grow_array((void **)&students, student_count, &student_capacity, sizeof(StudentProfile)))
+                        return 0;
+                students[student_count] = *(const StudentProfile *)profile;
+                if (students[student_count].student_id >= next_student_id)
+                        next_student_id = students[student_count].student_id + 1;
+                ref = PROFILE_REF(STUDENT, student_count++);
+        }
+        else if (type == STAFF)
+        {
+                if (!grow_array((void **)&staff, staff_count, &staff_capacity, sizeof(StaffProfile)))
+                        return 0;
+                staff[staff_count] = *(const StaffProfile *)profile;
+                if (staff[staff_count].staff_id >= next_staff_id)
+                        next_staff_id = staff[staff_count].staff_id + 1;
+                ref = PROFILE_REF(STAFF, staff_count++);
+        }
+        else if (type == VENDOR)
+        {
+                if (!grow_array((void **)&vendors, vendor_count, &vendor_capacity, sizeof(VendorProfile)))
+                        return 0;
+                vendors[vendor_count] = *(const VendorProfile *)profile;
+                vendors[vendor_count].next = NULL;
+                if ((unsigned int)vendors[vendor_count].vendor_id >= next_vendor_id)
+                        next_vendor_id = vendors[vendor_count].vendor_id + 1;
+                ref = PROFILE_REF(VENDOR, vendor_count++);
+        }
+        else
+                return 0;
+
+        insert_ref(ref);
+        return 1;
+}
+
+/**
+ * make_record - Fill a journal record for a profile
+ * @record: Record to fill
+ * @type: STUDENT, STAFF or VENDOR
+ * @profile: Profile of that type
+ */
+static void make_record(ProfileRecord *record, UserType type, const void *profile)
+{
+        memset(record, 0, sizeof(*record));
+        record->magic = PROFILE_JOURNAL_MAGIC;
+        record->type = type;
+        if (type == STUDENT)
+                record->profile.student = *(const StudentProfile *)profile;
+        else if (type == STAFF)
+                record->profile.staff = *(const StaffProfile *)profile;
+        else
+                record->profile.vendor = *(const VendorProfile *)profile;
+}
+
+/**
+ * append_journal - Append profile records to PROFILES_JOURNAL
+ * @records: Records
+ * @count: Number of records
+ *
+ * Compacts the journal into PROFILES_FILE once it is long enough.
+ *
+ * Return: 1 on success, 0 on failure
+ */
+static int append_journal(const ProfileRecord *records, int count)
+{
+        FILE *file;
+        int ok;
+
+        file = fopen(PROFILES_JOURNAL, "ab");
+        if (!file)
+                return 0;
+
+        ok = fwrite(records, sizeof(ProfileRecord), count, file) == (size_t)count;
+        ok = fclose(file) == 0 && ok;
+        if (!ok)
+                return 0;
+
+        journal_records += count;
+        if (journal_records >= PROFILE_COMPACT_RECORDS)
+                save_profiles_to_file();
+        return 1;
+}
+
+/**
+ * add_profile - Store a new profile and record it in the journal
+ * @type: STUDENT, STAFF or VENDOR
+ * @profile: Profile of that type
+ * Return: 1 on success, 0 on failure
+ */
+static int add_profile(UserType type, const void *profile)
+{
+        ProfileRecord record;
+
+        make_record(&record, type, profile);
+        return store_profile(type, profile) && append_journal(&record, 1);
+}
+
+/**
+ * release_profiles - Free every profile and both indexes
+ */
+void release_profiles(void)
+{
+        free(students);
+        free(staff);
+        free(vendors);
+        free(email_slots);
+        free(id_slots);
+        students = NULL;
+        staff = NULL;
+        vendors = NULL;
+        email_slots = NULL;
+        id_slots = NULL;
+        student_count = staff_count = vendor_count = 0;
+        student_capacity = staff_capacity = vendor_capacity = 0;
+        index_slot_count = 0;
+        journal_records = 0;
+        next_student_id = 1000;
+        next_staff_id = 5000;
+        next_vendor_id = 9000;
+}
+
 /**
- * save_profiles_to_file - Save all profiles to file
+ * save_profiles_to_file - Compact every profile into PROFILES_FILE
+ *
+ * The file is replaced atomically, then the journal it now covers is
+ * removed.
+ *
  * Return: 1 on success, 0 on failure
  */
 int save_profiles_to_file(void)
 {
         FILE *file;
+        int ok;
 
-        file = fopen(PROFILES_FILE, "wb");
+        file = fopen(PROFILES_FILE ".tmp", "wb");
         if (!file)
                 return 0;
 
@@ -36,39 +395,124 @@ int save_profiles_to_file(void)
         /* Write profiles */
         fwrite(students, sizeof(StudentProfile), student_count, file);
         fwrite(staff, sizeof(StaffProfile), staff_count, file);
-        fwrite(vendors, sizeof(VendorProfile), vendor_count, file);
+        ok = fwrite(vendors, sizeof(VendorProfile), vendor_count, file) == (size_t)vendor_count;
 
-        fclose(file);
+        ok = !ferror(file) && fflush(file) == 0 && fsync(fileno(file)) == 0 && ok;
+        ok = fclose(file) == 0 && ok;
+        if (!ok || rename(PROFILES_FILE ".tmp", PROFILES_FILE) != 0)
+        {
+                unlink(PROFILES_FILE ".tmp");
+                return 0;
+        }
+
+        /* Replaying a leftover journal is harmless: known emails are skipped */
+        unlink(PROFILES_JOURNAL);
+        journal_records = 0;
         return 1;
 }
 
+/**
+ * load_compacted_profiles - Read the profiles in PROFILES_FILE
+ * @file: Open PROFILES_FILE
+ * Return: 1 on success, 0 if the file is damaged
+ */
+static int load_compacted_profiles(FILE *file)
+{
+        StudentProfile student;
+        StaffProfile member;
+        VendorProfile vendor;
+        int counts[3];
+        unsigned int ids[3];
+        int i, ok = 1;
+
+        if (fread(counts, sizeof(int), 3, file) != 3 || fread(ids, sizeof(unsigned int), 3, file) != 3 ||
+            counts[0] < 0 || counts[1] < 0 || counts[2] < 0)
+                return 0;
+
+        next_student_id = ids[0];
+        next_staff_id = ids[1];
+        next_vendor_id = ids[2];
+
+        for (i = 0; ok && i < counts[0]; i++)
+                ok = fread(&student, sizeof(student), 1, file) == 1 && store_profile(STUDENT, &student);
+        for (i = 0; ok && i < counts[1]; i++)
+                ok = fread(&member, sizeof(member), 1, file) == 1 && store_profile(STAFF, &member);
+        for (i = 0; ok && i < counts[2]; i++)
+                ok = fread(&vendor, sizeof(vendor), 1, file) == 1 && store_profile(VENDOR, &vendor);
+        return ok;
+}
+
+/**
+ * replay_journal - Add the profiles recorded in PROFILES_JOURNAL
+ * @file: Open PROFILES_JOURNAL
+ *
+ * A torn record at the end is ignored, as are profiles already known.
+ *
+ * Return: Number of records read
+ */
+static int replay_journal(FILE *file)
+{
+        ProfileRecord record;
+        const char *email;
+        int count = 0;
+
+        while (fread(&record, sizeof(record), 1, file) == 1 && record.magic == PROFILE_JOURNAL_MAGIC)
+        {
+                if (record.type == STUDENT)
+                        email = record.profile.student.email;
+                else if (record.type == STAFF)
+                        email = record.profile.staff.email;
+                else if (record.type == VENDOR)
+                        email = record.profile.vendor.email;
+                else
+                        break;
+
+                if (!find_profile_by_email(email) && !store_profile(record.type, &record.profile))
+                        break;
+                count++;
+        }
+        return count;
+}
+
 /**
  * load_profiles_from_file - Load all profiles from file
+ *
+ * Reads PROFILES_FILE, replays PROFILES_JOURNAL on top of it and compacts
+ * the two.
+ *
  * Return: 1 on success, 0 if file doesn't exist or error
  */
 int load_profiles_from_file(void)
 {
         FILE *file;
+        int found = 0;
 
-        file = fopen(PROFILES_FILE, "rb");
-        if (!file)
-                return 0;
+        release_profiles();
 
-        /* Read counters */
-        fread(&student_count, sizeof(int), 1, file);
-        fread(&staff_count, sizeof(int), 1, file);
-        fread(&vendor_count, sizeof(int), 1, file);
-        fread(&next_student_id, sizeof(unsigned int), 1, file);
-        fread(&next_staff_id, sizeof(unsigned int), 1, file);
-        fread(&next_vendor_id, sizeof(unsigned int), 1, file);
+        file = fopen(PROFILES_FILE, "rb");
+        if (file)
+        {
+                found = load_compacted_profiles(file);
+                fclose(file);
+                if (!found)
+                {
+                        printf("Error: %s is damaged.\n", PROFILES_FILE);
+                        release_profiles();
+                        return 0;
+                }
+        }
 
-        /* Read profiles */
-        fread(students, sizeof(StudentProfile), student_count, file);
-        fread(staff, sizeof(StaffProfile), staff_count, file);
-        fread(vendors, sizeof(VendorProfile), vendor_count, file);
+        file = fopen(PROFILES_JOURNAL, "rb");
+        if (file)
+        {
+                journal_records = replay_journal(file);
+                fclose(file);
+                found = 1;
+                if (!save_profiles_to_file())
+                        printf("Warning: could not compact %s.\n", PROFILES_JOURNAL);
+        }
 
-        fclose(file);
-        return 1;
+        return found;
 }
 
 /**
@@ -99,12 +543,6 @@ StudentProfileWithWallet *create_student_profile(const char *email)
                 return NULL;
         }
 
-        if (student_count >= MAX_TRANSACTIONS)
-        {
-                printf("Maximum number of students reached\n");
-                return NULL;
-        }
-
         /* Create wallet first */
         wallet = create_wallet(email, NULL);
         if (!wallet)
@@ -123,20 +561,25 @@ StudentProfileWithWallet *create_student_profile(const char *email)
         }
 
         /* Initialize profile */
-        combined->profile.student_id = next_student_id++;
+        memset(&combined->profile, 0, sizeof(combined->profile));
+        combined->profile.student_id = next_student_id;
         strncpy(combined->profile.email, email, MAX_EMAIL - 1);
         strncpy(combined->profile.wallet_address, wallet->address, HASH_LENGTH);
 
         memcpy(&combined->wallet, wallet, sizeof(Wallet));
+        free(wallet); // Free temporary wallet
+
+        if (!add_profile(STUDENT, &combined->profile))
+        {
+                printf("Failed to save student profile\n");
+                free(combined);
+                return NULL;
+        }
 
         printf("\nStudent Profile Created:\n");
         printf("Email: %s\n", combined->profile.email);
         printf("Wallet Address: %s\n", combined->profile.wallet_address);
 
-        student_count++;
-        free(wallet); // Free temporary wallet
-
-        save_profiles_to_file();
         return combined;
 }
 
@@ -168,12 +611,6 @@ StaffProfileWithWallet *create_staff_profile(const char *email)
                 return NULL;
         }
 
-        if (staff_count >= MAX_TRANSACTIONS)
-        {
-                printf("Maximum number of staff reached\n");
-                return NULL;
-        }
-
         wallet = create_wallet(email, NULL);
         if (!wallet)
         {
@@ -191,20 +628,26 @@ StaffProfileWithWallet *create_staff_profile(const char *email)
         }
 
         /* Initialize staff profile */
-        combined->profile.staff_id = next_staff_id++;
+        memset(&combined->profile, 0, sizeof(combined->profile));
+        combined->profile.staff_id = next_staff_id;
         strncpy(combined->profile.email, email, MAX_EMAIL - 1);
         strncpy(combined->profile.wallet_address, wallet->address, HASH_LENGTH);
 
         /* Copy wallet into combined struct */
         memcpy(&combined->wallet, wallet, sizeof(Wallet));
+        free(wallet);
+
+        if (!add_profile(STAFF, &combined->profile))
+        {
+                printf("Failed to save staff profile\n");
+                free(combined);
+                return NULL;
+        }
 
         printf("\nStaff Profile Created:\n");
         printf("Email: %s\n", combined->profile.email);
         printf("Wallet Address: %s\n", combined->profile.wallet_address);
 
-        staff_count++;
-        free(wallet);
-        save_profiles_to_file();
         return combined;
 }
 
@@ -234,12 +677,6 @@ VendorProfileWithWallet *create_vendor_profile(const char *kitchen_name, const c
                 return NULL;
         }
 
-        if (vendor_count >= MAX_TRANSACTIONS)
-        {
-                printf("Maximum number of vendors reached\n");
-                return NULL;
-        }
-
         wallet = create_wallet(email, kitchen_name);
         if (!wallet)
         {
@@ -257,15 +694,24 @@ VendorProfileWithWallet *create_vendor_profile(const char *kitchen_name, const c
         }
 
         /* Initialize vendor profile */
-        combined->profile.vendor_id = next_vendor_id++;
-        strncpy(combined->profile.kitchen_name, kitchen_name, MAX_NAME - 1);
-        strncpy(combined->profile.email, email, MAX_EMAIL - 1);
-        strncpy(combined->profile.wallet_address, wallet->address, HASH_LENGTH);
-        combined->profile.balance = 0.0;
+        memset(&combined->profile, 0, sizeof(combined->profile));
+        combined->profile.vendor_id = next_vendor_id;
+        strncpy(combined->profile.kitchen_name, kitchen_name, sizeof(combined->profile.kitchen_name) - 1);
+        strncpy(combined->profile.email, email, sizeof(combined->profile.email) - 1);
+        strncpy(combined->profile.wallet_address, wallet->address, HASH_LENGTH - 1);
+        combined->profile.balance = 0;
 
         /* Copy wallet into combined struct */
         memcpy(&combined->wallet, wallet, sizeof(Wallet));
 
+        if (!add_profile(VENDOR, &combined->profile))
+        {
+                printf("Failed to save vendor profile\n");
+                free(wallet);
+                free(combined);
+                return NULL;
+        }
+
         printf("\nVendor Profile Created:\n");
         printf("ID: %u\n", combined->profile.vendor_id);
         printf("Kitchen Name: %s\n", combined->profile.kitchen_name);
@@ -275,48 +721,100 @@ VendorProfileWithWallet *create_vendor_profile(const char *kitchen_name, const c
         printf("Vendor wallet address: %s\n", wallet->address);
         add_kitchen(kitchen_name, wallet->email, wallet->address);
 
-        vendor_count++;
         free(wallet);
-        save_profiles_to_file();
         return combined;
 }
 
 /**
- * get_profile_by_email - Get profile by email address
- * @email: Email to search for
- * @type: Pointer to store profile type
- * Return: Void pointer to profile or NULL if not found
+ * add_enrolled_profiles - Add profiles for a batch of new wallets
+ * @wallets: Student and staff wallets already saved to WALLETS_FILE
+ * @count: Number of wallets
+ *
+ * The batch is recorded in the journal with a single write.
+ *
+ * Return: 1 on success, 0 on failure
  */
-void *get_profile_by_email(const char *email, UserType *type)
+int add_enrolled_profiles(const StoredWallet *wallets, int count)
 {
-        int i;
+        ProfileRecord *records;
+        StudentProfile student;
+        StaffProfile member;
+        int i, ok = 1;
 
-        for (i = 0; i < student_count; i++)
-        {
-                if (strcmp(students[i].email, email) == 0)
-                {
-                        *type = STUDENT;
-                        return &students[i];
-                }
-        }
+        records = malloc((size_t)(count ? count : 1) * sizeof(ProfileRecord));
+        if (!records)
+                return 0;
 
-        for (i = 0; i < staff_count; i++)
+        for (i = 0; ok && i < count; i++)
         {
-                if (strcmp(staff[i].email, email) == 0)
+                if (wallets[i].user_type == STUDENT)
                 {
-                        *type = STAFF;
-                        return &staff[i];
+                        memset(&student, 0, sizeof(student));
+                        student.student_id = next_student_id;
+                        strcpy(student.email, wallets[i].email);
+                        strcpy(student.wallet_address, wallets[i].address);
+                        make_record(&records[i], STUDENT, &student);
+                        ok = store_profile(STUDENT, &student);
                 }
-        }
-
-        for (i = 0; i < vendor_count; i++)
-        {
-                if (strcmp(vendors[i].email, email) == 0)
+                else if (wallets[i].user_type == STAFF)
                 {
-                        *type = VENDOR;
-                        return &vendors[i];
+                        memset(&member, 0, sizeof(member));
+                        member.staff_id = next_staff_id;
+                        strcpy(member.email, wallets[i].email);
+                        strcpy(member.wallet_address, wallets[i].address);
+                        make_record(&records[i], STAFF, &member);
+                        ok = store_profile(STAFF, &member);
                 }
+                else
+                        ok = 0;
         }
 
-        return NULL;
-}
\ No newline at end of file
+        /* Record whatever made it into memory so the two stay in step */
+        count = ok ? count : i - 1;
+        ok = append_journal(records, count) && ok;
+        free(records);
+        return ok;
+}
+
+/**
+ * get_profile_by_email - Get profile by email address
+ * @email: Email to search for
+ * @type: Pointer to store profile type
+ * Return: Void pointer to profile or NULL if not found; valid until the
+ * next profile is added
+ */
+void *get_profile_by_email(const char *email, UserType *type)
+{
+        uint32_t ref;
+
+        if (!email || !(ref = find_profile_by_email(email)))
+                return NULL;
+
+        *type = REF_TYPE(ref);
+        if (*type == STUDENT)
+                return &students[REF_INDEX(ref)];
+        if (*type == STAFF)
+                return &staff[REF_INDEX(ref)];
+        return &vendors[REF_INDEX(ref)];
+}
+
+/**
+ * get_profile_by_id - Get profile by its student, staff or vendor ID
+ * @type: STUDENT, STAFF or VENDOR
+ * @id: Profile ID
+ * Return: Void pointer to profile or NULL if not found; valid until the
+ * next profile is added
+ */
+void *get_profile_by_id(UserType type, unsigned int id)
+{
+        uint32_t ref;
+
+        if (!index_slot_count || (ref = id_slots[find_id_slot(id_slots, type, id)]) == 0)
+                return NULL;
+
+        if (type == STUDENT)
+                return &students[REF_INDEX(ref)];
+        if (type == STAFF)
+                return &staff[REF_INDEX(ref)];
+        return &vendors[REF_INDEX(ref)];
+}
@@ -0,0 +1,289 @@
+/* settlement.c */
+#include "alu_blockchain.h"
+#include "settlement.h"
+#include "wal.h"
+
+/*
+ * Settlement aggregates hold, per recipient account, UTC day and
+ * transaction type, how many transactions were received and their total.
+ * They are updated as each transaction is logged, stored in snapshots with
+ * the balances, and answer end-of-day queries with one lookup per type
+ * instead of a scan of the log.
+ */
+
+#define SETTLEMENT_MIN_SLOTS 256
+
+/**
+ * entry_key - Hash of a settlement key
+ * @account_id: Account ID
+ * @day: Day number
+ * @type: TransactionType
+ * Return: 32-bit hash
+ */
+static uint32_t entry_key(uint32_t account_id, uint32_t day, uint32_t type)
+{
+        uint32_t key = account_id * 2654435761u;
+
+        key ^= (day * 40503u + type) * 2246822519u;
+        return key ^ key >> 15;
+}
+
+/**
+ * find_slot - Find the slot holding a key or the empty slot for it
+ * @table: Table with at least one slot
+ * @account_id: Account ID
+ * @day: Day number
+ * @type: TransactionType
+ * Return: Slot
+ */
+static SettlementEntry *find_slot(const SettlementTable *table, uint32_t account_id,
+                                  uint32_t day, uint32_t type)
+{
+        size_t mask = table->slot_count - 1;
+        size_t i = entry_key(account_id, day, type) & mask;
+        SettlementEntry *slot;
+
+        for (;; i = (i + 1) & mask)
+        {
+                slot = &table->slots[i];
+                if (!slot->count ||
+                    (slot->account_id == account_id && slot->day == day && slot->type == type))
+                        return slot;
+        }
+}
+
+/**
+ * grow_table - Double the table and reinsert every entry
+ * @table: Table
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int grow_table(SettlementTable *table)
+{
+        SettlementTable grown;
+        size_t i;
+
+        grown.slot_count = table->slot_count ? table->slot_count * 2 : SETTLEMENT_MIN_SLOTS;
+        grown.count = table->count;
+        grown.slots = calloc(grown.slot_count, sizeof(SettlementEntry));
+        if (!grown.slots)
+                return 0;
+
+        for (i = 0; i < table->slot_count; i++)
+        {
+                if (table->slots[i].count)
+                        *find_slot(&grown, table->slots[i].account_id, table->slots[i].day,
+                                   table->slots[i].type) = table->slots[i];
+        }
+
+        free(table->slots);
+        *table = grown;
+        return 1;
+}
+
+/**
+ * settlement_init - Start an empty table
+ * @table: Table to initialise
+ */
+void settlement_init(SettlementTable *table)
+{
+        memset(table, 0, sizeof(SettlementTable));
+}
+
+/**
+ * settlement_free - Release a table and leave it empty
+ * @table: Table to free
+ */
+void settlement_free(SettlementTable *table)
+{
+        free(table->slots);
+        settlement_init(table);
+}
+
+/**
+ * settlement_add - Merge an entry into a table
+ * @table: Table
+ * @entry: Entry with a nonzero count
+ * Return: 1 on success, 0 on allocation failure or overflow
+ */
+int settlement_add(SettlementTable *table, const SettlementEntry *entry)
+{
+        SettlementEntry *slot;
+
+        if (entry->count == 0 || entry->type >= SETTLEMENT_TYPES)
+                return entry->count == 0;
+
+        /* Keep the load factor at or below one half */
+        if ((table->count + 1) * 2 > table->slot_count && !grow_table(table))
+                return 0;
+
+        slot = find_slot(table, entry->account_id, entry->day, entry->type);
+        if (!slot->count)
+        {
+                *slot = *entry;
+                table->count++;
+                return 1;
+        }
+
+        if (slot->count > UINT32_MAX - entry->count)
+                return 0;
+        slot->count += entry->count;
+        return lt_add(slot->total, entry->total, &slot->total);
+}
+
+/**
+ * settlement_record - Count a transaction towards its recipient's takings
+ * @table: Table
+ * @transaction: Logged transaction
+ * Return: 1 on success, 0 on allocation failure or overflow
+ */
+int settlement_record(SettlementTable *table, const Transaction *transaction)
+{
+        SettlementEntry entry;
+
+        entry.account_id = transaction->to_id;
+        entry.day = transaction->timestamp < 0 ? 0 : (uint32_t)(transaction->timestamp / SECONDS_PER_DAY);
+        entry.type = transaction->type;
+        entry.count = 1;
+        entry.total = transaction->amount;
+        return settlement_add(table, &entry);
+}
+
+/**
+ * settlement_day - Look up one account's takings on one day
+ * @table: Table
+ * @account_id: Account ID
+ * @day: Day number
+ * @out: Receives the takings by type
+ */
+void settlement_day(const SettlementTable *table, uint32_t account_id, uint32_t day,
+                    SettlementDay *out)
+{
+        const SettlementEntry *slot;
+        uint32_t type;
+
+        memset(out, 0, sizeof(SettlementDay));
+        if (!table->slot_count)
+                return;
+
+        for (type = 0; type < SETTLEMENT_TYPES; type++)
+        {
+                slot = find_slot(table, account_id, day, type);
+                out->count[type] = slot->count;
+                out->total[type] = slot->count ? slot->total : 0;
+        }
+}
+
+/**
+ * settlement_export - Copy every entry in use
+ * @table: Table
+ * @out: Buffer of at least @table->count entries
+ * Return: Number of entries copied
+ */
+size_t settlement_export(const SettlementTable *table, SettlementEntry *out)
+{
+        size_t i, n = 0;
+
+        for (i = 0; i < table->slot_count; i++)
+        {
+                if (table->slots[i].count)
+                        out[n++] = table->slots[i];
+        }
+        return n;
+}
+
+/**
+ * vendor_settlement - Takings of a wallet address on one day
+ * @address: Wallet address
+ * @day: Days since the epoch, in UTC
+ * @out: Receives the takings by type; all zero for an unknown address
+ * Return: 1 on success, 0 if the transaction log cannot be opened
+ */
+int vendor_settlement(const char *address, uint32_t day, SettlementDay *out)
+{
+        uint32_t id;
+
+        memset(out, 0, sizeof(SettlementDay));
+        if (!address || !wal_open())
+                return 0;
+
+        id = address_lookup(address);
+        if (id == ADDRESS_ID_NONE)
+                return 1;
+        return wal_settlement_day(id, day, out);
+}
+
+/**
+ * parse_settlement_day - Parse a YYYY-MM-DD date into a day number
+ * @date: Date, read as UTC
+ * @day: Receives the days since the epoch
+ * Return: 1 on success, 0 if @date is not a valid date from 1970 on
+ */
+int parse_settlement_day(const char *date, uint32_t *day)
+{
+        int year, month, mday, leap, length;
+        char extra;
+
+        if (!date || sscanf(date, "%4d-%2d-%2d%c", &year, &month, &mday, &extra) != 3 ||
+            year < 1970 || month < 1 || month > 12 || mday < 1)
+                return 0;
+
+        leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        length = month == 2 ? 28 + leap : 30 + ((month + (month > 7)) & 1);
+        if (mday > length)
+                return 0;
+
+        *day = (uint32_t)(civil_to_epoch(year, month, mday, 0, 0, 0) / SECONDS_PER_DAY);
+        return 1;
+}
+
+/**
+ * print_settlement_report - Print every kitchen's takings on one day
+ * @day: Days since the epoch, in UTC
+ * Return: 1 on success, 0 on failure
+ */
+int print_settlement_report(uint32_t day)
+{
+        static const char *const type_names[] = {
+            "Tuition Fee", "Cafeteria Payment", "Library Fine",
+            "Health Insurance", "Token Transfer"};
+        const VendorProfile *kitchen;
+        SettlementDay takings;
+        char date[16], amount[LT_FORMAT_SIZE];
+        time_t start = (time_t)day * SECONDS_PER_DAY;
+        int64_t total;
+        uint32_t count;
+        int type;
+
+        strftime(date, sizeof(date), "%Y-%m-%d", gmtime(&start));
+        printf("\n=== Settlement for %s (UTC) ===\n", date);
+        if (!vendor_list)
+        {
+                printf("No kitchens registered.\n");
+                return 1;
+        }
+
+        for (kitchen = vendor_list; kitchen; kitchen = kitchen->next)
+        {
+                if (!vendor_settlement(kitchen->wallet_address, day, &takings))
+                        return 0;
+
+                total = 0;
+                count = 0;
+                for (type = 0; type < SETTLEMENT_TYPES; type++)
+                {
+                        total += takings.total[type];
+                        count += takings.count[type];
+                }
+
+                printf("%-24s %6u payment(s) %14s %s\n", kitchen->kitchen_name, count,
+                       lt_format(total, amount), TOKEN_SYMBOL);
+                for (type = 0; type < SETTLEMENT_TYPES; type++)
+                {
+                        if (takings.count[type])
+                                printf("  %-22s %6u payment(s) %14s %s\n", type_names[type],
+                                       takings.count[type], lt_format(takings.total[type], amount),
+                                       TOKEN_SYMBOL);
+                }
+        }
+        return 1;
+}
@@ -0,0 +1,63 @@
+/* settlement.h */
+#ifndef SETTLEMENT_H
+#define SETTLEMENT_H
+
+#include "alu_blockchain.h"
+#include <stdint.h>
+
+#define SECONDS_PER_DAY 86400
+#define SETTLEMENT_TYPES (TOKEN_TRANSFER + 1)
+
+/**
+ * struct SettlementEntry - Takings of one account on one day for one type
+ * @account_id: Recipient account ID
+ * @day: Days since the epoch, in UTC
+ * @type: TransactionType
+ * @count: Number of transactions; 0 marks an empty slot
+ * @total: Sum of their amounts, in micro-LT
+ */
+typedef struct
+{
+        uint32_t account_id;
+        uint32_t day;
+        uint32_t type;
+        uint32_t count;
+        int64_t total;
+} SettlementEntry;
+
+/**
+ * struct SettlementTable - Open-addressing table of settlement entries
+ * @slots: Entries; a slot with a zero count is empty
+ * @slot_count: Number of slots, a power of two
+ * @count: Number of entries in use
+ */
+typedef struct
+{
+        SettlementEntry *slots;
+        size_t slot_count;
+        size_t count;
+} SettlementTable;
+
+/**
+ * struct SettlementDay - One account's takings on one day, by type
+ * @count: Transactions of each TransactionType
+ * @total: Micro-LT received through each TransactionType
+ */
+typedef struct
+{
+        uint32_t count[SETTLEMENT_TYPES];
+        int64_t total[SETTLEMENT_TYPES];
+} SettlementDay;
+
+void settlement_init(SettlementTable *table);
+void settlement_free(SettlementTable *table);
+int settlement_add(SettlementTable *table, const SettlementEntry *entry);
+int settlement_record(SettlementTable *table, const Transaction *transaction);
+void settlement_day(const SettlementTable *table, uint32_t account_id, uint32_t day,
+                    SettlementDay *out);
+size_t settlement_export(const SettlementTable *table, SettlementEntry *out);
+int vendor_settlement(const char *address, uint32_t day, SettlementDay *out);
+int parse_settlement_day(const char *date, uint32_t *day);
+int print_settlement_report(uint32_t day);
+
+#endif /* SETTLEMENT_H */
@@ -0,0 +1,481 @@
+/* signature.c */
+#define _XOPEN_SOURCE 700
+#include "alu_blockchain.h"
+#include "wal.h"
+#include <pthread.h>
+
+/*
+ * Ed25519 wallet keys and transaction signatures. A wallet's address is
+ * its public key in hex and its private key is the 32-byte seed in hex, so
+ * both keep the 64-character format of the hash-derived values they
+ * replace, and a verifier needs nothing but the address book. Verifying a
+ * block's body is split across a persistent pool of threads, each range
+ * with its own OpenSSL contexts. Transactions migrated from the pre-WAL
+ * files keep the unkeyed digest they were stored with; it is recomputed,
+ * and only accepted within the log's migration cutoff.
+ */
+
+#define DIGEST_TEXT_SIZE (2 * WAL_ADDRESS_BYTES + 64)
+
+#define ED25519_KEY_LENGTH 32
+#define VERIFY_MAX_THREADS 8
+#define VERIFY_MIN_PER_THREAD 8
+
+/**
+ * struct SignedMessage - Bytes a transaction signature covers
+ * @fields: The record up to its signature, signature_type included
+ * @from_address: Sender address, zero-padded like WalAddress
+ * @to_address: Recipient address, zero-padded like WalAddress
+ *
+ * Signing the addresses rather than only the account IDs ties the
+ * signature to the accounts themselves, not to their place in the log.
+ */
+typedef struct
+{
+        unsigned char fields[offsetof(Transaction, signature)];
+        char from_address[WAL_ADDRESS_BYTES];
+        char to_address[WAL_ADDRESS_BYTES];
+} SignedMessage;
+
+/**
+ * struct VerifyWorker - Range of transactions one thread verifies at a time
+ * @transactions: Transactions being verified
+ * @begin: First transaction of the range
+ * @end: One past the last transaction of the range
+ * @invalid: Set once a signature or digest in the range fails
+ * @unsigned_count: Migrated TX_SIGNED_DIGEST transactions in the range
+ */
+typedef struct
+{
+        const Transaction *transactions;
+        int begin;
+        int end;
+        int invalid;
+        int unsigned_count;
+} VerifyWorker;
+
+/* Helper threads, started by the first verify_signatures() call */
+static pthread_mutex_t verify_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+static int pool_threads = -1;
+static VerifyWorker *pool_ranges;
+static int pool_range_count;
+static int pool_next;
+static int pool_pending;
+
+/**
+ * build_message - Lay out the bytes a transaction signature covers
+ * @transaction: Transaction
+ * @from_address: Sender address
+ * @to_address: Recipient address
+ * @message: Message to fill
+ * Return: 1 on success, 0 if an address is missing or too long
+ */
+static int build_message(const Transaction *transaction, const char *from_address,
+                         const char *to_address, SignedMessage *message)
+{
+        if (!from_address || !to_address || strlen(from_address) > WAL_ADDRESS_BYTES ||
+            strlen(to_address) > WAL_ADDRESS_BYTES)
+                return 0;
+
+        memset(message, 0, sizeof(SignedMessage));
+        memcpy(message->fields, transaction, sizeof(message->fields));
+        strncpy(message->from_address, from_address, WAL_ADDRESS_BYTES);
+        strncpy(message->to_address, to_address, WAL_ADDRESS_BYTES);
+        return 1;
+}
+
+/**
+ * key_from_hex - Load an Ed25519 key from 64 hex digits
+ * @hex: Public key or private seed in hex
+ * @is_private: 1 if @hex is a private seed
+ * Return: Key (caller frees), or NULL if @hex is not a key
+ */
+static EVP_PKEY *key_from_hex(const char *hex, int is_private)
+{
+        unsigned char raw[ED25519_KEY_LENGTH];
+        EVP_PKEY *key;
+
+        if (strlen(hex) != 2 * ED25519_KEY_LENGTH || !hex_decode(hex, raw, ED25519_KEY_LENGTH))
+                return NULL;
+
+        if (is_private)
+                key = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, NULL, raw, ED25519_KEY_LENGTH);
+        else
+                key = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, NULL, raw, ED25519_KEY_LENGTH);
+        OPENSSL_cleanse(raw, sizeof(raw));
+        return key;
+}
+
+/**
+ * key_address - Format the public half of a key as an address
+ * @key: Ed25519 key
+ * @address: Output buffer of HASH_LENGTH + 1 bytes
+ * Return: 1 on success, 0 on failure
+ */
+static int key_address(EVP_PKEY *key, char *address)
+{
+        unsigned char raw[ED25519_KEY_LENGTH];
+        size_t length = sizeof(raw);
+
+        if (EVP_PKEY_get_raw_public_key(key, raw, &length) <= 0 || length != sizeof(raw))
+                return 0;
+        hex_encode(raw, length, address);
+        return 1;
+}
+
+/**
+ * generate_wallet_keys - Create a new Ed25519 key pair for a wallet
+ * @address: Output buffer of HASH_LENGTH + 1 bytes for the public key in hex
+ * @private_key: Output buffer of HASH_LENGTH + 1 bytes for the seed in hex
+ * Return: 1 on success, 0 on failure
+ */
+int generate_wallet_keys(char *address, char *private_key)
+{
+        EVP_PKEY_CTX *ctx;
+        EVP_PKEY *key = NULL;
+        unsigned char raw[ED25519_KEY_LENGTH];
+        size_t length = sizeof(raw);
+        int ok;
+
+        ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, NULL);
+        ok = ctx && EVP_PKEY_keygen_init(ctx) > 0 && EVP_PKEY_keygen(ctx, &key) > 0 &&
+             key_address(key, address) &&
+             EVP_PKEY_get_raw_private_key(key, raw, &length) > 0 && length == sizeof(raw);
+        if (ok)
+                hex_encode(raw, length, private_key);
+
+        OPENSSL_cleanse(raw, sizeof(raw));
+        EVP_PKEY_free(key);
+        EVP_PKEY_CTX_free(ctx);
+        return ok;
+}
+
+/**
+ * wallet_has_signing_key - Whether a wallet's address is its key's public half
+ * @wallet: Wallet
+ *
+ * Wallets created before key pairs have hash-derived addresses and cannot
+ * sign until upgrade_wallet_keys() moves them to a key pair.
+ *
+ * Return: 1 if the wallet can sign transactions, 0 otherwise
+ */
+int wallet_has_signing_key(const Wallet *wallet)
+{
+        char address[HASH_LENGTH + 1];
+        EVP_PKEY *key;
+        int ok;
+
+        key = wallet ? key_from_hex(wallet->private_key, 1) : NULL;
+        ok = key && key_address(key, address) && strcmp(address, wallet->address) == 0;
+        EVP_PKEY_free(key);
+        return ok;
+}
+
+/**
+ * sign_transaction - Sign a transaction with the sender's Ed25519 key
+ * @transaction: Transaction with every field but the signature filled in
+ * @private_key: Sender's private key in hex
+ * @from_address: Sender address, the account of from_id
+ * @to_address: Recipient address, the account of to_id
+ * Return: 1 on success, 0 on failure
+ */
+int sign_transaction(Transaction *transaction, const char *private_key,
+                     const char *from_address, const char *to_address)
+{
+        SignedMessage message;
+        EVP_MD_CTX *ctx;
+        EVP_PKEY *key;
+        size_t length = TX_SIGNATURE_LENGTH;
+        int ok;
+
+        if (!transaction || !private_key)
+                return 0;
+
+        transaction->signature_type = TX_SIGNED_ED25519;
+        memset(transaction->signature, 0, TX_SIGNATURE_LENGTH);
+        if (!build_message(transaction, from_address, to_address, &message))
+                return 0;
+
+        key = key_from_hex(private_key, 1);
+        ctx = EVP_MD_CTX_new();
+        ok = key && ctx && EVP_DigestSignInit(ctx, NULL, NULL, NULL, key) > 0 &&
+             EVP_DigestSign(ctx, transaction->signature, &length, (const unsigned char *)&message,
+                            sizeof(message)) > 0 &&
+             length == TX_SIGNATURE_LENGTH;
+
+        EVP_MD_CTX_free(ctx);
+        EVP_PKEY_free(key);
+        return ok;
+}
+
+/**
+ * check_signature - Verify one Ed25519-signed transaction
+ * @ctx: Digest context, reused between calls
+ * @key: Cached public key of account @key_id, replaced when the sender changes
+ * @key_id: Account ID @key belongs to
+ * @transaction: TX_SIGNED_ED25519 transaction
+ * Return: 1 if the sender's key signed it, 0 otherwise
+ */
+static int check_signature(EVP_MD_CTX *ctx, EVP_PKEY **key, uint32_t *key_id,
+                           const Transaction *transaction)
+{
+        SignedMessage message;
+        const char *from_address = address_of(transaction->from_id);
+
+        if (!build_message(transaction, from_address, address_of(transaction->to_id), &message))
+                return 0;
+
+        /* Consecutive transactions often share a sender */
+        if (!*key || *key_id != transaction->from_id)
+        {
+                EVP_PKEY_free(*key);
+                *key = key_from_hex(from_address, 0);
+                *key_id = transaction->from_id;
+                if (!*key)
+                        return 0;
+        }
+
+        return EVP_MD_CTX_reset(ctx) == 1 && EVP_DigestVerifyInit(ctx, NULL, NULL, NULL, *key) > 0 &&
+               EVP_DigestVerify(ctx, transaction->signature, TX_SIGNATURE_LENGTH,
+                                (const unsigned char *)&message, sizeof(message)) == 1;
+}
+
+/**
+ * check_digest - Verify a digest carried over from the pre-WAL files
+ * @transaction: TX_SIGNED_DIGEST transaction
+ *
+ * The old files hashed the record's text: both addresses, the amount in
+ * LT to two decimals and the timestamp.
+ *
+ * Return: 1 if the transaction is within the migration cutoff and its
+ * digest matches, 0 otherwise
+ */
+static int check_digest(const Transaction *transaction)
+{
+        char text[DIGEST_TEXT_SIZE];
+        unsigned char digest[SIGNATURE_LENGTH];
+        const char *from_address = address_of(transaction->from_id);
+        const char *to_address = address_of(transaction->to_id);
+
+        if (!from_address || !to_address || !wal_accepts_digest(transaction))
+                return 0;
+
+        snprintf(text, sizeof(text), "%s%s%.2f%lld", from_address, to_address,
+                 (double)transaction->amount / MICRO_LT_PER_LT, (long long)transaction->timestamp);
+        generate_digest(text, digest);
+        return memcmp(digest, transaction->signature, SIGNATURE_LENGTH) == 0;
+}
+
+/**
+ * verify_signature - Check that a transaction's sender signed it
+ * @transaction: Transaction
+ * Return: 1 if it carries a valid Ed25519 signature by its sender, 0 if
+ * the signature is bad or the transaction is TX_SIGNED_DIGEST
+ */
+int verify_signature(const Transaction *transaction)
+{
+        EVP_MD_CTX *ctx;
+        EVP_PKEY *key = NULL;
+        uint32_t key_id = ADDRESS_ID_NONE;
+        int ok;
+
+        if (!transaction || transaction->signature_type != TX_SIGNED_ED25519)
+                return 0;
+
+        ctx = EVP_MD_CTX_new();
+        ok = ctx && check_signature(ctx, &key, &key_id, transaction);
+        EVP_PKEY_free(key);
+        EVP_MD_CTX_free(ctx);
+        return ok;
+}
+
+/**
+ * verify_range - Verify the signatures in one range
+ * @worker: Range to verify; its results are filled in
+ */
+static void verify_range(VerifyWorker *worker)
+{
+        const Transaction *transaction;
+        EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+        EVP_PKEY *key = NULL;
+        uint32_t key_id = ADDRESS_ID_NONE;
+        int i;
+
+        for (i = worker->begin; i < worker->end && !worker->invalid; i++)
+        {
+                transaction = &worker->transactions[i];
+                if (transaction->signature_type == TX_SIGNED_DIGEST)
+                {
+                        if (check_digest(transaction))
+                                worker->unsigned_count++;
+                        else
+                                worker->invalid = 1;
+                }
+                else if (transaction->signature_type != TX_SIGNED_ED25519 || !ctx ||
+                         !check_signature(ctx, &key, &key_id, transaction))
+                {
+                        worker->invalid = 1;
+                }
+        }
+
+        EVP_PKEY_free(key);
+        EVP_MD_CTX_free(ctx);
+}
+
+/**
+ * take_range - Claim the next unverified range of the current call
+ * Return: Range to verify, or NULL if none is left
+ *
+ * The caller holds pool_lock.
+ */
+static VerifyWorker *take_range(void)
+{
+        if (pool_next >= pool_range_count)
+                return NULL;
+        return &pool_ranges[pool_next++];
+}
+
+/**
+ * finish_range - Record that a claimed range has been verified
+ *
+ * The caller holds pool_lock.
+ */
+static void finish_range(void)
+{
+        if (--pool_pending == 0)
+                pthread_cond_signal(&pool_done);
+}
+
+/**
+ * pool_worker - Verify ranges for as long as the process runs
+ * @arg: Unused
+ * Return: Never returns
+ */
+static void *pool_worker(void *arg)
+{
+        VerifyWorker *range;
+
+        (void)arg;
+        pthread_mutex_lock(&pool_lock);
+        for (;;)
+        {
+                range = take_range();
+                if (!range)
+                {
+                        pthread_cond_wait(&pool_work, &pool_lock);
+                        continue;
+                }
+                pthread_mutex_unlock(&pool_lock);
+                verify_range(range);
+                pthread_mutex_lock(&pool_lock);
+                finish_range();
+        }
+        return NULL;
+}
+
+/**
+ * start_pool - Start the helper threads on first use
+ *
+ * One helper per CPU beyond the calling thread, up to VERIFY_MAX_THREADS
+ * in all. A helper that cannot be started leaves its share to the others.
+ * The caller holds verify_lock.
+ */
+static void start_pool(void)
+{
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        pthread_t thread;
+        int wanted, i;
+
+        if (pool_threads >= 0)
+                return;
+
+        pool_threads = 0;
+        wanted = cpus < 1 ? 0 : cpus > VERIFY_MAX_THREADS ? VERIFY_MAX_THREADS - 1 : (int)cpus - 1;
+        for (i = 0; i < wanted; i++)
+        {
+                if (pthread_create(&thread, NULL, pool_worker, NULL) != 0)
+                        break;
+                pthread_detach(thread);
+                pool_threads++;
+        }
+}
+
+/**
+ * verify_signatures - Verify the signatures of a block's transactions
+ * @transactions: Transactions
+ * @count: Number of transactions
+ * @unsigned_count: Receives the number of migrated TX_SIGNED_DIGEST
+ *                  transactions, whose digests were checked instead of a
+ *                  signature; may be NULL
+ *
+ * The transactions are split into ranges shared between the calling
+ * thread and a pool of helper threads started on the first call and kept
+ * for later ones. Calls are serialized, and the address book must not
+ * change meanwhile.
+ *
+ * Return: 1 if every transaction verifies, 0 otherwise
+ */
+int verify_signatures(const Transaction *transactions, int count, int *unsigned_count)
+{
+        VerifyWorker ranges[VERIFY_MAX_THREADS];
+        VerifyWorker *range;
+        int range_count, t, ok = 1;
+
+        if (unsigned_count)
+                *unsigned_count = 0;
+        if (count <= 0)
+                return 1;
+        if (!transactions)
+                return 0;
+
+        pthread_mutex_lock(&verify_lock);
+        start_pool();
+
+        range_count = pool_threads + 1;
+        if (range_count > count / VERIFY_MIN_PER_THREAD)
+                range_count = count / VERIFY_MIN_PER_THREAD ? count / VERIFY_MIN_PER_THREAD : 1;
+
+        for (t = 0; t < range_count; t++)
+        {
+                ranges[t].transactions = transactions;
+                ranges[t].begin = (int)((long)count * t / range_count);
+                ranges[t].end = (int)((long)count * (t + 1) / range_count);
+                ranges[t].invalid = 0;
+                ranges[t].unsigned_count = 0;
+        }
+
+        pthread_mutex_lock(&pool_lock);
+        pool_ranges = ranges;
+        pool_range_count = range_count;
+        pool_next = 0;
+        pool_pending = range_count;
+        if (range_count > 1)
+                pthread_cond_broadcast(&pool_work);
+
+        /* The calling thread verifies ranges too, so none waits on a busy pool */
+        while ((range = take_range()))
+        {
+                pthread_mutex_unlock(&pool_lock);
+                verify_range(range);
+                pthread_mutex_lock(&pool_lock);
+                finish_range();
+        }
+        while (pool_pending > 0)
+                pthread_cond_wait(&pool_done, &pool_lock);
+        pool_ranges = NULL;
+        pool_range_count = 0;
+        pthread_mutex_unlock(&pool_lock);
+        pthread_mutex_unlock(&verify_lock);
+
+        for (t = 0; t < range_count; t++)
+        {
+                if (ranges[t].invalid)
+                        ok = 0;
+                if (unsigned_count)
+                        *unsigned_count += ranges[t].unsigned_count;
+        }
+        return ok;
+}
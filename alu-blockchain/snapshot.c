@@ -0,0 +1,579 @@
+/* snapshot.c */
+#define _XOPEN_SOURCE 700
+#include "alu_blockchain.h"
+#include "config.h"
+#include "snapshot.h"
+#include <fcntl.h>
+#include <limits.h>
+
+/*
+ * A snapshot is every account balance, plus the pending pool and the
+ * settlement aggregates, right after the block mark of one height was
+ * logged. Startup loads the newest one
+ * and replays only the log frames after it; historical queries load the
+ * nearest one at or below the requested height and replay forward.
+ */
+
+/**
+ * ledger_init - Start an empty ledger at the beginning of the log
+ * @state: Ledger to initialise
+ */
+void ledger_init(LedgerState *state)
+{
+        memset(state, 0, sizeof(LedgerState));
+}
+
+/**
+ * ledger_free - Release a ledger and leave it empty
+ * @state: Ledger to free
+ */
+void ledger_free(LedgerState *state)
+{
+        free(state->balances);
+        free(state->pending);
+        settlement_free(&state->settlements);
+        ledger_init(state);
+}
+
+/**
+ * add_account - Give the next account ID its initial balance
+ * @state: Ledger
+ * @balance: Starting balance
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int add_account(LedgerState *state, int64_t balance)
+{
+        int64_t *grown;
+        uint32_t capacity;
+
+        if (state->account_count == state->account_capacity)
+        {
+                capacity = state->account_capacity ? state->account_capacity * 2 : 128;
+                grown = realloc(state->balances, capacity * sizeof(int64_t));
+                if (!grown)
+                        return 0;
+                state->balances = grown;
+                state->account_capacity = capacity;
+        }
+
+        state->balances[state->account_count++] = balance;
+        return 1;
+}
+
+/**
+ * credit - Add a signed amount to an account
+ * @state: Ledger
+ * @id: Account ID; IDs never assigned (ADDRESS_ID_NONE) are ignored
+ * @amount: Micro-LT to add
+ * Return: 1 on success, 0 on overflow
+ */
+static int credit(LedgerState *state, uint32_t id, int64_t amount)
+{
+        if (id >= state->account_count)
+                return 1;
+        return lt_add(state->balances[id], amount, &state->balances[id]);
+}
+
+/**
+ * push_pending - Add a transaction to the ledger's pending pool
+ * @state: Ledger
+ * @transaction: Transaction to add
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int push_pending(LedgerState *state, const Transaction *transaction)
+{
+        Transaction *grown;
+        int capacity;
+
+        if (state->pending_count == state->pending_capacity)
+        {
+                capacity = state->pending_capacity ? state->pending_capacity * 2 : MAX_TRANSACTIONS;
+                grown = realloc(state->pending, (size_t)capacity * sizeof(Transaction));
+                if (!grown)
+                        return 0;
+                state->pending = grown;
+                state->pending_capacity = capacity;
+        }
+
+        state->pending[state->pending_count++] = *transaction;
+        return 1;
+}
+
+/**
+ * drop_pending - Remove the oldest transactions from the pending pool
+ * @state: Ledger
+ * @count: Number of transactions a block consumed
+ */
+static void drop_pending(LedgerState *state, int count)
+{
+        if (count <= 0)
+                return;
+        if (count > state->pending_count)
+                count = state->pending_count;
+
+        memmove(state->pending, state->pending + count,
+                (size_t)(state->pending_count - count) * sizeof(Transaction));
+        state->pending_count -= count;
+}
+
+/**
+ * ledger_apply - Apply the next log frame
+ * @state: Ledger positioned just before @frame
+ * @frame: Valid frame
+ *
+ * Address and rotate frames only assign the next account ID; the caller
+ * decides whether the global address book needs it too.
+ *
+ * Return: 1 on success, 0 on allocation failure, an out-of-range amount
+ * or a rotation that does not match the ledger
+ */
+int ledger_apply(LedgerState *state, const WalFrame *frame)
+{
+        const Transaction *tx = &frame->body.tx;
+        const WalBlockMark *block = &frame->body.block;
+        const WalRotate *rotate = &frame->body.rotate;
+        int64_t moved;
+
+        switch (frame->type)
+        {
+        case WAL_RECORD_TX:
+                if (!lt_valid(tx->amount) || !credit(state, tx->from_id, -tx->amount) ||
+                    !credit(state, tx->to_id, tx->amount) || !push_pending(state, tx) ||
+                    !settlement_record(&state->settlements, tx))
+                        return 0;
+                break;
+        case WAL_RECORD_BLOCK:
+                if (!lt_valid(block->reward) || !credit(state, block->validator_id, block->reward))
+                        return 0;
+                drop_pending(state, block->transaction_count);
+                state->height = block->block_index;
+                break;
+        case WAL_RECORD_ADJUST:
+                if (!credit(state, frame->body.adjust.account_id, frame->body.adjust.amount))
+                        return 0;
+                break;
+        case WAL_RECORD_ADDRESS:
+                if (!add_account(state, INITIAL_WALLET_BALANCE))
+                        return 0;
+                break;
+        case WAL_RECORD_ROTATE:
+                if (rotate->account_id >= state->account_count ||
+                    rotate->successor_id != state->account_count)
+                        return 0;
+                moved = state->balances[rotate->account_id];
+                if (!add_account(state, moved))
+                        return 0;
+                state->balances[rotate->account_id] = 0;
+                break;
+        }
+
+        state->lsn = frame->lsn;
+        state->frame_crc = frame->crc;
+        return 1;
+}
+
+/**
+ * ledger_balance - Balance of an account in a ledger
+ * @state: Ledger
+ * @id: Account ID, or ADDRESS_ID_NONE
+ * Return: Balance in micro-LT; accounts not yet seen hold the initial balance
+ */
+int64_t ledger_balance(const LedgerState *state, uint32_t id)
+{
+        if (id >= state->account_count)
+                return INITIAL_WALLET_BALANCE;
+        return state->balances[id];
+}
+
+/**
+ * snapshot_path - Build the file name of the snapshot at a height
+ * @height: Block height
+ * @path: Buffer of at least 512 bytes
+ * Return: 1 on success, 0 if there is no configuration
+ */
+static int snapshot_path(unsigned int height, char *path)
+{
+        const Config *config = get_config();
+
+        if (!config)
+                return 0;
+        sprintf(path, "%s/snapshot_%010u.dat", config->backup_directory, height);
+        return 1;
+}
+
+/**
+ * digest_snapshot - Compute the digest stored in a snapshot header
+ * @header: Header; its digest field is ignored
+ * @accounts: Account records
+ * @pending: Pending transactions
+ * @settlements: Settlement entries
+ * @digest: Output buffer of SIGNATURE_LENGTH bytes
+ */
+static void digest_snapshot(const SnapshotHeader *header, const SnapshotAccount *accounts,
+                            const Transaction *pending, const SettlementEntry *settlements,
+                            unsigned char *digest)
+{
+        SnapshotHeader copy = *header;
+        EVP_MD_CTX *mdctx;
+        unsigned int digest_len;
+
+        memset(copy.digest, 0, sizeof(copy.digest));
+        mdctx = EVP_MD_CTX_new();
+        EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL);
+        EVP_DigestUpdate(mdctx, &copy, sizeof(copy));
+        EVP_DigestUpdate(mdctx, accounts, header->account_count * sizeof(SnapshotAccount));
+        EVP_DigestUpdate(mdctx, pending, (size_t)header->pending_count * sizeof(Transaction));
+        EVP_DigestUpdate(mdctx, settlements, header->settlement_count * sizeof(SettlementEntry));
+        EVP_DigestFinal_ex(mdctx, digest, &digest_len);
+        EVP_MD_CTX_free(mdctx);
+}
+
+/**
+ * read_snapshot - Load and verify one snapshot file
+ * @height: Height of the snapshot
+ * @state: Empty ledger to fill
+ * @define_addresses: Nonzero to also fill the (empty) global address book
+ * Return: 1 on success, 0 if the file is missing, damaged or inconsistent
+ */
+static int read_snapshot(unsigned int height, LedgerState *state, int define_addresses)
+{
+        SnapshotHeader header;
+        SnapshotAccount *accounts = NULL;
+        SettlementEntry *settlements = NULL;
+        unsigned char digest[SIGNATURE_LENGTH];
+        char address[WAL_ADDRESS_BYTES + 1];
+        char path[512];
+        FILE *file;
+        uint32_t i;
+        int ok;
+
+        if (!snapshot_path(height, path))
+                return 0;
+        file = fopen(path, "rb");
+        if (!file)
+                return 0;
+
+        ok = fread(&header, sizeof(header), 1, file) == 1 &&
+             header.magic == SNAPSHOT_MAGIC && header.version == SNAPSHOT_VERSION &&
+             header.height == height && header.pending_count >= 0;
+        if (ok)
+        {
+                accounts = malloc((header.account_count + 1) * sizeof(SnapshotAccount));
+                settlements = malloc(((size_t)header.settlement_count + 1) * sizeof(SettlementEntry));
+                state->pending = malloc(((size_t)header.pending_count + 1) * sizeof(Transaction));
+                state->pending_capacity = header.pending_count + 1;
+                ok = accounts && settlements && state->pending &&
+                     fread(accounts, sizeof(SnapshotAccount), header.account_count, file) ==
+                         header.account_count &&
+                     fread(state->pending, sizeof(Transaction), header.pending_count, file) ==
+                         (size_t)header.pending_count &&
+                     fread(settlements, sizeof(SettlementEntry), header.settlement_count, file) ==
+                         header.settlement_count;
+        }
+        fclose(file);
+
+        if (ok)
+        {
+                digest_snapshot(&header, accounts, state->pending, settlements, digest);
+                ok = memcmp(digest, header.digest, sizeof(digest)) == 0;
+        }
+
+        for (i = 0; ok && i < header.settlement_count; i++)
+                ok = settlement_add(&state->settlements, &settlements[i]);
+        free(settlements);
+
+        for (i = 0; ok && i < header.account_count; i++)
+        {
+                ok = add_account(state, accounts[i].balance);
+                if (ok && define_addresses)
+                {
+                        memcpy(address, accounts[i].address, WAL_ADDRESS_BYTES);
+                        address[WAL_ADDRESS_BYTES] = '\0';
+                        ok = address_book_define(address) == i;
+                }
+        }
+        free(accounts);
+
+        if (!ok)
+        {
+                ledger_free(state);
+                if (define_addresses)
+                        address_book_clear();
+                return 0;
+        }
+
+        state->pending_count = header.pending_count;
+        state->height = header.height;
+        state->lsn = header.lsn;
+        state->frame_crc = header.frame_crc;
+        return 1;
+}
+
+/**
+ * snapshot_matches_log - Check that a ledger was built from this log
+ * @state: Ledger loaded from a snapshot
+ * @log: Mapped log
+ * Return: 1 if the log still holds the frame the snapshot ends at
+ */
+int snapshot_matches_log(const LedgerState *state, const TxLog *log)
+{
+        const WalFrame *frame;
+
+        if (state->lsn == 0)
+                return 1;
+        frame = txlog_frame(log, state->lsn - 1);
+        return frame && frame->lsn == state->lsn && frame->crc == state->frame_crc;
+}
+
+/**
+ * snapshot_load_latest - Load the newest usable snapshot
+ * @state: Empty ledger to fill
+ * @max_height: Highest block height wanted
+ * @log: If not NULL, snapshots that do not match this log are skipped
+ * @define_addresses: Nonzero to also fill the (empty) global address book
+ * Return: 1 if a snapshot was loaded, 0 if there is none (@state stays empty)
+ */
+int snapshot_load_latest(LedgerState *state, unsigned int max_height,
+                         const TxLog *log, int define_addresses)
+{
+        const Config *config = get_config();
+        unsigned int *heights = NULL;
+        unsigned int *grown;
+        unsigned int height, best;
+        size_t count = 0, capacity = 0, i, pick;
+        struct dirent *entry;
+        DIR *dir;
+        int loaded = 0;
+
+        if (!config)
+                return 0;
+        dir = opendir(config->backup_directory);
+        if (!dir)
+                return 0;
+
+        while ((entry = readdir(dir)))
+        {
+                if (sscanf(entry->d_name, "snapshot_%u.dat", &height) != 1 || height > max_height ||
+                    strcmp(entry->d_name + strlen(entry->d_name) - 4, ".dat") != 0)
+                        continue;
+                if (count == capacity)
+                {
+                        capacity = capacity ? capacity * 2 : 16;
+                        grown = realloc(heights, capacity * sizeof(unsigned int));
+                        if (!grown)
+                                break;
+                        heights = grown;
+                }
+                heights[count++] = height;
+        }
+        closedir(dir);
+
+        /* Newest first; a damaged or unrelated snapshot falls back to an older one */
+        while (!loaded && count > 0)
+        {
+                for (pick = 0, i = 1; i < count; i++)
+                        if (heights[i] > heights[pick])
+                                pick = i;
+                best = heights[pick];
+                heights[pick] = heights[--count];
+
+                loaded = read_snapshot(best, state, define_addresses);
+                if (loaded && log && !snapshot_matches_log(state, log))
+                {
+                        ledger_free(state);
+                        loaded = 0;
+                }
+        }
+
+        free(heights);
+        return loaded;
+}
+
+/**
+ * snapshot_latest_height - Height of the newest snapshot that verifies
+ * @height: Receives the height
+ *
+ * The snapshot's digest is checked and it must match the current log.
+ *
+ * Return: 1 on success, 0 if there is no usable snapshot
+ */
+int snapshot_latest_height(unsigned int *height)
+{
+        LedgerState state;
+        TxLog *log = txlog_shared();
+
+        ledger_init(&state);
+        if (!log || !snapshot_load_latest(&state, UINT_MAX, log, 0))
+                return 0;
+
+        *height = state.height;
+        ledger_free(&state);
+        return 1;
+}
+
+/**
+ * write_snapshot - Write a ledger to its snapshot file
+ * @state: Ledger positioned at a block mark
+ *
+ * Addresses come from the global address book, which holds every ID the
+ * ledger has seen. The file is written under a temporary name and renamed,
+ * so a crash never leaves a partial snapshot.
+ *
+ * Return: 1 on success, 0 on failure
+ */
+static int write_snapshot(const LedgerState *state)
+{
+        SnapshotHeader header;
+        SnapshotAccount *accounts;
+        SettlementEntry *settlements;
+        char path[512], tmp_path[520];
+        const char *address;
+        FILE *file;
+        uint32_t i;
+        int ok;
+
+        if (!snapshot_path(state->height, path))
+                return 0;
+
+        accounts = calloc(state->account_count + 1, sizeof(SnapshotAccount));
+        settlements = malloc((state->settlements.count + 1) * sizeof(SettlementEntry));
+        if (!accounts || !settlements)
+        {
+                free(accounts);
+                free(settlements);
+                return 0;
+        }
+        for (i = 0; i < state->account_count; i++)
+        {
+                address = address_of(i);
+                if (!address)
+                {
+                        free(accounts);
+                        free(settlements);
+                        return 0;
+                }
+                strncpy(accounts[i].address, address, WAL_ADDRESS_BYTES);
+                accounts[i].balance = state->balances[i];
+        }
+
+        memset(&header, 0, sizeof(header));
+        header.magic = SNAPSHOT_MAGIC;
+        header.version = SNAPSHOT_VERSION;
+        header.height = state->height;
+        header.account_count = state->account_count;
+        header.lsn = state->lsn;
+        header.frame_crc = state->frame_crc;
+        header.pending_count = state->pending_count;
+        header.settlement_count = (uint32_t)settlement_export(&state->settlements, settlements);
+        digest_snapshot(&header, accounts, state->pending, settlements, header.digest);
+
+        sprintf(tmp_path, "%s.tmp", path);
+        file = fopen(tmp_path, "wb");
+        ok = file != NULL;
+        if (ok)
+        {
+                ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                     fwrite(accounts, sizeof(SnapshotAccount), state->account_count, file) ==
+                         state->account_count &&
+                     fwrite(state->pending, sizeof(Transaction), state->pending_count, file) ==
+                         (size_t)state->pending_count &&
+                     fwrite(settlements, sizeof(SettlementEntry), header.settlement_count, file) ==
+                         header.settlement_count &&
+                     fflush(file) == 0 && fsync(fileno(file)) == 0;
+                ok = fclose(file) == 0 && ok;
+        }
+        free(accounts);
+        free(settlements);
+
+        if (!ok || rename(tmp_path, path) != 0)
+        {
+                unlink(tmp_path);
+                return 0;
+        }
+        return 1;
+}
+
+/**
+ * ledger_state_at - Rebuild every account balance as of a block height
+ * @height: Block height; 0 is the state before the first mined block
+ * @state: Receives the ledger; free it with ledger_free()
+ *
+ * Starts from the nearest snapshot at or below @height and replays the
+ * log forward to the block's mark.
+ *
+ * Return: 1 on success, 0 if the height has not been mined or on failure
+ */
+int ledger_state_at(unsigned int height, LedgerState *state)
+{
+        TxLog *log = txlog_shared();
+        const WalFrame *frame;
+        TxCursor cursor;
+
+        ledger_init(state);
+        if (!log)
+                return 0;
+
+        if (snapshot_load_latest(state, height, log, 0) && state->height == height)
+                return 1;
+
+        txcursor_begin(&cursor, log);
+        if (!txcursor_seek(&cursor, (size_t)state->lsn))
+        {
+                ledger_free(state);
+                return 0;
+        }
+
+        while ((frame = txcursor_next(&cursor)))
+        {
+                if (frame->type == WAL_RECORD_BLOCK && frame->body.block.block_index > height)
+                        break;
+                if (!ledger_apply(state, frame))
+                {
+                        ledger_free(state);
+                        return 0;
+                }
+                if (frame->type == WAL_RECORD_BLOCK && frame->body.block.block_index == height)
+                        return 1;
+        }
+
+        /* Without a mark for the genesis block, every account is untouched */
+        ledger_free(state);
+        return height == 0;
+}
+
+/**
+ * snapshot_take - Write the snapshot for a block that has been logged
+ * @height: Height of the block
+ * Return: 1 on success, 0 on failure
+ */
+int snapshot_take(unsigned int height)
+{
+        LedgerState state;
+        int ok;
+
+        if (!ledger_state_at(height, &state))
+                return 0;
+
+        ok = state.lsn > 0 && write_snapshot(&state);
+        ledger_free(&state);
+        return ok;
+}
+
+/**
+ * balance_at_height - Balance of an address as of a block height
+ * @address: Wallet address
+ * @height: Block height
+ * @balance: Receives the balance in micro-LT
+ * Return: 1 on success, 0 if the height has not been mined or on failure
+ */
+int balance_at_height(const char *address, unsigned int height, int64_t *balance)
+{
+        LedgerState state;
+
+        if (!address || !balance || !ledger_state_at(height, &state))
+                return 0;
+
+        *balance = ledger_balance(&state, address_lookup(address));
+        ledger_free(&state);
+        return 1;
+}
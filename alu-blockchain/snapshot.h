@@ -0,0 +1,94 @@
+/* snapshot.h */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "alu_blockchain.h"
+#include "wal.h"
+#include "txlog.h"
+#include "settlement.h"
+#include <stdint.h>
+
+#define SNAPSHOT_MAGIC 0x504e534cu /* "LSNP" */
+#define SNAPSHOT_VERSION 1
+
+/**
+ * struct LedgerState - Account balances at a position in the log
+ * @balances: Balance of each account ID, in micro-LT
+ * @account_count: Number of account IDs assigned so far
+ * @account_capacity: Allocated length of @balances
+ * @pending: Logged transactions not yet in a block, oldest first
+ * @pending_count: Number of pending transactions
+ * @pending_capacity: Allocated length of @pending
+ * @height: Index of the last block mark applied, 0 before the first
+ * @lsn: Number of log frames applied
+ * @frame_crc: Checksum of the last frame applied, 0 when @lsn is 0
+ * @settlements: Takings per recipient, day and type
+ *
+ * Every account starts at INITIAL_WALLET_BALANCE. Balances are also the
+ * proof-of-stake weights select_validator() draws from.
+ */
+typedef struct
+{
+        int64_t *balances;
+        uint32_t account_count;
+        uint32_t account_capacity;
+        Transaction *pending;
+        int pending_count;
+        int pending_capacity;
+        unsigned int height;
+        uint64_t lsn;
+        uint32_t frame_crc;
+        SettlementTable settlements;
+} LedgerState;
+
+/**
+ * struct SnapshotHeader - First bytes of a snapshot file
+ * @magic: SNAPSHOT_MAGIC
+ * @version: SNAPSHOT_VERSION
+ * @height: Block height the snapshot was taken at
+ * @account_count: Number of SnapshotAccount records that follow
+ * @lsn: Log frames covered, up to and including the block's mark
+ * @frame_crc: Checksum of frame @lsn, which ties the snapshot to its log
+ * @pending_count: Number of Transaction records after the accounts
+ * @settlement_count: Number of SettlementEntry records after the pending pool
+ * @reserved: Always zero
+ * @digest: SHA-256 of this header (with @digest zeroed) and all records
+ */
+typedef struct
+{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t height;
+        uint32_t account_count;
+        uint64_t lsn;
+        uint32_t frame_crc;
+        int32_t pending_count;
+        uint32_t settlement_count;
+        uint32_t reserved;
+        unsigned char digest[SIGNATURE_LENGTH];
+} SnapshotHeader;
+
+/**
+ * struct SnapshotAccount - One account in a snapshot, in account ID order
+ * @address: Address, zero-padded like WalAddress
+ * @balance: Balance in micro-LT
+ */
+typedef struct
+{
+        char address[WAL_ADDRESS_BYTES];
+        int64_t balance;
+} SnapshotAccount;
+
+void ledger_init(LedgerState *state);
+void ledger_free(LedgerState *state);
+int ledger_apply(LedgerState *state, const WalFrame *frame);
+int64_t ledger_balance(const LedgerState *state, uint32_t id);
+int snapshot_load_latest(LedgerState *state, unsigned int max_height,
+                         const TxLog *log, int define_addresses);
+int snapshot_matches_log(const LedgerState *state, const TxLog *log);
+int snapshot_latest_height(unsigned int *height);
+int ledger_state_at(unsigned int height, LedgerState *state);
+int snapshot_take(unsigned int height);
+int balance_at_height(const char *address, unsigned int height, int64_t *balance);
+
+#endif /* SNAPSHOT_H */
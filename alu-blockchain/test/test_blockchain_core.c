@@ -1,9 +1,24 @@
+#define _XOPEN_SOURCE 700
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
 #include "Unity/src/unity.h"
 #include "alu_blockchain.h"
+#include "txcolumns.h"
+#include "snapshot.h"
+#include "settlement.h"
+#include "export.h"
+#include "config.h"
+#include "legacy.h"
+
+/* Kitchen wallet addresses for the registry and export tests */
+#define PIUS_TEST_ADDRESS "0x000pius000000cuisine000000"
+#define JOSHUA_TEST_ADDRESS "0x000joshua000000kitchen000000"
+#define PASCAL_TEST_ADDRESS "0x000pascal000000kitchen000000"
 
 /* Mock file operations for transaction tests */
 #define MAX_MOCK_TRANSACTIONS 10
@@ -108,6 +123,44 @@ void tearDown(void)
         /* Nothing to clean up */
 }
 
+/* Scratch directories for tests that write the data files */
+static void enter_test_directory(char *directory, char *cwd, size_t size)
+{
+        TEST_ASSERT_NOT_NULL(getcwd(cwd, size));
+        TEST_ASSERT_NOT_NULL(mkdtemp(directory));
+        TEST_ASSERT_EQUAL_INT(0, chdir(directory));
+}
+
+static int remove_test_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+        (void)st;
+        (void)flag;
+        (void)ftw;
+        return remove(path);
+}
+
+static void leave_test_directory(const char *directory, const char *cwd)
+{
+        TEST_ASSERT_EQUAL_INT(0, chdir(cwd));
+        nftw(directory, remove_test_entry, 8, FTW_DEPTH | FTW_PHYS);
+}
+
+/* Read a text file into lines without their newlines; returns the count */
+static int read_test_lines(const char *path, char lines[][512], int max)
+{
+        FILE *file = fopen(path, "r");
+        int count = 0;
+
+        TEST_ASSERT_NOT_NULL(file);
+        while (count < max && fgets(lines[count], 512, file))
+        {
+                lines[count][strcspn(lines[count], "\n")] = '\0';
+                count++;
+        }
+        fclose(file);
+        return count;
+}
+
 void test_create_block_null_chain(void)
 {
         Block *result = create_block(NULL);
@@ -121,7 +174,6 @@ void test_create_block_success(void)
 
         genesis.index = 0;
         strcpy(genesis.current_hash, "genesis_hash");
-        genesis.next = NULL;
 
         chain.genesis = &genesis;
         chain.latest = &genesis;
@@ -134,8 +186,9 @@ void test_create_block_success(void)
         TEST_ASSERT_EQUAL_INT(0, new_block->nonce);
         TEST_ASSERT_EQUAL_INT(0, new_block->transaction_count);
         TEST_ASSERT_EQUAL_INT(BLOCK_REWARD, new_block->reward);
-        TEST_ASSERT_NULL(new_block->next);
+        TEST_ASSERT_NOT_NULL(new_block->transactions);
 
+        free(new_block->transactions);
         free(new_block);
 }
 
@@ -169,18 +222,23 @@ void test_validate_block_valid(void)
         Block latest;
         Block block_to_validate;
         char temp[512];
+        char timestamp[TIME_TEXT_SIZE];
 
+        memset(&block_to_validate, 0, sizeof(block_to_validate));
         strcpy(latest.current_hash, "latest_hash");
 
         chain.latest = &latest;
 
         block_to_validate.index = 1;
         strcpy(block_to_validate.previous_hash, "latest_hash");
-        strcpy(block_to_validate.timestamp, "2023-01-01 12:00:00");
+        block_to_validate.timestamp = 1672574400;
+        block_to_validate.utc_offset = 0;
         block_to_validate.nonce = 0;
 
+        format_block_time(&block_to_validate, timestamp);
+        TEST_ASSERT_EQUAL_STRING("2023-01-01 12:00:00", timestamp);
         sprintf(temp, "%u%s%s%u", block_to_validate.index, block_to_validate.previous_hash,
-                block_to_validate.timestamp, block_to_validate.nonce);
+                timestamp, block_to_validate.nonce);
         generate_hash(temp, block_to_validate.current_hash);
 
         TEST_ASSERT_EQUAL_INT(1, validate_block(&chain, &block_to_validate));
@@ -252,6 +310,1120 @@ void test_extract_transactions_max_transactions(void)
         free(result);
 }
 
+void test_transaction_record_is_compact(void)
+{
+        TEST_ASSERT_EQUAL_INT(96, (int)sizeof(Transaction));
+}
+
+void test_transaction_signatures(void)
+{
+        Wallet sender, legacy;
+        char recipient[HASH_LENGTH + 1], recipient_key[HASH_LENGTH + 1];
+        Transaction txs[40];
+        int i, unsigned_count;
+
+        memset(&sender, 0, sizeof(sender));
+        TEST_ASSERT_TRUE(generate_wallet_keys(sender.address, sender.private_key));
+        TEST_ASSERT_TRUE(generate_wallet_keys(recipient, recipient_key));
+        TEST_ASSERT_EQUAL_INT(64, (int)strlen(sender.address));
+        TEST_ASSERT_TRUE(wallet_has_signing_key(&sender));
+
+        /* Hash-derived wallets from before key pairs cannot sign */
+        memset(&legacy, 0, sizeof(legacy));
+        generate_hash("legacy@alustudent.com", legacy.address);
+        generate_hash("legacy key", legacy.private_key);
+        TEST_ASSERT_FALSE(wallet_has_signing_key(&legacy));
+
+        address_book_clear();
+        TEST_ASSERT_EQUAL_UINT(0, address_book_define(sender.address));
+        TEST_ASSERT_EQUAL_UINT(1, address_book_define(recipient));
+
+        memset(txs, 0, sizeof(txs));
+        for (i = 0; i < 40; i++)
+        {
+                txs[i].from_id = 0;
+                txs[i].to_id = 1;
+                txs[i].amount = (i + 1) * MICRO_LT_PER_LT;
+                txs[i].timestamp = 1700000000 + i;
+                txs[i].type = CAFETERIA_PAYMENT;
+                TEST_ASSERT_TRUE(sign_transaction(&txs[i], sender.private_key, sender.address, recipient));
+        }
+        TEST_ASSERT_TRUE(verify_signature(&txs[0]));
+        TEST_ASSERT_TRUE(verify_signatures(txs, 40, &unsigned_count));
+        TEST_ASSERT_EQUAL_INT(0, unsigned_count);
+
+        /* Only the sender's key verifies */
+        TEST_ASSERT_TRUE(sign_transaction(&txs[5], recipient_key, recipient, sender.address));
+        TEST_ASSERT_FALSE(verify_signature(&txs[5]));
+        TEST_ASSERT_TRUE(sign_transaction(&txs[5], sender.private_key, sender.address, recipient));
+
+        /* Any changed field breaks the signature, wherever it is in the block */
+        txs[37].amount++;
+        TEST_ASSERT_FALSE(verify_signature(&txs[37]));
+        TEST_ASSERT_FALSE(verify_signatures(txs, 40, NULL));
+        txs[37].amount--;
+        txs[37].to_id = 0;
+        TEST_ASSERT_FALSE(verify_signatures(txs, 40, NULL));
+        txs[37].to_id = 1;
+
+        /* Without a migration cutoff in the log, a digest is no substitute */
+        txs[3].signature_type = TX_SIGNED_DIGEST;
+        TEST_ASSERT_FALSE(verify_signature(&txs[3]));
+        TEST_ASSERT_FALSE(verify_signatures(txs, 40, &unsigned_count));
+        TEST_ASSERT_FALSE(wal_accepts_digest(&txs[3]));
+        txs[3].signature_type = 7;
+        TEST_ASSERT_FALSE(verify_signatures(txs, 40, NULL));
+
+        address_book_clear();
+}
+
+void test_hex_round_trip(void)
+{
+        unsigned char digest[SIGNATURE_LENGTH];
+        unsigned char decoded[SIGNATURE_LENGTH];
+        char hex[HASH_LENGTH + 1];
+        char hash[HASH_LENGTH + 1];
+
+        generate_digest("alu", digest);
+        hex_encode(digest, SIGNATURE_LENGTH, hex);
+        generate_hash("alu", hash);
+
+        TEST_ASSERT_EQUAL_STRING(hash, hex);
+        TEST_ASSERT_TRUE(hex_decode(hex, decoded, SIGNATURE_LENGTH));
+        TEST_ASSERT_EQUAL_MEMORY(digest, decoded, SIGNATURE_LENGTH);
+        TEST_ASSERT_FALSE(hex_decode("0x00", decoded, 2));
+}
+
+void test_lt_parse_and_format(void)
+{
+        int64_t amount;
+        char text[LT_FORMAT_SIZE];
+
+        TEST_ASSERT_TRUE(lt_parse("2.5", &amount));
+        TEST_ASSERT_TRUE(amount == 2500000);
+        TEST_ASSERT_EQUAL_STRING("2.50", lt_format(amount, text));
+
+        TEST_ASSERT_TRUE(lt_parse(" 0.000001\n", &amount));
+        TEST_ASSERT_TRUE(amount == 1);
+        TEST_ASSERT_EQUAL_STRING("0.000001", lt_format(amount, text));
+        TEST_ASSERT_EQUAL_STRING("-100.00", lt_format(-INITIAL_WALLET_BALANCE, text));
+
+        TEST_ASSERT_FALSE(lt_parse("0.0000001", &amount));
+        TEST_ASSERT_FALSE(lt_parse("1e3", &amount));
+        TEST_ASSERT_FALSE(lt_parse("", &amount));
+        TEST_ASSERT_FALSE(lt_parse("99999999", &amount));
+}
+
+void test_lt_checked_arithmetic(void)
+{
+        static int64_t amounts[LT_SUM_CHUNK + 3];
+        int64_t result = 0;
+        size_t i;
+
+        TEST_ASSERT_FALSE(lt_add(INT64_MAX, 1, &result));
+        TEST_ASSERT_FALSE(lt_sub(INT64_MIN, 1, &result));
+        TEST_ASSERT_TRUE(lt_sub(5, 7, &result));
+        TEST_ASSERT_TRUE(result == -2);
+
+        /* Spans two chunks; the exact total does not depend on the split */
+        for (i = 0; i < LT_SUM_CHUNK + 3; i++)
+                amounts[i] = (i % 2) ? -LT_AMOUNT_MAX : LT_AMOUNT_MAX;
+        TEST_ASSERT_TRUE(lt_sum(amounts, LT_SUM_CHUNK + 3, &result));
+        TEST_ASSERT_TRUE(result == LT_AMOUNT_MAX);
+}
+
+void test_txcolumns_kernels_agree(void)
+{
+        static const TxKernel kernels[] = {TX_KERNEL_SCALAR, TX_KERNEL_SSE42, TX_KERNEL_AVX2};
+        uint32_t from[37], to[37];
+        int64_t amount[37], timestamp[37];
+        uint8_t type[37];
+        TxColumns columns;
+        TxTotals expected, totals;
+        TxFilter filter;
+        size_t i, k;
+
+        memset(&columns, 0, sizeof(columns));
+        columns.from_id = from;
+        columns.to_id = to;
+        columns.amount = amount;
+        columns.timestamp = timestamp;
+        columns.type = type;
+        columns.count = 37;
+        columns.capacity = 37;
+        for (i = 0; i < 37; i++)
+        {
+                from[i] = i % 3;
+                to[i] = (i + 1) % 3;
+                amount[i] = (int64_t)(i + 1) * 1000;
+                timestamp[i] = 1000 + i;
+                type[i] = i % (TOKEN_TRANSFER + 1);
+        }
+
+        txfilter_init(&filter, 1);
+        filter.type = CAFETERIA_PAYMENT;
+        filter.start = 1005;
+        filter.end = 1030;
+
+        TEST_ASSERT_TRUE(txkernel_select(TX_KERNEL_SCALAR));
+        TEST_ASSERT_TRUE(txcolumns_sum(&columns, &filter, &expected));
+        TEST_ASSERT_TRUE(expected.sent > 0 && expected.received > 0);
+
+        /* SIMD kernels the CPU lacks are skipped */
+        for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+        {
+                if (!txkernel_select(kernels[k]))
+                        continue;
+                TEST_ASSERT_TRUE(txcolumns_sum(&columns, &filter, &totals));
+                TEST_ASSERT_TRUE(totals.sent == expected.sent);
+                TEST_ASSERT_TRUE(totals.received == expected.received);
+        }
+        txkernel_select(TX_KERNEL_AUTO);
+}
+
+void test_block_arena_lookup(void)
+{
+        Blockchain *chain = calloc(1, sizeof(Blockchain));
+        Block block;
+        Block *first = NULL;
+        unsigned int height;
+
+        TEST_ASSERT_NOT_NULL(chain);
+        memset(&block, 0, sizeof(block));
+
+        /* Enough blocks to span several chunks and grow the hash index */
+        for (height = 0; height < 3 * BLOCK_CHUNK_SIZE + 2; height++)
+        {
+                block.index = height;
+                sprintf(block.current_hash, "%064x", height * 7919 + 1);
+                TEST_ASSERT_NOT_NULL(append_block(chain, &block));
+                if (height == 0)
+                        first = chain->latest;
+        }
+
+        /* Earlier blocks never move as the chain grows */
+        TEST_ASSERT_TRUE(chain->genesis == first);
+        TEST_ASSERT_TRUE(get_block_by_index(chain, 0) == first);
+        TEST_ASSERT_EQUAL_INT(3 * BLOCK_CHUNK_SIZE + 2, chain->block_count);
+
+        for (height = 0; height < (unsigned int)chain->block_count; height++)
+        {
+                sprintf(block.current_hash, "%064x", height * 7919 + 1);
+                TEST_ASSERT_EQUAL_UINT(height, get_block_by_index(chain, height)->index);
+                TEST_ASSERT_TRUE(get_block_by_hash(chain, block.current_hash) ==
+                                 get_block_by_index(chain, height));
+        }
+
+        TEST_ASSERT_NULL(get_block_by_index(chain, chain->block_count));
+        TEST_ASSERT_NULL(get_block_by_hash(chain, "not a block hash"));
+
+        /* Appends must extend the chain at the next height */
+        block.index = 5;
+        TEST_ASSERT_NULL(append_block(chain, &block));
+
+        cleanup_blockchain(chain);
+}
+
+void test_block_body_merkle_root(void)
+{
+        Transaction txs[3];
+        unsigned char root[SIGNATURE_LENGTH];
+        unsigned char expected[SIGNATURE_LENGTH];
+        unsigned char pair[2 * SIGNATURE_LENGTH];
+        unsigned char zero[SIGNATURE_LENGTH] = {0};
+        Transaction swapped[2];
+        Block block;
+        int i;
+
+        memset(txs, 0, sizeof(txs));
+        for (i = 0; i < 3; i++)
+        {
+                txs[i].from_id = i;
+                txs[i].to_id = i + 1;
+                txs[i].amount = (i + 1) * MICRO_LT_PER_LT;
+        }
+
+        /* One leaf is its own root; an empty body has an all-zero root */
+        compute_merkle_root(txs, 1, root);
+        EVP_Digest(&txs[0], sizeof(Transaction), expected, NULL, EVP_sha256(), NULL);
+        TEST_ASSERT_EQUAL_MEMORY(expected, root, SIGNATURE_LENGTH);
+        compute_merkle_root(txs, 0, root);
+        TEST_ASSERT_EQUAL_MEMORY(zero, root, SIGNATURE_LENGTH);
+
+        /* Two leaves hash to SHA-256(leaf0 || leaf1), so order matters */
+        EVP_Digest(&txs[0], sizeof(Transaction), pair, NULL, EVP_sha256(), NULL);
+        EVP_Digest(&txs[1], sizeof(Transaction), pair + SIGNATURE_LENGTH, NULL, EVP_sha256(), NULL);
+        EVP_Digest(pair, sizeof(pair), expected, NULL, EVP_sha256(), NULL);
+        compute_merkle_root(txs, 2, root);
+        TEST_ASSERT_EQUAL_MEMORY(expected, root, SIGNATURE_LENGTH);
+        swapped[0] = txs[1];
+        swapped[1] = txs[0];
+        compute_merkle_root(swapped, 2, root);
+        TEST_ASSERT_TRUE(memcmp(expected, root, SIGNATURE_LENGTH) != 0);
+
+        /* Sealing trims the body and records the root; empty bodies are dropped */
+        memset(&block, 0, sizeof(block));
+        block.transactions = calloc(MAX_TRANSACTIONS, sizeof(Transaction));
+        TEST_ASSERT_NOT_NULL(block.transactions);
+        memcpy(block.transactions, txs, sizeof(txs));
+        block.transaction_count = 3;
+        seal_block_body(&block);
+        compute_merkle_root(txs, 3, root);
+        TEST_ASSERT_EQUAL_MEMORY(root, block.merkle_root, SIGNATURE_LENGTH);
+        TEST_ASSERT_TRUE(block.archive_offset == -1);
+        TEST_ASSERT_EQUAL_MEMORY(txs, block.transactions, sizeof(txs));
+        free_block_body(&block);
+        TEST_ASSERT_NULL(block.transactions);
+
+        block.transaction_count = 0;
+        block.transactions = calloc(MAX_TRANSACTIONS, sizeof(Transaction));
+        seal_block_body(&block);
+        TEST_ASSERT_NULL(block.transactions);
+        TEST_ASSERT_EQUAL_MEMORY(zero, block.merkle_root, SIGNATURE_LENGTH);
+}
+
+void test_pruned_bodies_reload_from_archive(void)
+{
+        char directory[] = "/tmp/test_pruneXXXXXX";
+        char cwd[512];
+        char path[512];
+        Blockchain *chain = calloc(1, sizeof(Blockchain));
+        Transaction txs[4][3];
+        Transaction *body;
+        unsigned char root[SIGNATURE_LENGTH];
+        Block block, *stored;
+        unsigned int height;
+        FILE *file;
+        int i;
+
+        TEST_ASSERT_NOT_NULL(chain);
+        enter_test_directory(directory, cwd, sizeof(cwd));
+        TEST_ASSERT_EQUAL_INT(0, mkdir(get_config()->backup_directory, 0755));
+
+        /* An empty genesis block, then three blocks of three transactions */
+        memset(txs, 0, sizeof(txs));
+        for (height = 0; height < 4; height++)
+        {
+                memset(&block, 0, sizeof(block));
+                block.index = height;
+                sprintf(block.current_hash, "%064x", height + 1);
+                block.transaction_count = height ? 3 : 0;
+                block.transactions = calloc(MAX_TRANSACTIONS, sizeof(Transaction));
+                TEST_ASSERT_NOT_NULL(block.transactions);
+                for (i = 0; i < block.transaction_count; i++)
+                {
+                        txs[height][i].from_id = height;
+                        txs[height][i].to_id = i;
+                        txs[height][i].amount = (height * 10 + i + 1) * MICRO_LT_PER_LT;
+                        block.transactions[i] = txs[height][i];
+                }
+                seal_block_body(&block);
+                TEST_ASSERT_NOT_NULL(append_block(chain, &block));
+        }
+
+        TEST_ASSERT_TRUE(prune_blocks(chain, 2));
+        TEST_ASSERT_EQUAL_UINT(3, chain->pruned_count);
+        TEST_ASSERT_NOT_NULL(get_block_by_index(chain, 3)->transactions);
+
+        /* Archived bodies read back intact and still match the stored root */
+        for (height = 1; height <= 2; height++)
+        {
+                stored = get_block_by_index(chain, height);
+                TEST_ASSERT_NULL(stored->transactions);
+                TEST_ASSERT_TRUE(stored->archive_offset >= 0);
+                body = load_block_body(stored);
+                TEST_ASSERT_NOT_NULL(body);
+                TEST_ASSERT_EQUAL_MEMORY(txs[height], body, sizeof(txs[height]));
+                compute_merkle_root(body, stored->transaction_count, root);
+                TEST_ASSERT_EQUAL_MEMORY(stored->merkle_root, root, SIGNATURE_LENGTH);
+                free(body);
+        }
+
+        /* Pruning below the pruned height is a no-op */
+        TEST_ASSERT_TRUE(prune_blocks(chain, 1));
+        TEST_ASSERT_EQUAL_UINT(3, chain->pruned_count);
+
+        /* A body altered in the archive no longer matches its root */
+        sprintf(path, "%s/%s", get_config()->backup_directory, BLOCK_ARCHIVE_FILE);
+        file = fopen(path, "r+b");
+        TEST_ASSERT_NOT_NULL(file);
+        TEST_ASSERT_EQUAL_INT(0, fseek(file, -1, SEEK_END));
+        fputc(~txs[2][2].signature[TX_SIGNATURE_LENGTH - 1] & 0xff, file);
+        fclose(file);
+        TEST_ASSERT_NULL(load_block_body(get_block_by_index(chain, 2)));
+        body = load_block_body(get_block_by_index(chain, 1));
+        TEST_ASSERT_NOT_NULL(body);
+        free(body);
+
+        cleanup_blockchain(chain);
+        leave_test_directory(directory, cwd);
+}
+
+void test_ledger_applies_frames(void)
+{
+        LedgerState state;
+        WalFrame frames[5];
+        size_t i;
+
+        memset(frames, 0, sizeof(frames));
+        frames[0].type = WAL_RECORD_ADDRESS;
+        frames[1].type = WAL_RECORD_ADDRESS;
+        frames[2].type = WAL_RECORD_TX;
+        frames[2].body.tx.from_id = 0;
+        frames[2].body.tx.to_id = 1;
+        frames[2].body.tx.amount = 5 * MICRO_LT_PER_LT;
+        frames[3].type = WAL_RECORD_BLOCK;
+        frames[3].body.block.block_index = 1;
+        frames[3].body.block.transaction_count = 1;
+        frames[3].body.block.validator_id = 1;
+        frames[3].body.block.reward = 2 * MICRO_LT_PER_LT;
+        frames[4].type = WAL_RECORD_TX;
+        frames[4].body.tx.from_id = 1;
+        frames[4].body.tx.to_id = 0;
+        frames[4].body.tx.amount = MICRO_LT_PER_LT / 2;
+
+        ledger_init(&state);
+        for (i = 0; i < 5; i++)
+        {
+                frames[i].lsn = i + 1;
+                frames[i].crc = 0x1000 + i;
+                TEST_ASSERT_TRUE(ledger_apply(&state, &frames[i]));
+        }
+
+        TEST_ASSERT_EQUAL_UINT(2, state.account_count);
+        TEST_ASSERT_TRUE(ledger_balance(&state, 0) == INITIAL_WALLET_BALANCE - 4500000);
+        TEST_ASSERT_TRUE(ledger_balance(&state, 1) == INITIAL_WALLET_BALANCE + 6500000);
+        TEST_ASSERT_TRUE(ledger_balance(&state, 7) == INITIAL_WALLET_BALANCE);
+        TEST_ASSERT_TRUE(ledger_balance(&state, ADDRESS_ID_NONE) == INITIAL_WALLET_BALANCE);
+
+        /* The block consumed the first transaction; the second is pending */
+        TEST_ASSERT_EQUAL_UINT(1, state.height);
+        TEST_ASSERT_EQUAL_INT(1, state.pending_count);
+        TEST_ASSERT_TRUE(state.pending[0].amount == MICRO_LT_PER_LT / 2);
+        TEST_ASSERT_TRUE(state.lsn == 5 && state.frame_crc == 0x1004);
+
+        frames[4].body.tx.amount = LT_AMOUNT_MAX + 1;
+        TEST_ASSERT_FALSE(ledger_apply(&state, &frames[4]));
+
+        ledger_free(&state);
+        TEST_ASSERT_NULL(state.balances);
+        TEST_ASSERT_EQUAL_UINT(0, state.account_count);
+}
+
+void test_wal_recovers_intact_prefix(void)
+{
+        char directory[] = "/tmp/test_walXXXXXX";
+        char cwd[512];
+        char sender[HASH_LENGTH + 1], sender_key[HASH_LENGTH + 1];
+        char recipient[HASH_LENGTH + 1], recipient_key[HASH_LENGTH + 1];
+        off_t intact = (off_t)(sizeof(WalFileHeader) + 5 * sizeof(WalFrame));
+        Transaction tx;
+        WalFrame frame;
+        struct stat st;
+        int fd, i;
+
+        enter_test_directory(directory, cwd, sizeof(cwd));
+        TEST_ASSERT_TRUE(generate_wallet_keys(sender, sender_key));
+        TEST_ASSERT_TRUE(generate_wallet_keys(recipient, recipient_key));
+
+        /* Two address frames, then three transactions */
+        TEST_ASSERT_TRUE(wal_open());
+        memset(&tx, 0, sizeof(tx));
+        tx.from_id = wal_intern_address(sender);
+        tx.to_id = wal_intern_address(recipient);
+        tx.type = TOKEN_TRANSFER;
+        for (i = 0; i < 3; i++)
+        {
+                tx.amount = (i + 1) * MICRO_LT_PER_LT;
+                tx.timestamp = 1700000000 + i;
+                TEST_ASSERT_TRUE(sign_transaction(&tx, sender_key, sender, recipient));
+                TEST_ASSERT_TRUE(wal_append_transaction(&tx));
+        }
+
+        /* Only signed transactions are logged */
+        tx.signature_type = TX_SIGNED_DIGEST;
+        TEST_ASSERT_FALSE(wal_append_transaction(&tx));
+        TEST_ASSERT_EQUAL_INT(3, wal_pending_count());
+        wal_close();
+
+        /* Replay rebuilds the address book and the pool */
+        TEST_ASSERT_TRUE(wal_open());
+        TEST_ASSERT_EQUAL_INT(3, wal_pending_count());
+        TEST_ASSERT_EQUAL_STRING(recipient, address_of(1));
+        wal_close();
+
+        /* A torn tail is cut off */
+        fd = open(TX_FILE, O_RDWR);
+        TEST_ASSERT_TRUE(fd >= 0);
+        TEST_ASSERT_EQUAL_INT((int)sizeof(frame), (int)pread(fd, &frame, sizeof(frame), intact - sizeof(frame)));
+        TEST_ASSERT_TRUE(wal_frame_valid(&frame));
+        TEST_ASSERT_EQUAL_INT((int)sizeof(frame) / 2, (int)pwrite(fd, &frame, sizeof(frame) / 2, intact));
+        close(fd);
+
+        TEST_ASSERT_TRUE(wal_open());
+        TEST_ASSERT_EQUAL_INT(3, wal_pending_count());
+        TEST_ASSERT_EQUAL_INT(0, stat(TX_FILE, &st));
+        TEST_ASSERT_TRUE(st.st_size == intact);
+        wal_close();
+
+        /* A frame that fails its checksum ends the log */
+        frame.body.tx.amount++;
+        TEST_ASSERT_FALSE(wal_frame_valid(&frame));
+        fd = open(TX_FILE, O_RDWR);
+        TEST_ASSERT_TRUE(fd >= 0);
+        TEST_ASSERT_EQUAL_INT((int)sizeof(frame), (int)pwrite(fd, &frame, sizeof(frame), intact - sizeof(frame)));
+        close(fd);
+
+        TEST_ASSERT_TRUE(wal_open());
+        TEST_ASSERT_EQUAL_INT(2, wal_pending_count());
+        TEST_ASSERT_EQUAL_INT(0, stat(TX_FILE, &st));
+        TEST_ASSERT_TRUE(st.st_size == intact - (off_t)sizeof(WalFrame));
+
+        /* Appends continue from the intact prefix */
+        tx.amount = 9 * MICRO_LT_PER_LT;
+        TEST_ASSERT_TRUE(sign_transaction(&tx, sender_key, sender, recipient));
+        TEST_ASSERT_TRUE(wal_append_transaction(&tx));
+        wal_close();
+        TEST_ASSERT_TRUE(wal_open());
+        TEST_ASSERT_EQUAL_INT(3, wal_pending_count());
+        wal_close();
+
+        leave_test_directory(directory, cwd);
+}
+
+void test_balance_scans_agree(void)
+{
+        char directory[] = "/tmp/test_balanceXXXXXX";
+        char cwd[512];
+        char addresses[3][HASH_LENGTH + 1], keys[3][HASH_LENGTH + 1];
+        int64_t columnar[4], cursor[4];
+        Transaction tx;
+        FILE *file;
+        int i;
+
+        enter_test_directory(directory, cwd, sizeof(cwd));
+        TEST_ASSERT_TRUE(wal_open());
+        for (i = 0; i < 3; i++)
+        {
+                TEST_ASSERT_TRUE(generate_wallet_keys(addresses[i], keys[i]));
+                TEST_ASSERT_EQUAL_UINT(i, wal_intern_address(addresses[i]));
+        }
+
+        /* Account 0 pays account 1 three times; account 1 pays account 2 */
+        memset(&tx, 0, sizeof(tx));
+        tx.type = TOKEN_TRANSFER;
+        for (i = 0; i < 4; i++)
+        {
+                tx.from_id = i < 3 ? 0 : 1;
+                tx.to_id = i < 3 ? 1 : 2;
+                tx.amount = i < 3 ? (i + 1) * MICRO_LT_PER_LT : MICRO_LT_PER_LT / 2;
+                tx.timestamp = 1700000000 + i;
+                TEST_ASSERT_TRUE(sign_transaction(&tx, keys[tx.from_id], addresses[tx.from_id],
+                                                  addresses[tx.to_id]));
+                TEST_ASSERT_TRUE(wal_append_transaction(&tx));
+        }
+
+        file = fopen(CONFIG_FILE, "w");
+        TEST_ASSERT_NOT_NULL(file);
+        fprintf(file, "columnar_scan=1\n");
+        fclose(file);
+        TEST_ASSERT_TRUE(reload_config());
+        for (i = 0; i < 3; i++)
+                columnar[i] = get_unspent_balance(addresses[i]);
+        columnar[3] = get_unspent_balance("not-an-account");
+
+        /* The cursor walks the mapped log frame by frame */
+        file = fopen(CONFIG_FILE, "w");
+        TEST_ASSERT_NOT_NULL(file);
+        fprintf(file, "columnar_scan=0\n");
+        fclose(file);
+        TEST_ASSERT_TRUE(reload_config());
+        for (i = 0; i < 3; i++)
+                cursor[i] = get_unspent_balance(addresses[i]);
+        cursor[3] = get_unspent_balance("not-an-account");
+
+        for (i = 0; i < 4; i++)
+                TEST_ASSERT_TRUE(columnar[i] == cursor[i]);
+        TEST_ASSERT_TRUE(cursor[0] == INITIAL_WALLET_BALANCE - 6 * MICRO_LT_PER_LT);
+        TEST_ASSERT_TRUE(cursor[1] == INITIAL_WALLET_BALANCE + 6 * MICRO_LT_PER_LT - MICRO_LT_PER_LT / 2);
+        TEST_ASSERT_TRUE(cursor[2] == INITIAL_WALLET_BALANCE + MICRO_LT_PER_LT / 2);
+        TEST_ASSERT_TRUE(cursor[3] == INITIAL_WALLET_BALANCE);
+
+        /* Back to the defaults for the tests that follow */
+        unlink(CONFIG_FILE);
+        TEST_ASSERT_TRUE(reload_config());
+        txcolumns_close_shared();
+        txlog_close_shared();
+        wal_close();
+        leave_test_directory(directory, cwd);
+}
+
+void test_snapshot_balances_by_height(void)
+{
+        char directory[] = "/tmp/test_snapshotXXXXXX";
+        char cwd[512];
+        char addresses[2][HASH_LENGTH + 1], keys[2][HASH_LENGTH + 1];
+        char path[512];
+        unsigned int height;
+        int64_t balance;
+        Transaction tx;
+        FILE *file;
+        int i;
+
+        enter_test_directory(directory, cwd, sizeof(cwd));
+        TEST_ASSERT_EQUAL_INT(0, mkdir(get_config()->backup_directory, 0755));
+        TEST_ASSERT_TRUE(wal_open());
+        for (i = 0; i < 2; i++)
+        {
+                TEST_ASSERT_TRUE(generate_wallet_keys(addresses[i], keys[i]));
+                TEST_ASSERT_EQUAL_UINT(i, wal_intern_address(addresses[i]));
+        }
+
+        /* Block 1: account 0 pays 2 LT, account 1 validates for 1 LT */
+        memset(&tx, 0, sizeof(tx));
+        tx.from_id = 0;
+        tx.to_id = 1;
+        tx.type = TOKEN_TRANSFER;
+        tx.amount = 2 * MICRO_LT_PER_LT;
+        tx.timestamp = 1700000000;
+        TEST_ASSERT_TRUE(sign_transaction(&tx, keys[0], addresses[0], addresses[1]));
+        TEST_ASSERT_TRUE(wal_append_transaction(&tx));
+        TEST_ASSERT_TRUE(wal_append_block(1, 1, 1, MICRO_LT_PER_LT));
+        TEST_ASSERT_TRUE(snapshot_take(1));
+        TEST_ASSERT_TRUE(snapshot_latest_height(&height));
+        TEST_ASSERT_EQUAL_UINT(1, height);
+
+        /* Block 2 goes only to the log; one more payment stays pending */
+        tx.amount = 3 * MICRO_LT_PER_LT;
+        tx.timestamp++;
+        TEST_ASSERT_TRUE(sign_transaction(&tx, keys[0], addresses[0], addresses[1]));
+        TEST_ASSERT_TRUE(wal_append_transaction(&tx));
+        TEST_ASSERT_TRUE(wal_append_block(2, 1, 0, 0));
+        tx.amount = MICRO_LT_PER_LT;
+        tx.timestamp++;
+        TEST_ASSERT_TRUE(sign_transaction(&tx, keys[0], addresses[0], addresses[1]));
+        TEST_ASSERT_TRUE(wal_append_transaction(&tx));
+        wal_close();
+        txlog_close_shared();
+
+        /* Reopening resumes from the snapshot and replays what follows it */
+        TEST_ASSERT_TRUE(wal_open());
+        TEST_ASSERT_EQUAL_INT(1, wal_pending_count());
+        TEST_ASSERT_TRUE(balance_at_height(addresses[0], 0, &balance));
+        TEST_ASSERT_TRUE(balance == INITIAL_WALLET_BALANCE);
+        TEST_ASSERT_TRUE(balance_at_height(addresses[0], 1, &balance));
+        TEST_ASSERT_TRUE(balance == INITIAL_WALLET_BALANCE - 2 * MICRO_LT_PER_LT);
+        TEST_ASSERT_TRUE(balance_at_height(addresses[1], 1, &balance));
+        TEST_ASSERT_TRUE(balance == INITIAL_WALLET_BALANCE + 3 * MICRO_LT_PER_LT);
+        TEST_ASSERT_TRUE(balance_at_height(addresses[0], 2, &balance));
+        TEST_ASSERT_TRUE(balance == INITIAL_WALLET_BALANCE - 5 * MICRO_LT_PER_LT);
+        TEST_ASSERT_TRUE(balance_at_height(addresses[1], 2, &balance));
+        TEST_ASSERT_TRUE(balance == INITIAL_WALLET_BALANCE + 6 * MICRO_LT_PER_LT);
+        TEST_ASSERT_FALSE(balance_at_height(addresses[0], 3, &balance));
+
+        /* A damaged snapshot is skipped and the log replayed from the start */
+        sprintf(path, "%s/snapshot_%010u.dat", get_config()->backup_directory, 1);
+        file = fopen(path, "r+b");
+        TEST_ASSERT_NOT_NULL(file);
+        fseek(file, (long)sizeof(SnapshotHeader), SEEK_SET);
+        fputc(0x7f, file);
+        fclose(file);
+        TEST_ASSERT_FALSE(snapshot_latest_height(&height));
+        TEST_ASSERT_TRUE(balance_at_height(addresses[1], 1, &balance));
+        TEST_ASSERT_TRUE(balance == INITIAL_WALLET_BALANCE + 3 * MICRO_LT_PER_LT);
+
+        txlog_close_shared();
+        wal_close();
+        leave_test_directory(directory, cwd);
+}
+
+void test_legacy_wallet_upgrades_and_spends(void)
+{
+        char directory[] = "/tmp/test_upgradeXXXXXX";
+        char cwd[512], text[256];
+        char old_address[HASH_LENGTH + 1], old_key[HASH_LENGTH + 1], peer_address[HASH_LENGTH + 1];
+        char payee_address[HASH_LENGTH + 1], payee_key[HASH_LENGTH + 1], new_key[HASH_LENGTH + 1];
+        LegacyStoredWallet wallets[2];
+        LegacyTransaction legacy[2];
+        Blockchain *chain = calloc(1, sizeof(Blockchain));
+        Transaction pending[4];
+        Wallet *wallet, *payee, forged;
+        uint32_t old_id, new_id;
+        FILE *file;
+        int i;
+
+        TEST_ASSERT_NOT_NULL(chain);
+        enter_test_directory(directory, cwd, sizeof(cwd));
+
+        /* A data set from before the log and key pairs: peer paid old 50 LT, old paid back 5 LT */
+        generate_hash("old@alustudent.com1600000000", old_address);
+        generate_hash("old key", old_key);
+        generate_hash("peer@alustudent.com1600000000", peer_address);
+        memset(legacy, 0, sizeof(legacy));
+        for (i = 0; i < 2; i++)
+        {
+                strcpy(legacy[i].from_address, i ? old_address : peer_address);
+                strcpy(legacy[i].to_address, i ? peer_address : old_address);
+                legacy[i].amount = i ? 5.0 : 50.0;
+                legacy[i].type = TOKEN_TRANSFER;
+                legacy[i].timestamp = 1600000000 + i;
+                sprintf(text, "%s%s%.2f%ld", legacy[i].from_address, legacy[i].to_address,
+                        legacy[i].amount, (long)legacy[i].timestamp);
+                generate_hash(text, legacy[i].signature);
+        }
+        file = fopen(TX_FILE, "wb");
+        TEST_ASSERT_NOT_NULL(file);
+        TEST_ASSERT_EQUAL_INT(2, (int)fwrite(legacy, sizeof(LegacyTransaction), 2, file));
+        fclose(file);
+
+        /* old also earned a 1 LT reward the old files never logged */
+        memset(wallets, 0, sizeof(wallets));
+        strcpy(wallets[0].email, "old@alustudent.com");
+        strcpy(wallets[0].private_key, old_key);
+        strcpy(wallets[0].address, old_address);
+        wallets[0].balance = 146.0;
+        strcpy(wallets[1].email, "peer@alustudent.com");
+        generate_hash("peer key", wallets[1].private_key);
+        strcpy(wallets[1].address, peer_address);
+        wallets[1].balance = 55.0;
+        file = fopen(LEGACY_WALLETS_FILE, "wb");
+        TEST_ASSERT_NOT_NULL(file);
+        TEST_ASSERT_EQUAL_INT(2, (int)fwrite(wallets, sizeof(LegacyStoredWallet), 2, file));
+        fclose(file);
+
+        TEST_ASSERT_TRUE(migrate_legacy_wallets());
+        TEST_ASSERT_TRUE(wal_open());
+        TEST_ASSERT_TRUE(generate_wallet_keys(payee_address, payee_key));
+        TEST_ASSERT_TRUE(save_wallet("payee@alustudent.com", payee_key, payee_address, NULL));
+
+        /* The legacy wallet loads but cannot sign */
+        wallet = load_wallet_by_key(old_key);
+        TEST_ASSERT_NOT_NULL(wallet);
+        TEST_ASSERT_TRUE(wallet->balance == 146 * MICRO_LT_PER_LT);
+        TEST_ASSERT_FALSE(wallet_has_signing_key(wallet));
+        TEST_ASSERT_FALSE(initiate_transaction(chain, wallet, payee_address, MICRO_LT_PER_LT,
+                                               TOKEN_TRANSFER));
+
+        /* Only the key on file proves ownership */
+        forged = *wallet;
+        generate_hash("guessed key", forged.private_key);
+        TEST_ASSERT_FALSE(upgrade_wallet_keys(&forged));
+
+        old_id = address_lookup(old_address);
+        TEST_ASSERT_TRUE(upgrade_wallet_keys(wallet));
+        TEST_ASSERT_TRUE(wallet_has_signing_key(wallet));
+        TEST_ASSERT_TRUE(strcmp(wallet->address, old_address) != 0);
+        TEST_ASSERT_NULL(load_wallet_by_key(old_key));
+        strcpy(new_key, wallet->private_key);
+        new_id = address_lookup(wallet->address);
+        TEST_ASSERT_EQUAL_UINT(old_id, wal_rotated_from(new_id));
+        TEST_ASSERT_EQUAL_UINT(new_id, wal_rotated_to(old_id));
+        TEST_ASSERT_FALSE(upgrade_wallet_keys(wallet));
+
+        /* The logged history carries over, so more than the initial balance can be spent */
+        TEST_ASSERT_TRUE(get_unspent_balance(wallet->address) == 145 * MICRO_LT_PER_LT);
+        TEST_ASSERT_TRUE(initiate_transaction(chain, wallet, payee_address, 120 * MICRO_LT_PER_LT,
+                                              TOKEN_TRANSFER));
+
+        /* A payment to the old address reaches the new one */
+        payee = load_wallet_by_key(payee_key);
+        TEST_ASSERT_NOT_NULL(payee);
+        TEST_ASSERT_TRUE(initiate_transaction(chain, payee, old_address, 2 * MICRO_LT_PER_LT,
+                                              TOKEN_TRANSFER));
+        TEST_ASSERT_EQUAL_INT(2, wal_copy_pending(pending, 4));
+        TEST_ASSERT_EQUAL_UINT(new_id, pending[0].from_id);
+        TEST_ASSERT_EQUAL_UINT(new_id, pending[1].to_id);
+        TEST_ASSERT_TRUE(verify_signatures(pending, 2, NULL));
+        free(payee);
+        free(wallet);
+
+        /* Replay moves the whole balance, reward included, and keeps the rotation */
+        txlog_close_shared();
+        wal_close();
+        TEST_ASSERT_TRUE(wal_open());
+        wallet = load_wallet_by_key(new_key);
+        TEST_ASSERT_NOT_NULL(wallet);
+        TEST_ASSERT_TRUE(wallet->balance == 28 * MICRO_LT_PER_LT);
+        TEST_ASSERT_EQUAL_UINT(old_id, wal_rotated_from(address_lookup(wallet->address)));
+        TEST_ASSERT_TRUE(get_unspent_balance(wallet->address) == 27 * MICRO_LT_PER_LT);
+        payee = load_wallet_by_key(payee_key);
+        TEST_ASSERT_NOT_NULL(payee);
+        TEST_ASSERT_TRUE(payee->balance == 218 * MICRO_LT_PER_LT);
+        free(payee);
+        free(wallet);
+
+        free(chain);
+        txlog_close_shared();
+        wal_close();
+        leave_test_directory(directory, cwd);
+}
+
+void test_parse_enroll_line(void)
+{
+        char email[MAX_EMAIL];
+        char line[MAX_EMAIL + 32];
+
+        TEST_ASSERT_EQUAL_INT(1, parse_enroll_line("a.b@alustudent.com\n", email));
+        TEST_ASSERT_EQUAL_STRING("a.b@alustudent.com", email);
+        TEST_ASSERT_EQUAL_INT(1, parse_enroll_line("  \"c@alueducation.com\" ,Jane,2\r\n", email));
+        TEST_ASSERT_EQUAL_STRING("c@alueducation.com", email);
+
+        /* Blank lines carry nothing; a header or stray text is not an email */
+        TEST_ASSERT_EQUAL_INT(0, parse_enroll_line("\n", email));
+        TEST_ASSERT_EQUAL_INT(-1, parse_enroll_line("email,name\n", email));
+
+        memset(line, 'x', MAX_EMAIL);
+        strcpy(line + MAX_EMAIL, "@alustudent.com");
+        TEST_ASSERT_EQUAL_INT(-1, parse_enroll_line(line, email));
+}
+
+void test_profile_store_grows_and_reloads(void)
+{
+        char directory[] = "/tmp/test_profilesXXXXXX";
+        char cwd[512];
+        StoredWallet *wallets;
+        StudentProfile *student;
+        StaffProfile *member;
+        UserType type;
+        int i, count = 3 * MAX_TRANSACTIONS;
+
+        TEST_ASSERT_NOT_NULL(getcwd(cwd, sizeof(cwd)));
+        TEST_ASSERT_NOT_NULL(mkdtemp(directory));
+        TEST_ASSERT_EQUAL_INT(0, chdir(directory));
+
+        wallets = calloc(count, sizeof(StoredWallet));
+        TEST_ASSERT_NOT_NULL(wallets);
+        for (i = 0; i < count; i++)
+        {
+                wallets[i].user_type = i % 3 ? STUDENT : STAFF;
+                sprintf(wallets[i].email, "user%d%s", i, i % 3 ? STUDENT_DOMAIN : STAFF_DOMAIN);
+                sprintf(wallets[i].address, "%064x", i + 1);
+        }
+
+        /* More profiles than the old fixed tables held */
+        release_profiles();
+        TEST_ASSERT_TRUE(add_enrolled_profiles(wallets, count));
+        student = get_profile_by_email("user299" STUDENT_DOMAIN, &type);
+        TEST_ASSERT_NOT_NULL(student);
+        TEST_ASSERT_EQUAL_INT(STUDENT, type);
+        TEST_ASSERT_EQUAL_STRING(wallets[299].address, student->wallet_address);
+
+        /* Journal plus compacted file must reload to the same profiles */
+        release_profiles();
+        TEST_ASSERT_NULL(get_profile_by_email("user299" STUDENT_DOMAIN, &type));
+        TEST_ASSERT_TRUE(load_profiles_from_file());
+        TEST_ASSERT_TRUE(access(PROFILES_JOURNAL, F_OK) != 0);
+
+        member = get_profile_by_email("user0" STAFF_DOMAIN, &type);
+        TEST_ASSERT_NOT_NULL(member);
+        TEST_ASSERT_EQUAL_INT(STAFF, type);
+        TEST_ASSERT_TRUE(get_profile_by_id(STAFF, member->staff_id) == member);
+        student = get_profile_by_email("user299" STUDENT_DOMAIN, &type);
+        TEST_ASSERT_NOT_NULL(student);
+        TEST_ASSERT_TRUE(get_profile_by_id(STUDENT, student->student_id) == student);
+        TEST_ASSERT_NULL(get_profile_by_id(STAFF, student->student_id));
+        TEST_ASSERT_NULL(get_profile_by_email("nobody" STUDENT_DOMAIN, &type));
+
+        /* A short batch stays in the journal until the next load */
+        sprintf(wallets[0].email, "late%s", STAFF_DOMAIN);
+        TEST_ASSERT_TRUE(add_enrolled_profiles(wallets, 1));
+        TEST_ASSERT_TRUE(access(PROFILES_JOURNAL, F_OK) == 0);
+        TEST_ASSERT_TRUE(load_profiles_from_file());
+        member = get_profile_by_email("late" STAFF_DOMAIN, &type);
+        TEST_ASSERT_NOT_NULL(member);
+        TEST_ASSERT_TRUE(get_profile_by_id(STAFF, member->staff_id) == member);
+        TEST_ASSERT_NOT_NULL(get_profile_by_email("user0" STAFF_DOMAIN, &type));
+
+        release_profiles();
+        free(wallets);
+        unlink(PROFILES_FILE);
+        TEST_ASSERT_EQUAL_INT(0, chdir(cwd));
+        rmdir(directory);
+}
+
+void test_vendor_registry_lookups(void)
+{
+        char directory[] = "/tmp/test_vendorsXXXXXX";
+        char cwd[512];
+        VendorProfile *kitchen;
+        FILE *file;
+
+        TEST_ASSERT_NOT_NULL(getcwd(cwd, sizeof(cwd)));
+        TEST_ASSERT_NOT_NULL(mkdtemp(directory));
+        TEST_ASSERT_EQUAL_INT(0, chdir(directory));
+
+        file = fopen(KITCHENS_FILE, "w");
+        TEST_ASSERT_NOT_NULL(file);
+        fprintf(file, "%s,pius@vendor.com,%s,100.00\n", Pius_Cuisine, PIUS_TEST_ADDRESS);
+        fprintf(file, "%s,joshua@vendor.com,%s,100.00\n", Joshua_Kitchen, JOSHUA_TEST_ADDRESS);
+        fclose(file);
+
+        release_profiles();
+        TEST_ASSERT_TRUE(load_vendor_registry());
+        TEST_ASSERT_EQUAL_INT(2, vendor_registry_count());
+        TEST_ASSERT_TRUE(vendor_list == get_kitchen_vendor(0));
+        TEST_ASSERT_TRUE(vendor_list->next == get_kitchen_vendor(1));
+
+        kitchen = get_kitchen_vendor(1);
+        TEST_ASSERT_NOT_NULL(kitchen);
+        TEST_ASSERT_EQUAL_STRING(JOSHUA_TEST_ADDRESS, kitchen->wallet_address);
+        TEST_ASSERT_TRUE(kitchen->balance == INITIAL_WALLET_BALANCE);
+        TEST_ASSERT_TRUE(get_vendor_by_name(Joshua_Kitchen) == kitchen);
+        TEST_ASSERT_TRUE(get_vendor_by_address(JOSHUA_TEST_ADDRESS) == kitchen);
+        TEST_ASSERT_TRUE(get_vendor_by_id(kitchen->vendor_id) == kitchen);
+        TEST_ASSERT_NULL(get_kitchen_vendor(2));
+        TEST_ASSERT_NULL(get_kitchen_vendor(-1));
+
+        /* New kitchens reach the registry and the file together */
+        add_kitchen(Pascal_Kitchen, "pascal@vendor.com", PASCAL_TEST_ADDRESS);
+        kitchen = get_vendor_by_address(PASCAL_TEST_ADDRESS);
+        TEST_ASSERT_NOT_NULL(kitchen);
+        TEST_ASSERT_TRUE(get_kitchen_vendor(2) == kitchen);
+        TEST_ASSERT_TRUE(load_vendor_registry());
+        TEST_ASSERT_EQUAL_INT(3, vendor_registry_count());
+        TEST_ASSERT_NOT_NULL(get_vendor_by_name(Pascal_Kitchen));
+        TEST_ASSERT_NULL(get_vendor_by_name("No Such Kitchen"));
+
+        release_vendor_registry();
+        TEST_ASSERT_NULL(vendor_list);
+        unlink(KITCHENS_FILE);
+        TEST_ASSERT_EQUAL_INT(0, chdir(cwd));
+        rmdir(directory);
+}
+
+void test_settlement_aggregates(void)
+{
+        SettlementTable table;
+        SettlementEntry entries[8];
+        SettlementDay takings;
+        Transaction tx;
+        uint32_t day;
+        int i;
+
+        settlement_init(&table);
+        memset(&tx, 0, sizeof(tx));
+        tx.to_id = 7;
+        tx.type = CAFETERIA_PAYMENT;
+        tx.timestamp = 2 * SECONDS_PER_DAY + 60;
+        for (i = 1; i <= 3; i++)
+        {
+                tx.amount = i * MICRO_LT_PER_LT;
+                TEST_ASSERT_TRUE(settlement_record(&table, &tx));
+        }
+        tx.type = TOKEN_TRANSFER;
+        TEST_ASSERT_TRUE(settlement_record(&table, &tx));
+        tx.timestamp += SECONDS_PER_DAY;
+        TEST_ASSERT_TRUE(settlement_record(&table, &tx));
+        tx.to_id = 8;
+        TEST_ASSERT_TRUE(settlement_record(&table, &tx));
+
+        settlement_day(&table, 7, 2, &takings);
+        TEST_ASSERT_EQUAL_UINT32(3, takings.count[CAFETERIA_PAYMENT]);
+        TEST_ASSERT_TRUE(takings.total[CAFETERIA_PAYMENT] == 6 * MICRO_LT_PER_LT);
+        TEST_ASSERT_EQUAL_UINT32(1, takings.count[TOKEN_TRANSFER]);
+        TEST_ASSERT_EQUAL_UINT32(0, takings.count[TUITION_FEE]);
+        settlement_day(&table, 7, 3, &takings);
+        TEST_ASSERT_EQUAL_UINT32(0, takings.count[CAFETERIA_PAYMENT]);
+        TEST_ASSERT_EQUAL_UINT32(1, takings.count[TOKEN_TRANSFER]);
+        TEST_ASSERT_EQUAL_INT(4, (int)settlement_export(&table, entries));
+        settlement_free(&table);
+
+        TEST_ASSERT_TRUE(parse_settlement_day("1970-01-02", &day));
+        TEST_ASSERT_EQUAL_UINT32(1, day);
+        TEST_ASSERT_TRUE(parse_settlement_day("2024-03-01", &day));
+        TEST_ASSERT_EQUAL_UINT32(19783, day);
+        TEST_ASSERT_FALSE(parse_settlement_day("2023-02-29", &day));
+        TEST_ASSERT_FALSE(parse_settlement_day("2024-13-01", &day));
+}
+
+void test_time_index_ranges(void)
+{
+        TimeIndex index;
+        int64_t times[300], time;
+        size_t first, last, i;
+        int32_t utc_offset;
+        char text[TIME_TEXT_SIZE];
+        int w;
+        const int64_t windows[][2] = {{1100, 1110}, {400, 600}, {0, 5000}, {1299, 1300}, {2000, 3000}};
+
+        time_index_init(&index);
+        for (i = 0; i < 300; i++)
+        {
+                /* The clock steps back once */
+                times[i] = i == 130 ? 500 : 1000 + (int64_t)i;
+                TEST_ASSERT_TRUE(time_index_add(&index, times[i], i * 2));
+        }
+
+        for (w = 0; w < 5; w++)
+        {
+                time_index_range(&index, windows[w][0], windows[w][1], &first, &last);
+                TEST_ASSERT_EQUAL_INT(0, (int)(first % TIME_INDEX_STRIDE));
+                TEST_ASSERT_TRUE(first <= last && last <= 300);
+                for (i = 0; i < 300; i++)
+                {
+                        if (times[i] >= windows[w][0] && times[i] < windows[w][1])
+                                TEST_ASSERT_TRUE(i >= first && i < last);
+                }
+        }
+
+        /* A narrow window only reaches the strides around it */
+        time_index_range(&index, 1250, 1260, &first, &last);
+        TEST_ASSERT_EQUAL_INT(192, (int)first);
+        TEST_ASSERT_EQUAL_INT(300, (int)last);
+        TEST_ASSERT_EQUAL_INT(384, (int)time_index_position(&index, first));
+        time_index_range(&index, 2000, 3000, &first, &last);
+        TEST_ASSERT_TRUE(first == last || first >= 256);
+        time_index_free(&index);
+
+        TEST_ASSERT_TRUE(civil_to_epoch(2023, 1, 1, 12, 0, 0) == 1672574400);
+        TEST_ASSERT_TRUE(civil_to_epoch(1969, 12, 31, 23, 59, 59) == -1);
+        TEST_ASSERT_TRUE(parse_block_time("2024-02-29 08:15:00", &time, &utc_offset));
+        format_epoch(time, utc_offset, text);
+        TEST_ASSERT_EQUAL_STRING("2024-02-29 08:15:00", text);
+        TEST_ASSERT_FALSE(parse_block_time("not a time", &time, &utc_offset));
+}
+
+void test_export_ledger_rows(void)
+{
+        char directory[] = "/tmp/test_exportXXXXXX";
+        char cwd[512];
+        char addresses[3][HASH_LENGTH + 1], keys[3][HASH_LENGTH + 1];
+        char expected[512], amount[LT_FORMAT_SIZE];
+        char lines[8][512];
+        const char *emails[3] = {"a@alustudent.com", "b@alustudent.com", "c@alustudent.com"};
+        const int64_t balances[3] = {INITIAL_WALLET_BALANCE - 3 * MICRO_LT_PER_LT / 2,
+                                     INITIAL_WALLET_BALANCE + 5 * MICRO_LT_PER_LT / 2,
+                                     INITIAL_WALLET_BALANCE};
+        Blockchain *chain = calloc(1, sizeof(Blockchain));
+        ExportOptions options;
+        Transaction txs[2];
+        Block block;
+        char *comma;
+        int64_t balance, total = 0;
+        int i, j;
+
+        TEST_ASSERT_NOT_NULL(chain);
+        enter_test_directory(directory, cwd, sizeof(cwd));
+        TEST_ASSERT_EQUAL_INT(0, mkdir(get_config()->backup_directory, 0755));
+        TEST_ASSERT_TRUE(wal_open());
+
+        /* Three registered wallets; the third never transacts */
+        for (i = 0; i < 3; i++)
+        {
+                TEST_ASSERT_TRUE(generate_wallet_keys(addresses[i], keys[i]));
+                TEST_ASSERT_TRUE(save_wallet(emails[i], keys[i], addresses[i], NULL));
+        }
+
+        /* Block 1: a pays b 2 LT for lunch, b sends back 0.5 LT and validates for 1 LT */
+        memset(txs, 0, sizeof(txs));
+        for (i = 0; i < 2; i++)
+        {
+                txs[i].from_id = wal_intern_address(addresses[i]);
+                txs[i].to_id = wal_intern_address(addresses[1 - i]);
+                txs[i].amount = i ? MICRO_LT_PER_LT / 2 : 2 * MICRO_LT_PER_LT;
+                txs[i].type = i ? TOKEN_TRANSFER : CAFETERIA_PAYMENT;
+                txs[i].timestamp = 1700000000 + 60 * i;
+                TEST_ASSERT_TRUE(sign_transaction(&txs[i], keys[i], addresses[i], addresses[1 - i]));
+                TEST_ASSERT_TRUE(wal_append_transaction(&txs[i]));
+        }
+        TEST_ASSERT_TRUE(wal_append_block(1, 2, 1, MICRO_LT_PER_LT));
+
+        for (i = 0; i < 2; i++)
+        {
+                memset(&block, 0, sizeof(block));
+                block.index = i;
+                block.timestamp = 1699999990 + 110 * i;
+                block.reward = i;
+                sprintf(block.current_hash, "%064x", i + 1);
+                sprintf(block.previous_hash, "%064x", i);
+                block.transaction_count = 2 * i;
+                block.transactions = calloc(MAX_TRANSACTIONS, sizeof(Transaction));
+                TEST_ASSERT_NOT_NULL(block.transactions);
+                memcpy(block.transactions, txs, (size_t)block.transaction_count * sizeof(Transaction));
+                seal_block_body(&block);
+                TEST_ASSERT_NOT_NULL(append_block(chain, &block));
+        }
+
+        export_options_init(&options);
+        options.prefix = "ledger";
+        TEST_ASSERT_TRUE(export_ledger(chain, &options));
+
+        TEST_ASSERT_EQUAL_INT(3, read_test_lines("ledger_blocks.csv", lines, 8));
+        TEST_ASSERT_EQUAL_STRING("height,time,hash,previous_hash,transactions,reward", lines[0]);
+        sprintf(expected, "1,2023-11-14T22:15:00Z,%064x,%064x,2,1", 2, 1);
+        TEST_ASSERT_EQUAL_STRING(expected, lines[2]);
+
+        TEST_ASSERT_EQUAL_INT(3, read_test_lines("ledger_transactions.csv", lines, 8));
+        TEST_ASSERT_EQUAL_STRING("block,time,type,from,to,amount", lines[0]);
+        sprintf(expected, "1,2023-11-14T22:13:20Z,cafeteria_payment,%s,%s,2.00", addresses[0], addresses[1]);
+        TEST_ASSERT_EQUAL_STRING(expected, lines[1]);
+        sprintf(expected, "1,2023-11-14T22:14:20Z,token_transfer,%s,%s,0.50", addresses[1], addresses[0]);
+        TEST_ASSERT_EQUAL_STRING(expected, lines[2]);
+
+        /* One row per wallet, and the totals add up to the supply plus the reward */
+        TEST_ASSERT_EQUAL_INT(4, read_test_lines("ledger_balances.csv", lines, 8));
+        TEST_ASSERT_EQUAL_STRING("address,balance", lines[0]);
+        for (i = 1; i < 4; i++)
+        {
+                comma = strchr(lines[i], ',');
+                TEST_ASSERT_NOT_NULL(comma);
+                *comma = '\0';
+                TEST_ASSERT_TRUE(lt_parse(comma + 1, &balance));
+                for (j = 0; j < 3 && strcmp(lines[i], addresses[j]) != 0; j++)
+                        ;
+                TEST_ASSERT_TRUE(j < 3);
+                TEST_ASSERT_TRUE(balance == balances[j]);
+                total += balance;
+        }
+        TEST_ASSERT_TRUE(total == 3 * INITIAL_WALLET_BALANCE + MICRO_LT_PER_LT);
+
+        /* Filtered to the idle wallet: no transactions, no blocks, its balance only */
+        options.format = EXPORT_JSONL;
+        options.prefix = "idle";
+        options.address = addresses[2];
+        TEST_ASSERT_TRUE(export_ledger(chain, &options));
+        TEST_ASSERT_EQUAL_INT(0, read_test_lines("idle_transactions.jsonl", lines, 8));
+        TEST_ASSERT_EQUAL_INT(0, read_test_lines("idle_blocks.jsonl", lines, 8));
+        TEST_ASSERT_EQUAL_INT(1, read_test_lines("idle_balances.jsonl", lines, 8));
+        sprintf(expected, "{\"address\":\"%s\",\"balance\":%s}", addresses[2],
+                lt_format(INITIAL_WALLET_BALANCE, amount));
+        TEST_ASSERT_EQUAL_STRING(expected, lines[0]);
+
+        cleanup_blockchain(chain);
+        txlog_close_shared();
+        wal_close();
+        leave_test_directory(directory, cwd);
+}
+
+void test_parse_export_args(void)
+{
+        ExportOptions options;
+        char *full[] = {"jsonl", "/tmp/ledger", "address=0x000joshua000000kitchen000000",
+                        "type=cafeteria_payment", "from=2024-03-01 12:00", "to=2024-03-01 14:00"};
+        char *numbered[] = {"csv", "out", "type=4"};
+        char *bad_format[] = {"xml", "out"};
+        char *bad_filter[] = {"csv", "out", "type=9"};
+        char *bad_time[] = {"csv", "out", "from=yesterday"};
+
+        TEST_ASSERT_TRUE(parse_export_args(6, full, &options));
+        TEST_ASSERT_EQUAL_INT(EXPORT_JSONL, options.format);
+        TEST_ASSERT_EQUAL_STRING("/tmp/ledger", options.prefix);
+        TEST_ASSERT_EQUAL_STRING(JOSHUA_TEST_ADDRESS, options.address);
+        TEST_ASSERT_EQUAL_INT(CAFETERIA_PAYMENT, options.type);
+        TEST_ASSERT_TRUE(options.end - options.start == 2 * 3600);
+
+        TEST_ASSERT_TRUE(parse_export_args(3, numbered, &options));
+        TEST_ASSERT_EQUAL_INT(EXPORT_CSV, options.format);
+        TEST_ASSERT_EQUAL_INT(TOKEN_TRANSFER, options.type);
+        TEST_ASSERT_NULL(options.address);
+        TEST_ASSERT_TRUE(options.start == INT64_MIN && options.end == INT64_MAX);
+
+        TEST_ASSERT_FALSE(parse_export_args(1, numbered, &options));
+        TEST_ASSERT_FALSE(parse_export_args(2, bad_format, &options));
+        TEST_ASSERT_FALSE(parse_export_args(3, bad_filter, &options));
+        TEST_ASSERT_FALSE(parse_export_args(3, bad_time, &options));
+}
+
 /* Test runner */
 int main(void)
 {
@@ -275,5 +1447,50 @@ int main(void)
         RUN_TEST(test_extract_transactions_with_data);
         RUN_TEST(test_extract_transactions_max_transactions);
 
+        /* transaction record tests */
+        RUN_TEST(test_transaction_record_is_compact);
+        RUN_TEST(test_transaction_signatures);
+        RUN_TEST(test_hex_round_trip);
+
+        /* token amount tests */
+        RUN_TEST(test_lt_parse_and_format);
+        RUN_TEST(test_lt_checked_arithmetic);
+
+        /* columnar transaction store tests */
+        RUN_TEST(test_txcolumns_kernels_agree);
+
+        /* block arena tests */
+        RUN_TEST(test_block_arena_lookup);
+        RUN_TEST(test_block_body_merkle_root);
+        RUN_TEST(test_pruned_bodies_reload_from_archive);
+
+        /* state snapshot tests */
+        RUN_TEST(test_ledger_applies_frames);
+        RUN_TEST(test_snapshot_balances_by_height);
+
+        /* transaction log tests */
+        RUN_TEST(test_wal_recovers_intact_prefix);
+        RUN_TEST(test_balance_scans_agree);
+        RUN_TEST(test_legacy_wallet_upgrades_and_spends);
+
+        /* bulk enrollment tests */
+        RUN_TEST(test_parse_enroll_line);
+
+        /* profile store tests */
+        RUN_TEST(test_profile_store_grows_and_reloads);
+
+        /* vendor registry tests */
+        RUN_TEST(test_vendor_registry_lookups);
+
+        /* settlement tests */
+        RUN_TEST(test_settlement_aggregates);
+
+        /* time index tests */
+        RUN_TEST(test_time_index_ranges);
+
+        /* ledger export tests */
+        RUN_TEST(test_parse_export_args);
+        RUN_TEST(test_export_ledger_rows);
+
         return UNITY_END();
 }
\ No newline at end of file
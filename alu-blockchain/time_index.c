@@ -0,0 +1,284 @@
+/* time_index.c */
+#include "time_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * A time index answers "which records can fall in [start, end)" without
+ * reading the records. Every TIME_INDEX_STRIDE records get one entry with
+ * the latest time before them and the earliest time from them on; a range
+ * lookup is two binary searches, and the caller scans at most one stride
+ * of records outside the range at each end.
+ */
+
+/**
+ * time_index_init - Start an empty index
+ * @index: Index to initialise
+ *
+ * A zero-filled TimeIndex (from calloc()) is empty as well.
+ */
+void time_index_init(TimeIndex *index)
+{
+        memset(index, 0, sizeof(TimeIndex));
+}
+
+/**
+ * time_index_free - Release an index and leave it empty
+ * @index: Index to free
+ */
+void time_index_free(TimeIndex *index)
+{
+        free(index->entries);
+        time_index_init(index);
+}
+
+/**
+ * time_index_reserve - Make room to add one more record without failing
+ * @index: Index
+ * Return: 1 on success, 0 on allocation failure
+ */
+int time_index_reserve(TimeIndex *index)
+{
+        TimeIndexEntry *grown;
+        size_t capacity;
+
+        if (index->count % TIME_INDEX_STRIDE || index->entry_count < index->entry_capacity)
+                return 1;
+
+        capacity = index->entry_capacity ? index->entry_capacity * 2 : 16;
+        grown = realloc(index->entries, capacity * sizeof(TimeIndexEntry));
+        if (!grown)
+                return 0;
+        index->entries = grown;
+        index->entry_capacity = capacity;
+        return 1;
+}
+
+/**
+ * time_index_add - Add the next record
+ * @index: Index
+ * @time: Time of the record, in seconds since the epoch
+ * @position: Caller's position of the record, kept if it starts an entry
+ *
+ * Records may arrive out of time order; an earlier time only lowers the
+ * bounds of the entries it follows.
+ *
+ * Return: 1 on success, 0 on allocation failure (never after
+ * time_index_reserve() succeeded)
+ */
+int time_index_add(TimeIndex *index, int64_t time, size_t position)
+{
+        TimeIndexEntry *entry;
+        size_t k;
+
+        if (!time_index_reserve(index))
+                return 0;
+
+        if (index->count % TIME_INDEX_STRIDE == 0)
+        {
+                entry = &index->entries[index->entry_count++];
+                entry->position = position;
+                entry->max_before = index->count ? index->latest : INT64_MIN;
+                entry->min_after = time;
+        }
+
+        for (k = index->entry_count; k > 0 && index->entries[k - 1].min_after > time; k--)
+                index->entries[k - 1].min_after = time;
+
+        if (!index->count || time > index->latest)
+                index->latest = time;
+        index->count++;
+        return 1;
+}
+
+/**
+ * time_index_range - Records that may have a time in [start, end)
+ * @index: Index
+ * @start: First time included
+ * @end: First time excluded
+ * @first: Receives the first record to scan, a multiple of TIME_INDEX_STRIDE
+ * @last: Receives the record after the last one to scan
+ *
+ * Every record in the range lies in [*first, *last); records near either
+ * end may still be outside it and must be filtered by the caller.
+ */
+void time_index_range(const TimeIndex *index, int64_t start, int64_t end,
+                      size_t *first, size_t *last)
+{
+        size_t low, high, middle;
+
+        *first = *last = 0;
+        if (start >= end || !index->entry_count)
+                return;
+
+        /* The last entry with every earlier record before @start */
+        low = 0;
+        high = index->entry_count;
+        while (low < high)
+        {
+                middle = low + (high - low) / 2;
+                if (index->entries[middle].max_before < start)
+                        low = middle + 1;
+                else
+                        high = middle;
+        }
+        *first = low ? (low - 1) * TIME_INDEX_STRIDE : 0;
+
+        /* The first entry with every later record at or after @end */
+        low = low ? low - 1 : 0;
+        high = index->entry_count;
+        while (low < high)
+        {
+                middle = low + (high - low) / 2;
+                if (index->entries[middle].min_after < end)
+                        low = middle + 1;
+                else
+                        high = middle;
+        }
+        *last = low < index->entry_count ? low * TIME_INDEX_STRIDE : index->count;
+}
+
+/**
+ * time_index_position - Caller's position of a record that starts an entry
+ * @index: Index
+ * @record: Record number, a multiple of TIME_INDEX_STRIDE below @index->count
+ * Return: Position given to time_index_add() for that record
+ */
+size_t time_index_position(const TimeIndex *index, size_t record)
+{
+        return index->entries[record / TIME_INDEX_STRIDE].position;
+}
+
+/**
+ * civil_to_epoch - Seconds since the epoch of a UTC calendar time
+ * @year: Year
+ * @month: Month, 1 to 12
+ * @day: Day of the month, 1 to 31
+ * @hour: Hour
+ * @minute: Minute
+ * @second: Second
+ *
+ * Unlike mktime() this ignores the local time zone, and unlike timegm()
+ * it is standard C.
+ *
+ * Return: Seconds since 1970-01-01 00:00:00 UTC
+ */
+int64_t civil_to_epoch(int year, int month, int day, int hour, int minute, int second)
+{
+        int64_t era, year_of_era, day_of_year, day_of_era;
+
+        year -= month <= 2;
+        era = (year >= 0 ? year : year - 399) / 400;
+        year_of_era = year - era * 400;
+        day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        return ((era * 146097 + day_of_era - 719468) * 24 + hour) * 3600 + minute * 60 + second;
+}
+
+/**
+ * parse_local_time - Parse "YYYY-MM-DD HH:MM[:SS]" in the local time zone
+ * @text: Time
+ * @time: Receives seconds since the epoch
+ * Return: 1 on success, 0 if @text is not a valid local time
+ */
+int parse_local_time(const char *text, int64_t *time)
+{
+        struct tm fields, parsed;
+        time_t when;
+        char extra;
+        int count;
+
+        memset(&fields, 0, sizeof(fields));
+        if (!text)
+                return 0;
+        count = sscanf(text, "%4d-%2d-%2d %2d:%2d:%2d%c", &fields.tm_year, &fields.tm_mon,
+                       &fields.tm_mday, &fields.tm_hour, &fields.tm_min, &fields.tm_sec, &extra);
+        if (count != 5 && count != 6)
+                return 0;
+
+        fields.tm_year -= 1900;
+        fields.tm_mon -= 1;
+        fields.tm_isdst = -1;
+        parsed = fields;
+        when = mktime(&parsed);
+
+        /* mktime() normalises 31 June to 1 July; reject anything it moved */
+        if (when == (time_t)-1 || parsed.tm_year != fields.tm_year || parsed.tm_mon != fields.tm_mon ||
+            parsed.tm_mday != fields.tm_mday || parsed.tm_hour != fields.tm_hour ||
+            parsed.tm_min != fields.tm_min || parsed.tm_sec != fields.tm_sec)
+                return 0;
+
+        *time = (int64_t)when;
+        return 1;
+}
+
+/**
+ * format_epoch - Format a time as "YYYY-MM-DD HH:MM:SS"
+ * @time: Seconds since the epoch
+ * @utc_offset: Seconds east of UTC of the time zone to show it in
+ * @text: Output buffer of TIME_TEXT_SIZE bytes
+ */
+void format_epoch(int64_t time, int32_t utc_offset, char *text)
+{
+        time_t shifted = (time_t)(time + utc_offset);
+        struct tm *fields = gmtime(&shifted);
+
+        if (!fields || !strftime(text, TIME_TEXT_SIZE, "%Y-%m-%d %H:%M:%S", fields))
+                snprintf(text, TIME_TEXT_SIZE, "%lld", (long long)time);
+}
+
+/**
+ * local_utc_offset - Offset of the local time zone at a given time
+ * @time: Seconds since the epoch
+ * Return: Seconds east of UTC, daylight saving included
+ */
+int32_t local_utc_offset(int64_t time)
+{
+        time_t when = (time_t)time;
+        struct tm *fields = localtime(&when);
+
+        if (!fields)
+                return 0;
+        return (int32_t)(civil_to_epoch(fields->tm_year + 1900, fields->tm_mon + 1, fields->tm_mday,
+                                        fields->tm_hour, fields->tm_min, fields->tm_sec) -
+                         time);
+}
+
+/**
+ * parse_block_time - Recover a block time from its "YYYY-MM-DD HH:MM:SS" text
+ * @text: Local time as older versions stored it
+ * @time: Receives seconds since the epoch
+ * @utc_offset: Receives the offset that formats @time back to @text
+ *
+ * The text is read in the current time zone. Whatever zone it was written
+ * in, format_epoch(*time, *utc_offset) gives back @text exactly, so block
+ * hashes over it still verify.
+ *
+ * Return: 1 on success, 0 if @text is not in that format
+ */
+int parse_block_time(const char *text, int64_t *time, int32_t *utc_offset)
+{
+        struct tm fields;
+        char formatted[TIME_TEXT_SIZE];
+        int64_t local;
+        time_t when;
+
+        memset(&fields, 0, sizeof(fields));
+        if (sscanf(text, "%4d-%2d-%2d %2d:%2d:%2d", &fields.tm_year, &fields.tm_mon, &fields.tm_mday,
+                   &fields.tm_hour, &fields.tm_min, &fields.tm_sec) != 6)
+                return 0;
+
+        local = civil_to_epoch(fields.tm_year, fields.tm_mon, fields.tm_mday,
+                               fields.tm_hour, fields.tm_min, fields.tm_sec);
+        fields.tm_year -= 1900;
+        fields.tm_mon -= 1;
+        fields.tm_isdst = -1;
+        when = mktime(&fields);
+
+        *time = when == (time_t)-1 ? local : (int64_t)when;
+        *utc_offset = (int32_t)(local - *time);
+        format_epoch(*time, *utc_offset, formatted);
+        return strcmp(formatted, text) == 0;
+}
@@ -0,0 +1,61 @@
+/* time_index.h */
+#ifndef TIME_INDEX_H
+#define TIME_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Records summarised by each time index entry */
+#define TIME_INDEX_STRIDE 64
+
+/* Size of a buffer for format_epoch(), "YYYY-MM-DD HH:MM:SS" plus NUL */
+#define TIME_TEXT_SIZE 30
+
+/**
+ * struct TimeIndexEntry - Summary of TIME_INDEX_STRIDE consecutive records
+ * @position: Caller's position of the first record (block height, log frame)
+ * @max_before: Latest time of any record before this entry's first one
+ * @min_after: Earliest time of any record from this entry's first one on
+ *
+ * Both bounds are monotonic across entries even when the records' own
+ * times are not (a clock stepped back), so both can be binary searched.
+ */
+typedef struct
+{
+        size_t position;
+        int64_t max_before;
+        int64_t min_after;
+} TimeIndexEntry;
+
+/**
+ * struct TimeIndex - Sparse index from time to record number
+ * @entries: One entry per TIME_INDEX_STRIDE records, in record order
+ * @entry_count: Number of entries in use
+ * @entry_capacity: Allocated length of @entries
+ * @count: Number of records added
+ * @latest: Latest time of any record added, unset while @count is 0
+ */
+typedef struct
+{
+        TimeIndexEntry *entries;
+        size_t entry_count;
+        size_t entry_capacity;
+        size_t count;
+        int64_t latest;
+} TimeIndex;
+
+void time_index_init(TimeIndex *index);
+void time_index_free(TimeIndex *index);
+int time_index_reserve(TimeIndex *index);
+int time_index_add(TimeIndex *index, int64_t time, size_t position);
+void time_index_range(const TimeIndex *index, int64_t start, int64_t end,
+                      size_t *first, size_t *last);
+size_t time_index_position(const TimeIndex *index, size_t record);
+
+int64_t civil_to_epoch(int year, int month, int day, int hour, int minute, int second);
+int parse_local_time(const char *text, int64_t *time);
+void format_epoch(int64_t time, int32_t utc_offset, char *text);
+int32_t local_utc_offset(int64_t time);
+int parse_block_time(const char *text, int64_t *time, int32_t *utc_offset);
+
+#endif /* TIME_INDEX_H */
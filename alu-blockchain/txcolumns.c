@@ -0,0 +1,428 @@
+/* txcolumns.c */
+#include "alu_blockchain.h"
+#include "txcolumns.h"
+#include "wal.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TX_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * SumKernel - Filtered sum over rows [start, end) of a column store
+ *
+ * The range never exceeds LT_SUM_CHUNK rows, so the plain int64 lane
+ * sums cannot overflow for amounts within LT_AMOUNT_MAX.
+ */
+typedef void (*SumKernel)(const TxColumns *columns, size_t start, size_t end,
+                          const TxFilter *filter, int64_t *sent, int64_t *received);
+
+static TxColumns shared_columns = {NULL, NULL, NULL, NULL, NULL, 0, 0, 0, {NULL, 0, 0, 0, 0}};
+static SumKernel active_kernel = NULL;
+static const char *active_name = "none";
+
+/**
+ * grow_columns - Make room for at least one more transaction
+ * @columns: Column store
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int grow_columns(TxColumns *columns)
+{
+        size_t capacity = columns->capacity ? columns->capacity * 2 : 1024;
+        void *from_id, *to_id, *amount, *timestamp, *type;
+
+        from_id = realloc(columns->from_id, capacity * sizeof(uint32_t));
+        if (from_id)
+                columns->from_id = from_id;
+        to_id = realloc(columns->to_id, capacity * sizeof(uint32_t));
+        if (to_id)
+                columns->to_id = to_id;
+        amount = realloc(columns->amount, capacity * sizeof(int64_t));
+        if (amount)
+                columns->amount = amount;
+        timestamp = realloc(columns->timestamp, capacity * sizeof(int64_t));
+        if (timestamp)
+                columns->timestamp = timestamp;
+        type = realloc(columns->type, capacity * sizeof(uint8_t));
+        if (type)
+                columns->type = type;
+
+        if (!from_id || !to_id || !amount || !timestamp || !type)
+                return 0;
+
+        columns->capacity = capacity;
+        return 1;
+}
+
+/**
+ * txcolumns_sync - Append transactions logged since the last sync
+ * @columns: Column store, zero-initialised before first use
+ * @log: Mapped log
+ *
+ * Only frames past columns->frames_seen are read. A log that shrank
+ * (torn tail discarded) is re-read from the start.
+ *
+ * Return: 1 on success, 0 on allocation failure or an out-of-range amount
+ */
+int txcolumns_sync(TxColumns *columns, TxLog *log)
+{
+        const WalFrame *frame;
+        const Transaction *tx;
+        TxCursor cursor;
+        size_t row;
+
+        if (!columns || !log)
+                return 0;
+
+        txlog_refresh(log);
+        if (log->count < columns->frames_seen)
+        {
+                columns->count = 0;
+                columns->frames_seen = 0;
+                time_index_free(&columns->times);
+        }
+
+        txcursor_begin(&cursor, log);
+        txcursor_seek(&cursor, columns->frames_seen);
+        while ((frame = txcursor_next(&cursor)))
+        {
+                if (frame->type == WAL_RECORD_TX)
+                {
+                        tx = &frame->body.tx;
+                        if (!lt_valid(tx->amount))
+                                return 0;
+                        if ((columns->count == columns->capacity && !grow_columns(columns)) ||
+                            !time_index_add(&columns->times, tx->timestamp, cursor.position - 1))
+                                return 0;
+
+                        row = columns->count++;
+                        columns->from_id[row] = tx->from_id;
+                        columns->to_id[row] = tx->to_id;
+                        columns->amount[row] = tx->amount;
+                        columns->timestamp[row] = tx->timestamp;
+                        columns->type[row] = tx->type;
+                }
+                columns->frames_seen = cursor.position;
+        }
+        return 1;
+}
+
+/**
+ * txcolumns_free - Release a column store
+ * @columns: Column store
+ */
+void txcolumns_free(TxColumns *columns)
+{
+        free(columns->from_id);
+        free(columns->to_id);
+        free(columns->amount);
+        free(columns->timestamp);
+        free(columns->type);
+        time_index_free(&columns->times);
+        memset(columns, 0, sizeof(TxColumns));
+}
+
+/**
+ * txcolumns_shared - Process-wide column store over TX_FILE, kept in sync
+ * Return: Column store, or NULL if the log cannot be read
+ */
+TxColumns *txcolumns_shared(void)
+{
+        TxLog *log = txlog_shared();
+
+        if (!log || !txcolumns_sync(&shared_columns, log))
+                return NULL;
+        return &shared_columns;
+}
+
+/**
+ * txcolumns_close_shared - Release the process-wide column store
+ */
+void txcolumns_close_shared(void)
+{
+        txcolumns_free(&shared_columns);
+}
+
+/**
+ * txfilter_init - Filter matching every transaction of an account
+ * @filter: Filter to initialise
+ * @account: Account ID
+ */
+void txfilter_init(TxFilter *filter, uint32_t account)
+{
+        filter->account = account;
+        filter->type = TX_ANY_TYPE;
+        filter->start = INT64_MIN;
+        filter->end = INT64_MAX;
+}
+
+/**
+ * sum_scalar - Portable filtered sum
+ * @columns: Column store
+ * @start: First row
+ * @end: Row after the last
+ * @filter: Filter
+ * @sent: Receives the sent total
+ * @received: Receives the received total
+ */
+static void sum_scalar(const TxColumns *columns, size_t start, size_t end,
+                       const TxFilter *filter, int64_t *sent, int64_t *received)
+{
+        int64_t out = 0, in = 0;
+        size_t i;
+
+        for (i = start; i < end; i++)
+        {
+                if (filter->type != TX_ANY_TYPE && columns->type[i] != filter->type)
+                        continue;
+                if (columns->timestamp[i] < filter->start || columns->timestamp[i] >= filter->end)
+                        continue;
+                if (columns->from_id[i] == filter->account)
+                        out += columns->amount[i];
+                if (columns->to_id[i] == filter->account)
+                        in += columns->amount[i];
+        }
+
+        *sent = out;
+        *received = in;
+}
+
+#ifdef TX_KERNEL_X86
+/**
+ * sum_sse42 - Filtered sum, two rows per step
+ * @columns: Column store
+ * @start: First row
+ * @end: Row after the last
+ * @filter: Filter
+ * @sent: Receives the sent total
+ * @received: Receives the received total
+ */
+__attribute__((target("sse4.2"))) static void sum_sse42(const TxColumns *columns, size_t start, size_t end,
+                                                       const TxFilter *filter, int64_t *sent, int64_t *received)
+{
+        const __m128i account = _mm_set1_epi32((int)filter->account);
+        const __m128i want_type = _mm_set1_epi64x(filter->type);
+        const __m128i window_start = _mm_set1_epi64x(filter->start);
+        const __m128i window_end = _mm_set1_epi64x(filter->end);
+        __m128i out = _mm_setzero_si128();
+        __m128i in = _mm_setzero_si128();
+        __m128i from, to, match, value;
+        int64_t lanes[2], tail_out, tail_in;
+        uint16_t types;
+        size_t i;
+
+        for (i = start; i + 2 <= end; i += 2)
+        {
+                if (filter->type == TX_ANY_TYPE)
+                {
+                        match = _mm_set1_epi64x(-1);
+                }
+                else
+                {
+                        memcpy(&types, columns->type + i, sizeof(types));
+                        match = _mm_cmpeq_epi64(_mm_cvtepu8_epi64(_mm_cvtsi32_si128(types)), want_type);
+                }
+
+                value = _mm_loadu_si128((const __m128i *)(columns->timestamp + i));
+                match = _mm_andnot_si128(_mm_cmpgt_epi64(window_start, value), match);
+                match = _mm_and_si128(_mm_cmpgt_epi64(window_end, value), match);
+
+                from = _mm_cvtepi32_epi64(_mm_cmpeq_epi32(
+                    _mm_loadl_epi64((const __m128i *)(columns->from_id + i)), account));
+                to = _mm_cvtepi32_epi64(_mm_cmpeq_epi32(
+                    _mm_loadl_epi64((const __m128i *)(columns->to_id + i)), account));
+
+                value = _mm_and_si128(_mm_loadu_si128((const __m128i *)(columns->amount + i)), match);
+                out = _mm_add_epi64(out, _mm_and_si128(value, from));
+                in = _mm_add_epi64(in, _mm_and_si128(value, to));
+        }
+
+        sum_scalar(columns, i, end, filter, &tail_out, &tail_in);
+
+        _mm_storeu_si128((__m128i *)lanes, out);
+        *sent = lanes[0] + lanes[1] + tail_out;
+        _mm_storeu_si128((__m128i *)lanes, in);
+        *received = lanes[0] + lanes[1] + tail_in;
+}
+
+/**
+ * sum_avx2 - Filtered sum, four rows per step
+ * @columns: Column store
+ * @start: First row
+ * @end: Row after the last
+ * @filter: Filter
+ * @sent: Receives the sent total
+ * @received: Receives the received total
+ */
+__attribute__((target("avx2"))) static void sum_avx2(const TxColumns *columns, size_t start, size_t end,
+                                                    const TxFilter *filter, int64_t *sent, int64_t *received)
+{
+        const __m128i account = _mm_set1_epi32((int)filter->account);
+        const __m256i want_type = _mm256_set1_epi64x(filter->type);
+        const __m256i window_start = _mm256_set1_epi64x(filter->start);
+        const __m256i window_end = _mm256_set1_epi64x(filter->end);
+        __m256i out = _mm256_setzero_si256();
+        __m256i in = _mm256_setzero_si256();
+        __m256i from, to, match, value;
+        int64_t lanes[4], tail_out, tail_in;
+        uint32_t types;
+        size_t i;
+
+        for (i = start; i + 4 <= end; i += 4)
+        {
+                if (filter->type == TX_ANY_TYPE)
+                {
+                        match = _mm256_set1_epi64x(-1);
+                }
+                else
+                {
+                        memcpy(&types, columns->type + i, sizeof(types));
+                        match = _mm256_cmpeq_epi64(_mm256_cvtepu8_epi64(_mm_cvtsi32_si128((int)types)),
+                                                   want_type);
+                }
+
+                value = _mm256_loadu_si256((const __m256i *)(columns->timestamp + i));
+                match = _mm256_andnot_si256(_mm256_cmpgt_epi64(window_start, value), match);
+                match = _mm256_and_si256(_mm256_cmpgt_epi64(window_end, value), match);
+
+                from = _mm256_cvtepi32_epi64(_mm_cmpeq_epi32(
+                    _mm_loadu_si128((const __m128i *)(columns->from_id + i)), account));
+                to = _mm256_cvtepi32_epi64(_mm_cmpeq_epi32(
+                    _mm_loadu_si128((const __m128i *)(columns->to_id + i)), account));
+
+                value = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(columns->amount + i)), match);
+                out = _mm256_add_epi64(out, _mm256_and_si256(value, from));
+                in = _mm256_add_epi64(in, _mm256_and_si256(value, to));
+        }
+
+        sum_scalar(columns, i, end, filter, &tail_out, &tail_in);
+
+        _mm256_storeu_si256((__m256i *)lanes, out);
+        *sent = lanes[0] + lanes[1] + lanes[2] + lanes[3] + tail_out;
+        _mm256_storeu_si256((__m256i *)lanes, in);
+        *received = lanes[0] + lanes[1] + lanes[2] + lanes[3] + tail_in;
+}
+#endif /* TX_KERNEL_X86 */
+
+/**
+ * txkernel_select - Choose the implementation used by txcolumns_sum()
+ * @kernel: Implementation, or TX_KERNEL_AUTO for the best available
+ * Return: 1 on success, 0 if the CPU does not support @kernel
+ */
+int txkernel_select(TxKernel kernel)
+{
+        int avx2 = 0;
+        int sse42 = 0;
+
+#ifdef TX_KERNEL_X86
+        __builtin_cpu_init();
+        avx2 = __builtin_cpu_supports("avx2");
+        sse42 = __builtin_cpu_supports("sse4.2");
+#endif
+
+        if (kernel == TX_KERNEL_AUTO)
+                kernel = avx2 ? TX_KERNEL_AVX2 : sse42 ? TX_KERNEL_SSE42
+                                                       : TX_KERNEL_SCALAR;
+
+        switch (kernel)
+        {
+#ifdef TX_KERNEL_X86
+        case TX_KERNEL_AVX2:
+                if (!avx2)
+                        return 0;
+                active_kernel = sum_avx2;
+                active_name = "avx2";
+                return 1;
+        case TX_KERNEL_SSE42:
+                if (!sse42)
+                        return 0;
+                active_kernel = sum_sse42;
+                active_name = "sse4.2";
+                return 1;
+#endif
+        case TX_KERNEL_SCALAR:
+                active_kernel = sum_scalar;
+                active_name = "scalar";
+                return 1;
+        default:
+                return 0;
+        }
+}
+
+/**
+ * txkernel_name - Name of the implementation txcolumns_sum() uses
+ * Return: "avx2", "sse4.2", "scalar", or "none" before the first selection
+ */
+const char *txkernel_name(void)
+{
+        return active_name;
+}
+
+/**
+ * txcolumns_sum - Sum the amounts an account sent and received
+ * @columns: Column store
+ * @filter: Account, type and time window to match
+ * @totals: Receives the totals
+ *
+ * Every kernel gives bit-identical results: rows are summed in chunks of
+ * LT_SUM_CHUNK with integer additions, and only the chunk totals are
+ * combined with overflow checks.
+ *
+ * Return: 1 on success, 0 on overflow
+ */
+int txcolumns_sum(const TxColumns *columns, const TxFilter *filter, TxTotals *totals)
+{
+        int64_t sent, received;
+        size_t start, end, last;
+
+        if (!columns || !filter || !totals)
+                return 0;
+
+        if (!active_kernel)
+                txkernel_select(TX_KERNEL_AUTO);
+
+        /* Only the rows the time index cannot rule out are scanned */
+        if (!txcolumns_time_range(columns, filter->start, filter->end, &start, &last, NULL))
+        {
+                start = 0;
+                last = columns->count;
+        }
+
+        totals->sent = 0;
+        totals->received = 0;
+        for (; start < last; start = end)
+        {
+                end = last - start > LT_SUM_CHUNK ? start + LT_SUM_CHUNK : last;
+                active_kernel(columns, start, end, filter, &sent, &received);
+                if (!lt_add(totals->sent, sent, &totals->sent) ||
+                    !lt_add(totals->received, received, &totals->received))
+                        return 0;
+        }
+        return 1;
+}
+
+/**
+ * txcolumns_time_range - Rows that may have a timestamp in [start, end)
+ * @columns: Column store
+ * @start: First timestamp included
+ * @end: First timestamp excluded
+ * @first: Receives the first row to scan
+ * @last: Receives the row after the last one to scan
+ * @frame: Receives the log frame of row @first, or NULL
+ *
+ * Rows in the returned range still need their timestamp checked; every
+ * row outside it is outside the window.
+ *
+ * Return: 1 on success, 0 if @columns has no time index (built by hand)
+ */
+int txcolumns_time_range(const TxColumns *columns, int64_t start, int64_t end,
+                         size_t *first, size_t *last, size_t *frame)
+{
+        if (!columns || columns->times.count != columns->count)
+                return 0;
+
+        time_index_range(&columns->times, start, end, first, last);
+        if (frame)
+                *frame = *first < *last ? time_index_position(&columns->times, *first) : 0;
+        return 1;
+}
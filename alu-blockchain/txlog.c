@@ -0,0 +1,305 @@
+/* txlog.c */
+#define _XOPEN_SOURCE 700
+#include "alu_blockchain.h"
+#include "txlog.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static TxLog shared_log = {-1, NULL, 0, NULL, 0};
+
+/**
+ * validate_new_frames - Extend log->count over newly mapped intact frames
+ * @log: Mapped log
+ *
+ * Stops at the first frame that is partial, fails its checksum or breaks
+ * the LSN sequence; wal_open() truncates such a tail on the next start.
+ */
+static void validate_new_frames(TxLog *log)
+{
+        size_t available;
+
+        if (log->length < sizeof(WalFileHeader))
+                return;
+
+        available = (log->length - sizeof(WalFileHeader)) / sizeof(WalFrame);
+        while (log->count < available &&
+               wal_frame_valid(&log->frames[log->count]) &&
+               log->frames[log->count].lsn == log->count + 1)
+                log->count++;
+}
+
+/**
+ * map_file - (Re)create the mapping for the current file size
+ * @log: Log with an open descriptor
+ * @size: Current file size
+ * Return: 1 on success, 0 on failure
+ */
+static int map_file(TxLog *log, size_t size)
+{
+        const WalFileHeader *header;
+        void *base;
+
+        if (log->base)
+                munmap((void *)log->base, log->length);
+        log->base = NULL;
+        log->frames = NULL;
+        log->length = 0;
+
+        if (size < sizeof(WalFileHeader))
+                return 1;
+
+        base = mmap(NULL, size, PROT_READ, MAP_SHARED, log->fd, 0);
+        if (base == MAP_FAILED)
+                return 0;
+
+        header = base;
+        if (header->magic != WAL_MAGIC || header->version != WAL_VERSION ||
+            header->frame_size != sizeof(WalFrame))
+        {
+                munmap(base, size);
+                return 0;
+        }
+
+        log->base = base;
+        log->length = size;
+        log->frames = (const WalFrame *)(log->base + sizeof(WalFileHeader));
+        validate_new_frames(log);
+        return 1;
+}
+
+/**
+ * txlog_map - Map TX_FILE for reading
+ * @log: Log to initialise
+ * Return: 1 on success, 0 if the file is missing or not a transaction log
+ */
+int txlog_map(TxLog *log)
+{
+        return txlog_map_trusted(log, 0, 0);
+}
+
+/**
+ * txlog_map_trusted - Map TX_FILE, trusting a prefix checked earlier
+ * @log: Log to initialise
+ * @trusted: Number of leading frames already known to be intact
+ * @crc: Checksum the last trusted frame must carry
+ *
+ * Only the last trusted frame and the frames after it are checksummed, so
+ * a caller resuming from a snapshot does not touch the rest of the log. If
+ * that frame does not match, the whole log is validated as by txlog_map().
+ *
+ * Return: 1 on success, 0 if the file is missing or not a transaction log
+ */
+int txlog_map_trusted(TxLog *log, size_t trusted, uint32_t crc)
+{
+        WalFrame frame;
+        struct stat st;
+
+        log->base = NULL;
+        log->frames = NULL;
+        log->length = 0;
+        log->count = 0;
+
+        log->fd = open(TX_FILE, O_RDONLY);
+        if (log->fd < 0)
+                return 0;
+
+        if (fstat(log->fd, &st) != 0)
+        {
+                txlog_unmap(log);
+                return 0;
+        }
+
+        if (trusted > 0 &&
+            pread(log->fd, &frame, sizeof(frame),
+                  (off_t)(sizeof(WalFileHeader) + (trusted - 1) * sizeof(WalFrame))) ==
+                (ssize_t)sizeof(frame) &&
+            frame.lsn == trusted && frame.crc == crc && wal_frame_valid(&frame))
+                log->count = trusted;
+
+        if (!map_file(log, (size_t)st.st_size))
+        {
+                txlog_unmap(log);
+                return 0;
+        }
+        return 1;
+}
+
+/**
+ * txlog_refresh - Pick up frames appended since the log was mapped
+ * @log: Mapped log
+ *
+ * Remaps only when the file grew; frames already validated are not
+ * checked again. A shrunken file (truncated tail) is remapped from scratch.
+ *
+ * Return: 1 on success, 0 on failure
+ */
+int txlog_refresh(TxLog *log)
+{
+        struct stat st;
+
+        if (log->fd < 0)
+                return txlog_map(log);
+
+        if (fstat(log->fd, &st) != 0)
+                return 0;
+
+        if ((size_t)st.st_size == log->length)
+                return 1;
+
+        if ((size_t)st.st_size < log->length)
+                log->count = 0;
+
+        return map_file(log, (size_t)st.st_size);
+}
+
+/**
+ * txlog_unmap - Release a mapping
+ * @log: Log to release
+ */
+void txlog_unmap(TxLog *log)
+{
+        if (log->base)
+                munmap((void *)log->base, log->length);
+        if (log->fd >= 0)
+                close(log->fd);
+
+        log->fd = -1;
+        log->base = NULL;
+        log->frames = NULL;
+        log->length = 0;
+        log->count = 0;
+}
+
+/**
+ * txlog_shared - Process-wide mapping of TX_FILE, refreshed on each call
+ * Return: Mapped log, or NULL if the log cannot be read
+ */
+TxLog *txlog_shared(void)
+{
+        if (!txlog_refresh(&shared_log))
+                return NULL;
+        return &shared_log;
+}
+
+/**
+ * txlog_close_shared - Release the process-wide mapping
+ */
+void txlog_close_shared(void)
+{
+        txlog_unmap(&shared_log);
+}
+
+/**
+ * txlog_frame - Random access to a frame
+ * @log: Mapped log
+ * @index: Zero-based frame index
+ * Return: Frame inside the mapping, or NULL if out of range
+ */
+const WalFrame *txlog_frame(const TxLog *log, size_t index)
+{
+        if (!log || index >= log->count)
+                return NULL;
+        return &log->frames[index];
+}
+
+/**
+ * txcursor_begin - Position a cursor before the first frame
+ * @cursor: Cursor to initialise
+ * @log: Mapped log
+ */
+void txcursor_begin(TxCursor *cursor, TxLog *log)
+{
+        cursor->log = log;
+        cursor->position = 0;
+}
+
+/**
+ * txcursor_end - Position a cursor after the last frame, for reverse scans
+ * @cursor: Cursor to initialise
+ * @log: Mapped log
+ */
+void txcursor_end(TxCursor *cursor, TxLog *log)
+{
+        txlog_refresh(log);
+        cursor->log = log;
+        cursor->position = log->count;
+}
+
+/**
+ * txcursor_seek - Move a cursor so txcursor_next() returns frame @index
+ * @cursor: Cursor
+ * @index: Zero-based frame index, may equal the frame count
+ * Return: 1 on success, 0 if @index is past the end of the log
+ */
+int txcursor_seek(TxCursor *cursor, size_t index)
+{
+        if (index > cursor->log->count)
+                txlog_refresh(cursor->log);
+        if (index > cursor->log->count)
+                return 0;
+
+        cursor->position = index;
+        return 1;
+}
+
+/**
+ * txcursor_next - Return the next frame and advance
+ * @cursor: Cursor
+ *
+ * Reaching the end checks once whether the file has grown and remaps.
+ *
+ * Return: Frame, or NULL at the end of the log
+ */
+const WalFrame *txcursor_next(TxCursor *cursor)
+{
+        if (cursor->position >= cursor->log->count)
+        {
+                txlog_refresh(cursor->log);
+                if (cursor->position >= cursor->log->count)
+                        return NULL;
+        }
+        return &cursor->log->frames[cursor->position++];
+}
+
+/**
+ * txcursor_prev - Step back and return the previous frame
+ * @cursor: Cursor
+ * Return: Frame, or NULL at the start of the log
+ */
+const WalFrame *txcursor_prev(TxCursor *cursor)
+{
+        if (cursor->position == 0)
+                return NULL;
+        return &cursor->log->frames[--cursor->position];
+}
+
+/**
+ * txcursor_next_transaction - Advance to the next transaction frame
+ * @cursor: Cursor
+ * Return: Transaction inside the mapping, or NULL at the end of the log
+ */
+const Transaction *txcursor_next_transaction(TxCursor *cursor)
+{
+        const WalFrame *frame;
+
+        while ((frame = txcursor_next(cursor)))
+                if (frame->type == WAL_RECORD_TX)
+                        return &frame->body.tx;
+        return NULL;
+}
+
+/**
+ * txcursor_prev_transaction - Step back to the previous transaction frame
+ * @cursor: Cursor
+ * Return: Transaction inside the mapping, or NULL at the start of the log
+ */
+const Transaction *txcursor_prev_transaction(TxCursor *cursor)
+{
+        const WalFrame *frame;
+
+        while ((frame = txcursor_prev(cursor)))
+                if (frame->type == WAL_RECORD_TX)
+                        return &frame->body.tx;
+        return NULL;
+}
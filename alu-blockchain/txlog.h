@@ -0,0 +1,56 @@
+/* txlog.h */
+#ifndef TXLOG_H
+#define TXLOG_H
+
+#include "wal.h"
+
+/**
+ * struct TxLog - Read-only memory mapping of the transaction log
+ * @fd: Descriptor of TX_FILE, -1 when not open
+ * @base: Start of the mapping (the file header)
+ * @length: Number of bytes mapped
+ * @frames: First frame, directly after the header
+ * @count: Number of leading frames that passed validation
+ *
+ * Frames are checksummed once when they first become visible; after that
+ * they are read in place. Pointers into the mapping stay valid until the
+ * next txlog_refresh() that finds the file has grown.
+ */
+typedef struct
+{
+        int fd;
+        const unsigned char *base;
+        size_t length;
+        const WalFrame *frames;
+        size_t count;
+} TxLog;
+
+/**
+ * struct TxCursor - Position in a TxLog
+ * @log: Log being read
+ * @position: Index of the frame txcursor_next() returns; txcursor_prev()
+ *            returns the frame before it
+ */
+typedef struct
+{
+        TxLog *log;
+        size_t position;
+} TxCursor;
+
+int txlog_map(TxLog *log);
+int txlog_map_trusted(TxLog *log, size_t trusted, uint32_t crc);
+int txlog_refresh(TxLog *log);
+void txlog_unmap(TxLog *log);
+TxLog *txlog_shared(void);
+void txlog_close_shared(void);
+const WalFrame *txlog_frame(const TxLog *log, size_t index);
+
+void txcursor_begin(TxCursor *cursor, TxLog *log);
+void txcursor_end(TxCursor *cursor, TxLog *log);
+int txcursor_seek(TxCursor *cursor, size_t index);
+const WalFrame *txcursor_next(TxCursor *cursor);
+const WalFrame *txcursor_prev(TxCursor *cursor);
+const Transaction *txcursor_next_transaction(TxCursor *cursor);
+const Transaction *txcursor_prev_transaction(TxCursor *cursor);
+
+#endif /* TXLOG_H */
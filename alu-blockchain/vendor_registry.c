@@ -0,0 +1,363 @@
+/* vendor_registry.c */
+#include "alu_blockchain.h"
+
+/*
+ * Kitchens are read from KITCHENS_FILE once, after the profiles, and kept
+ * in memory in file order. vendor_list links them in that order; the
+ * registry also indexes them by position, vendor ID, kitchen name and
+ * wallet address. add_kitchen() appends to the file and the registry
+ * together, so lookups never reread the file.
+ *
+ * A vendor's ID is its profile's vendor_id when it has a vendor profile,
+ * otherwise its 1-based position in the file (the preloaded kitchens).
+ */
+
+#define VENDOR_INDEX_MIN_SLOTS 64
+
+VendorProfile *vendor_list = NULL;
+
+static VendorProfile **vendors_by_position = NULL;
+static int registry_count = 0;
+static int registry_capacity = 0;
+static int registry_loaded = 0;
+
+/* Slots hold a position plus one, 0 when empty */
+static int *id_slots = NULL;
+static int *name_slots = NULL;
+static int *address_slots = NULL;
+static size_t slot_count = 0;
+
+/**
+ * string_key - FNV-1a hash of a string
+ * @text: String
+ * Return: 32-bit hash
+ */
+static uint32_t string_key(const char *text)
+{
+        uint32_t key = 2166136261u;
+
+        while (*text)
+        {
+                key ^= (unsigned char)*text++;
+                key *= 16777619u;
+        }
+        return key;
+}
+
+/**
+ * id_key - Hash of a vendor ID
+ * @id: Vendor ID
+ * Return: 32-bit hash
+ */
+static uint32_t id_key(int id)
+{
+        uint32_t key = (uint32_t)id * 2654435761u;
+
+        return key ^ key >> 16;
+}
+
+/**
+ * find_id_slot - Find the slot holding @id or the empty slot for it
+ * @slots: ID index
+ * @id: Vendor ID
+ * Return: Slot number
+ */
+static size_t find_id_slot(const int *slots, int id)
+{
+        size_t mask = slot_count - 1;
+        size_t i = id_key(id) & mask;
+
+        while (slots[i] && vendors_by_position[slots[i] - 1]->vendor_id != id)
+                i = (i + 1) & mask;
+        return i;
+}
+
+/**
+ * find_name_slot - Find the slot holding a kitchen name or the empty slot for it
+ * @slots: Name index
+ * @name: Kitchen name
+ * Return: Slot number
+ */
+static size_t find_name_slot(const int *slots, const char *name)
+{
+        size_t mask = slot_count - 1;
+        size_t i = string_key(name) & mask;
+
+        while (slots[i] && strcmp(vendors_by_position[slots[i] - 1]->kitchen_name, name) != 0)
+                i = (i + 1) & mask;
+        return i;
+}
+
+/**
+ * find_address_slot - Find the slot holding a wallet address or the empty slot for it
+ * @slots: Address index
+ * @address: Wallet address
+ * Return: Slot number
+ */
+static size_t find_address_slot(const int *slots, const char *address)
+{
+        size_t mask = slot_count - 1;
+        size_t i = string_key(address) & mask;
+
+        while (slots[i] && strcmp(vendors_by_position[slots[i] - 1]->wallet_address, address) != 0)
+                i = (i + 1) & mask;
+        return i;
+}
+
+/**
+ * index_vendor - Add the vendor at a position to all three indexes
+ * @position: Position in vendors_by_position
+ *
+ * The first vendor with a given name or address keeps that slot.
+ */
+static void index_vendor(int position)
+{
+        VendorProfile *vendor = vendors_by_position[position];
+        size_t slot;
+
+        slot = find_id_slot(id_slots, vendor->vendor_id);
+        if (!id_slots[slot])
+                id_slots[slot] = position + 1;
+        slot = find_name_slot(name_slots, vendor->kitchen_name);
+        if (!name_slots[slot])
+                name_slots[slot] = position + 1;
+        slot = find_address_slot(address_slots, vendor->wallet_address);
+        if (!address_slots[slot])
+                address_slots[slot] = position + 1;
+}
+
+/**
+ * grow_indexes - Double all three indexes and reinsert every vendor
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int grow_indexes(void)
+{
+        size_t count = slot_count ? slot_count * 2 : VENDOR_INDEX_MIN_SLOTS;
+        int *ids, *names, *addresses;
+        int i;
+
+        ids = calloc(count, sizeof(int));
+        names = calloc(count, sizeof(int));
+        addresses = calloc(count, sizeof(int));
+        if (!ids || !names || !addresses)
+        {
+                free(ids);
+                free(names);
+                free(addresses);
+                return 0;
+        }
+
+        free(id_slots);
+        free(name_slots);
+        free(address_slots);
+        id_slots = ids;
+        name_slots = names;
+        address_slots = addresses;
+        slot_count = count;
+
+        for (i = 0; i < registry_count; i++)
+                index_vendor(i);
+        return 1;
+}
+
+/**
+ * register_vendor - Add a kitchen to the registry
+ * @kitchen_name: Kitchen name
+ * @email: Vendor email
+ * @wallet_address: Wallet address
+ * @balance: Balance recorded in KITCHENS_FILE, in micro-LT
+ * Return: 1 on success, 0 on failure
+ */
+static int register_vendor(const char *kitchen_name, const char *email,
+                           const char *wallet_address, int64_t balance)
+{
+        VendorProfile **grown;
+        VendorProfile *vendor, *profile;
+        UserType type;
+
+        if ((size_t)(registry_count + 1) * 2 > slot_count && !grow_indexes())
+                return 0;
+
+        if (registry_count == registry_capacity)
+        {
+                grown = realloc(vendors_by_position,
+                                (registry_capacity ? registry_capacity * 2 : 16) * sizeof(VendorProfile *));
+                if (!grown)
+                        return 0;
+                vendors_by_position = grown;
+                registry_capacity = registry_capacity ? registry_capacity * 2 : 16;
+        }
+
+        vendor = calloc(1, sizeof(VendorProfile));
+        if (!vendor)
+                return 0;
+
+        strncpy(vendor->kitchen_name, kitchen_name, sizeof(vendor->kitchen_name) - 1);
+        strncpy(vendor->email, email, sizeof(vendor->email) - 1);
+        strncpy(vendor->wallet_address, wallet_address, sizeof(vendor->wallet_address) - 1);
+        vendor->balance = balance;
+
+        profile = get_profile_by_email(vendor->email, &type);
+        vendor->vendor_id = profile && type == VENDOR ? profile->vendor_id : registry_count + 1;
+
+        /* Keep vendor_list in file order */
+        if (registry_count)
+                vendors_by_position[registry_count - 1]->next = vendor;
+        else
+                vendor_list = vendor;
+
+        vendors_by_position[registry_count] = vendor;
+        index_vendor(registry_count++);
+        return 1;
+}
+
+/**
+ * load_vendor_registry - Read KITCHENS_FILE into the registry
+ *
+ * Call after load_profiles_from_file() so vendors get their profile IDs.
+ *
+ * Return: 1 on success or if there are no kitchens yet, 0 on failure
+ */
+int load_vendor_registry(void)
+{
+        char line[256];
+        char kitchen_name[MAX_NAME], email[MAX_EMAIL], wallet_address[HASH_LENGTH];
+        char balance_text[LT_FORMAT_SIZE];
+        int64_t balance;
+        FILE *file;
+        int ok = 1;
+
+        release_vendor_registry();
+        registry_loaded = 1;
+
+        file = fopen(KITCHENS_FILE, "r");
+        if (!file)
+                return 1;
+
+        while (ok && fgets(line, sizeof(line), file))
+        {
+                balance_text[0] = '\0';
+                if (sscanf(line, "%99[^,],%99[^,],%64[^,\n],%31s", kitchen_name, email,
+                           wallet_address, balance_text) < 3)
+                        continue;
+                if (!lt_parse(balance_text, &balance))
+                        balance = 0;
+                ok = register_vendor(kitchen_name, email, wallet_address, balance);
+        }
+
+        fclose(file);
+        return ok;
+}
+
+/**
+ * release_vendor_registry - Free every registered vendor and the indexes
+ */
+void release_vendor_registry(void)
+{
+        int i;
+
+        for (i = 0; i < registry_count; i++)
+                free(vendors_by_position[i]);
+        free(vendors_by_position);
+        free(id_slots);
+        free(name_slots);
+        free(address_slots);
+        vendors_by_position = NULL;
+        id_slots = name_slots = address_slots = NULL;
+        vendor_list = NULL;
+        registry_count = registry_capacity = 0;
+        slot_count = 0;
+        registry_loaded = 0;
+}
+
+/**
+ * add_kitchen - Add a new kitchen vendor to the list
+ * @kitchen_name: Name of the kitchen
+ * @email: Vendor's email
+ * @wallet_address: Wallet address for the kitchen
+ */
+void add_kitchen(const char *kitchen_name, const char *email, const char *wallet_address)
+{
+        char balance[LT_FORMAT_SIZE];
+        FILE *file;
+
+        file = fopen(KITCHENS_FILE, "a");
+        if (!file)
+        {
+                printf("Failed to open file for appending!\n");
+                return;
+        }
+
+        fprintf(file, "%s,%s,%s,%s\n", kitchen_name, email, wallet_address,
+                lt_format(INITIAL_WALLET_BALANCE, balance));
+        fclose(file);
+
+        /* Before the registry is loaded, the load picks the kitchen up from the file */
+        if (registry_loaded && !register_vendor(kitchen_name, email, wallet_address, INITIAL_WALLET_BALANCE))
+                printf("Warning: kitchen %s is not in the registry until restart.\n", kitchen_name);
+}
+
+/**
+ * vendor_registry_count - Number of registered kitchens
+ * Return: Kitchen count
+ */
+int vendor_registry_count(void)
+{
+        return registry_count;
+}
+
+/**
+ * get_kitchen_vendor - Get kitchen vendor by index
+ * @kitchen_index: Index of the kitchen vendor, in KITCHENS_FILE order
+ * Return: Registered vendor (owned by the registry) or NULL if not found
+ */
+VendorProfile *get_kitchen_vendor(int kitchen_index)
+{
+        if (kitchen_index < 0 || kitchen_index >= registry_count)
+                return NULL;
+        return vendors_by_position[kitchen_index];
+}
+
+/**
+ * get_vendor_by_id - Get kitchen vendor by vendor ID
+ * @vendor_id: Vendor ID
+ * Return: Registered vendor (owned by the registry) or NULL if not found
+ */
+VendorProfile *get_vendor_by_id(int vendor_id)
+{
+        int position;
+
+        if (!slot_count || !(position = id_slots[find_id_slot(id_slots, vendor_id)]))
+                return NULL;
+        return vendors_by_position[position - 1];
+}
+
+/**
+ * get_vendor_by_name - Get kitchen vendor by kitchen name
+ * @kitchen_name: Kitchen name
+ * Return: Registered vendor (owned by the registry) or NULL if not found
+ */
+VendorProfile *get_vendor_by_name(const char *kitchen_name)
+{
+        int position;
+
+        if (!slot_count || !kitchen_name ||
+            !(position = name_slots[find_name_slot(name_slots, kitchen_name)]))
+                return NULL;
+        return vendors_by_position[position - 1];
+}
+
+/**
+ * get_vendor_by_address - Get kitchen vendor by wallet address
+ * @wallet_address: Wallet address
+ * Return: Registered vendor (owned by the registry) or NULL if not found
+ */
+VendorProfile *get_vendor_by_address(const char *wallet_address)
+{
+        int position;
+
+        if (!slot_count || !wallet_address ||
+            !(position = address_slots[find_address_slot(address_slots, wallet_address)]))
+                return NULL;
+        return vendors_by_position[position - 1];
+}
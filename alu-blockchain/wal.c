@@ -0,0 +1,1116 @@
+/* wal.c */
+#define _XOPEN_SOURCE 700
+#include "alu_blockchain.h"
+#include "config.h"
+#include "wal.h"
+#include "txlog.h"
+#include "legacy.h"
+#include "snapshot.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define LEGACY_MIGRATION_FILE TX_FILE ".migrating"
+
+/**
+ * struct WalletTable - wallets.dat loaded for balance reconstruction
+ * @wallets: Records in file order
+ * @count: Number of records
+ */
+typedef struct
+{
+        StoredWallet *wallets;
+        size_t count;
+} WalletTable;
+
+static int wal_fd = -1;
+static off_t wal_size = 0;
+static uint64_t last_lsn = 0;
+static uint64_t synced_lsn = 0;
+static int sync_in_progress = 0;
+static int durable_waiters = 0;
+static WalFileHeader log_header;
+static pthread_mutex_t wal_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wal_synced = PTHREAD_COND_INITIALIZER;
+
+/* Transactions logged but not yet consumed by a block, oldest first */
+static Transaction *pending = NULL;
+static int pending_count = 0;
+static int pending_capacity = 0;
+
+/* Takings per recipient, day and type of every logged transaction */
+static SettlementTable settlements = {NULL, 0, 0};
+
+/* Every rotation in the log, oldest first; there are only ever a few */
+static WalRotate *rotations = NULL;
+static int rotation_count = 0;
+static int rotation_capacity = 0;
+
+static uint32_t crc_table[256];
+static int crc_table_ready = 0;
+
+/**
+ * crc32_init - Build the CRC-32 (IEEE 802.3) lookup table
+ */
+static void crc32_init(void)
+{
+        uint32_t c;
+        int n, k;
+
+        for (n = 0; n < 256; n++)
+        {
+                c = (uint32_t)n;
+                for (k = 0; k < 8; k++)
+                        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                crc_table[n] = c;
+        }
+        crc_table_ready = 1;
+}
+
+/**
+ * frame_crc - Compute the checksum stored in a frame
+ * @frame: Frame to checksum
+ * Return: CRC-32 of every byte after the crc field
+ */
+static uint32_t frame_crc(const WalFrame *frame)
+{
+        const unsigned char *p = (const unsigned char *)frame + sizeof(frame->crc);
+        size_t len = sizeof(WalFrame) - sizeof(frame->crc);
+        uint32_t c = 0xffffffffu;
+
+        if (!crc_table_ready)
+                crc32_init();
+
+        while (len--)
+                c = crc_table[(c ^ *p++) & 0xff] ^ (c >> 8);
+        return c ^ 0xffffffffu;
+}
+
+/**
+ * wal_frame_valid - Check a frame's type and checksum
+ * @frame: Frame read from the log
+ * Return: 1 if intact, 0 otherwise
+ */
+int wal_frame_valid(const WalFrame *frame)
+{
+        if (frame->type < WAL_RECORD_TX || frame->type > WAL_RECORD_ROTATE)
+                return 0;
+        return frame->crc == frame_crc(frame);
+}
+
+/**
+ * wal_accepts_digest - Check a transaction against the migration cutoff
+ * @transaction: TX_SIGNED_DIGEST transaction
+ *
+ * Only the migrated transactions of a pre-WAL data set may carry a digest:
+ * the sender must be one of the accounts that migration interned, whose
+ * hash-derived addresses have no key pair, and the transaction no newer
+ * than the last one migrated. Whether the digest itself matches is checked
+ * by the caller. The log must be open.
+ *
+ * Return: 1 if the transaction is within the cutoff, 0 otherwise
+ */
+int wal_accepts_digest(const Transaction *transaction)
+{
+        return log_header.legacy_lsn > 0 && transaction->from_id < log_header.legacy_accounts &&
+               transaction->timestamp <= log_header.legacy_time;
+}
+
+/**
+ * write_all - write() that retries short writes and EINTR
+ * @fd: File descriptor
+ * @buf: Data to write
+ * @len: Number of bytes
+ * Return: 1 on success, 0 on failure
+ */
+static int write_all(int fd, const void *buf, size_t len)
+{
+        const char *p = buf;
+        ssize_t n;
+
+        while (len > 0)
+        {
+                n = write(fd, p, len);
+                if (n < 0)
+                {
+                        if (errno == EINTR)
+                                continue;
+                        return 0;
+                }
+                p += n;
+                len -= (size_t)n;
+        }
+        return 1;
+}
+
+/**
+ * pending_push - Add a logged transaction to the in-memory pool
+ * @transaction: Transaction to add
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int pending_push(const Transaction *transaction)
+{
+        Transaction *grown;
+        int capacity;
+
+        if (pending_count == pending_capacity)
+        {
+                capacity = pending_capacity ? pending_capacity * 2 : MAX_TRANSACTIONS;
+                grown = realloc(pending, (size_t)capacity * sizeof(Transaction));
+                if (!grown)
+                        return 0;
+                pending = grown;
+                pending_capacity = capacity;
+        }
+
+        pending[pending_count++] = *transaction;
+        return 1;
+}
+
+/**
+ * pending_drop - Remove the oldest transactions from the pool
+ * @count: Number of transactions a block consumed
+ */
+static void pending_drop(int count)
+{
+        if (count <= 0)
+                return;
+        if (count > pending_count)
+                count = pending_count;
+
+        memmove(pending, pending + count,
+                (size_t)(pending_count - count) * sizeof(Transaction));
+        pending_count -= count;
+}
+
+/**
+ * rotation_push - Remember a logged rotation
+ * @rotation: Rotation to add
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int rotation_push(const WalRotate *rotation)
+{
+        WalRotate *grown;
+        int capacity;
+
+        if (rotation_count == rotation_capacity)
+        {
+                capacity = rotation_capacity ? rotation_capacity * 2 : 16;
+                grown = realloc(rotations, (size_t)capacity * sizeof(WalRotate));
+                if (!grown)
+                        return 0;
+                rotations = grown;
+                rotation_capacity = capacity;
+        }
+
+        rotations[rotation_count++] = *rotation;
+        return 1;
+}
+
+/**
+ * find_rotation - Look up the rotation that retired or created an account
+ * @account_id: Account ID
+ * @successor: 1 to find the rotation that created @account_id, 0 to find
+ *             the one that retired it
+ * Return: Rotation, or NULL if there is none
+ *
+ * The caller holds wal_lock.
+ */
+static const WalRotate *find_rotation(uint32_t account_id, int successor)
+{
+        int i;
+
+        for (i = 0; i < rotation_count; i++)
+        {
+                if ((successor ? rotations[i].successor_id : rotations[i].account_id) == account_id)
+                        return &rotations[i];
+        }
+        return NULL;
+}
+
+/**
+ * free_wallet_table - Release a wallet table
+ * @table: Table to free
+ */
+static void free_wallet_table(WalletTable *table)
+{
+        free(table->wallets);
+        memset(table, 0, sizeof(WalletTable));
+}
+
+/**
+ * load_wallet_table - Read wallets.dat into memory
+ * @table: Table to fill
+ * Return: 1 on success (an absent file gives an empty table), 0 on failure
+ */
+static int load_wallet_table(WalletTable *table)
+{
+        FILE *file;
+        StoredWallet wallet;
+        StoredWallet *grown;
+        size_t capacity = 0;
+
+        memset(table, 0, sizeof(WalletTable));
+
+        file = fopen(WALLETS_FILE, "rb");
+        if (!file)
+                return 1;
+
+        while (fread(&wallet, sizeof(StoredWallet), 1, file))
+        {
+                if (table->count == capacity)
+                {
+                        capacity = capacity ? capacity * 2 : 64;
+                        grown = realloc(table->wallets, capacity * sizeof(StoredWallet));
+                        if (!grown)
+                        {
+                                fclose(file);
+                                free_wallet_table(table);
+                                return 0;
+                        }
+                        table->wallets = grown;
+                }
+                table->wallets[table->count++] = wallet;
+        }
+        fclose(file);
+        return 1;
+}
+
+/**
+ * frame_address - Copy the address out of an address or rotate frame
+ * @frame: WAL_RECORD_ADDRESS or WAL_RECORD_ROTATE frame
+ * @address: Buffer of HASH_LENGTH + 1 bytes
+ */
+static void frame_address(const WalFrame *frame, char *address)
+{
+        if (frame->type == WAL_RECORD_ROTATE)
+                memcpy(address, frame->body.rotate.address, WAL_ADDRESS_BYTES);
+        else
+                memcpy(address, frame->body.address.address, WAL_ADDRESS_BYTES);
+        address[WAL_ADDRESS_BYTES] = '\0';
+}
+
+/**
+ * replay_frame - Apply a replayed frame to the address book and a ledger
+ * @state: Ledger being rebuilt
+ * @frame: Valid frame
+ * Return: 1 on success, 0 if the address book could not be extended or an
+ * amount is out of range
+ */
+static int replay_frame(LedgerState *state, const WalFrame *frame)
+{
+        char address[HASH_LENGTH + 1];
+
+        if (frame->type == WAL_RECORD_ADDRESS || frame->type == WAL_RECORD_ROTATE)
+        {
+                frame_address(frame, address);
+                if (address_book_define(address) != state->account_count)
+                        return 0;
+        }
+        return ledger_apply(state, frame);
+}
+
+/**
+ * init_frame - Zero a frame and set its type
+ * @frame: Frame to initialise
+ * @type: WAL_RECORD_* value
+ *
+ * Zeroing matters: the checksum covers padding bytes too.
+ */
+static void init_frame(WalFrame *frame, uint16_t type)
+{
+        memset(frame, 0, sizeof(WalFrame));
+        frame->type = type;
+}
+
+/**
+ * init_header - Fill in the header of a log with no migrated transactions
+ * @header: Header to initialise
+ */
+static void init_header(WalFileHeader *header)
+{
+        memset(header, 0, sizeof(WalFileHeader));
+        header->magic = WAL_MAGIC;
+        header->version = WAL_VERSION;
+        header->frame_size = sizeof(WalFrame);
+}
+
+/**
+ * write_header - Write the file header to an empty log
+ * @fd: Log file descriptor
+ * Return: 1 on success, 0 on failure
+ */
+static int write_header(int fd)
+{
+        WalFileHeader header;
+
+        init_header(&header);
+        return write_all(fd, &header, sizeof(header));
+}
+
+/**
+ * count_records - Count fixed-size records in a file
+ * @path: File to inspect
+ * @record_size: Size of one record
+ * Return: Number of whole records, 0 if the file is absent
+ */
+static long count_records(const char *path, size_t record_size)
+{
+        struct stat st;
+
+        if (stat(path, &st) != 0)
+                return 0;
+        return (long)(st.st_size / (off_t)record_size);
+}
+
+/**
+ * emit_frame - Number, checksum and write a frame during migration
+ * @fd: Migration output file
+ * @lsn: Last sequence number written, advanced on success
+ * @frame: Frame with type and body filled in
+ * Return: 1 on success, 0 on failure
+ */
+static int emit_frame(int fd, uint64_t *lsn, WalFrame *frame)
+{
+        frame->lsn = ++(*lsn);
+        frame->crc = frame_crc(frame);
+        return write_all(fd, frame, sizeof(WalFrame));
+}
+
+/**
+ * emit_address - Intern an address during migration
+ * @fd: Migration output file
+ * @lsn: Last sequence number written
+ * @state: Ledger being rebuilt
+ * @address: Address to intern
+ * Return: Account ID, or ADDRESS_ID_NONE on failure
+ */
+static uint32_t emit_address(int fd, uint64_t *lsn, LedgerState *state, const char *address)
+{
+        WalFrame frame;
+        uint32_t id;
+
+        id = address_lookup(address);
+        if (id != ADDRESS_ID_NONE)
+                return id;
+
+        init_frame(&frame, WAL_RECORD_ADDRESS);
+        strncpy(frame.body.address.address, address, WAL_ADDRESS_BYTES);
+        if (!emit_frame(fd, lsn, &frame) || !replay_frame(state, &frame))
+                return ADDRESS_ID_NONE;
+        return address_lookup(address);
+}
+
+/**
+ * migrate_legacy_log - Convert a pre-WAL transactions.dat/txpool.dat pair
+ *
+ * The old format is a bare array of hex-address LegacyTransaction records
+ * plus a separate pool file holding copies of the not-yet-mined tail.
+ * Every transaction is re-logged in the compact format; a block mark
+ * retires the ones that were already mined, and adjust records carry over
+ * balance changes the old files never logged (mining rewards), so that
+ * replaying the log reproduces wallets.dat.
+ *
+ * The header then records the migration cutoff, which is what lets the
+ * migrated transactions keep their unkeyed digests.
+ *
+ * Return: 1 on success, 0 on failure
+ */
+static int migrate_legacy_log(void)
+{
+        FILE *legacy;
+        LegacyTransaction old;
+        WalFileHeader header;
+        WalletTable table;
+        LedgerState state;
+        WalFrame frame;
+        long pooled;
+        long total = 0;
+        uint64_t lsn = 0;
+        uint32_t from_id, to_id, id;
+        int64_t stored, derived, latest = 0;
+        size_t i;
+        int fd;
+        int ok = 1;
+
+        printf("Migrating %s to the write-ahead log format...\n", TX_FILE);
+
+        if (!load_wallet_table(&table))
+                return 0;
+        address_book_clear();
+        ledger_init(&state);
+
+        legacy = fopen(TX_FILE, "rb");
+        fd = open(LEGACY_MIGRATION_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (!legacy || fd < 0 || !write_header(fd))
+                ok = 0;
+
+        while (ok && fread(&old, sizeof(LegacyTransaction), 1, legacy))
+        {
+                old.from_address[HASH_LENGTH] = '\0';
+                old.to_address[HASH_LENGTH] = '\0';
+                from_id = emit_address(fd, &lsn, &state, old.from_address);
+                to_id = emit_address(fd, &lsn, &state, old.to_address);
+                if (from_id == ADDRESS_ID_NONE || to_id == ADDRESS_ID_NONE)
+                {
+                        ok = 0;
+                        break;
+                }
+
+                init_frame(&frame, WAL_RECORD_TX);
+                transaction_from_legacy(&old, from_id, to_id, &frame.body.tx);
+                ok = emit_frame(fd, &lsn, &frame) && replay_frame(&state, &frame);
+                if (frame.body.tx.timestamp > latest)
+                        latest = frame.body.tx.timestamp;
+                total++;
+        }
+
+        /* Everything except the pool tail was already mined */
+        pooled = count_records(TX_POOL, sizeof(LegacyTransaction));
+        if (ok && total > pooled)
+        {
+                init_frame(&frame, WAL_RECORD_BLOCK);
+                frame.body.block.transaction_count = (int32_t)(total - pooled);
+                frame.body.block.validator_id = ADDRESS_ID_NONE;
+                ok = emit_frame(fd, &lsn, &frame);
+        }
+
+        for (i = 0; ok && i < table.count; i++)
+        {
+                stored = table.wallets[i].balance;
+                derived = ledger_balance(&state, address_lookup(table.wallets[i].address));
+                if (stored == derived)
+                        continue;
+
+                id = emit_address(fd, &lsn, &state, table.wallets[i].address);
+                if (id == ADDRESS_ID_NONE)
+                {
+                        ok = 0;
+                        break;
+                }
+                init_frame(&frame, WAL_RECORD_ADJUST);
+                frame.body.adjust.account_id = id;
+                ok = lt_sub(stored, derived, &frame.body.adjust.amount) &&
+                     emit_frame(fd, &lsn, &frame);
+        }
+
+        if (ok)
+        {
+                init_header(&header);
+                header.legacy_accounts = address_count();
+                header.legacy_lsn = lsn;
+                header.legacy_time = latest;
+                ok = lseek(fd, 0, SEEK_SET) == 0 && write_all(fd, &header, sizeof(header)) &&
+                     fsync(fd) == 0;
+        }
+        if (legacy)
+                fclose(legacy);
+        if (fd >= 0)
+                close(fd);
+        free_wallet_table(&table);
+        ledger_free(&state);
+        address_book_clear();
+
+        if (!ok || rename(LEGACY_MIGRATION_FILE, TX_FILE) != 0)
+        {
+                printf("Error: migration of %s failed.\n", TX_FILE);
+                unlink(LEGACY_MIGRATION_FILE);
+                return 0;
+        }
+
+        unlink(TX_POOL);
+        printf("Migrated %ld transaction(s), %ld pending.\n", total, pooled);
+        return 1;
+}
+
+/**
+ * restore_wallet_balances - Make wallets.dat agree with the replayed log
+ * @table: Wallet table
+ * @state: Ledger holding the log-derived balances
+ */
+static void restore_wallet_balances(WalletTable *table, const LedgerState *state)
+{
+        FILE *file;
+        int64_t balance;
+        size_t i;
+        size_t changed = 0;
+
+        for (i = 0; i < table->count; i++)
+        {
+                balance = ledger_balance(state, address_lookup(table->wallets[i].address));
+                if (table->wallets[i].balance == balance)
+                        continue;
+                table->wallets[i].balance = balance;
+                changed++;
+        }
+
+        if (!changed)
+                return;
+
+        file = fopen(WALLETS_FILE, "wb");
+        if (!file)
+        {
+                printf("Error opening wallet file for writing.\n");
+                return;
+        }
+        fwrite(table->wallets, sizeof(StoredWallet), table->count, file);
+        fclose(file);
+
+        printf("Recovered %lu wallet balance(s) from the transaction log.\n",
+               (unsigned long)changed);
+}
+
+/**
+ * replay_log - Scan the log, truncate a torn tail and rebuild derived state
+ * @size: Current size of the log file
+ *
+ * Replay resumes from the newest snapshot, so only the frames logged after
+ * it are checksummed and applied.
+ *
+ * Return: 1 on success, 0 on failure
+ */
+static int replay_log(off_t size)
+{
+        TxLog log;
+        const WalFrame *frame;
+        TxCursor cursor;
+        WalletTable table;
+        LedgerState state;
+        off_t offset;
+        size_t i;
+        int ok;
+
+        if (!load_wallet_table(&table))
+                return 0;
+
+        /* The snapshot also refills the address book */
+        address_book_clear();
+        ledger_init(&state);
+        snapshot_load_latest(&state, UINT_MAX, NULL, 1);
+
+        if (!txlog_map_trusted(&log, (size_t)state.lsn, state.frame_crc))
+        {
+                ledger_free(&state);
+                free_wallet_table(&table);
+                return 0;
+        }
+
+        if (!snapshot_matches_log(&state, &log))
+        {
+                printf("Ignoring the snapshot at block %u: it does not match %s.\n",
+                       state.height, TX_FILE);
+                ledger_free(&state);
+                address_book_clear();
+        }
+
+        /* The mapping only exposes the intact prefix of the log */
+        txcursor_begin(&cursor, &log);
+        ok = txcursor_seek(&cursor, (size_t)state.lsn);
+        while (ok && (frame = txcursor_next(&cursor)))
+        {
+                /* Past the migration cutoff every transaction must be signed */
+                if (frame->type == WAL_RECORD_TX && frame->lsn > log_header.legacy_lsn &&
+                    frame->body.tx.signature_type != TX_SIGNED_ED25519)
+                {
+                        printf("Error: %s holds an unsigned transaction at record %llu.\n",
+                               TX_FILE, (unsigned long long)frame->lsn);
+                        ok = 0;
+                        break;
+                }
+                ok = replay_frame(&state, frame);
+        }
+
+        /* Rotations are looked up by account, so the snapshot does not cover them */
+        rotation_count = 0;
+        for (i = 0; ok && i < log.count; i++)
+        {
+                frame = txlog_frame(&log, i);
+                if (frame->type == WAL_RECORD_ROTATE)
+                        ok = rotation_push(&frame->body.rotate);
+        }
+        last_lsn = log.count;
+        offset = (off_t)(sizeof(WalFileHeader) + log.count * sizeof(WalFrame));
+        txlog_unmap(&log);
+
+        if (ok && offset < size)
+        {
+                printf("Discarding %ld byte(s) of incomplete log tail.\n",
+                       (long)(size - offset));
+                ok = ftruncate(wal_fd, offset) == 0 && fsync(wal_fd) == 0;
+        }
+
+        if (ok)
+        {
+                wal_size = offset;
+                synced_lsn = last_lsn;
+
+                /* The ledger's pool becomes the live one */
+                free(pending);
+                pending = state.pending;
+                pending_count = state.pending_count;
+                pending_capacity = state.pending_capacity;
+                state.pending = NULL;
+
+                settlement_free(&settlements);
+                settlements = state.settlements;
+                settlement_init(&state.settlements);
+
+                restore_wallet_balances(&table, &state);
+        }
+
+        ledger_free(&state);
+        free_wallet_table(&table);
+        return ok;
+}
+
+/**
+ * wal_open - Open the transaction log and recover state from it
+ *
+ * Creates the log if missing and migrates the legacy format. The log is
+ * scanned once: a torn or corrupt tail is truncated, the pending pool is
+ * rebuilt, and wallet balances are replayed and written back if a crash
+ * left wallets.dat behind the log.
+ *
+ * Return: 1 on success, 0 on failure
+ */
+int wal_open(void)
+{
+        WalFileHeader header;
+        struct stat st;
+        FILE *probe;
+        int ok;
+
+        if (wal_fd >= 0)
+                return 1;
+
+        if (stat(TX_FILE, &st) == 0 && st.st_size > 0)
+        {
+                probe = fopen(TX_FILE, "rb");
+                if (!probe)
+                        return 0;
+                if (fread(&header, sizeof(header), 1, probe) != 1)
+                        header.magic = 0;
+                fclose(probe);
+
+                if (header.magic != WAL_MAGIC && !migrate_legacy_log())
+                        return 0;
+        }
+
+        wal_fd = open(TX_FILE, O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (wal_fd < 0)
+        {
+                printf("Error opening transactions file.\n");
+                return 0;
+        }
+
+        ok = fstat(wal_fd, &st) == 0;
+        if (ok && st.st_size == 0)
+        {
+                ok = write_header(wal_fd) && fsync(wal_fd) == 0;
+                init_header(&header);
+                st.st_size = sizeof(WalFileHeader);
+        }
+        else if (ok && (pread(wal_fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+                        header.magic != WAL_MAGIC || header.version != WAL_VERSION ||
+                        header.frame_size != sizeof(WalFrame)))
+        {
+                printf("Error: %s was written by an unsupported version.\n", TX_FILE);
+                ok = 0;
+        }
+
+        if (ok)
+        {
+                log_header = header;
+                ok = replay_log(st.st_size);
+        }
+
+        if (!ok)
+        {
+                close(wal_fd);
+                wal_fd = -1;
+                memset(&log_header, 0, sizeof(log_header));
+        }
+        return ok;
+}
+
+/**
+ * wal_close - Flush and close the transaction log
+ */
+void wal_close(void)
+{
+        if (wal_fd < 0)
+                return;
+
+        fsync(wal_fd);
+        close(wal_fd);
+        wal_fd = -1;
+
+        free(pending);
+        pending = NULL;
+        pending_count = 0;
+        pending_capacity = 0;
+        settlement_free(&settlements);
+        free(rotations);
+        rotations = NULL;
+        rotation_count = 0;
+        rotation_capacity = 0;
+        address_book_clear();
+        memset(&log_header, 0, sizeof(log_header));
+}
+
+/**
+ * wait_durable - Block until @lsn is on stable storage (group commit)
+ * @lsn: Sequence number of the caller's frame
+ *
+ * The first waiter becomes the leader and issues one fdatasync for
+ * everything written so far; followers sleep until a sync covers them.
+ * The leader lingers for the batch window first, but only when there is
+ * company to wait for: another appender already blocked here, or frames
+ * written after the leader's own. A lone writer syncs straight away.
+ * Called with wal_lock held.
+ *
+ * Return: 1 once durable, 0 if the sync failed
+ */
+static int wait_durable(uint64_t lsn)
+{
+        const Config *config = get_config();
+        struct timespec window;
+        uint64_t target;
+        int ok = 1;
+
+        durable_waiters++;
+        while (synced_lsn < lsn)
+        {
+                if (sync_in_progress)
+                {
+                        pthread_cond_wait(&wal_synced, &wal_lock);
+                        continue;
+                }
+
+                sync_in_progress = 1;
+                if (config && config->wal_batch_window_us > 0 &&
+                    (durable_waiters > 1 || last_lsn > lsn))
+                {
+                        window.tv_sec = config->wal_batch_window_us / 1000000;
+                        window.tv_nsec = (long)(config->wal_batch_window_us % 1000000) * 1000;
+                        pthread_mutex_unlock(&wal_lock);
+                        nanosleep(&window, NULL);
+                        pthread_mutex_lock(&wal_lock);
+                }
+
+                target = last_lsn;
+                pthread_mutex_unlock(&wal_lock);
+                ok = fdatasync(wal_fd) == 0;
+                pthread_mutex_lock(&wal_lock);
+
+                sync_in_progress = 0;
+                if (ok && target > synced_lsn)
+                        synced_lsn = target;
+                pthread_cond_broadcast(&wal_synced);
+                if (!ok)
+                        break;
+        }
+        durable_waiters--;
+        return ok;
+}
+
+/**
+ * cut_frame - Take the frame just written off the end of the log
+ * @previous_size: Size of the log before the frame
+ *
+ * Called with wal_lock held, so nothing has been written after it.
+ *
+ * Return: Always 0, the result of the append that failed
+ */
+static int cut_frame(off_t previous_size)
+{
+        if (ftruncate(wal_fd, previous_size) != 0)
+        {
+                printf("Error: a failed record is left in the log and will replay.\n");
+                return 0;
+        }
+        wal_size = previous_size;
+        last_lsn--;
+        return 0;
+}
+
+/**
+ * write_frame - Assign an LSN, checksum and write a frame
+ * @frame: Frame with type and body filled in
+ *
+ * Called with wal_lock held. Transaction and block frames update the
+ * in-memory pool, transactions the settlement aggregates and rotations
+ * the rotation table, in log order. A transaction or rotation the
+ * in-memory state cannot take is cut off the log again, so a failed
+ * append is not replayed on the next start.
+ *
+ * Return: 1 on success, 0 on failure
+ */
+static int write_frame(WalFrame *frame)
+{
+        off_t previous_size = wal_size;
+
+        frame->lsn = last_lsn + 1;
+        frame->crc = frame_crc(frame);
+        if (!write_all(wal_fd, frame, sizeof(WalFrame)))
+        {
+                /* Never leave a partial frame in front of later appends */
+                if (ftruncate(wal_fd, wal_size) != 0)
+                        printf("Error: transaction log may have a torn tail.\n");
+                return 0;
+        }
+        last_lsn = frame->lsn;
+        wal_size += sizeof(WalFrame);
+
+        if (frame->type == WAL_RECORD_TX)
+        {
+                if (pending_push(&frame->body.tx))
+                {
+                        if (settlement_record(&settlements, &frame->body.tx))
+                                return 1;
+                        pending_count--;
+                }
+                return cut_frame(previous_size);
+        }
+        if (frame->type == WAL_RECORD_ROTATE && !rotation_push(&frame->body.rotate))
+                return cut_frame(previous_size);
+        if (frame->type == WAL_RECORD_BLOCK)
+                pending_drop(frame->body.block.transaction_count);
+        return 1;
+}
+
+/**
+ * append_frame - Write a frame and wait for the configured durability
+ * @frame: Frame with type and body filled in
+ * Return: 1 on success, 0 on failure
+ */
+static int append_frame(WalFrame *frame)
+{
+        const Config *config = get_config();
+        int durability = config ? config->wal_durability : WAL_DURABILITY_BATCHED;
+        int ok;
+
+        if (wal_fd < 0 && !wal_open())
+                return 0;
+
+        pthread_mutex_lock(&wal_lock);
+
+        ok = write_frame(frame);
+        if (ok && durability == WAL_DURABILITY_PER_TX)
+        {
+                if (fdatasync(wal_fd) != 0)
+                        ok = 0;
+                else if (last_lsn > synced_lsn)
+                        synced_lsn = last_lsn;
+        }
+        else if (ok && durability == WAL_DURABILITY_BATCHED)
+        {
+                ok = wait_durable(frame->lsn);
+        }
+
+        pthread_mutex_unlock(&wal_lock);
+        return ok;
+}
+
+/**
+ * wal_intern_address - Get or assign the account ID of an address
+ * @address: Wallet address
+ *
+ * A new assignment is logged before it becomes visible. It is not synced
+ * on its own: the transaction that needed the ID follows it in the log,
+ * and that append's sync covers both.
+ *
+ * Return: Account ID, or ADDRESS_ID_NONE on failure
+ */
+uint32_t wal_intern_address(const char *address)
+{
+        WalFrame frame;
+        uint32_t id;
+
+        if (!address || !*address || strlen(address) > WAL_ADDRESS_BYTES)
+                return ADDRESS_ID_NONE;
+        if (wal_fd < 0 && !wal_open())
+                return ADDRESS_ID_NONE;
+
+        pthread_mutex_lock(&wal_lock);
+        id = address_lookup(address);
+        if (id == ADDRESS_ID_NONE)
+        {
+                init_frame(&frame, WAL_RECORD_ADDRESS);
+                strncpy(frame.body.address.address, address, WAL_ADDRESS_BYTES);
+                if (write_frame(&frame))
+                        id = address_book_define(address);
+        }
+        pthread_mutex_unlock(&wal_lock);
+        return id;
+}
+
+/**
+ * wal_rotate_address - Move an account to a new address
+ * @account_id: Account to retire; it must not have been rotated already
+ * @address: New address; it must not have an account yet
+ *
+ * The new address gets the next account ID and the whole balance of the
+ * old one. The rotation is synced before this returns, whatever the
+ * configured durability, because the caller goes on to replace the
+ * wallet's keys.
+ *
+ * Return: Account ID of @address, or ADDRESS_ID_NONE on failure
+ */
+uint32_t wal_rotate_address(uint32_t account_id, const char *address)
+{
+        WalFrame frame;
+        uint32_t id = ADDRESS_ID_NONE;
+
+        if (!address || !*address || strlen(address) > WAL_ADDRESS_BYTES)
+                return ADDRESS_ID_NONE;
+        if (wal_fd < 0 && !wal_open())
+                return ADDRESS_ID_NONE;
+
+        pthread_mutex_lock(&wal_lock);
+        if (account_id < address_count() && !find_rotation(account_id, 0) &&
+            address_lookup(address) == ADDRESS_ID_NONE)
+        {
+                init_frame(&frame, WAL_RECORD_ROTATE);
+                frame.body.rotate.account_id = account_id;
+                frame.body.rotate.successor_id = address_count();
+                strncpy(frame.body.rotate.address, address, WAL_ADDRESS_BYTES);
+                if (write_frame(&frame))
+                {
+                        id = address_book_define(address);
+                        if (!wait_durable(frame.lsn))
+                                id = ADDRESS_ID_NONE;
+                }
+        }
+        pthread_mutex_unlock(&wal_lock);
+        return id;
+}
+
+/**
+ * wal_rotated_from - Find the account a rotation replaced
+ * @account_id: Account ID
+ * Return: Account that @account_id was rotated from, or ADDRESS_ID_NONE
+ */
+uint32_t wal_rotated_from(uint32_t account_id)
+{
+        const WalRotate *rotation;
+        uint32_t id;
+
+        pthread_mutex_lock(&wal_lock);
+        rotation = find_rotation(account_id, 1);
+        id = rotation ? rotation->account_id : ADDRESS_ID_NONE;
+        pthread_mutex_unlock(&wal_lock);
+        return id;
+}
+
+/**
+ * wal_rotated_to - Find the account that replaced a rotated one
+ * @account_id: Account ID
+ * Return: Account that @account_id was rotated to, or ADDRESS_ID_NONE
+ */
+uint32_t wal_rotated_to(uint32_t account_id)
+{
+        const WalRotate *rotation;
+        uint32_t id;
+
+        pthread_mutex_lock(&wal_lock);
+        rotation = find_rotation(account_id, 0);
+        id = rotation ? rotation->successor_id : ADDRESS_ID_NONE;
+        pthread_mutex_unlock(&wal_lock);
+        return id;
+}
+
+/**
+ * wal_append_transaction - Log a transaction and add it to the pool
+ * @transaction: Transaction to log; only TX_SIGNED_ED25519 records are
+ *               accepted, digests being reserved for migrated ones
+ * Return: 1 once logged with the configured durability, 0 on failure
+ */
+int wal_append_transaction(const Transaction *transaction)
+{
+        WalFrame frame;
+
+        if (!transaction || !lt_valid(transaction->amount) ||
+            transaction->signature_type != TX_SIGNED_ED25519)
+                return 0;
+
+        init_frame(&frame, WAL_RECORD_TX);
+        frame.body.tx = *transaction;
+        return append_frame(&frame);
+}
+
+/**
+ * wal_append_block - Log that a block consumed the oldest pending transactions
+ * @block_index: Index of the mined block
+ * @transaction_count: Number of pending transactions included in the block
+ * @validator_id: Rewarded validator's account ID, or ADDRESS_ID_NONE
+ * @reward: Validator reward in micro-LT
+ * Return: 1 on success, 0 on failure
+ */
+int wal_append_block(unsigned int block_index, int transaction_count,
+                     uint32_t validator_id, int64_t reward)
+{
+        WalFrame frame;
+
+        init_frame(&frame, WAL_RECORD_BLOCK);
+        frame.body.block.block_index = block_index;
+        frame.body.block.transaction_count = transaction_count;
+        frame.body.block.validator_id = validator_id;
+        if (validator_id != ADDRESS_ID_NONE)
+                frame.body.block.reward = reward;
+        return append_frame(&frame);
+}
+
+/**
+ * wal_pending_count - Number of logged transactions not yet in a block
+ * Return: Pool size
+ */
+int wal_pending_count(void)
+{
+        int count;
+
+        pthread_mutex_lock(&wal_lock);
+        count = pending_count;
+        pthread_mutex_unlock(&wal_lock);
+        return count;
+}
+
+/**
+ * wal_copy_pending - Copy the oldest pending transactions
+ * @out: Destination array
+ * @max: Capacity of @out
+ * Return: Number of transactions copied
+ */
+int wal_copy_pending(Transaction *out, int max)
+{
+        int count;
+
+        pthread_mutex_lock(&wal_lock);
+        count = pending_count < max ? pending_count : max;
+        memcpy(out, pending, (size_t)count * sizeof(Transaction));
+        pthread_mutex_unlock(&wal_lock);
+        return count;
+}
+
+/**
+ * wal_settlement_day - One account's takings on one day, from the live aggregates
+ * @account_id: Recipient account ID
+ * @day: Days since the epoch, in UTC
+ * @out: Receives the takings by type
+ * Return: 1 on success, 0 if the log is not open
+ */
+int wal_settlement_day(uint32_t account_id, uint32_t day, SettlementDay *out)
+{
+        if (wal_fd < 0)
+        {
+                memset(out, 0, sizeof(SettlementDay));
+                return 0;
+        }
+
+        pthread_mutex_lock(&wal_lock);
+        settlement_day(&settlements, account_id, day, out);
+        pthread_mutex_unlock(&wal_lock);
+        return 1;
+}
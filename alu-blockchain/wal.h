@@ -0,0 +1,142 @@
+/* wal.h */
+#ifndef WAL_H
+#define WAL_H
+
+#include "alu_blockchain.h"
+#include "address_book.h"
+#include "settlement.h"
+#include <stdint.h>
+
+#define WAL_MAGIC 0x4c41574cu /* "LWAL" */
+#define WAL_VERSION 1
+
+/* Frame types */
+#define WAL_RECORD_TX 1
+#define WAL_RECORD_BLOCK 2
+#define WAL_RECORD_ADJUST 3
+#define WAL_RECORD_ADDRESS 4
+#define WAL_RECORD_ROTATE 5
+
+#define WAL_ADDRESS_BYTES 64
+
+/**
+ * struct WalFileHeader - First bytes of TX_FILE
+ * @magic: WAL_MAGIC
+ * @version: WAL_VERSION
+ * @frame_size: sizeof(WalFrame) when the log was created
+ * @legacy_accounts: Account IDs below this were interned by the migration
+ *                   of a pre-WAL data set; their addresses have no key pair
+ * @legacy_lsn: Last sequence number written by that migration, 0 if the log
+ *              was created empty
+ * @legacy_time: Latest timestamp of a migrated transaction
+ *
+ * The legacy fields are the migration cutoff: only transactions migrated
+ * from the old files may carry a TX_SIGNED_DIGEST digest instead of a
+ * signature (see wal_accepts_digest()).
+ */
+typedef struct
+{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t frame_size;
+        uint32_t legacy_accounts;
+        uint64_t legacy_lsn;
+        int64_t legacy_time;
+} WalFileHeader;
+
+/**
+ * struct WalBlockMark - A block was mined from the oldest pending transactions
+ * @block_index: Index of the mined block
+ * @transaction_count: Number of pending transactions the block consumed
+ * @validator_id: Account ID of the rewarded validator, or ADDRESS_ID_NONE
+ * @reserved: Always zero
+ * @reward: Reward credited to the validator, in micro-LT
+ */
+typedef struct
+{
+        uint32_t block_index;
+        int32_t transaction_count;
+        uint32_t validator_id;
+        uint32_t reserved;
+        int64_t reward;
+} WalBlockMark;
+
+/**
+ * struct WalAdjust - Balance correction carried over from a legacy data set
+ * @account_id: Account ID
+ * @reserved: Always zero
+ * @amount: Signed micro-LT amount added to the log-derived balance
+ */
+typedef struct
+{
+        uint32_t account_id;
+        uint32_t reserved;
+        int64_t amount;
+} WalAdjust;
+
+/**
+ * struct WalAddress - Assigns the next account ID to an address
+ * @address: Address, zero-padded (not terminated when 64 characters long)
+ */
+typedef struct
+{
+        char address[WAL_ADDRESS_BYTES];
+} WalAddress;
+
+/**
+ * struct WalRotate - Moves an account to a new address with a key pair
+ * @account_id: Account ID being retired
+ * @successor_id: Account ID assigned to @address, always the next free one
+ * @address: New address, zero-padded like WalAddress
+ *
+ * The successor starts with the retired account's whole balance and the
+ * retired account is left empty. Both keep their IDs and addresses, so the
+ * transactions logged before the rotation still verify.
+ */
+typedef struct
+{
+        uint32_t account_id;
+        uint32_t successor_id;
+        char address[WAL_ADDRESS_BYTES];
+} WalRotate;
+
+/**
+ * struct WalFrame - Fixed-size, checksummed log record
+ * @crc: CRC-32 of every byte after this field
+ * @type: WAL_RECORD_* value
+ * @reserved: Always zero
+ * @lsn: Log sequence number, starting at 1
+ * @body: Record payload selected by @type
+ */
+typedef struct
+{
+        uint32_t crc;
+        uint16_t type;
+        uint16_t reserved;
+        uint64_t lsn;
+        union
+        {
+                Transaction tx;
+                WalBlockMark block;
+                WalAdjust adjust;
+                WalAddress address;
+                WalRotate rotate;
+        } body;
+} WalFrame;
+
+int wal_open(void);
+void wal_close(void);
+int wal_append_transaction(const Transaction *transaction);
+int wal_append_block(unsigned int block_index, int transaction_count,
+                     uint32_t validator_id, int64_t reward);
+uint32_t wal_intern_address(const char *address);
+uint32_t wal_rotate_address(uint32_t account_id, const char *address);
+uint32_t wal_rotated_from(uint32_t account_id);
+uint32_t wal_rotated_to(uint32_t account_id);
+int wal_pending_count(void);
+int wal_copy_pending(Transaction *out, int max);
+int wal_frame_valid(const WalFrame *frame);
+int wal_accepts_digest(const Transaction *transaction);
+int wal_settlement_day(uint32_t account_id, uint32_t day, SettlementDay *out);
+
+#endif /* WAL_H */
@@ -1,5 +1,8 @@
 /* wallet_storage.c */
+#define _XOPEN_SOURCE 700
 #include "alu_blockchain.h"
+#include "legacy.h"
+#include "wal.h"
 
 /**
  * get_user_type_from_email - Determine user type from email domain
@@ -29,6 +32,69 @@ UserType get_user_type_from_email(const char *email)
 //                 strstr(email, VENDOR_DOMAIN));
 // }
 
+/**
+ * migrate_legacy_wallets - Convert wallets.dat to integer micro-LT balances
+ *
+ * The old file has the same record size, so the converted records go to a
+ * new file name; the old file is removed once the new one is in place.
+ *
+ * Return: 1 on success or if there is nothing to migrate, 0 on failure
+ */
+int migrate_legacy_wallets(void)
+{
+        FILE *legacy_file;
+        FILE *file;
+        LegacyStoredWallet legacy;
+        StoredWallet wallet;
+        long migrated = 0;
+        int ok = 1;
+
+        if (access(WALLETS_FILE, F_OK) == 0)
+                return 1;
+
+        legacy_file = fopen(LEGACY_WALLETS_FILE, "rb");
+        if (!legacy_file)
+                return 1;
+
+        file = fopen(WALLETS_FILE ".tmp", "wb");
+        if (!file)
+        {
+                fclose(legacy_file);
+                printf("Error opening wallet file for writing.\n");
+                return 0;
+        }
+
+        while (ok && fread(&legacy, sizeof(LegacyStoredWallet), 1, legacy_file))
+        {
+                memset(&wallet, 0, sizeof(wallet));
+                memcpy(wallet.email, legacy.email, sizeof(wallet.email));
+                memcpy(wallet.private_key, legacy.private_key, sizeof(wallet.private_key));
+                memcpy(wallet.address, legacy.address, sizeof(wallet.address));
+                memcpy(wallet.kitchen_name, legacy.kitchen_name, sizeof(wallet.kitchen_name));
+                memcpy(wallet.name, legacy.name, sizeof(wallet.name));
+                wallet.user_type = legacy.user_type;
+                wallet.balance = LT_TO_MICRO(legacy.balance);
+                ok = fwrite(&wallet, sizeof(StoredWallet), 1, file) == 1;
+                migrated++;
+        }
+
+        fclose(legacy_file);
+        if (fflush(file) != 0 || fsync(fileno(file)) != 0)
+                ok = 0;
+        fclose(file);
+
+        if (!ok || rename(WALLETS_FILE ".tmp", WALLETS_FILE) != 0)
+        {
+                printf("Error: migration of %s failed.\n", LEGACY_WALLETS_FILE);
+                unlink(WALLETS_FILE ".tmp");
+                return 0;
+        }
+
+        unlink(LEGACY_WALLETS_FILE);
+        printf("Migrated %ld wallet(s) to integer balances.\n", migrated);
+        return 1;
+}
+
 /**
  * save_wallet - Save wallet data in binary format
  * @email: Owner's email
@@ -46,7 +112,7 @@ int save_wallet(const char *email, const char *private_key,
         strncpy(wallet.email, email, MAX_EMAIL - 1);
         strncpy(wallet.private_key, private_key, HASH_LENGTH - 1);
         strncpy(wallet.address, address, HASH_LENGTH - 1);
-        wallet.balance = 100.0; // Initial balance
+        wallet.balance = INITIAL_WALLET_BALANCE;
         wallet.user_type = get_user_type_from_email(email);
 
         if (kitchen_name && wallet.user_type == VENDOR)
@@ -324,8 +390,6 @@ Wallet *load_wallet_by_email(const char *email)
 Wallet *create_wallet(const char *email, const char *kitchen_name)
 {
         Wallet *wallet;
-        char temp[MAX_EMAIL + 20];
-        time_t now;
         UserType type;
 
         if (!verify_email_domain(email))
@@ -355,14 +419,15 @@ Wallet *create_wallet(const char *email, const char *kitchen_name)
 
         strncpy(wallet->email, email, MAX_EMAIL - 1);
         wallet->user_type = type;
-        wallet->balance = 100.0; // Initial balance
+        wallet->balance = INITIAL_WALLET_BALANCE;
 
-        time(&now);
-        sprintf(temp, "%s%ld", email, now);
-        generate_hash(temp, wallet->address);
-
-        sprintf(temp, "%s%ld%s", email, now, wallet->address);
-        generate_hash(temp, wallet->private_key);
+        /* The address is the public half of a fresh Ed25519 key pair */
+        if (!generate_wallet_keys(wallet->address, wallet->private_key))
+        {
+                printf("Error generating wallet keys\n");
+                free(wallet);
+                return NULL;
+        }
 
         // Save wallet with kitchen name if user type is VENDOR
         if (!save_wallet(email, wallet->private_key, wallet->address,
@@ -376,100 +441,137 @@ Wallet *create_wallet(const char *email, const char *kitchen_name)
 }
 
 /**
- * reload_wallet - Reload wallet from file using public key
- * @current_wallet: Current wallet to reload
- * Return: Updated wallet or NULL if not found
+ * replace_wallet_keys - Give a wallet record a new address and private key
+ * @old_address: Address of the record
+ * @address: New address
+ * @private_key: New private key
+ *
+ * The records are written to a new file that is renamed over the old one,
+ * so a crash leaves either the old keys or the new ones on disk.
+ *
+ * Return: 1 on success, 0 on failure
  */
-Wallet *reload_wallet(Wallet *current_wallet)
+static int replace_wallet_keys(const char *old_address, const char *address,
+                               const char *private_key)
 {
-        if (!current_wallet)
-                return NULL;
+        FILE *old_file;
+        FILE *file;
+        StoredWallet wallet;
+        int replaced = 0;
+        int ok = 1;
 
-        Wallet *temp_wallet = load_wallet_by_public_key(current_wallet->address);
+        old_file = fopen(WALLETS_FILE, "rb");
+        if (!old_file)
+                return 0;
 
-        if (temp_wallet)
+        file = fopen(WALLETS_FILE ".tmp", "wb");
+        if (!file)
         {
-                // Only free current_wallet if it's dynamically allocated
-                if (current_wallet != temp_wallet)
-                        free(current_wallet);
+                fclose(old_file);
+                printf("Error opening wallet file for writing.\n");
+                return 0;
+        }
 
-                return temp_wallet;
+        while (ok && fread(&wallet, sizeof(StoredWallet), 1, old_file))
+        {
+                if (!replaced && strcmp(wallet.address, old_address) == 0)
+                {
+                        memset(wallet.address, 0, sizeof(wallet.address));
+                        memset(wallet.private_key, 0, sizeof(wallet.private_key));
+                        strncpy(wallet.address, address, HASH_LENGTH - 1);
+                        strncpy(wallet.private_key, private_key, HASH_LENGTH - 1);
+                        replaced = 1;
+                }
+                ok = fwrite(&wallet, sizeof(StoredWallet), 1, file) == 1;
         }
 
-        return current_wallet; // Keep the old one if loading fails
+        fclose(old_file);
+        if (fflush(file) != 0 || fsync(fileno(file)) != 0)
+                ok = 0;
+        fclose(file);
+
+        if (!ok || !replaced || rename(WALLETS_FILE ".tmp", WALLETS_FILE) != 0)
+        {
+                unlink(WALLETS_FILE ".tmp");
+                return 0;
+        }
+        return 1;
 }
 
 /**
- * add_kitchen - Add a new kitchen vendor to the list
- * @vendor_id: Unique vendor ID
- * @kitchen_name: Name of the kitchen
- * @email: Vendor's email
- * @wallet_address: Wallet address for the kitchen
+ * upgrade_wallet_keys - Move a wallet created before key pairs to a key pair
+ * @wallet: Wallet loaded with its hash-derived private key; on success it
+ *          holds the new address and key
+ *
+ * The hash-derived private key proves ownership: it must match the one on
+ * file. The log then records the account's rotation to the address of a
+ * fresh Ed25519 key pair, which takes over the whole balance, before the
+ * wallet record gets the new address and key. The old key stops working,
+ * and payments to the old address are forwarded to the new one.
+ *
+ * Return: 1 on success, 0 on failure
  */
-void add_kitchen(const char *kitchen_name, const char *email, const char *wallet_address)
+int upgrade_wallet_keys(Wallet *wallet)
 {
-        FILE *file = fopen("kitchens.txt", "a"); // Open the file in append mode
-        if (!file)
+        char address[HASH_LENGTH + 1];
+        char private_key[HASH_LENGTH + 1];
+        Wallet *stored;
+        uint32_t id;
+        int owner;
+
+        if (!wallet || wallet_has_signing_key(wallet))
+                return 0;
+
+        stored = load_wallet_by_public_key(wallet->address);
+        owner = stored && strcmp(stored->private_key, wallet->private_key) == 0;
+        free(stored);
+        if (!owner)
         {
-                printf("Failed to open file for appending!\n");
-                return;
+                printf("The private key does not match this wallet.\n");
+                return 0;
         }
 
-        // Write the kitchen information to the file
-        fprintf(file, "%s,%s,%s,%.2f\n", kitchen_name, email, wallet_address, 100.0); // Default balance set to 100.0
+        /* A wallet that never transacted gets its account, at the initial balance */
+        id = wal_intern_address(wallet->address);
+        if (id == ADDRESS_ID_NONE || !generate_wallet_keys(address, private_key) ||
+            wal_rotate_address(id, address) == ADDRESS_ID_NONE)
+        {
+                printf("Error upgrading wallet keys.\n");
+                return 0;
+        }
 
-        fclose(file);
-}
+        if (!replace_wallet_keys(wallet->address, address, private_key))
+        {
+                printf("Error: the balance moved to %s, but %s could not be updated.\n",
+                       address, WALLETS_FILE);
+                return 0;
+        }
 
-void trim_newline(char *str)
-{
-        size_t len = strlen(str);
-        if (len > 0 && str[len - 1] == '\n')
-                str[len - 1] = '\0';
+        strcpy(wallet->address, address);
+        strcpy(wallet->private_key, private_key);
+        return 1;
 }
 
 /**
- * get_kitchen_vendor - Get kitchen vendor by index
- * @kitchen_index: Index of the kitchen vendor
- * Return: Pointer to the kitchen vendor or NULL if not found
+ * reload_wallet - Reload wallet from file using public key
+ * @current_wallet: Current wallet to reload
+ * Return: Updated wallet or NULL if not found
  */
-VendorProfile *get_kitchen_vendor(int kitchen_index)
+Wallet *reload_wallet(Wallet *current_wallet)
 {
-        FILE *file = fopen("kitchens.txt", "r");
-        if (!file)
-        {
-                printf("Failed to open kitchens file.\n");
+        if (!current_wallet)
                 return NULL;
-        }
 
-        char line[256];
-        int current_index = 0;
-        while (fgets(line, sizeof(line), file))
-        {
-                if (current_index == kitchen_index)
-                {
-                        VendorProfile *kitchen = malloc(sizeof(VendorProfile));
-                        if (!kitchen)
-                        {
-                                printf("Memory allocation failed.\n");
-                                fclose(file);
-                                return NULL;
-                        }
-
-                        // Debugging: Print the line being read
-                        printf("Raw line from file: %s\n", line);
+        Wallet *temp_wallet = load_wallet_by_public_key(current_wallet->address);
 
-                        sscanf(line, "%99[^,],%99[^,],%255[^,],%lf",
-                               kitchen->kitchen_name, kitchen->email,
-                               kitchen->wallet_address, &kitchen->balance);
-                        trim_newline(kitchen->wallet_address); // Remove newline if present
+        if (temp_wallet)
+        {
+                // Only free current_wallet if it's dynamically allocated
+                if (current_wallet != temp_wallet)
+                        free(current_wallet);
 
-                        fclose(file);
-                        return kitchen;
-                }
-                current_index++;
+                return temp_wallet;
         }
 
-        fclose(file);
-        return NULL;
+        return current_wallet; // Keep the old one if loading fails
 }
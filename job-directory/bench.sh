@@ -0,0 +1,5 @@
+gcc -O2 -I. bench/bench_job_hash.c blockchain_job.c job_index.c job_store.c job_verify.c job_import.c job_match.c -o bench_job_hash -lssl -lcrypto -pthread
+gcc -O2 -I. bench/bench_job_match.c job_match.c -o bench_job_match
+./bench_job_hash "$@"
+echo
+./bench_job_match "$@"
\ No newline at end of file
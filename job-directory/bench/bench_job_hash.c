@@ -0,0 +1,183 @@
+#define _XOPEN_SOURCE 700
+#include "blockchain_job.h"
+
+/*
+ * Measures job hashing throughput on a synthetic bulk import: the old
+ * formatted preimage with a new digest context per call, the
+ * length-prefixed field digest with one reused context, whole
+ * add_job_listing() calls into an in-memory chain, and import_jobs() of
+ * the same listings from a CSV feed, which digests them across threads.
+ *
+ * Usage: bench_job_hash [listings]
+ */
+
+#define BENCH_DEFAULT_LISTINGS 200000
+
+/**
+ * now_seconds - Monotonic clock reading
+ * Return: Seconds
+ */
+static double now_seconds(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/**
+ * hash_formatted - Hash of a listing as it was computed before streaming
+ * @job: Job listing to hash; not modified
+ * @output: Buffer of HASH_LENGTH + 1 bytes for the hex hash
+ *
+ * The fields were formatted back to back, so "ab" + "c" and "a" + "bc"
+ * gave the same preimage.
+ */
+static void hash_formatted(const JobListing *job, char *output)
+{
+        char buffer[MAX_TITLE_LENGTH + MAX_COMPANY_LENGTH +
+                    MAX_LOCATION_LENGTH + MAX_DESCRIPTION_LENGTH +
+                    HASH_LENGTH + 100];
+
+        sprintf(buffer, "%d%.*s%.*s%.*s%.*s%ld%.*s", job->id,
+                MAX_TITLE_LENGTH - 1, job->title,
+                MAX_COMPANY_LENGTH - 1, job->company,
+                MAX_LOCATION_LENGTH - 1, job->location,
+                MAX_DESCRIPTION_LENGTH - 1, job->description,
+                (long)job->timestamp, HASH_LENGTH, job->prevHash);
+
+        generate_hash(buffer, output);
+}
+
+/**
+ * fill_listings - Generate listings with realistic field lengths
+ * @jobs: Listings to fill
+ * @count: Number of listings
+ */
+static void fill_listings(JobListing *jobs, long count)
+{
+        static const char *const titles[] = {"Backend Developer", "Data Engineer",
+                                             "DevOps Specialist", "Product Designer"};
+        static const char *const companies[] = {"TechFlow Inc", "DataMinds Corp",
+                                                "CloudNet Solutions"};
+        long i;
+
+        memset(jobs, 0, count * sizeof(JobListing));
+        for (i = 0; i < count; i++)
+        {
+                jobs[i].id = (int32_t)(i + 1);
+                jobs[i].timestamp = 1700000000 + i;
+                sprintf(jobs[i].title, "%s %ld", titles[i % 4], i % 97);
+                strcpy(jobs[i].company, companies[i % 3]);
+                sprintf(jobs[i].location, "Office %ld", i % 50);
+                sprintf(jobs[i].description,
+                        "Listing %ld. Experience with Python, SQL, Docker and AWS is "
+                        "expected; the role covers design, delivery and operations of "
+                        "services used by millions of customers every day.", i);
+        }
+}
+
+/**
+ * report - Print one method's throughput
+ * @name: Method
+ * @count: Listings processed
+ * @elapsed: Seconds taken
+ * @baseline: Seconds the first method took, for the speedup
+ */
+static void report(const char *name, long count, double elapsed, double baseline)
+{
+        printf("%-24s %12.0f %12.3f %10.2f\n", name, count / elapsed, elapsed * 1e6 / count,
+               baseline / elapsed);
+}
+
+/**
+ * main - Run the benchmark
+ * @argc: Argument count
+ * @argv: Optional number of listings
+ * Return: 0 on success, 1 on failure
+ */
+int main(int argc, char **argv)
+{
+        long count = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_LISTINGS;
+        JobBlockchain *chain;
+        JobListing *jobs;
+        JobHasher hasher;
+        ImportStats stats;
+        double start, legacy;
+        FILE *feed;
+        long i;
+
+        if (count < 1)
+        {
+                printf("Usage: %s [listings]\n", argv[0]);
+                return (1);
+        }
+
+        jobs = malloc(count * sizeof(JobListing));
+        chain = initialize_blockchain();
+        if (jobs == NULL || chain == NULL || !job_hasher_init(&hasher))
+        {
+                printf("Error: out of memory\n");
+                return (1);
+        }
+        fill_listings(jobs, count);
+        printf("Hashing %ld listings\n\n%-24s %12s %12s %10s\n", count, "method", "listings/s",
+               "us/listing", "speedup");
+
+        start = now_seconds();
+        for (i = 0; i < count; i++)
+        {
+                strcpy(jobs[i].prevHash, i ? jobs[i - 1].currentHash : GENESIS_PREV_HASH);
+                hash_formatted(&jobs[i], jobs[i].currentHash);
+        }
+        legacy = now_seconds() - start;
+        report("sprintf + new context", count, legacy, legacy);
+
+        start = now_seconds();
+        for (i = 0; i < count; i++)
+        {
+                strcpy(jobs[i].prevHash, i ? jobs[i - 1].currentHash : GENESIS_PREV_HASH);
+                job_hash_with(&hasher, &jobs[i], jobs[i].currentHash);
+        }
+        report("field stream, reused", count, now_seconds() - start, legacy);
+
+        start = now_seconds();
+        for (i = 0; i < count; i++)
+        {
+                if (!add_job_listing(chain, jobs[i].title, jobs[i].company, jobs[i].location,
+                                     jobs[i].description))
+                {
+                        printf("Error: add_job_listing failed at %ld\n", i);
+                        return (1);
+                }
+        }
+        report("add_job_listing", count, now_seconds() - start, legacy);
+
+        free_blockchain(chain);
+        chain = initialize_blockchain();
+        feed = tmpfile();
+        if (chain == NULL || feed == NULL)
+        {
+                printf("Error: cannot set up the import\n");
+                return (1);
+        }
+        for (i = 0; i < count; i++)
+                fprintf(feed, "\"%s\",\"%s\",\"%s\",\"%s\",%lld\n", jobs[i].title, jobs[i].company,
+                        jobs[i].location, jobs[i].description, (long long)jobs[i].timestamp);
+        rewind(feed);
+        if (!import_jobs(chain, feed, IMPORT_CSV, &stats) || stats.imported != count)
+        {
+                printf("Error: import_jobs failed\n");
+                return (1);
+        }
+        report("import_jobs (CSV)", count, stats.total_seconds, legacy);
+        printf("\nimport per listing: parse %.2f us, digest %.2f us, link, store and index %.2f us\n",
+               stats.parse_seconds * 1e6 / count, stats.digest_seconds * 1e6 / count,
+               stats.link_seconds * 1e6 / count);
+
+        fclose(feed);
+        job_hasher_free(&hasher);
+        free_blockchain(chain);
+        free(jobs);
+        return (0);
+}
@@ -0,0 +1,155 @@
+#define _XOPEN_SOURCE 700
+#include "blockchain_job.h"
+
+/*
+ * Measures substring search over the text fields of a generated job
+ * corpus: libc strstr(), which is case-sensitive, against each kernel of
+ * job_match(), which is not. Each method scans every title, company and
+ * description for every needle and counts the listings that match.
+ *
+ * Usage: bench_job_match [listings]
+ */
+
+#define BENCH_DEFAULT_LISTINGS 100000
+
+/**
+ * now_seconds - Monotonic clock reading
+ * Return: Seconds
+ */
+static double now_seconds(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/**
+ * fill_listings - Generate listings with realistic field lengths and case
+ * @jobs: Listings to fill
+ * @count: Number of listings
+ */
+static void fill_listings(JobListing *jobs, long count)
+{
+        static const char *const titles[] = {"Senior Software Engineer", "Data Engineer",
+                                             "DevOps Specialist", "Product Designer",
+                                             "Machine Learning ENGINEER"};
+        static const char *const companies[] = {"TechFlow Inc", "DataMinds Corp",
+                                                "CloudNet Solutions", "Kigali Analytics"};
+        static const char *const skills[] = {"Python", "SQL", "Docker", "Kubernetes", "AWS",
+                                             "Node.js", "PostgreSQL", "Terraform", "React"};
+        long i;
+
+        memset(jobs, 0, count * sizeof(JobListing));
+        for (i = 0; i < count; i++)
+        {
+                jobs[i].id = (int32_t)(i + 1);
+                strcpy(jobs[i].title, titles[i % 5]);
+                strcpy(jobs[i].company, companies[i % 4]);
+                sprintf(jobs[i].description,
+                        "Listing %ld. We are hiring to grow our platform team. Experience with "
+                        "%s, %s and %s is expected; the role covers design, delivery and "
+                        "operations of services used by millions of customers every day. "
+                        "Remote friendly, with a quarterly offsite.",
+                        i, skills[i % 9], skills[(i / 9) % 9], skills[(i / 81) % 9]);
+        }
+}
+
+/**
+ * count_strstr - Count listings whose text contains a needle, with case
+ * @jobs: Listings
+ * @count: Number of listings
+ * @needle: Text to find
+ * Return: Number of listings containing it
+ */
+static long count_strstr(const JobListing *jobs, long count, const char *needle)
+{
+        long i, found = 0;
+
+        for (i = 0; i < count; i++)
+                found += strstr(jobs[i].title, needle) || strstr(jobs[i].company, needle) ||
+                         strstr(jobs[i].description, needle);
+        return (found);
+}
+
+/**
+ * count_match - Count listings whose text contains a needle, in any case
+ * @jobs: Listings
+ * @count: Number of listings
+ * @matcher: Matcher for the needle
+ * Return: Number of listings containing it
+ */
+static long count_match(const JobListing *jobs, long count, const JobMatcher *matcher)
+{
+        long i, found = 0;
+
+        for (i = 0; i < count; i++)
+                found += job_match(matcher, jobs[i].title, sizeof(jobs[i].title)) ||
+                         job_match(matcher, jobs[i].company, sizeof(jobs[i].company)) ||
+                         job_match(matcher, jobs[i].description, sizeof(jobs[i].description));
+        return (found);
+}
+
+/**
+ * main - Run the benchmark
+ * @argc: Argument count
+ * @argv: Optional number of listings
+ * Return: 0 on success, 1 on failure
+ */
+int main(int argc, char **argv)
+{
+        static const char *const needles[] = {"engineer", "kubernetes", "node.js", "offsite",
+                                              "golang"};
+        static const char *const kernels[] = {"job_match scalar", "job_match SSE2",
+                                              "job_match AVX2"};
+        long count = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_LISTINGS;
+        long i, found, bytes = 0;
+        int method, best = (int)job_match_best_kernel();
+        JobMatcher matcher;
+        JobListing *jobs;
+        double start, elapsed, baseline = 0;
+        size_t n;
+
+        if (count < 1)
+        {
+                printf("Usage: %s [listings]\n", argv[0]);
+                return (1);
+        }
+
+        jobs = malloc(count * sizeof(JobListing));
+        if (jobs == NULL)
+        {
+                printf("Error: out of memory\n");
+                return (1);
+        }
+        fill_listings(jobs, count);
+        for (i = 0; i < count; i++)
+                bytes += (long)(strlen(jobs[i].title) + strlen(jobs[i].company) +
+                                strlen(jobs[i].description));
+        printf("Searching %ld listings, %.1f MB of text, for %d needles\n\n%-18s %12s %10s %10s\n",
+               count, bytes / 1e6, (int)(sizeof(needles) / sizeof(needles[0])), "method", "matches",
+               "MB/s", "speedup");
+
+        /* Method -1 is strstr(), then each kernel the CPU can run */
+        for (method = -1; method <= best; method++)
+        {
+                found = 0;
+                start = now_seconds();
+                for (n = 0; n < sizeof(needles) / sizeof(needles[0]); n++)
+                {
+                        job_matcher_init(&matcher, needles[n]);
+                        matcher.kernel = (JobMatchKernel)(method < 0 ? 0 : method);
+                        found += method < 0 ? count_strstr(jobs, count, needles[n])
+                                     : count_match(jobs, count, &matcher);
+                }
+                elapsed = now_seconds() - start;
+                if (!baseline)
+                        baseline = elapsed;
+                printf("%-18s %12ld %10.0f %10.2f\n",
+                       method < 0 ? "strstr" : kernels[method], found,
+                       bytes * (double)n / elapsed / 1e6, baseline / elapsed);
+        }
+
+        free(jobs);
+        return (0);
+}
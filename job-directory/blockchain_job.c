@@ -1,66 +1,4 @@
-#ifndef BLOCKCHAIN_JOB_H
-#define BLOCKCHAIN_JOB_H
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-#include <openssl/evp.h>
-
-/* Maximum lengths for job listing fields */
-#define MAX_TITLE_LENGTH 100
-#define MAX_COMPANY_LENGTH 100
-#define MAX_LOCATION_LENGTH 100
-#define MAX_DESCRIPTION_LENGTH 500
-#define HASH_LENGTH 64
-
-/**
- * struct JobListing - Structure for storing job information
- * @id: Unique identifier for the job
- * @title: Job title
- * @company: Company name
- * @location: Job location
- * @description: Job description
- * @timestamp: Time when job was posted
- * @prevHash: Hash of previous block
- * @currentHash: Hash of current block
- * @next: Pointer to next job listing
- */
-typedef struct JobListing
-{
-        int id;
-        char title[MAX_TITLE_LENGTH];
-        char company[MAX_COMPANY_LENGTH];
-        char location[MAX_LOCATION_LENGTH];
-        char description[MAX_DESCRIPTION_LENGTH];
-        time_t timestamp;
-        char prevHash[HASH_LENGTH + 1];
-        char currentHash[HASH_LENGTH + 1];
-        struct JobListing *next;
-} JobListing;
-
-/**
- * struct JobBlockchain - Structure for managing the blockchain
- * @head: Pointer to first job listing
- * @count: Number of job listings
- */
-typedef struct JobBlockchain
-{
-        JobListing *head;
-        int count;
-} JobBlockchain;
-
-/* Function prototypes */
-JobBlockchain *initialize_blockchain(void);
-void calculate_hash(JobListing *job);
-int add_job_listing(JobBlockchain *chain, const char *title,
-                    const char *company, const char *location, const char *description);
-JobListing *search_jobs(JobBlockchain *chain, const char *keyword);
-int verify_integrity(JobBlockchain *chain);
-void free_blockchain(JobBlockchain *chain);
-void print_job(JobListing *job);
-
-#endif
+#include "blockchain_job.h"
 
 /**
  * generate_hash - Generate SHA-256 hash from input string
@@ -100,26 +38,269 @@ JobBlockchain *initialize_blockchain(void)
         if (chain == NULL)
                 return (NULL);
 
-        chain->head = NULL;
+        if (!job_hasher_init(&chain->hasher))
+        {
+                free(chain);
+                return (NULL);
+        }
+
         chain->count = 0;
+        chain->chunks = NULL;
+        chain->chunk_count = 0;
+        chain->chunk_capacity = 0;
+        job_index_init(&chain->index);
+        job_index_init(&chain->companies);
+        job_index_init(&chain->locations);
+        memset(&chain->times, 0, sizeof(JobTimeIndex));
+        chain->indexed = 0;
+        chain->time_ordered = 1;
+        chain->fd = -1;
+        chain->store = NULL;
         return (chain);
 }
 
+/**
+ * open_blockchain - Open a blockchain kept in a job store file
+ * @path: Store file; created empty if missing
+ *
+ * Listings are mapped from the file rather than read, and new ones are
+ * written to it as they are added.
+ *
+ * Return: Pointer to the blockchain or NULL on failure
+ */
+JobBlockchain *open_blockchain(const char *path)
+{
+        JobBlockchain *chain = initialize_blockchain();
+
+        if (chain == NULL)
+                return (NULL);
+
+        if (!job_store_open(chain, path))
+        {
+                free_blockchain(chain);
+                return (NULL);
+        }
+        return (chain);
+}
+
+/*
+ * A listing's hash is computed in two steps. The content digest is
+ * SHA-256 over the ID and timestamp as little-endian integers and then
+ * each text field as a 4-byte little-endian length and its bytes, so no
+ * two different listings share a preimage. The listing hash is SHA-256
+ * over the content digest and the previous listing's hash. Only that
+ * second, fixed-size step depends on the chain order.
+ */
+
+/**
+ * put_le - Encode an integer in little-endian byte order
+ * @out: Buffer of @size bytes
+ * @value: Value
+ * @size: Number of bytes to write
+ */
+static void put_le(unsigned char *out, uint64_t value, size_t size)
+{
+        size_t i;
+
+        for (i = 0; i < size; i++)
+                out[i] = (unsigned char)(value >> (8 * i));
+}
+
+/**
+ * digest_field - Feed one length-prefixed text field to a digest
+ * @ctx: Digest in progress
+ * @text: Field, read up to its NUL or its last byte before the end
+ * @size: Size of the field array
+ */
+static void digest_field(EVP_MD_CTX *ctx, const char *text, size_t size)
+{
+        const char *end = memchr(text, '\0', size - 1);
+        size_t length = end ? (size_t)(end - text) : size - 1;
+        unsigned char prefix[4];
+
+        put_le(prefix, length, sizeof(prefix));
+        EVP_DigestUpdate(ctx, prefix, sizeof(prefix));
+        EVP_DigestUpdate(ctx, text, length);
+}
+
+/**
+ * job_hasher_init - Create a reusable hashing context
+ * @hasher: Hasher to initialise
+ * Return: 1 on success, 0 on allocation failure
+ */
+int job_hasher_init(JobHasher *hasher)
+{
+        hasher->ctx = EVP_MD_CTX_new();
+        return (hasher->ctx != NULL);
+}
+
+/**
+ * job_hasher_free - Release a hashing context
+ * @hasher: Hasher to free
+ */
+void job_hasher_free(JobHasher *hasher)
+{
+        EVP_MD_CTX_free(hasher->ctx);
+        hasher->ctx = NULL;
+}
+
+/**
+ * job_content_digest - Digest of everything in a listing but its hashes
+ * @hasher: Hashing context
+ * @job: Job listing; not modified
+ * @digest: Receives JOB_DIGEST_SIZE bytes
+ */
+void job_content_digest(JobHasher *hasher, const JobListing *job, unsigned char *digest)
+{
+        unsigned char numbers[12];
+
+        put_le(numbers, (uint32_t)job->id, 4);
+        put_le(numbers + 4, (uint64_t)job->timestamp, 8);
+
+        EVP_DigestInit_ex(hasher->ctx, EVP_sha256(), NULL);
+        EVP_DigestUpdate(hasher->ctx, numbers, sizeof(numbers));
+        digest_field(hasher->ctx, job->title, MAX_TITLE_LENGTH);
+        digest_field(hasher->ctx, job->company, MAX_COMPANY_LENGTH);
+        digest_field(hasher->ctx, job->location, MAX_LOCATION_LENGTH);
+        digest_field(hasher->ctx, job->description, MAX_DESCRIPTION_LENGTH);
+        EVP_DigestFinal_ex(hasher->ctx, digest, NULL);
+}
+
+/**
+ * job_link_hash - Chain a content digest to the previous listing's hash
+ * @hasher: Hashing context
+ * @digest: Content digest of JOB_DIGEST_SIZE bytes
+ * @prev_hash: Previous listing's hash, HASH_LENGTH hex digits
+ * @output: Buffer of HASH_LENGTH + 1 bytes for the hex hash
+ */
+void job_link_hash(JobHasher *hasher, const unsigned char *digest, const char *prev_hash,
+                   char *output)
+{
+        static const char hex[] = "0123456789abcdef";
+        unsigned char hash[JOB_DIGEST_SIZE];
+        int i;
+
+        EVP_DigestInit_ex(hasher->ctx, EVP_sha256(), NULL);
+        EVP_DigestUpdate(hasher->ctx, digest, JOB_DIGEST_SIZE);
+        EVP_DigestUpdate(hasher->ctx, prev_hash, HASH_LENGTH);
+        EVP_DigestFinal_ex(hasher->ctx, hash, NULL);
+
+        for (i = 0; i < JOB_DIGEST_SIZE; i++)
+        {
+                output[2 * i] = hex[hash[i] >> 4];
+                output[2 * i + 1] = hex[hash[i] & 15];
+        }
+        output[HASH_LENGTH] = '\0';
+}
+
+/**
+ * job_hash_with - Compute the hash a job listing should have
+ * @hasher: Hashing context
+ * @job: Job listing to hash; not modified
+ * @output: Buffer of HASH_LENGTH + 1 bytes for the hex hash
+ */
+void job_hash_with(JobHasher *hasher, const JobListing *job, char *output)
+{
+        unsigned char digest[JOB_DIGEST_SIZE];
+
+        job_content_digest(hasher, job, digest);
+        job_link_hash(hasher, digest, job->prevHash, output);
+}
+
+/**
+ * job_hash - Compute the hash a job listing should have
+ * @job: Job listing to hash; not modified
+ * @output: Buffer of HASH_LENGTH + 1 bytes for the hex hash; empty if
+ *          no hashing context could be allocated
+ */
+void job_hash(const JobListing *job, char *output)
+{
+        JobHasher hasher;
+
+        output[0] = '\0';
+        if (!job_hasher_init(&hasher))
+                return;
+        job_hash_with(&hasher, job, output);
+        job_hasher_free(&hasher);
+}
+
 /**
  * calculate_hash - Calculate hash for job listing
  * @job: Job listing to hash
  */
 void calculate_hash(JobListing *job)
 {
-        char buffer[MAX_TITLE_LENGTH + MAX_COMPANY_LENGTH +
-                    MAX_LOCATION_LENGTH + MAX_DESCRIPTION_LENGTH +
-                    HASH_LENGTH + 100];
+        job_hash(job, job->currentHash);
+}
+
+/**
+ * next_slot - Storage for the next job listing
+ * @chain: Blockchain
+ * Return: Zeroed slot for ID @chain->count + 1, or NULL on allocation failure
+ */
+static JobListing *next_slot(JobBlockchain *chain)
+{
+        JobListing **chunks;
+        int capacity;
+
+        if (chain->count == chain->chunk_count * JOB_CHUNK_SIZE)
+        {
+                if (chain->chunk_count == chain->chunk_capacity)
+                {
+                        capacity = chain->chunk_capacity ? chain->chunk_capacity * 2 : 8;
+                        chunks = realloc(chain->chunks, capacity * sizeof(JobListing *));
+                        if (chunks == NULL)
+                                return (NULL);
+                        chain->chunks = chunks;
+                        chain->chunk_capacity = capacity;
+                }
+
+                if (chain->fd >= 0)
+                        chain->chunks[chain->chunk_count] = job_store_grow(chain);
+                else
+                        chain->chunks[chain->chunk_count] = malloc(JOB_CHUNK_SIZE * sizeof(JobListing));
+                if (chain->chunks[chain->chunk_count] == NULL)
+                        return (NULL);
+                chain->chunk_count++;
+        }
 
-        sprintf(buffer, "%d%s%s%s%s%ld%s", job->id, job->title,
-                job->company, job->location, job->description,
-                job->timestamp, job->prevHash);
+        return (memset(&chain->chunks[chain->count / JOB_CHUNK_SIZE][chain->count % JOB_CHUNK_SIZE],
+                       0, sizeof(JobListing)));
+}
 
-        generate_hash(buffer, job->currentHash);
+/**
+ * index_jobs - Add every listing not yet indexed to the search indexes
+ * @chain: Blockchain
+ *
+ * A store is opened without reading its listings, so they are indexed
+ * here, by the first search, rather than at startup.
+ *
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int index_jobs(JobBlockchain *chain)
+{
+        JobListing *job;
+
+        while (chain->indexed < chain->count)
+        {
+                job = get_job(chain, chain->indexed + 1);
+                if (!job_index_add(&chain->index, job->id, job->title) ||
+                    !job_index_add(&chain->index, job->id, job->company) ||
+                    !job_index_add(&chain->index, job->id, job->description) ||
+                    !job_index_add_value(&chain->companies, job->id, job->company) ||
+                    !job_index_add_value(&chain->locations, job->id, job->location) ||
+                    !job_time_index_add(&chain->times, job->timestamp))
+                {
+                        job_index_drop(&chain->index, job->id);
+                        job_index_drop(&chain->companies, job->id);
+                        job_index_drop(&chain->locations, job->id);
+                        return (0);
+                }
+                if (job->id > 1 && job->timestamp < get_job(chain, job->id - 1)->timestamp)
+                        chain->time_ordered = 0;
+                chain->indexed++;
+        }
+        return (1);
 }
 
 /**
@@ -135,8 +316,7 @@ int add_job_listing(JobBlockchain *chain, const char *title,
                     const char *company, const char *location,
                     const char *description)
 {
-        JobListing *new_job = malloc(sizeof(JobListing));
-        JobListing *last = chain->head;
+        JobListing *new_job = next_slot(chain);
 
         if (new_job == NULL)
                 return (0);
@@ -147,354 +327,390 @@ int add_job_listing(JobBlockchain *chain, const char *title,
         strncpy(new_job->location, location, MAX_LOCATION_LENGTH - 1);
         strncpy(new_job->description, description, MAX_DESCRIPTION_LENGTH - 1);
         new_job->timestamp = time(NULL);
-        new_job->next = NULL;
 
-        if (chain->head == NULL)
+        if (chain->count == 0)
         {
                 /* First block */
-                strcpy(new_job->prevHash, "0000000000000000000000000000000000000000000000000000000000000000");
-                calculate_hash(new_job);
-                chain->head = new_job;
+                strcpy(new_job->prevHash, GENESIS_PREV_HASH);
         }
         else
         {
-                /* Find the last block in the chain */
-                while (last->next != NULL)
-                        last = last->next;
-
                 /* Set new block's prevHash to last block's currentHash */
-                strcpy(new_job->prevHash, last->currentHash);
-                calculate_hash(new_job);
-
-                /* Append to the end of the chain */
-                last->next = new_job;
+                strcpy(new_job->prevHash, get_job(chain, chain->count)->currentHash);
         }
+        job_hash_with(&chain->hasher, new_job, new_job->currentHash);
 
         chain->count++;
+        if (!job_store_commit(chain, new_job))
+        {
+                chain->count--;
+                return (0);
+        }
+
+        /* Keep an up-to-date index current; a failure is retried by the next search */
+        if (chain->indexed == chain->count - 1)
+                index_jobs(chain);
         return (1);
 }
 
 /**
- * search_jobs - Search for jobs by keyword
- * @chain: Blockchain to search
- * @keyword: Search keyword
- * Return: List of matching jobs or NULL if none found
+ * add_job_batch - Append listings whose content digests are already known
+ * @chain: Blockchain
+ * @jobs: Listings with every field, timestamp and ID set; the IDs follow
+ *        on from @chain->count
+ * @digests: job_content_digest() of each listing, JOB_DIGEST_SIZE bytes
+ *           apiece
+ * @count: Number of listings
+ *
+ * Only each listing's link to the hash before it is computed here, in
+ * order, and the store is flushed once for the whole batch.
+ *
+ * Return: 1 on success, 0 on failure (none of the listings are added)
  */
-JobListing *search_jobs(JobBlockchain *chain, const char *keyword)
+int add_job_batch(JobBlockchain *chain, const JobListing *jobs, const unsigned char *digests,
+                  int count)
 {
-        JobListing *results = NULL, *current = chain->head;
-        JobListing *last_result = NULL, *match;
+        JobListing *job;
+        int first = chain->count + 1, i;
 
-        while (current != NULL)
+        for (i = 0; i < count; i++)
         {
-                if (strstr(current->title, keyword) ||
-                    strstr(current->company, keyword) ||
-                    strstr(current->description, keyword))
+                job = next_slot(chain);
+                if (job == NULL)
                 {
-                        match = malloc(sizeof(JobListing));
-                        if (match == NULL)
-                        {
-                                current = current->next;
-                                continue;
-                        }
-                        memcpy(match, current, sizeof(JobListing));
-                        match->next = NULL;
-
-                        if (results == NULL)
-                        {
-                                results = match;
-                                last_result = match;
-                        }
-                        else
-                        {
-                                last_result->next = match;
-                                last_result = match;
-                        }
+                        chain->count = first - 1;
+                        return (0);
                 }
-                current = current->next;
+
+                memcpy(job, &jobs[i], sizeof(JobListing));
+                strcpy(job->prevHash, chain->count ? get_job(chain, chain->count)->currentHash
+                                                   : GENESIS_PREV_HASH);
+                job_link_hash(&chain->hasher, digests + (size_t)i * JOB_DIGEST_SIZE, job->prevHash,
+                              job->currentHash);
+                chain->count++;
         }
-        return (results);
+
+        if (!job_store_commit_range(chain, first, chain->count + 1))
+        {
+                chain->count = first - 1;
+                return (0);
+        }
+        if (chain->indexed == first - 1)
+                index_jobs(chain);
+        return (1);
 }
 
 /**
- * verify_integrity - Check blockchain integrity
- * @chain: Blockchain to verify
- * Return: 1 if intact, 0 if compromised
+ * get_job - Find a job listing by ID
+ * @chain: Blockchain to look in
+ * @id: Job ID
+ * Return: The listing, or NULL if there is none with that ID
  */
+JobListing *get_job(JobBlockchain *chain, int id)
+{
+        if (id < 1 || id > chain->count)
+                return (NULL);
+        id--;
+        return (&chain->chunks[id / JOB_CHUNK_SIZE][id % JOB_CHUNK_SIZE]);
+}
+
 /**
- * verify_integrity - Check blockchain integrity and write results to file
- * @chain: Blockchain to verify
- * Return: 1 if intact, 0 if compromised
+ * sorts_before - Whether one listing comes before another by posting time
+ * @a: Listing
+ * @b: Listing
+ * @newest: Nonzero for newest first, 0 for oldest first
+ * Return: 1 if @a comes first, 0 otherwise; ties are broken by ID
  */
-int verify_integrity(JobBlockchain *chain)
+static int sorts_before(const JobListing *a, const JobListing *b, int newest)
 {
-        JobListing *current;
-        char temp_hash[HASH_LENGTH + 1];
-        FILE *output_file;
-        int block_count = 0;
-        int is_valid = 1;
-
-        /* Open output file for writing */
-        output_file = fopen("output.txt", "w");
-        if (output_file == NULL)
-        {
-                perror("Error opening output.txt");
-                return (-1);
-        }
-
-        fprintf(output_file, "=== BLOCKCHAIN INTEGRITY VERIFICATION ===\n\n");
-
-        if (chain->head == NULL)
-        {
-                fprintf(output_file, "Blockchain is empty. Integrity valid.\n");
-                fclose(output_file);
-                return (1);
-        }
-
-        /* First pass: check hash recalculation and collect block info */
-        current = chain->head;
-        while (current != NULL)
-        {
-                block_count++;
-                fprintf(output_file, "Block #%d:\n", block_count);
-                fprintf(output_file, "  Title: %s\n", current->title);
-                fprintf(output_file, "  Current Hash: %s\n", current->currentHash);
-                if (current->next != NULL)
-                {
-                        fprintf(output_file, "  Next Block: %s\n", current->next->title);
-                }
-
-                /* Verify hash hasn't been tampered with */
-                strcpy(temp_hash, current->currentHash);
-                calculate_hash(current);
-                if (strcmp(temp_hash, current->currentHash) != 0)
-                {
-                        fprintf(output_file, "  HASH TAMPERING: Recalculated hash doesn't match stored hash\n");
-                        fprintf(output_file, "  Stored hash: %s\n", temp_hash);
-                        fprintf(output_file, "  Recalculated hash: %s\n", current->currentHash);
-                        is_valid = 0;
-                }
-                else
-                {
-                        /* Restore the original hash */
-                        strcpy(current->currentHash, temp_hash);
-                }
-
-                current = current->next;
-        }
-
-        /* Second pass: check chain integrity - this matches original logic */
-        current = chain->head;
-        while (current->next != NULL)
-        {
-                /* Check if the prevHash of the next block matches this block's currentHash */
-                if (strcmp(current->currentHash, current->next->prevHash) != 0)
-                {
-                        fprintf(output_file, "\nBlock #%d -> Block #%d integrity error:\n",
-                                block_count - (current->next->next ? 2 : 1),
-                                block_count - (current->next->next ? 1 : 0));
-                        fprintf(output_file, "  Current block hash: %s\n", current->currentHash);
-                        fprintf(output_file, "  Next block prevHash: %s\n", current->next->prevHash);
-                        fprintf(output_file, "  HASH MISMATCH: Chain integrity compromised\n");
-                        is_valid = 0;
-                }
-
-                current = current->next;
-        }
+        if (a->timestamp != b->timestamp)
+                return ((a->timestamp < b->timestamp) != newest);
+        return ((a->id < b->id) != newest);
+}
 
-        fprintf(output_file, "\n=== VERIFICATION SUMMARY ===\n");
-        fprintf(output_file, "Total blocks: %d\n", block_count);
-        fprintf(output_file, "Blockchain integrity: %s\n",
-                is_valid ? "INTACT" : "COMPROMISED");
+/**
+ * compare_newest - qsort() comparator for newest first
+ * @a: Pointer to a JobListing pointer
+ * @b: Pointer to a JobListing pointer
+ * Return: Negative if @a comes first, positive otherwise
+ */
+static int compare_newest(const void *a, const void *b)
+{
+        return (sorts_before(*(JobListing *const *)a, *(JobListing *const *)b, 1) ? -1 : 1);
+}
 
-        fclose(output_file);
-        return (is_valid);
+/**
+ * compare_oldest - qsort() comparator for oldest first
+ * @a: Pointer to a JobListing pointer
+ * @b: Pointer to a JobListing pointer
+ * Return: Negative if @a comes first, positive otherwise
+ */
+static int compare_oldest(const void *a, const void *b)
+{
+        return (sorts_before(*(JobListing *const *)a, *(JobListing *const *)b, 0) ? -1 : 1);
 }
 
 /**
- * free_blockchain - Free all blockchain memory
- * @chain: Blockchain to free
+ * sift_down - Restore a heap whose root may have moved up the order
+ * @heap: Heap with the listing that sorts last at the root
+ * @count: Number of listings in the heap
+ * @newest: Order of the search
  */
-void free_blockchain(JobBlockchain *chain)
+static void sift_down(JobListing **heap, size_t count, int newest)
 {
-        JobListing *current = chain->head;
-        JobListing *temp;
+        size_t i = 0, child;
+        JobListing *swap;
 
-        while (current != NULL)
+        while ((child = 2 * i + 1) < count)
         {
-                temp = current;
-                current = current->next;
-                free(temp);
+                if (child + 1 < count && sorts_before(heap[child], heap[child + 1], newest))
+                        child++;
+                if (!sorts_before(heap[i], heap[child], newest))
+                        break;
+                swap = heap[i];
+                heap[i] = heap[child];
+                heap[child] = swap;
+                i = child;
         }
-        free(chain);
 }
 
 /**
- * print_job - Display job listing information
- * @job: Job to display
+ * sift_up - Restore a heap after adding a listing at its end
+ * @heap: Heap with the listing that sorts last at the root
+ * @count: Number of listings in the heap, the new one included
+ * @newest: Order of the search
  */
-void print_job(JobListing *job)
+static void sift_up(JobListing **heap, size_t count, int newest)
 {
-        printf("\nJob ID: %d\n", job->id);
-        printf("Title: %s\n", job->title);
-        printf("Company: %s\n", job->company);
-        printf("Location: %s\n", job->location);
-        printf("Description: %s\n", job->description);
-        printf("Timestamp: %s", ctime(&job->timestamp));
-        printf("Previous Hash: %.16s...\n", job->prevHash);
-        printf("Current Hash: %.16s...\n", job->currentHash);
+        size_t i = count - 1, parent;
+        JobListing *swap;
+
+        while (i > 0 && sorts_before(heap[parent = (i - 1) / 2], heap[i], newest))
+        {
+                swap = heap[i];
+                heap[i] = heap[parent];
+                heap[parent] = swap;
+                i = parent;
+        }
 }
 
 /**
- * clear_input_buffer - Clears input buffer
+ * job_search_init - Start a search for every listing
+ * @search: Search to initialise; the caller then sets the words, filters
+ *          and page it wants
  */
-void clear_input_buffer(void)
+void job_search_init(JobSearch *search)
 {
-        int c;
-        while ((c = getchar()) != '\n' && c != EOF)
-                ;
+        memset(search, 0, sizeof(JobSearch));
+        search->from = INT64_MIN;
+        search->to = INT64_MAX;
 }
 
 /**
- * get_string_input - Gets string input safely
- * @prompt: Prompt to display
- * @buffer: Buffer to store input
- * @size: Size of buffer
+ * compile_search - Turn a search into a planned index query
+ * @chain: Blockchain with every listing indexed
+ * @search: Search
+ * @descending: Nonzero to stream from the highest ID down
+ * @query: Query to build; release with job_query_free()
+ * @matcher: Receives the matcher for @search->contains
+ *
+ * Each filter is one clause of the query: the posting lists of the
+ * company and location values, the ID range the time index narrows
+ * the posting times to, and the words the text to contain implies.
+ * Planning runs the most selective clause first, so a rare filter or
+ * word drives the search and nothing is scanned that the indexes rule
+ * out.
+ *
+ * Return: 1 on success, 0 on allocation failure
  */
-void get_string_input(const char *prompt, char *buffer, size_t size)
+static int compile_search(JobBlockchain *chain, const JobSearch *search, int descending,
+                          JobQuery *query, JobMatcher *matcher)
 {
-        printf("%s", prompt);
-        if (fgets(buffer, size, stdin) != NULL)
+        int first = 1, last = chain->count + 1;
+
+        if (search->from != INT64_MIN || search->to != INT64_MAX)
+                job_time_index_range(&chain->times, search->from, search->to, &first, &last);
+
+        job_query_init(query, descending);
+        if ((search->query && !job_query_add_words(&chain->index, query, search->query)) ||
+            (search->contains && !job_query_add_substring(&chain->index, query, search->contains)) ||
+            (search->company && !job_query_add_value(&chain->companies, query, search->company)) ||
+            (search->location && !job_query_add_value(&chain->locations, query, search->location)) ||
+            !job_query_add_range(query, first, last))
         {
-                size_t len = strlen(buffer);
-                if (len > 0 && buffer[len - 1] == '\n')
-                        buffer[len - 1] = '\0';
+                job_query_free(query);
+                return (0);
         }
+        job_query_plan(query);
+        job_matcher_init(matcher, search->contains ? search->contains : "");
+        return (1);
 }
 
 /**
- * display_menu - Displays main menu
+ * next_match - Next listing matching a search
+ * @chain: Blockchain
+ * @search: Search
+ * @query: Query from compile_search()
+ * @matcher: Matcher from compile_search()
+ * Return: The listing, or NULL when there are no more matches
  */
-void display_menu(void)
+static JobListing *next_match(JobBlockchain *chain, const JobSearch *search, JobQuery *query,
+                              const JobMatcher *matcher)
 {
-        printf("\n=== Blockchain Job Directory ===\n");
-        printf("1. Add new job listing\n");
-        printf("2. View all job listings\n");
-        printf("3. Search jobs\n");
-        printf("4. Verify blockchain integrity\n");
-        printf("5. Exit\n");
-        printf("Enter your choice (1-5): ");
+        JobListing *job;
+        int id;
+
+        /* The indexes only narrow the candidates for times and text */
+        while ((id = job_query_next(query)) != 0)
+        {
+                job = get_job(chain, id);
+                if (job->timestamp < search->from || job->timestamp >= search->to)
+                        continue;
+                if (!matcher->length ||
+                    job_match(matcher, job->title, sizeof(job->title)) ||
+                    job_match(matcher, job->company, sizeof(job->company)) ||
+                    job_match(matcher, job->description, sizeof(job->description)))
+                        return (job);
+        }
+        return (NULL);
 }
 
 /**
- * main - Entry point
- * Return: 0 on success, 1 on failure
+ * search_by_time - Fill a page in posting-time order
+ * @chain: Blockchain whose timestamps do not rise with ID
+ * @search: Search
+ * @page: Page to fill
+ *
+ * A heap keeps the first offset + limit matches in time order seen so
+ * far, so memory grows with the page, not with the number of matches.
+ *
+ * Return: 1 on success, 0 on allocation failure
  */
-int main(void)
+static int search_by_time(JobBlockchain *chain, const JobSearch *search, JobPage *page)
 {
-        JobBlockchain *chain = initialize_blockchain();
-        JobListing *current, *results, *temp;
-        int choice;
-        char title[MAX_TITLE_LENGTH];
-        char company[MAX_COMPANY_LENGTH];
-        char location[MAX_LOCATION_LENGTH];
-        char description[MAX_DESCRIPTION_LENGTH];
-        char keyword[50];
-
-        if (chain == NULL)
+        int newest = search->order == JOB_ORDER_NEWEST;
+        size_t keep = search->offset + search->limit, count = 0, matches = 0, i;
+        JobListing **heap, *job;
+        JobMatcher matcher;
+        JobQuery query;
+
+        if (keep < search->offset || keep > (size_t)chain->count)
+                keep = (size_t)chain->count;
+        heap = malloc((keep ? keep : 1) * sizeof(JobListing *));
+        if (heap == NULL)
+                return (0);
+        if (!compile_search(chain, search, 0, &query, &matcher))
         {
-                printf("Failed to initialize blockchain\n");
-                return (1);
+                free(heap);
+                return (0);
         }
 
-        /* Initialize with sample job listings */
-        add_job_listing(chain, "Backend Developer", "TechFlow Inc",
-                        "Remote", "Looking for a skilled backend developer with 3+ years of "
-                                  "experience in Python, Django, and PostgreSQL. Knowledge of RESTful "
-                                  "APIs and microservices architecture required.");
-
-        add_job_listing(chain, "Data Engineer", "DataMinds Corp",
-                        "New York, NY", "Seeking experienced data engineer for ETL pipeline "
-                                        "development. Must have strong SQL skills and experience with Apache "
-                                        "Spark and AWS services. Big data experience is a plus.");
-
-        add_job_listing(chain, "DevOps Specialist", "CloudNet Solutions",
-                        "San Francisco, CA", "Join our team as a DevOps specialist. "
-                                             "Experience with Docker, Kubernetes, and CI/CD pipelines required. "
-                                             "AWS certification preferred.");
-
-        printf("Initialized blockchain with 3 sample job listings.\n");
-
-        while (1)
+        while ((job = next_match(chain, search, &query, &matcher)) != NULL)
         {
-                display_menu();
-                if (scanf("%d", &choice) != 1)
+                matches++;
+                if (count < keep)
                 {
-                        printf("Invalid input. Please enter a number.\n");
-                        clear_input_buffer();
-                        continue;
+                        heap[count++] = job;
+                        sift_up(heap, count, newest);
                 }
-                clear_input_buffer();
-
-                switch (choice)
+                else if (keep && sorts_before(job, heap[0], newest))
                 {
-                case 1:
-                        printf("\n=== Add New Job Listing ===\n");
-                        get_string_input("Enter job title: ", title, MAX_TITLE_LENGTH);
-                        get_string_input("Enter company name: ", company, MAX_COMPANY_LENGTH);
-                        get_string_input("Enter location: ", location, MAX_LOCATION_LENGTH);
-                        get_string_input("Enter job description: ", description, MAX_DESCRIPTION_LENGTH);
-
-                        if (add_job_listing(chain, title, company, location, description))
-                                printf("Job listing added successfully!\n");
-                        else
-                                printf("Failed to add job listing.\n");
-                        break;
+                        heap[0] = job;
+                        sift_down(heap, count, newest);
+                }
+        }
+        job_query_free(&query);
 
-                case 2:
-                        printf("\n=== All Job Listings ===\n");
-                        current = chain->head;
-                        if (current == NULL)
-                                printf("No job listings found.\n");
-                        while (current != NULL)
-                        {
-                                print_job(current);
-                                current = current->next;
-                        }
-                        break;
+        qsort(heap, count, sizeof(JobListing *), newest ? compare_newest : compare_oldest);
+        for (i = search->offset; i < count; i++)
+                page->jobs[page->count++] = heap[i];
+        page->more = matches > search->offset + page->count;
+        free(heap);
+        return (1);
+}
 
-                case 3:
-                        printf("\n=== Search Jobs ===\n");
-                        get_string_input("Enter search keyword: ", keyword, sizeof(keyword));
-                        results = search_jobs(chain, keyword);
-                        current = results;
-
-                        if (current == NULL)
-                                printf("No matching jobs found.\n");
-                        while (current != NULL)
-                        {
-                                print_job(current);
-                                temp = current;
-                                current = current->next;
-                                free(temp);
-                        }
-                        break;
+/**
+ * search_jobs - Search for jobs by keyword and filters, one page at a time
+ * @chain: Blockchain to search
+ * @search: Words to look for in the title, company and description (see
+ *          job_query_add_words() for "OR" and "prefix*"), text they must
+ *          contain, company, location and posting time filters, order
+ *          and page
+ * @page: Page to fill; @page->jobs must have room for @search->limit
+ *        listings, which point into the chain and are not copied
+ *
+ * Matches are streamed from the indexes. In ID order, and in time order
+ * while posting times rise with ID, nothing but the page is kept.
+ *
+ * Return: 1 on success, 0 on allocation failure
+ */
+int search_jobs(JobBlockchain *chain, const JobSearch *search, JobPage *page)
+{
+        JobListing *job;
+        JobMatcher matcher;
+        JobQuery query;
+        size_t skipped = 0;
+
+        page->count = 0;
+        page->more = 0;
+        if (!index_jobs(chain))
+                return (0);
+        if (search->order != JOB_ORDER_ID && !chain->time_ordered)
+                return (search_by_time(chain, search, page));
 
-                case 4:
-                        printf("\n=== Blockchain Integrity Check ===\n");
-                        if (verify_integrity(chain))
-                                printf("Blockchain integrity verified: No tampering detected\n");
-                        else
-                                printf("Warning: Blockchain integrity compromised!\n");
+        if (!compile_search(chain, search, search->order == JOB_ORDER_NEWEST, &query, &matcher))
+                return (0);
+        while ((job = next_match(chain, search, &query, &matcher)) != NULL)
+        {
+                if (skipped < search->offset)
+                        skipped++;
+                else if (page->count < search->limit)
+                        page->jobs[page->count++] = job;
+                else
+                {
+                        page->more = 1;
                         break;
-
-                case 5:
-                        printf("\nExiting program. Goodbye!\n");
-                        free_blockchain(chain);
-                        return (0);
-
-                default:
-                        printf("Invalid choice. Please try again.\n");
                 }
         }
-}
\ No newline at end of file
+        job_query_free(&query);
+        return (1);
+}
+
+/**
+ * free_blockchain - Free all blockchain memory
+ * @chain: Blockchain to free
+ */
+void free_blockchain(JobBlockchain *chain)
+{
+        int i;
+
+        if (chain->fd >= 0)
+                job_store_close(chain);
+        for (i = 0; i < chain->chunk_count; i++)
+                free(chain->chunks[i]);
+        free(chain->chunks);
+        job_index_free(&chain->index);
+        job_index_free(&chain->companies);
+        job_index_free(&chain->locations);
+        job_time_index_free(&chain->times);
+        job_hasher_free(&chain->hasher);
+        free(chain);
+}
+
+/**
+ * print_job - Display job listing information
+ * @job: Job to display
+ */
+void print_job(JobListing *job)
+{
+        time_t posted = (time_t)job->timestamp;
+
+        printf("\nJob ID: %d\n", job->id);
+        printf("Title: %s\n", job->title);
+        printf("Company: %s\n", job->company);
+        printf("Location: %s\n", job->location);
+        printf("Description: %s\n", job->description);
+        printf("Timestamp: %s", ctime(&posted));
+        printf("Previous Hash: %.16s...\n", job->prevHash);
+        printf("Current Hash: %.16s...\n", job->currentHash);
+}
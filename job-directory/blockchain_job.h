@@ -0,0 +1,269 @@
+#ifndef BLOCKCHAIN_JOB_H
+#define BLOCKCHAIN_JOB_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <openssl/evp.h>
+#include "job_index.h"
+#include "job_match.h"
+
+/* Maximum lengths for job listing fields */
+#define MAX_TITLE_LENGTH 100
+#define MAX_COMPANY_LENGTH 100
+#define MAX_LOCATION_LENGTH 100
+#define MAX_DESCRIPTION_LENGTH 500
+#define HASH_LENGTH 64
+
+/* Size of a raw SHA-256 digest */
+#define JOB_DIGEST_SIZE 32
+
+/* prevHash of the first listing */
+#define GENESIS_PREV_HASH "0000000000000000000000000000000000000000000000000000000000000000"
+
+/* Job listings per storage chunk */
+#define JOB_CHUNK_SIZE 256
+
+/* On-disk job store; see job_store.c */
+#define JOB_STORE_PATH "jobs.dat"
+#define JOB_STORE_MAGIC "JOBCHAIN"
+#define JOB_STORE_VERSION 1
+#define JOB_STORE_HEADER_SIZE 4096
+#define JOB_RECORD_SIZE 1024
+
+/**
+ * struct JobListing - Structure for storing job information
+ * @id: Unique identifier for the job
+ * @title: Job title
+ * @company: Company name
+ * @location: Job location
+ * @description: Job description
+ * @timestamp: Time when job was posted
+ * @prevHash: Hash of previous block
+ * @currentHash: Hash of current block
+ * @reserved: Zero padding to JOB_RECORD_SIZE bytes
+ *
+ * This is also the record format of the job store, so it holds no
+ * pointers and only fixed-width fields.
+ */
+typedef struct JobListing
+{
+        int32_t id;
+        char title[MAX_TITLE_LENGTH];
+        char company[MAX_COMPANY_LENGTH];
+        char location[MAX_LOCATION_LENGTH];
+        char description[MAX_DESCRIPTION_LENGTH];
+        int64_t timestamp;
+        char prevHash[HASH_LENGTH + 1];
+        char currentHash[HASH_LENGTH + 1];
+        char reserved[78];
+} JobListing;
+
+/**
+ * struct JobStoreHeader - First page of a job store file
+ * @magic: JOB_STORE_MAGIC, not NUL-terminated
+ * @version: JOB_STORE_VERSION
+ * @record_size: JOB_RECORD_SIZE
+ * @chunk_size: JOB_CHUNK_SIZE
+ * @reserved: Zero
+ * @count: Number of listings committed
+ *
+ * Listing n (from 0) is at JOB_STORE_HEADER_SIZE + n * JOB_RECORD_SIZE.
+ * The file grows a whole chunk at a time, so it may be longer than @count
+ * records.
+ */
+typedef struct JobStoreHeader
+{
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t chunk_size;
+        uint32_t reserved;
+        uint64_t count;
+} JobStoreHeader;
+
+/**
+ * struct JobHasher - Reusable hashing context
+ * @ctx: OpenSSL digest context, reset for every digest
+ *
+ * A hasher must not be shared between threads.
+ */
+typedef struct JobHasher
+{
+        EVP_MD_CTX *ctx;
+} JobHasher;
+
+/**
+ * struct JobBlockchain - Structure for managing the blockchain
+ * @count: Number of job listings
+ * @chunks: Storage for the listings, JOB_CHUNK_SIZE each; the listing with
+ *          ID n is slot (n - 1) % JOB_CHUNK_SIZE of chunk (n - 1) / JOB_CHUNK_SIZE
+ * @chunk_count: Number of chunks allocated
+ * @chunk_capacity: Allocated length of @chunks
+ * @index: Words of every listing's title, company and description
+ * @companies: Every listing's whole company name
+ * @locations: Every listing's whole location
+ * @times: Every listing's posting time
+ * @indexed: Number of listings, from the first, already in the indexes
+ * @time_ordered: Nonzero while the indexed listings' timestamps never
+ *                fall from one ID to the next
+ * @fd: Job store file, or -1 for a chain held only in memory
+ * @store: Mapped header of the job store, or NULL
+ * @hasher: Hashing context for new listings
+ *
+ * Chunks never move once allocated, so listings keep their address as
+ * the chain grows. With a store, each chunk is a mapping of the file.
+ */
+typedef struct JobBlockchain
+{
+        int count;
+        JobListing **chunks;
+        int chunk_count;
+        int chunk_capacity;
+        JobIndex index;
+        JobIndex companies;
+        JobIndex locations;
+        JobTimeIndex times;
+        int indexed;
+        int time_ordered;
+        int fd;
+        JobStoreHeader *store;
+        JobHasher hasher;
+} JobBlockchain;
+
+/* Result orders of search_jobs() */
+typedef enum JobOrder
+{
+        JOB_ORDER_ID,
+        JOB_ORDER_NEWEST,
+        JOB_ORDER_OLDEST
+} JobOrder;
+
+/**
+ * struct JobSearch - What search_jobs() looks for and which page it returns
+ * @query: Words to look for, or NULL; see job_query_add_words()
+ * @contains: Text the title, company or description must contain, in
+ *            any case and even inside a word, or NULL
+ * @company: Company the listing must be from, or NULL for any
+ * @location: Location the listing must be in, or NULL for any
+ * @from: Earliest posting time included
+ * @to: First posting time excluded
+ * @order: JOB_ORDER_ID, or by posting time with JOB_ORDER_NEWEST or
+ *         JOB_ORDER_OLDEST
+ * @offset: Number of matches to skip
+ * @limit: Most listings to return
+ *
+ * Start from job_search_init(), which matches every listing.
+ */
+typedef struct JobSearch
+{
+        const char *query;
+        const char *contains;
+        const char *company;
+        const char *location;
+        int64_t from;
+        int64_t to;
+        JobOrder order;
+        size_t offset;
+        size_t limit;
+} JobSearch;
+
+/**
+ * struct JobPage - One page of search results
+ * @jobs: Caller's array of at least JobSearch.limit entries; receives the
+ *        listings, which point into the chain
+ * @count: Number of listings on the page
+ * @more: Nonzero if more matches follow the page
+ */
+typedef struct JobPage
+{
+        JobListing **jobs;
+        size_t count;
+        int more;
+} JobPage;
+
+/* Report formats of verify_chain() */
+typedef enum VerifyFormat
+{
+        VERIFY_TEXT,
+        VERIFY_JSON
+} VerifyFormat;
+
+/**
+ * struct VerifyOptions - How verify_chain() checks the chain and reports
+ * @sink: Stream the report is written to
+ * @format: VERIFY_TEXT, or VERIFY_JSON for one JSON object per line
+ * @stop_at_first: Nonzero to stop at the first failure, 0 to report all
+ */
+typedef struct VerifyOptions
+{
+        FILE *sink;
+        VerifyFormat format;
+        int stop_at_first;
+} VerifyOptions;
+
+/* Feed formats of import_jobs() */
+typedef enum ImportFormat
+{
+        IMPORT_CSV,
+        IMPORT_JSONL
+} ImportFormat;
+
+/**
+ * struct ImportStats - What import_jobs() did and where the time went
+ * @imported: Listings added to the chain
+ * @skipped: Records that could not be imported
+ * @parse_seconds: Time spent reading and parsing the feed
+ * @digest_seconds: Time spent computing content digests, across threads
+ * @link_seconds: Time spent chaining the digests, storing and indexing
+ * @total_seconds: Time the whole import took
+ */
+typedef struct ImportStats
+{
+        int imported;
+        int skipped;
+        double parse_seconds;
+        double digest_seconds;
+        double link_seconds;
+        double total_seconds;
+} ImportStats;
+
+/* job_import.c */
+int import_jobs(JobBlockchain *chain, FILE *feed, ImportFormat format, ImportStats *stats);
+
+/* Function prototypes */
+JobBlockchain *initialize_blockchain(void);
+JobBlockchain *open_blockchain(const char *path);
+int job_hasher_init(JobHasher *hasher);
+void job_hasher_free(JobHasher *hasher);
+void job_content_digest(JobHasher *hasher, const JobListing *job, unsigned char *digest);
+void job_link_hash(JobHasher *hasher, const unsigned char *digest, const char *prev_hash,
+                   char *output);
+void job_hash_with(JobHasher *hasher, const JobListing *job, char *output);
+void job_hash(const JobListing *job, char *output);
+void calculate_hash(JobListing *job);
+int add_job_listing(JobBlockchain *chain, const char *title,
+                    const char *company, const char *location, const char *description);
+int add_job_batch(JobBlockchain *chain, const JobListing *jobs, const unsigned char *digests,
+                  int count);
+JobListing *get_job(JobBlockchain *chain, int id);
+void job_search_init(JobSearch *search);
+int search_jobs(JobBlockchain *chain, const JobSearch *search, JobPage *page);
+void free_blockchain(JobBlockchain *chain);
+void print_job(JobListing *job);
+void generate_hash(const char *input, char *output);
+
+/* job_verify.c */
+int verify_chain(JobBlockchain *chain, const VerifyOptions *options);
+int verify_integrity(JobBlockchain *chain);
+
+/* job_store.c */
+int job_store_open(JobBlockchain *chain, const char *path);
+JobListing *job_store_grow(JobBlockchain *chain);
+int job_store_commit(JobBlockchain *chain, const JobListing *job);
+int job_store_commit_range(JobBlockchain *chain, int first, int last);
+void job_store_close(JobBlockchain *chain);
+
+#endif /* BLOCKCHAIN_JOB_H */
@@ -1,2 +1,2 @@
-gcc blockchain_job.c -o job_directory.exe -lssl -lcrypto
+gcc main.c blockchain_job.c job_index.c job_store.c job_verify.c job_import.c job_match.c -o job_directory.exe -lssl -lcrypto -pthread
 ./job_directory.exe
\ No newline at end of file
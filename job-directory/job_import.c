@@ -0,0 +1,611 @@
+#define _XOPEN_SOURCE 700
+#include "blockchain_job.h"
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <strings.h>
+#include <unistd.h>
+
+/*
+ * A feed is imported a batch of listings at a time. The batch is parsed
+ * into staging listings whose IDs and timestamps are already final, so
+ * threads can split it and compute every listing's content digest at
+ * once; only the link of each digest to the hash before it is left to
+ * add_job_batch(), which runs in order and flushes the store once.
+ */
+
+#define IMPORT_BATCH 4096
+#define IMPORT_MAX_THREADS 8
+#define IMPORT_MIN_RANGE 256
+
+/* Fields of a record, in CSV column order */
+#define IMPORT_FIELDS 5
+#define IMPORT_TIME_LENGTH 32
+
+/**
+ * struct ImportRecord - Where the fields of one record are parsed to
+ * @fields: Title, company, location, description and timestamp buffers
+ * @sizes: Size of each buffer
+ * @time: Timestamp as written in the feed, empty if it has none
+ */
+typedef struct ImportRecord
+{
+        char *fields[IMPORT_FIELDS];
+        size_t sizes[IMPORT_FIELDS];
+        char time[IMPORT_TIME_LENGTH];
+} ImportRecord;
+
+/**
+ * struct ImportReader - A feed being parsed
+ * @feed: Feed
+ * @format: IMPORT_CSV or IMPORT_JSONL
+ * @text: Line buffer for JSON Lines
+ * @text_size: Allocated length of @text
+ * @line: Number of lines read so far
+ * @now: Timestamp of records without one
+ */
+typedef struct ImportReader
+{
+        FILE *feed;
+        ImportFormat format;
+        char *text;
+        size_t text_size;
+        long line;
+        int64_t now;
+} ImportReader;
+
+/**
+ * struct ImportWorker - One thread's share of a batch
+ * @jobs: Staged listings of the batch
+ * @digests: Receives JOB_DIGEST_SIZE bytes per listing of the batch
+ * @first: First listing to digest
+ * @last: Listing after the last one to digest
+ * @ok: Set to 0 if the thread could not allocate a hashing context
+ */
+typedef struct ImportWorker
+{
+        const JobListing *jobs;
+        unsigned char *digests;
+        int first;
+        int last;
+        int ok;
+} ImportWorker;
+
+/**
+ * now_seconds - Monotonic clock reading
+ * Return: Seconds
+ */
+static double now_seconds(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/**
+ * start_record - Point a record's fields at a cleared staging listing
+ * @record: Record
+ * @job: Staging listing
+ */
+static void start_record(ImportRecord *record, JobListing *job)
+{
+        memset(job, 0, sizeof(JobListing));
+        record->fields[0] = job->title;
+        record->sizes[0] = MAX_TITLE_LENGTH;
+        record->fields[1] = job->company;
+        record->sizes[1] = MAX_COMPANY_LENGTH;
+        record->fields[2] = job->location;
+        record->sizes[2] = MAX_LOCATION_LENGTH;
+        record->fields[3] = job->description;
+        record->sizes[3] = MAX_DESCRIPTION_LENGTH;
+        record->fields[4] = record->time;
+        record->sizes[4] = IMPORT_TIME_LENGTH;
+        record->time[0] = '\0';
+}
+
+/**
+ * finish_record - Check a parsed record and set its timestamp
+ * @record: Record
+ * @job: Staging listing the record was parsed into
+ * @now: Timestamp of a record without one
+ * Return: NULL if the record can be imported, otherwise why not
+ */
+static const char *finish_record(const ImportRecord *record, JobListing *job, int64_t now)
+{
+        char *end;
+
+        if (!job->title[0])
+                return ("no title");
+
+        job->timestamp = now;
+        if (record->time[0])
+        {
+                errno = 0;
+                job->timestamp = strtoll(record->time, &end, 10);
+                if (errno || *end)
+                        return ("bad timestamp");
+        }
+        return (NULL);
+}
+
+/**
+ * put_char - Append a byte to a field, dropping what does not fit
+ * @record: Record
+ * @field: Field number; past the last field, the byte is dropped
+ * @length: Bytes already in the field
+ * @c: Byte
+ */
+static void put_char(ImportRecord *record, int field, size_t *length, int c)
+{
+        if (field < IMPORT_FIELDS && *length + 1 < record->sizes[field])
+        {
+                record->fields[field][(*length)++] = (char)c;
+                record->fields[field][*length] = '\0';
+        }
+}
+
+/**
+ * read_csv - Parse the next CSV record
+ * @feed: Feed
+ * @record: Record, started on a staging listing
+ * @line: Line number, advanced past the record
+ *
+ * Columns are title, company, location, description and, optionally, a
+ * Unix timestamp. Fields may be quoted, with "" for a quote inside, and
+ * quoted fields may span lines.
+ *
+ * Return: Number of fields read, 0 at the end of the feed
+ */
+static int read_csv(FILE *feed, ImportRecord *record, long *line)
+{
+        int c, field = 0, quoted = 0, started = 0, fresh = 1;
+        size_t length = 0;
+
+        while ((c = getc(feed)) != EOF)
+        {
+                if (c == '\n')
+                        (*line)++;
+                if (quoted)
+                {
+                        if (c != '"')
+                                put_char(record, field, &length, c);
+                        else if ((c = getc(feed)) == '"')
+                                put_char(record, field, &length, c);
+                        else
+                        {
+                                ungetc(c, feed);
+                                quoted = 0;
+                        }
+                        continue;
+                }
+
+                if (c == '\n' && started)
+                        return (field + 1);
+                if (c == '\n' || c == '\r')
+                        continue;
+
+                started = 1;
+                if (c == '"' && fresh)
+                        quoted = 1;
+                else if (c == ',')
+                {
+                        field++;
+                        length = 0;
+                }
+                else
+                        put_char(record, field, &length, c);
+                fresh = c == ',';
+        }
+        return (started ? field + 1 : 0);
+}
+
+/**
+ * put_utf8 - Append a code point to a field as UTF-8
+ * @record: Record
+ * @field: Field number
+ * @length: Bytes already in the field
+ * @code: Code point
+ */
+static void put_utf8(ImportRecord *record, int field, size_t *length, unsigned long code)
+{
+        if (code < 0x80)
+                put_char(record, field, length, (int)code);
+        else if (code < 0x800)
+        {
+                put_char(record, field, length, (int)(0xC0 | code >> 6));
+                put_char(record, field, length, (int)(0x80 | (code & 0x3F)));
+        }
+        else if (code < 0x10000)
+        {
+                put_char(record, field, length, (int)(0xE0 | code >> 12));
+                put_char(record, field, length, (int)(0x80 | (code >> 6 & 0x3F)));
+                put_char(record, field, length, (int)(0x80 | (code & 0x3F)));
+        }
+        else
+        {
+                put_char(record, field, length, (int)(0xF0 | code >> 18));
+                put_char(record, field, length, (int)(0x80 | (code >> 12 & 0x3F)));
+                put_char(record, field, length, (int)(0x80 | (code >> 6 & 0x3F)));
+                put_char(record, field, length, (int)(0x80 | (code & 0x3F)));
+        }
+}
+
+/**
+ * read_hex4 - Parse the four hex digits of a \u escape
+ * @text: Digits
+ * @code: Receives their value
+ * Return: 1 on success, 0 if they are not four hex digits
+ */
+static int read_hex4(const char *text, unsigned long *code)
+{
+        int i;
+
+        *code = 0;
+        for (i = 0; i < 4; i++)
+        {
+                if (!isxdigit((unsigned char)text[i]))
+                        return (0);
+                *code = *code * 16 + (unsigned long)(isdigit((unsigned char)text[i])
+                                                     ? text[i] - '0'
+                                                     : tolower((unsigned char)text[i]) - 'a' + 10);
+        }
+        return (1);
+}
+
+/**
+ * read_json_string - Parse a JSON string
+ * @text: Position of the opening quote, advanced past the closing one
+ * @record: Record
+ * @field: Field to append the string to, or IMPORT_FIELDS to drop it
+ * Return: 1 on success, 0 if the string is malformed
+ */
+static int read_json_string(const char **text, ImportRecord *record, int field)
+{
+        static const char escapes[] = "\"\"\\\\//b\bf\fn\nr\rt\t";
+        const char *p = *text + 1, *escape;
+        unsigned long code, low;
+        size_t length = 0;
+
+        if (**text != '"')
+                return (0);
+        if (field < IMPORT_FIELDS)
+                record->fields[field][0] = '\0';
+        for (; *p && *p != '"'; p++)
+        {
+                if (*p != '\\')
+                {
+                        put_char(record, field, &length, *p);
+                        continue;
+                }
+
+                p++;
+                if (*p == 'u')
+                {
+                        if (!read_hex4(p + 1, &code))
+                                return (0);
+                        p += 4;
+                        /* A surrogate pair encodes one code point past U+FFFF */
+                        if (code >= 0xD800 && code < 0xDC00 && p[1] == '\\' && p[2] == 'u' &&
+                            read_hex4(p + 3, &low) && low >= 0xDC00 && low < 0xE000)
+                        {
+                                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                                p += 6;
+                        }
+                        /* Half a pair has no UTF-8 encoding */
+                        if (code >= 0xD800 && code < 0xE000)
+                                return (0);
+                        put_utf8(record, field, &length, code);
+                        continue;
+                }
+                for (escape = escapes; *escape && *escape != *p; escape += 2)
+                        ;
+                if (!*p || !*escape)
+                        return (0);
+                put_char(record, field, &length, escape[1]);
+        }
+
+        if (*p != '"')
+                return (0);
+        *text = p + 1;
+        return (1);
+}
+
+/**
+ * skip_space - Skip JSON whitespace
+ * @text: Text
+ * Return: First byte that is not whitespace
+ */
+static const char *skip_space(const char *text)
+{
+        while (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n')
+                text++;
+        return (text);
+}
+
+/**
+ * skip_json_value - Skip a JSON value of a key that is not imported
+ * @text: Position of the value, advanced past it
+ * @record: Record, for scratch string parsing
+ * Return: 1 on success, 0 if the value is malformed
+ */
+static int skip_json_value(const char **text, ImportRecord *record)
+{
+        const char *p = *text;
+        int depth = 0;
+
+        /* The value ends at the first ',' or '}' outside any nesting */
+        while ((p = skip_space(p)), depth > 0 || (*p != ',' && *p != '}'))
+        {
+                if (!*p)
+                        return (0);
+                if (*p == '"')
+                {
+                        if (!read_json_string(&p, record, IMPORT_FIELDS))
+                                return (0);
+                        continue;
+                }
+                if (*p == '{' || *p == '[')
+                        depth++;
+                else if (*p == '}' || *p == ']')
+                        depth--;
+                p++;
+        }
+
+        *text = p;
+        return (1);
+}
+
+/**
+ * read_json_line - Parse one JSON Lines record
+ * @text: Line
+ * @record: Record, started on a staging listing
+ *
+ * The record is an object with string members "title", "company",
+ * "location" and "description" and an optional integer "timestamp";
+ * other members are ignored.
+ *
+ * Return: 1 on success, 0 for a blank line, -1 if the line is malformed
+ */
+static int read_json_line(const char *text, ImportRecord *record)
+{
+        static const char *const keys[IMPORT_FIELDS] = {"title", "company", "location",
+                                                         "description", "timestamp"};
+        char key[16];
+        ImportRecord scratch;
+        const char *p = skip_space(text), *end;
+        int field;
+
+        if (!*p)
+                return (0);
+        if (*p++ != '{')
+                return (-1);
+
+        p = skip_space(p);
+        if (*p == '}')
+                return (*skip_space(p + 1) ? -1 : 1);
+
+        /* Every member, including one after a comma, starts with its key */
+        for (;; p = skip_space(p + 1))
+        {
+                scratch.fields[0] = key;
+                scratch.sizes[0] = sizeof(key);
+                key[0] = '\0';
+                if (!read_json_string(&p, &scratch, 0))
+                        return (-1);
+                p = skip_space(p);
+                if (*p++ != ':')
+                        return (-1);
+
+                p = skip_space(p);
+                for (field = 0; field < IMPORT_FIELDS && strcmp(key, keys[field]) != 0; field++)
+                        ;
+                if (field == IMPORT_FIELDS)
+                {
+                        if (!skip_json_value(&p, record))
+                                return (-1);
+                }
+                else if (field == IMPORT_FIELDS - 1)
+                {
+                        for (end = p; *end == '-' || isdigit((unsigned char)*end); end++)
+                                ;
+                        if (end == p || (size_t)(end - p) >= IMPORT_TIME_LENGTH)
+                                return (-1);
+                        memcpy(record->time, p, (size_t)(end - p));
+                        record->time[end - p] = '\0';
+                        p = end;
+                }
+                else if (!read_json_string(&p, record, field))
+                        return (-1);
+
+                p = skip_space(p);
+                if (*p == '}')
+                        break;
+                if (*p != ',')
+                        return (-1);
+        }
+        return (*skip_space(p + 1) ? -1 : 1);
+}
+
+/**
+ * digest_jobs - Compute the content digests of a range of staged listings
+ * @arg: ImportWorker
+ * Return: NULL
+ */
+static void *digest_jobs(void *arg)
+{
+        ImportWorker *worker = arg;
+        JobHasher hasher;
+        int i;
+
+        worker->ok = job_hasher_init(&hasher);
+        for (i = worker->first; worker->ok && i < worker->last; i++)
+                job_content_digest(&hasher, &worker->jobs[i],
+                                   worker->digests + (size_t)i * JOB_DIGEST_SIZE);
+        if (worker->ok)
+                job_hasher_free(&hasher);
+        return (NULL);
+}
+
+/**
+ * digest_batch - Compute the content digests of a batch across threads
+ * @jobs: Staged listings
+ * @count: Number of listings
+ * @digests: Receives JOB_DIGEST_SIZE bytes per listing
+ * Return: 1 on success, 0 if a thread could not allocate a hashing context
+ */
+static int digest_batch(const JobListing *jobs, int count, unsigned char *digests)
+{
+        ImportWorker workers[IMPORT_MAX_THREADS];
+        pthread_t threads[IMPORT_MAX_THREADS];
+        int started[IMPORT_MAX_THREADS];
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int thread_count, t, ok = 1;
+
+        thread_count = cpus > 0 ? (int)cpus : 1;
+        if (thread_count > IMPORT_MAX_THREADS)
+                thread_count = IMPORT_MAX_THREADS;
+        if (thread_count > (count + IMPORT_MIN_RANGE - 1) / IMPORT_MIN_RANGE)
+                thread_count = (count + IMPORT_MIN_RANGE - 1) / IMPORT_MIN_RANGE;
+
+        for (t = 0; t < thread_count; t++)
+        {
+                workers[t].jobs = jobs;
+                workers[t].digests = digests;
+                workers[t].first = (int)((long)count * t / thread_count);
+                workers[t].last = (int)((long)count * (t + 1) / thread_count);
+                started[t] = t > 0 && pthread_create(&threads[t], NULL, digest_jobs, &workers[t]) == 0;
+        }
+
+        /* The calling thread takes the first range and any that failed to start */
+        for (t = 0; t < thread_count; t++)
+        {
+                if (!started[t])
+                        digest_jobs(&workers[t]);
+        }
+        for (t = 0; t < thread_count; t++)
+        {
+                if (started[t])
+                        pthread_join(threads[t], NULL);
+        }
+        for (t = 0; t < thread_count; t++)
+                ok &= workers[t].ok;
+        return (ok);
+}
+
+/**
+ * read_batch - Parse up to a batch of importable records
+ * @reader: Feed being parsed
+ * @jobs: Staging listings, IMPORT_BATCH of them
+ * @first_id: ID the first listing of the batch will have
+ * @stats: Counts skipped records
+ * Return: Number of listings staged, -1 on a read error
+ */
+static int read_batch(ImportReader *reader, JobListing *jobs, int first_id, ImportStats *stats)
+{
+        ImportRecord record;
+        const char *problem;
+        int count = 0, result;
+        long start;
+
+        while (count < IMPORT_BATCH)
+        {
+                start_record(&record, &jobs[count]);
+                start = reader->line + 1;
+                if (reader->format == IMPORT_CSV)
+                {
+                        result = read_csv(reader->feed, &record, &reader->line);
+                        /* A header row names its columns */
+                        if (start == 1 && result && strcasecmp(jobs[count].title, "title") == 0)
+                                continue;
+                        if (result && result < IMPORT_FIELDS - 1)
+                                result = -1;
+                }
+                else
+                {
+                        if (getline(&reader->text, &reader->text_size, reader->feed) < 0)
+                                break;
+                        reader->line++;
+                        result = read_json_line(reader->text, &record);
+                        if (!result)
+                                continue;
+                }
+                if (!result)
+                        break;
+
+                problem = result < 0 ? "malformed record"
+                                     : finish_record(&record, &jobs[count], reader->now);
+                if (problem != NULL)
+                {
+                        printf("Skipping record at line %ld: %s\n", start, problem);
+                        stats->skipped++;
+                        continue;
+                }
+                jobs[count].id = first_id + count;
+                count++;
+        }
+
+        if (ferror(reader->feed))
+        {
+                printf("Error reading feed: %s\n", strerror(errno));
+                return (-1);
+        }
+        return (count);
+}
+
+/**
+ * import_jobs - Append every listing of a CSV or JSON Lines feed
+ * @chain: Blockchain
+ * @feed: Feed
+ * @format: IMPORT_CSV, with columns title, company, location, description
+ *          and an optional Unix timestamp, or IMPORT_JSONL, one object per
+ *          line with members of the same names
+ * @stats: Receives the counts and the time spent in each stage
+ *
+ * Records that cannot be imported are reported and skipped. Each batch
+ * is durable once added; a failure leaves earlier batches in the chain.
+ *
+ * Return: 1 on success, 0 on a read, allocation or store failure
+ */
+int import_jobs(JobBlockchain *chain, FILE *feed, ImportFormat format, ImportStats *stats)
+{
+        JobListing *jobs = malloc(IMPORT_BATCH * sizeof(JobListing));
+        unsigned char *digests = malloc((size_t)IMPORT_BATCH * JOB_DIGEST_SIZE);
+        ImportReader reader;
+        double start, mark;
+        int count, ok = jobs != NULL && digests != NULL;
+
+        memset(stats, 0, sizeof(ImportStats));
+        memset(&reader, 0, sizeof(reader));
+        reader.feed = feed;
+        reader.format = format;
+        reader.now = (int64_t)time(NULL);
+        start = now_seconds();
+        while (ok)
+        {
+                mark = now_seconds();
+                count = read_batch(&reader, jobs, chain->count + 1, stats);
+                stats->parse_seconds += now_seconds() - mark;
+                if (count <= 0)
+                {
+                        ok = count == 0;
+                        break;
+                }
+
+                mark = now_seconds();
+                ok = digest_batch(jobs, count, digests);
+                stats->digest_seconds += now_seconds() - mark;
+
+                mark = now_seconds();
+                ok = ok && add_job_batch(chain, jobs, digests, count);
+                stats->link_seconds += now_seconds() - mark;
+                if (ok)
+                        stats->imported += count;
+        }
+
+        stats->total_seconds = now_seconds() - start;
+        free(reader.text);
+        free(jobs);
+        free(digests);
+        return (ok);
+}
@@ -0,0 +1,787 @@
+#include "job_index.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The index maps every word of a job's title, company and description,
+ * folded to lowercase, to the sorted list of job IDs containing it. Jobs
+ * are added in ID order, so a posting list only ever grows at its end.
+ * Words are found through a hash table; a second, alphabetical list of
+ * the words answers prefix queries with a binary search. The same
+ * structure indexes whole company and location values for exact filters.
+ * Queries stream their matches in ID order, either way, by moving a
+ * cursor along each list, so they never collect every match.
+ */
+
+#define INDEX_MIN_SLOTS 256
+
+/**
+ * is_word_char - Whether a byte belongs to a word
+ * @c: Byte
+ * Return: 1 for letters, digits and non-ASCII bytes, 0 otherwise
+ */
+static int is_word_char(unsigned char c)
+{
+        return (isalnum(c) || c >= 0x80);
+}
+
+/**
+ * next_word - Find the next word in a text and fold it to lowercase
+ * @text: Text to scan
+ * @start: Receives the start of the word in @text
+ * @word: Buffer of MAX_TERM_LENGTH bytes; receives the folded word,
+ *        cut short if it is longer
+ * Return: End of the word in @text, or NULL if there are no more words
+ */
+static const char *next_word(const char *text, const char **start, char *word)
+{
+        size_t length = 0;
+
+        while (*text && !is_word_char((unsigned char)*text))
+                text++;
+        if (!*text)
+                return (NULL);
+
+        *start = text;
+        for (; is_word_char((unsigned char)*text); text++)
+        {
+                if (length < MAX_TERM_LENGTH - 1)
+                        word[length++] = (char)tolower((unsigned char)*text);
+        }
+        word[length] = '\0';
+        return (text);
+}
+
+/**
+ * hash_word - FNV-1a hash of a word
+ * @word: Word
+ * Return: 32-bit hash
+ */
+static uint32_t hash_word(const char *word)
+{
+        uint32_t hash = 2166136261u;
+
+        while (*word)
+        {
+                hash ^= (unsigned char)*word++;
+                hash *= 16777619u;
+        }
+        return (hash);
+}
+
+/**
+ * find_slot - Find the slot holding a word or the empty slot for it
+ * @index: Index with at least one slot
+ * @word: Word
+ * Return: Slot
+ */
+static size_t *find_slot(const JobIndex *index, const char *word)
+{
+        size_t mask = index->slot_count - 1;
+        size_t i = hash_word(word) & mask;
+
+        for (;; i = (i + 1) & mask)
+        {
+                if (!index->slots[i] || strcmp(index->terms[index->slots[i] - 1].text, word) == 0)
+                        return (&index->slots[i]);
+        }
+}
+
+/**
+ * grow_slots - Double the hash table and reinsert every term
+ * @index: Index
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int grow_slots(JobIndex *index)
+{
+        JobIndex grown = *index;
+        size_t i;
+
+        grown.slot_count = index->slot_count ? index->slot_count * 2 : INDEX_MIN_SLOTS;
+        grown.slots = calloc(grown.slot_count, sizeof(size_t));
+        if (grown.slots == NULL)
+                return (0);
+
+        for (i = 0; i < index->term_count; i++)
+                *find_slot(&grown, index->terms[i].text) = i + 1;
+
+        free(index->slots);
+        index->slots = grown.slots;
+        index->slot_count = grown.slot_count;
+        return (1);
+}
+
+/**
+ * lower_bound - First position in alphabetical order not before a word
+ * @index: Index
+ * @word: Word or prefix
+ * Return: Position in @index->sorted
+ */
+static size_t lower_bound(const JobIndex *index, const char *word)
+{
+        size_t low = 0, high = index->term_count, middle;
+
+        while (low < high)
+        {
+                middle = low + (high - low) / 2;
+                if (strcmp(index->terms[index->sorted[middle]].text, word) < 0)
+                        low = middle + 1;
+                else
+                        high = middle;
+        }
+        return (low);
+}
+
+/**
+ * add_term - Add a new word with no jobs yet
+ * @index: Index
+ * @slot: Empty slot for the word, from find_slot()
+ * @word: Word
+ * Return: The new term, or NULL on allocation failure
+ */
+static JobTerm *add_term(JobIndex *index, size_t *slot, const char *word)
+{
+        JobTerm *terms, *term;
+        size_t *sorted, capacity, position;
+        char *text;
+
+        if (index->term_count == index->term_capacity)
+        {
+                capacity = index->term_capacity ? index->term_capacity * 2 : 64;
+                terms = realloc(index->terms, capacity * sizeof(JobTerm));
+                if (terms == NULL)
+                        return (NULL);
+                index->terms = terms;
+                sorted = realloc(index->sorted, capacity * sizeof(size_t));
+                if (sorted == NULL)
+                        return (NULL);
+                index->sorted = sorted;
+                index->term_capacity = capacity;
+        }
+
+        text = malloc(strlen(word) + 1);
+        if (text == NULL)
+                return (NULL);
+        strcpy(text, word);
+
+        position = lower_bound(index, word);
+        memmove(&index->sorted[position + 1], &index->sorted[position],
+                (index->term_count - position) * sizeof(size_t));
+        index->sorted[position] = index->term_count;
+
+        term = &index->terms[index->term_count++];
+        term->text = text;
+        term->ids = NULL;
+        term->count = 0;
+        term->capacity = 0;
+        *slot = index->term_count;
+        return (term);
+}
+
+/**
+ * add_posting - Record that a job contains a word
+ * @index: Index
+ * @word: Folded word
+ * @id: Job ID, not below any ID added before
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int add_posting(JobIndex *index, const char *word, int id)
+{
+        JobTerm *term;
+        size_t *slot;
+        size_t capacity;
+        int *ids;
+
+        /* Keep the load factor at or below one half */
+        if ((index->term_count + 1) * 2 > index->slot_count && !grow_slots(index))
+                return (0);
+
+        slot = find_slot(index, word);
+        term = *slot ? &index->terms[*slot - 1] : add_term(index, slot, word);
+        if (term == NULL)
+                return (0);
+        if (term->count && term->ids[term->count - 1] == id)
+                return (1);
+
+        if (term->count == term->capacity)
+        {
+                capacity = term->capacity ? term->capacity * 2 : 4;
+                ids = realloc(term->ids, capacity * sizeof(int));
+                if (ids == NULL)
+                        return (0);
+                term->ids = ids;
+                term->capacity = capacity;
+        }
+        term->ids[term->count++] = id;
+        return (1);
+}
+
+/**
+ * job_index_init - Start an empty index
+ * @index: Index to initialise
+ */
+void job_index_init(JobIndex *index)
+{
+        memset(index, 0, sizeof(JobIndex));
+}
+
+/**
+ * job_index_free - Release an index and leave it empty
+ * @index: Index to free
+ */
+void job_index_free(JobIndex *index)
+{
+        size_t i;
+
+        for (i = 0; i < index->term_count; i++)
+        {
+                free(index->terms[i].text);
+                free(index->terms[i].ids);
+        }
+        free(index->terms);
+        free(index->slots);
+        free(index->sorted);
+        job_index_init(index);
+}
+
+/**
+ * job_index_add - Index every word of a text under a job
+ * @index: Index
+ * @id: Job ID, not below any ID added before
+ * @text: Text to index
+ *
+ * On failure some words may already be indexed; job_index_drop() removes
+ * them.
+ *
+ * Return: 1 on success, 0 on allocation failure
+ */
+int job_index_add(JobIndex *index, int id, const char *text)
+{
+        char word[MAX_TERM_LENGTH];
+        const char *start;
+
+        while ((text = next_word(text, &start, word)) != NULL)
+        {
+                if (!add_posting(index, word, id))
+                        return (0);
+        }
+        return (1);
+}
+
+/**
+ * job_index_drop - Remove the job added last from the index
+ * @index: Index
+ * @id: ID of that job
+ */
+void job_index_drop(JobIndex *index, int id)
+{
+        size_t i;
+
+        for (i = 0; i < index->term_count; i++)
+        {
+                if (index->terms[i].count && index->terms[i].ids[index->terms[i].count - 1] == id)
+                        index->terms[i].count--;
+        }
+}
+
+/**
+ * fold_value - Fold a field value for exact lookups
+ * @text: Value
+ * @folded: Buffer of MAX_VALUE_LENGTH bytes; receives the value in
+ *          lowercase, its words separated by single spaces
+ */
+static void fold_value(const char *text, char *folded)
+{
+        char word[MAX_TERM_LENGTH];
+        const char *start, *end;
+        size_t length = 0, n;
+
+        folded[0] = '\0';
+        while ((end = next_word(text, &start, word)) != NULL)
+        {
+                n = (size_t)(end - start);
+                if (length + (length > 0) + n >= MAX_VALUE_LENGTH)
+                        break;
+                if (length)
+                        folded[length++] = ' ';
+                while (start < end)
+                        folded[length++] = (char)tolower((unsigned char)*start++);
+                folded[length] = '\0';
+                text = end;
+        }
+}
+
+/**
+ * job_index_add_value - Index a whole field value under a job
+ * @index: Index of values of one field
+ * @id: Job ID, not below any ID added before
+ * @text: Value; case and punctuation are ignored
+ * Return: 1 on success, 0 on allocation failure
+ */
+int job_index_add_value(JobIndex *index, int id, const char *text)
+{
+        char folded[MAX_VALUE_LENGTH];
+
+        fold_value(text, folded);
+        return (!folded[0] || add_posting(index, folded, id));
+}
+
+/**
+ * job_time_index_add - Add the next job's posting time
+ * @index: Time index
+ * @time: Posting time of job ID @index->count + 1
+ *
+ * Times may arrive out of order; an earlier time only lowers the bounds
+ * of the entries it follows.
+ *
+ * Return: 1 on success, 0 on allocation failure
+ */
+int job_time_index_add(JobTimeIndex *index, int64_t time)
+{
+        JobTimeEntry *entries;
+        size_t capacity, k;
+
+        if (index->count % JOB_TIME_STRIDE == 0)
+        {
+                if (index->entry_count == index->entry_capacity)
+                {
+                        capacity = index->entry_capacity ? index->entry_capacity * 2 : 16;
+                        entries = realloc(index->entries, capacity * sizeof(JobTimeEntry));
+                        if (entries == NULL)
+                                return (0);
+                        index->entries = entries;
+                        index->entry_capacity = capacity;
+                }
+                index->entries[index->entry_count].max_before = index->count ? index->latest : INT64_MIN;
+                index->entries[index->entry_count].min_after = time;
+                index->entry_count++;
+        }
+
+        for (k = index->entry_count; k > 0 && index->entries[k - 1].min_after > time; k--)
+                index->entries[k - 1].min_after = time;
+        if (!index->count || time > index->latest)
+                index->latest = time;
+        index->count++;
+        return (1);
+}
+
+/**
+ * job_time_index_range - Jobs that may have been posted in [from, to)
+ * @index: Time index
+ * @from: First time included
+ * @to: First time excluded
+ * @first: Receives the first job ID to consider
+ * @last: Receives the ID after the last one to consider
+ *
+ * Every job posted in the range lies in [*first, *last); jobs near either
+ * end, or anywhere if the clock went back, may still be outside it.
+ */
+void job_time_index_range(const JobTimeIndex *index, int64_t from, int64_t to,
+                          int *first, int *last)
+{
+        size_t low = 0, high = index->entry_count, middle, start;
+
+        *first = *last = 1;
+        if (from >= to || !index->entry_count)
+                return;
+
+        /* The last entry with every earlier job posted before @from */
+        while (low < high)
+        {
+                middle = low + (high - low) / 2;
+                if (index->entries[middle].max_before < from)
+                        low = middle + 1;
+                else
+                        high = middle;
+        }
+        start = low ? low - 1 : 0;
+        *first = (int)(start * JOB_TIME_STRIDE) + 1;
+
+        /* The first entry with every later job posted at or after @to */
+        low = start;
+        high = index->entry_count;
+        while (low < high)
+        {
+                middle = low + (high - low) / 2;
+                if (index->entries[middle].min_after < to)
+                        low = middle + 1;
+                else
+                        high = middle;
+        }
+        *last = (low < index->entry_count ? (int)(low * JOB_TIME_STRIDE) : index->count) + 1;
+}
+
+/**
+ * job_time_index_free - Release a time index and leave it empty
+ * @index: Time index
+ */
+void job_time_index_free(JobTimeIndex *index)
+{
+        free(index->entries);
+        memset(index, 0, sizeof(JobTimeIndex));
+}
+
+/**
+ * job_query_init - Start a query that matches every job
+ * @query: Query to initialise; release with job_query_free()
+ * @descending: Nonzero to stream matches from the highest ID down
+ *
+ * Each job_query_add_*() call adds a clause that matches jobs must also
+ * match; job_query_plan() must be called before job_query_next().
+ */
+void job_query_init(JobQuery *query, int descending)
+{
+        memset(query, 0, sizeof(JobQuery));
+        query->descending = descending;
+}
+
+/**
+ * add_clause - Start a new, empty clause
+ * @query: Query
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int add_clause(JobQuery *query)
+{
+        JobClause *clauses;
+        size_t capacity;
+
+        if (query->clause_count == query->clause_capacity)
+        {
+                capacity = query->clause_capacity ? query->clause_capacity * 2 : 4;
+                clauses = realloc(query->clauses, capacity * sizeof(JobClause));
+                if (clauses == NULL)
+                        return (0);
+                query->clauses = clauses;
+                query->clause_capacity = capacity;
+        }
+
+        query->clauses[query->clause_count].first = query->posting_count;
+        query->clauses[query->clause_count].end = query->posting_count;
+        query->clauses[query->clause_count].estimate = 0;
+        query->clause_count++;
+        return (1);
+}
+
+/**
+ * add_cursor - Add a list of IDs to the last clause
+ * @query: Query with at least one clause
+ * @ids: Increasing IDs, or NULL for every ID in [@low, @high)
+ * @low: First position in @ids, or first ID
+ * @high: Position after the last in @ids, or ID after the last
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int add_cursor(JobQuery *query, const int *ids, size_t low, size_t high)
+{
+        JobPostingCursor *postings;
+        JobClause *clause = &query->clauses[query->clause_count - 1];
+        size_t capacity;
+
+        if (low >= high)
+                return (1);
+        if (query->posting_count == query->posting_capacity)
+        {
+                capacity = query->posting_capacity ? query->posting_capacity * 2 : 8;
+                postings = realloc(query->postings, capacity * sizeof(JobPostingCursor));
+                if (postings == NULL)
+                        return (0);
+                query->postings = postings;
+                query->posting_capacity = capacity;
+        }
+
+        query->postings[query->posting_count].ids = ids;
+        query->postings[query->posting_count].low = low;
+        query->postings[query->posting_count].high = high;
+        query->posting_count++;
+        clause->end = query->posting_count;
+        clause->estimate += high - low;
+        return (1);
+}
+
+/**
+ * add_word - Add the posting lists of a query word to the last clause
+ * @index: Index
+ * @query: Query
+ * @word: Folded word
+ * @prefix: Nonzero to add every word starting with @word
+ * Return: 1 on success, 0 on allocation failure
+ */
+static int add_word(const JobIndex *index, JobQuery *query, const char *word, int prefix)
+{
+        size_t length = strlen(word), i, slot;
+        const JobTerm *term;
+
+        if (!index->term_count)
+                return (1);
+        if (!prefix)
+        {
+                slot = *find_slot(index, word);
+                return (!slot || add_cursor(query, index->terms[slot - 1].ids, 0,
+                                            index->terms[slot - 1].count));
+        }
+
+        for (i = lower_bound(index, word); i < index->term_count; i++)
+        {
+                term = &index->terms[index->sorted[i]];
+                if (strncmp(term->text, word, length) != 0)
+                        break;
+                if (!add_cursor(query, term->ids, 0, term->count))
+                        return (0);
+        }
+        return (1);
+}
+
+/**
+ * job_query_add_words - Require keywords
+ * @index: Word index; must not change while the query is in use
+ * @query: Query
+ * @text: Words, all of which must match; "a OR b" matches either word,
+ *        and a word ending in '*' matches any word it starts
+ *
+ * Case is ignored. Punctuation separates words, so "CI/CD" asks for both
+ * "ci" and "cd". The query holds one cursor per matching index word, not
+ * the matching IDs, so its size does not grow with the number of matches.
+ *
+ * Return: 1 on success, 0 on allocation failure
+ */
+int job_query_add_words(const JobIndex *index, JobQuery *query, const char *text)
+{
+        char word[MAX_TERM_LENGTH];
+        const char *start, *end;
+        int join = 0, words = 0;
+
+        while ((end = next_word(text, &start, word)) != NULL)
+        {
+                text = end;
+                if (words && !join && end - start == 2 && start[0] == 'O' && start[1] == 'R')
+                {
+                        join = 1;
+                        continue;
+                }
+
+                if ((!join && !add_clause(query)) || !add_word(index, query, word, *end == '*'))
+                        return (0);
+                join = 0;
+                words++;
+        }
+        return (1);
+}
+
+/**
+ * job_query_add_substring - Require the words a piece of text implies
+ * @index: Word index; must not change while the query is in use
+ * @query: Query
+ * @text: Text a matching job must contain somewhere
+ *
+ * A word of @text with a separator on both sides is a whole word of any
+ * job containing @text, and a word that only ends @text starts one, so
+ * they narrow the search to jobs the text can be in. The first word may
+ * be the end of a longer one and adds nothing. The text itself must
+ * still be checked on each job.
+ *
+ * Return: 1 on success, 0 on allocation failure
+ */
+int job_query_add_substring(const JobIndex *index, JobQuery *query, const char *text)
+{
+        char word[MAX_TERM_LENGTH];
+        const char *start, *end, *scan = text;
+
+        while ((end = next_word(scan, &start, word)) != NULL)
+        {
+                scan = end;
+                if (start == text)
+                        continue;
+                if (!add_clause(query) || !add_word(index, query, word, *end == '\0'))
+                        return (0);
+        }
+        return (1);
+}
+
+/**
+ * job_query_add_value - Require a field to equal a value
+ * @index: Value index of the field; must not change while the query is
+ *         in use
+ * @query: Query
+ * @value: Value; case and punctuation are ignored
+ * Return: 1 on success, 0 on allocation failure
+ */
+int job_query_add_value(const JobIndex *index, JobQuery *query, const char *value)
+{
+        char folded[MAX_VALUE_LENGTH];
+        size_t slot;
+
+        if (!add_clause(query))
+                return (0);
+
+        fold_value(value, folded);
+        if (!index->term_count || !folded[0])
+                return (1);
+        slot = *find_slot(index, folded);
+        return (!slot || add_cursor(query, index->terms[slot - 1].ids, 0, index->terms[slot - 1].count));
+}
+
+/**
+ * job_query_add_range - Require an ID in a range
+ * @query: Query
+ * @first: First ID
+ * @last: ID after the last one
+ * Return: 1 on success, 0 on allocation failure
+ */
+int job_query_add_range(JobQuery *query, int first, int last)
+{
+        if (first < 1)
+                first = 1;
+        return (add_clause(query) && add_cursor(query, NULL, (size_t)first, last > first ? (size_t)last : 0));
+}
+
+/**
+ * compare_clauses - qsort() comparator, smallest estimate first
+ * @a: First clause
+ * @b: Second clause
+ * Return: Negative, zero or positive as @a is smaller, equal or larger
+ */
+static int compare_clauses(const void *a, const void *b)
+{
+        size_t x = ((const JobClause *)a)->estimate, y = ((const JobClause *)b)->estimate;
+
+        return ((x > y) - (x < y));
+}
+
+/**
+ * job_query_plan - Order the clauses for evaluation
+ * @query: Query with every clause added
+ *
+ * The clause with the fewest candidate IDs goes first, so it proposes
+ * the candidates and the larger clauses are only probed for them. A
+ * clause with no candidates ends the query before any work.
+ */
+void job_query_plan(JobQuery *query)
+{
+        qsort(query->clauses, query->clause_count, sizeof(JobClause), compare_clauses);
+        query->done = query->clause_count == 0 || query->clauses[0].estimate == 0;
+}
+
+/**
+ * seek_posting - Move a posting cursor to the first ID at or past a target
+ * @posting: Cursor
+ * @target: ID
+ * @descending: Nonzero if "past" means lower
+ * Return: That ID, or 0 if the list has none
+ */
+static int seek_posting(JobPostingCursor *posting, int target, int descending)
+{
+        size_t low = posting->low, high = posting->high, middle;
+
+        if (posting->ids == NULL)
+        {
+                /* A range: every ID from low up to high */
+                if (!descending)
+                {
+                        posting->low = (size_t)target > low ? (size_t)target : low;
+                        return (posting->low < high ? (int)posting->low : 0);
+                }
+                posting->high = (size_t)target < high ? (size_t)target + 1 : high;
+                return (posting->high > low ? (int)posting->high - 1 : 0);
+        }
+
+        while (low < high)
+        {
+                middle = low + (high - low) / 2;
+                if (posting->ids[middle] < target)
+                        low = middle + 1;
+                else
+                        high = middle;
+        }
+
+        if (!descending)
+        {
+                posting->low = low;
+                return (low < posting->high ? posting->ids[low] : 0);
+        }
+
+        if (low < posting->high && posting->ids[low] == target)
+                low++;
+        posting->high = low;
+        return (low > posting->low ? posting->ids[low - 1] : 0);
+}
+
+/**
+ * seek_clause - First ID at or past a target in any of a clause's lists
+ * @query: Query
+ * @clause: Clause
+ * @target: ID
+ * Return: That ID, or 0 if no list of the clause has one
+ */
+static int seek_clause(JobQuery *query, const JobClause *clause, int target)
+{
+        size_t i;
+        int best = 0, id;
+
+        for (i = clause->first; i < clause->end; i++)
+        {
+                id = seek_posting(&query->postings[i], target, query->descending);
+                if (id && (!best || (query->descending ? id > best : id < best)))
+                        best = id;
+        }
+        return (best);
+}
+
+/**
+ * job_query_next - Next matching job ID
+ * @query: Planned query
+ *
+ * Each clause in turn is moved to the candidate ID; a clause that has to
+ * go past it supplies the next candidate, so lists skip over the IDs
+ * other clauses rule out instead of being walked one by one.
+ *
+ * Return: The ID, or 0 when there are no more matches
+ */
+int job_query_next(JobQuery *query)
+{
+        size_t clause = 0, agreed = 0;
+        int target, id;
+
+        if (query->done)
+                return (0);
+        if (query->current)
+                target = query->descending ? query->current - 1 : query->current + 1;
+        else
+                target = query->descending ? INT_MAX : 1;
+
+        while (target > 0)
+        {
+                id = seek_clause(query, &query->clauses[clause], target);
+                if (!id)
+                        break;
+                if (id == target)
+                        agreed++;
+                else
+                {
+                        target = id;
+                        agreed = 1;
+                }
+                if (agreed == query->clause_count)
+                {
+                        query->current = id;
+                        return (id);
+                }
+                clause = (clause + 1) % query->clause_count;
+        }
+
+        query->done = 1;
+        return (0);
+}
+
+/**
+ * job_query_free - Release a query
+ * @query: Query to free
+ */
+void job_query_free(JobQuery *query)
+{
+        free(query->postings);
+        free(query->clauses);
+        memset(query, 0, sizeof(JobQuery));
+        query->done = 1;
+}
@@ -0,0 +1,152 @@
+#ifndef JOB_INDEX_H
+#define JOB_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Longest term kept; longer words are indexed by their first letters */
+#define MAX_TERM_LENGTH 32
+
+/* Longest whole field value kept for exact lookups */
+#define MAX_VALUE_LENGTH 128
+
+/**
+ * struct JobTerm - One indexed word and the jobs containing it
+ * @text: Lowercase word
+ * @ids: IDs of the jobs containing it, in increasing order
+ * @count: Number of IDs
+ * @capacity: Allocated length of @ids
+ */
+typedef struct JobTerm
+{
+        char *text;
+        int *ids;
+        size_t count;
+        size_t capacity;
+} JobTerm;
+
+/**
+ * struct JobIndex - Inverted index from words to job IDs
+ * @terms: Every term, in the order first seen
+ * @term_count: Number of terms
+ * @term_capacity: Allocated length of @terms and @sorted
+ * @slots: Hash table of term index + 1, 0 for an empty slot
+ * @slot_count: Number of slots, a power of two
+ * @sorted: Term indexes in alphabetical order, for prefix lookups
+ */
+typedef struct JobIndex
+{
+        JobTerm *terms;
+        size_t term_count;
+        size_t term_capacity;
+        size_t *slots;
+        size_t slot_count;
+        size_t *sorted;
+} JobIndex;
+
+/* Jobs summarised by each time index entry */
+#define JOB_TIME_STRIDE 64
+
+/**
+ * struct JobTimeEntry - Bounds on the posting times of JOB_TIME_STRIDE jobs
+ * @max_before: Latest time of any job before this entry's first one
+ * @min_after: Earliest time of any job from this entry's first one on
+ *
+ * Both bounds are monotonic across entries even when the jobs' own times
+ * are not, so both can be binary searched.
+ */
+typedef struct JobTimeEntry
+{
+        int64_t max_before;
+        int64_t min_after;
+} JobTimeEntry;
+
+/**
+ * struct JobTimeIndex - Sparse index from posting time to job ID
+ * @entries: One entry per JOB_TIME_STRIDE jobs, from ID 1
+ * @entry_count: Number of entries in use
+ * @entry_capacity: Allocated length of @entries
+ * @count: Number of jobs added
+ * @latest: Latest time of any job added
+ */
+typedef struct JobTimeIndex
+{
+        JobTimeEntry *entries;
+        size_t entry_count;
+        size_t entry_capacity;
+        int count;
+        int64_t latest;
+} JobTimeIndex;
+
+/**
+ * struct JobPostingCursor - Position in one list of job IDs
+ * @ids: IDs in increasing order, or NULL for the range [@low, @high)
+ * @low: First position still ahead of the cursor
+ * @high: One past the last position still ahead of the cursor
+ */
+typedef struct JobPostingCursor
+{
+        const int *ids;
+        size_t low;
+        size_t high;
+} JobPostingCursor;
+
+/**
+ * struct JobClause - Lists of which a matching job is in at least one
+ * @first: First cursor of the clause in JobQuery.postings
+ * @end: One past its last cursor
+ * @estimate: Total length of its lists, an upper bound on its matches
+ */
+typedef struct JobClause
+{
+        size_t first;
+        size_t end;
+        size_t estimate;
+} JobClause;
+
+/**
+ * struct JobQuery - Clauses, all of which a matching job satisfies
+ * @postings: Cursors of every clause
+ * @posting_count: Number of cursors
+ * @posting_capacity: Allocated length of @postings
+ * @clauses: Clauses, in evaluation order once planned
+ * @clause_count: Number of clauses
+ * @clause_capacity: Allocated length of @clauses
+ * @descending: Nonzero to stream from the highest ID down
+ * @current: Last ID returned, 0 before the first
+ * @done: Nonzero once every match has been returned
+ */
+typedef struct JobQuery
+{
+        JobPostingCursor *postings;
+        size_t posting_count;
+        size_t posting_capacity;
+        JobClause *clauses;
+        size_t clause_count;
+        size_t clause_capacity;
+        int descending;
+        int current;
+        int done;
+} JobQuery;
+
+void job_index_init(JobIndex *index);
+void job_index_free(JobIndex *index);
+int job_index_add(JobIndex *index, int id, const char *text);
+int job_index_add_value(JobIndex *index, int id, const char *text);
+void job_index_drop(JobIndex *index, int id);
+
+int job_time_index_add(JobTimeIndex *index, int64_t time);
+void job_time_index_range(const JobTimeIndex *index, int64_t from, int64_t to,
+                          int *first, int *last);
+void job_time_index_free(JobTimeIndex *index);
+
+void job_query_init(JobQuery *query, int descending);
+int job_query_add_words(const JobIndex *index, JobQuery *query, const char *text);
+int job_query_add_substring(const JobIndex *index, JobQuery *query, const char *text);
+int job_query_add_value(const JobIndex *index, JobQuery *query, const char *value);
+int job_query_add_range(JobQuery *query, int first, int last);
+void job_query_plan(JobQuery *query);
+int job_query_next(JobQuery *query);
+void job_query_free(JobQuery *query);
+
+#endif
@@ -0,0 +1,216 @@
+#include "job_match.h"
+#include <string.h>
+
+/*
+ * Case-insensitive substring search over job text. The vector kernels
+ * compare the first and last bytes of the needle against a whole block
+ * of candidate positions at once, with ASCII case folded by setting bit
+ * 0x20 (which folds a few punctuation pairs together too, so it only
+ * proposes candidates); each candidate is then compared in full. On
+ * x86-64 SSE2 is always available and AVX2 is used when the CPU has it;
+ * elsewhere the scalar kernel runs.
+ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define JOB_MATCH_X86 1
+#endif
+
+/**
+ * fold - Lowercase an ASCII letter
+ * @c: Byte
+ * Return: @c, lowercased if it is an uppercase ASCII letter
+ */
+static unsigned char fold(unsigned char c)
+{
+        return (c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+}
+
+/**
+ * same_folded - Whether text equals a lowercase needle, ignoring case
+ * @text: Text
+ * @needle: Lowercase needle
+ * @length: Bytes to compare
+ * Return: 1 if equal, 0 otherwise
+ */
+static int same_folded(const char *text, const char *needle, size_t length)
+{
+        size_t i;
+
+        for (i = 0; i < length; i++)
+        {
+                if (fold((unsigned char)text[i]) != (unsigned char)needle[i])
+                        return (0);
+        }
+        return (1);
+}
+
+/**
+ * match_scalar - Find the needle a byte at a time
+ * @matcher: Matcher
+ * @text: Text of @size bytes, ending at its first NUL or at @size
+ * @size: Size of @text, at least the needle's length
+ * @start: First position to try, not past the end of the text
+ * Return: First match at or after @start, or NULL
+ */
+static const char *match_scalar(const JobMatcher *matcher, const char *text, size_t size,
+                                size_t start)
+{
+        size_t n = matcher->length, i;
+        unsigned char first = (unsigned char)matcher->needle[0];
+
+        for (i = start; i + n <= size && text[i]; i++)
+        {
+                if (fold((unsigned char)text[i]) == first && same_folded(text + i, matcher->needle, n))
+                        return (text + i);
+        }
+        return (NULL);
+}
+
+#ifdef JOB_MATCH_X86
+
+/**
+ * match_sse2 - Find the needle sixteen positions at a time
+ * @matcher: Matcher
+ * @text: Text of @size bytes, ending at its first NUL or at @size
+ * @size: Size of @text, at least the needle's length
+ * Return: First match, or NULL
+ */
+static const char *match_sse2(const JobMatcher *matcher, const char *text, size_t size)
+{
+        size_t n = matcher->length, i;
+        const __m128i case_bit = _mm_set1_epi8(0x20);
+        const __m128i first = _mm_set1_epi8((char)(matcher->needle[0] | 0x20));
+        const __m128i last = _mm_set1_epi8((char)(matcher->needle[n - 1] | 0x20));
+        __m128i block;
+        unsigned int mask, end;
+
+        for (i = 0; i + n - 1 + 16 <= size; i += 16)
+        {
+                block = _mm_loadu_si128((const __m128i *)(text + i));
+                end = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128()));
+                mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(_mm_or_si128(block, case_bit), first),
+                    _mm_cmpeq_epi8(_mm_or_si128(_mm_loadu_si128((const __m128i *)(text + i + n - 1)),
+                                                case_bit),
+                                   last)));
+                /* Only positions before the end of the text can start a match */
+                if (end)
+                        mask &= (end & -end) - 1;
+                for (; mask; mask &= mask - 1)
+                {
+                        if (same_folded(text + i + __builtin_ctz(mask), matcher->needle, n))
+                                return (text + i + __builtin_ctz(mask));
+                }
+                if (end)
+                        return (NULL);
+        }
+        return (match_scalar(matcher, text, size, i));
+}
+
+/**
+ * match_avx2 - Find the needle thirty-two positions at a time
+ * @matcher: Matcher
+ * @text: Text of @size bytes, ending at its first NUL or at @size
+ * @size: Size of @text, at least the needle's length
+ * Return: First match, or NULL
+ */
+__attribute__((target("avx2")))
+static const char *match_avx2(const JobMatcher *matcher, const char *text, size_t size)
+{
+        size_t n = matcher->length, i;
+        const __m256i case_bit = _mm256_set1_epi8(0x20);
+        const __m256i first = _mm256_set1_epi8((char)(matcher->needle[0] | 0x20));
+        const __m256i last = _mm256_set1_epi8((char)(matcher->needle[n - 1] | 0x20));
+        __m256i block;
+        unsigned int mask, end;
+
+        for (i = 0; i + n - 1 + 32 <= size; i += 32)
+        {
+                block = _mm256_loadu_si256((const __m256i *)(text + i));
+                end = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_setzero_si256()));
+                mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(
+                    _mm256_cmpeq_epi8(_mm256_or_si256(block, case_bit), first),
+                    _mm256_cmpeq_epi8(_mm256_or_si256(_mm256_loadu_si256((const __m256i *)(text + i + n - 1)),
+                                                      case_bit),
+                                      last)));
+                if (end)
+                        mask &= (end & -end) - 1;
+                for (; mask; mask &= mask - 1)
+                {
+                        if (same_folded(text + i + __builtin_ctz(mask), matcher->needle, n))
+                                return (text + i + __builtin_ctz(mask));
+                }
+                if (end)
+                {
+                        _mm256_zeroupper();
+                        return (NULL);
+                }
+        }
+
+        /* Clear the upper halves so the SSE2 tail does not stall on them */
+        _mm256_zeroupper();
+        return (match_sse2(matcher, text + i, size - i));
+}
+
+#endif
+
+/**
+ * job_match_best_kernel - Fastest kernel this CPU can run
+ * Return: The kernel
+ */
+JobMatchKernel job_match_best_kernel(void)
+{
+#ifdef JOB_MATCH_X86
+        return (__builtin_cpu_supports("avx2") ? JOB_MATCH_AVX2 : JOB_MATCH_SSE2);
+#else
+        return (JOB_MATCH_SCALAR);
+#endif
+}
+
+/**
+ * job_matcher_init - Prepare to find a piece of text
+ * @matcher: Matcher to initialise
+ * @needle: Text to find; ASCII letters match either case
+ */
+void job_matcher_init(JobMatcher *matcher, const char *needle)
+{
+        size_t i;
+
+        matcher->length = strlen(needle);
+        for (i = 0; i < matcher->length && i < JOB_MATCH_MAX; i++)
+                matcher->needle[i] = (char)fold((unsigned char)needle[i]);
+        matcher->kernel = job_match_best_kernel();
+}
+
+/**
+ * job_match - Find a matcher's text in a piece of text
+ * @matcher: Matcher
+ * @text: Text to search, which ends at its first NUL or after @size
+ *        bytes, like a fixed-size field of a job listing
+ * @size: Bytes of @text that may be read
+ *
+ * The text is scanned once, for its end and the needle together, so a
+ * field needs no strlen() first.
+ *
+ * Return: First match in @text, or NULL if there is none
+ */
+const char *job_match(const JobMatcher *matcher, const char *text, size_t size)
+{
+        if (matcher->length > size || matcher->length >= JOB_MATCH_MAX)
+                return (NULL);
+        if (matcher->length == 0)
+                return (text);
+
+        switch (matcher->kernel)
+        {
+#ifdef JOB_MATCH_X86
+        case JOB_MATCH_AVX2:
+                return (match_avx2(matcher, text, size));
+        case JOB_MATCH_SSE2:
+                return (match_sse2(matcher, text, size));
+#endif
+        default:
+                return (match_scalar(matcher, text, size, 0));
+        }
+}
@@ -0,0 +1,34 @@
+#ifndef JOB_MATCH_H
+#define JOB_MATCH_H
+
+#include <stddef.h>
+
+/* Longest text a matcher looks for; longer text matches nothing */
+#define JOB_MATCH_MAX 512
+
+/* Implementations of job_match(), fastest last */
+typedef enum JobMatchKernel
+{
+        JOB_MATCH_SCALAR,
+        JOB_MATCH_SSE2,
+        JOB_MATCH_AVX2
+} JobMatchKernel;
+
+/**
+ * struct JobMatcher - Text to find, ignoring ASCII case
+ * @needle: The text in lowercase
+ * @length: Its length in bytes
+ * @kernel: Implementation job_match() uses
+ */
+typedef struct JobMatcher
+{
+        char needle[JOB_MATCH_MAX];
+        size_t length;
+        JobMatchKernel kernel;
+} JobMatcher;
+
+JobMatchKernel job_match_best_kernel(void);
+void job_matcher_init(JobMatcher *matcher, const char *needle);
+const char *job_match(const JobMatcher *matcher, const char *text, size_t size);
+
+#endif
@@ -0,0 +1,306 @@
+#define _XOPEN_SOURCE 700
+#include "blockchain_job.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * The job store is a file of fixed-size records after a one-page header.
+ * Each chunk of JOB_CHUNK_SIZE records is mapped into memory as one piece
+ * of the chain's storage, so opening a store reads nothing but the header
+ * and listings are used where they lie in the page cache. A new listing is
+ * written into its mapped record and flushed before the header's count
+ * takes it in, so a crash never leaves a counted but unwritten record.
+ */
+
+#define CHUNK_BYTES ((off_t)JOB_CHUNK_SIZE * JOB_RECORD_SIZE)
+
+/* The record layout is the file format */
+typedef char job_record_size_check[sizeof(JobListing) == JOB_RECORD_SIZE ? 1 : -1];
+
+/**
+ * chunk_offset - Where a chunk of records starts in the file
+ * @chunk: Chunk number
+ * Return: File offset
+ */
+static off_t chunk_offset(int chunk)
+{
+        return ((off_t)JOB_STORE_HEADER_SIZE + chunk * CHUNK_BYTES);
+}
+
+/**
+ * page_slack - Bytes between a file offset and the page boundary below it
+ * @offset: File offset
+ * Return: Bytes to map before @offset so that the mapping starts on a page
+ */
+static size_t page_slack(off_t offset)
+{
+        return ((size_t)(offset % sysconf(_SC_PAGESIZE)));
+}
+
+/**
+ * map_chunk - Map one chunk of records
+ * @chain: Blockchain with an open store
+ * @chunk: Chunk number; the file must already cover it
+ * Return: First record of the chunk, or NULL on failure
+ */
+static JobListing *map_chunk(JobBlockchain *chain, int chunk)
+{
+        off_t offset = chunk_offset(chunk);
+        size_t slack = page_slack(offset);
+        char *base;
+
+        base = mmap(NULL, CHUNK_BYTES + slack, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    chain->fd, offset - slack);
+        if (base == MAP_FAILED)
+        {
+                printf("Error mapping job store: %s\n", strerror(errno));
+                return (NULL);
+        }
+        return ((JobListing *)(base + slack));
+}
+
+/**
+ * sync_range - Flush part of a mapping to disk
+ * @address: Start of the bytes to flush
+ * @length: Number of bytes
+ * Return: 1 on success, 0 on failure
+ */
+static int sync_range(const void *address, size_t length)
+{
+        size_t slack = (size_t)((uintptr_t)address % sysconf(_SC_PAGESIZE));
+
+        if (msync((char *)address - slack, length + slack, MS_SYNC) != 0)
+        {
+                printf("Error writing job store: %s\n", strerror(errno));
+                return (0);
+        }
+        return (1);
+}
+
+/**
+ * create_header - Write the header of an empty store
+ * @fd: Empty store file
+ * Return: 1 on success, 0 on failure
+ */
+static int create_header(int fd)
+{
+        JobStoreHeader header;
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, JOB_STORE_MAGIC, sizeof(header.magic));
+        header.version = JOB_STORE_VERSION;
+        header.record_size = JOB_RECORD_SIZE;
+        header.chunk_size = JOB_CHUNK_SIZE;
+
+        if (ftruncate(fd, JOB_STORE_HEADER_SIZE) != 0 ||
+            pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || fsync(fd) != 0)
+        {
+                printf("Error creating job store: %s\n", strerror(errno));
+                return (0);
+        }
+        return (1);
+}
+
+/**
+ * check_header - Validate a store's header against its file size
+ * @header: Mapped header
+ * @size: File size
+ * Return: 1 if the store can be opened, 0 otherwise
+ */
+static int check_header(const JobStoreHeader *header, off_t size)
+{
+        uint64_t chunks;
+
+        if (memcmp(header->magic, JOB_STORE_MAGIC, sizeof(header->magic)) != 0)
+        {
+                printf("Error: not a job store\n");
+                return (0);
+        }
+        if (header->version != JOB_STORE_VERSION || header->record_size != JOB_RECORD_SIZE ||
+            header->chunk_size != JOB_CHUNK_SIZE)
+        {
+                printf("Error: unsupported job store version %u\n", header->version);
+                return (0);
+        }
+
+        chunks = (header->count + JOB_CHUNK_SIZE - 1) / JOB_CHUNK_SIZE;
+        if (header->count > INT_MAX || size < chunk_offset((int)chunks))
+        {
+                printf("Error: job store is truncated\n");
+                return (0);
+        }
+        return (1);
+}
+
+/**
+ * job_store_open - Attach a job store to an empty chain
+ * @chain: Chain from initialize_blockchain(), with no listings
+ * @path: Store file; created if missing
+ *
+ * The store stays locked against other processes until job_store_close().
+ *
+ * Return: 1 on success, 0 on failure (the chain is left without a store)
+ */
+int job_store_open(JobBlockchain *chain, const char *path)
+{
+        JobListing **chunks;
+        struct flock lock;
+        struct stat info;
+        void *header;
+        int chunk_count;
+
+        chain->fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (chain->fd < 0)
+        {
+                printf("Error opening %s: %s\n", path, strerror(errno));
+                return (0);
+        }
+
+        memset(&lock, 0, sizeof(lock));
+        lock.l_type = F_WRLCK;
+        lock.l_whence = SEEK_SET;
+        if (fcntl(chain->fd, F_SETLK, &lock) != 0)
+        {
+                printf("Error: %s is in use by another process\n", path);
+                job_store_close(chain);
+                return (0);
+        }
+
+        if (fstat(chain->fd, &info) != 0 || (info.st_size == 0 && !create_header(chain->fd)) ||
+            fstat(chain->fd, &info) != 0 || info.st_size < JOB_STORE_HEADER_SIZE)
+        {
+                printf("Error: %s is not a job store\n", path);
+                job_store_close(chain);
+                return (0);
+        }
+
+        header = mmap(NULL, JOB_STORE_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, chain->fd, 0);
+        if (header == MAP_FAILED)
+        {
+                printf("Error mapping %s: %s\n", path, strerror(errno));
+                job_store_close(chain);
+                return (0);
+        }
+        chain->store = header;
+        if (!check_header(chain->store, info.st_size))
+        {
+                job_store_close(chain);
+                return (0);
+        }
+
+        chunk_count = (int)((chain->store->count + JOB_CHUNK_SIZE - 1) / JOB_CHUNK_SIZE);
+        if (chunk_count)
+        {
+                chunks = malloc(chunk_count * sizeof(JobListing *));
+                if (chunks == NULL)
+                {
+                        job_store_close(chain);
+                        return (0);
+                }
+                chain->chunks = chunks;
+                chain->chunk_capacity = chunk_count;
+        }
+
+        while (chain->chunk_count < chunk_count)
+        {
+                chain->chunks[chain->chunk_count] = map_chunk(chain, chain->chunk_count);
+                if (chain->chunks[chain->chunk_count] == NULL)
+                {
+                        job_store_close(chain);
+                        return (0);
+                }
+                chain->chunk_count++;
+        }
+
+        chain->count = (int)chain->store->count;
+        return (1);
+}
+
+/**
+ * job_store_grow - Extend the store by one chunk and map it
+ * @chain: Blockchain with an open store
+ * Return: First record of the new chunk, or NULL on failure
+ */
+JobListing *job_store_grow(JobBlockchain *chain)
+{
+        if (ftruncate(chain->fd, chunk_offset(chain->chunk_count + 1)) != 0 || fsync(chain->fd) != 0)
+        {
+                printf("Error growing job store: %s\n", strerror(errno));
+                return (NULL);
+        }
+        return (map_chunk(chain, chain->chunk_count));
+}
+
+/**
+ * job_store_commit - Make a new listing durable
+ * @chain: Blockchain, already counting the listing
+ * @job: Listing just written to the last record
+ * Return: 1 on success or without a store, 0 if the store could not be
+ *         written (the listing is not counted in the store)
+ */
+int job_store_commit(JobBlockchain *chain, const JobListing *job)
+{
+        return (job_store_commit_range(chain, job->id, job->id + 1));
+}
+
+/**
+ * job_store_commit_range - Make a run of new listings durable at once
+ * @chain: Blockchain, already counting the listings
+ * @first: ID of the first listing just written
+ * @last: ID after the last one; the store then counts @last - 1 listings
+ *
+ * The records are flushed one chunk at a time before the header is, so a
+ * batch costs two flushes per chunk it touches rather than per listing.
+ *
+ * Return: 1 on success or without a store, 0 if the store could not be
+ *         written (none of the listings are counted in the store)
+ */
+int job_store_commit_range(JobBlockchain *chain, int first, int last)
+{
+        int id, end;
+
+        if (chain->fd < 0)
+                return (1);
+        for (id = first; id < last; id = end)
+        {
+                end = ((id - 1) / JOB_CHUNK_SIZE + 1) * JOB_CHUNK_SIZE + 1;
+                if (end > last)
+                        end = last;
+                if (!sync_range(get_job(chain, id), (size_t)(end - id) * sizeof(JobListing)))
+                        return (0);
+        }
+
+        chain->store->count = (uint64_t)last - 1;
+        if (!sync_range(chain->store, sizeof(JobStoreHeader)))
+        {
+                chain->store->count = (uint64_t)first - 1;
+                return (0);
+        }
+        return (1);
+}
+
+/**
+ * job_store_close - Unmap every chunk and close the store
+ * @chain: Blockchain; its chunks are unmapped but @chunks is not freed
+ */
+void job_store_close(JobBlockchain *chain)
+{
+        int i;
+
+        for (i = 0; i < chain->chunk_count; i++)
+                munmap((char *)chain->chunks[i] - page_slack(chunk_offset(i)),
+                       CHUNK_BYTES + page_slack(chunk_offset(i)));
+        chain->chunk_count = 0;
+
+        if (chain->store != NULL)
+                munmap(chain->store, JOB_STORE_HEADER_SIZE);
+        chain->store = NULL;
+
+        if (chain->fd >= 0)
+                close(chain->fd);
+        chain->fd = -1;
+}
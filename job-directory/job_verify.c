@@ -0,0 +1,274 @@
+#define _XOPEN_SOURCE 700
+#include "blockchain_job.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/*
+ * The chain is verified a window of listings at a time. Threads split the
+ * window, recompute each listing's hash into their own buffer and compare
+ * its prevHash with the stored hash of the listing before it, leaving one
+ * status byte per listing; the listings themselves are only read. The
+ * calling thread then reports the window's failures in ID order, so the
+ * report streams out while memory stays bounded by the window.
+ */
+
+#define VERIFY_MAX_THREADS 8
+#define VERIFY_WINDOW 16384
+#define VERIFY_MIN_RANGE 256
+
+/* Status bits of a checked listing */
+#define VERIFY_HASH_BAD 1
+#define VERIFY_LINK_BAD 2
+
+/**
+ * struct VerifyWorker - One thread's share of a window
+ * @chain: Blockchain being verified
+ * @first: First ID to check
+ * @last: ID after the last one to check
+ * @status: Receives the status of @first onwards
+ * @ok: Set to 0 if the thread could not allocate a hashing context
+ */
+typedef struct VerifyWorker
+{
+        JobBlockchain *chain;
+        int first;
+        int last;
+        unsigned char *status;
+        int ok;
+} VerifyWorker;
+
+/**
+ * check_jobs - Check the hash and link of a range of listings
+ * @arg: VerifyWorker
+ * Return: NULL
+ */
+static void *check_jobs(void *arg)
+{
+        VerifyWorker *worker = arg;
+        const JobListing *job;
+        const char *previous;
+        char hash[HASH_LENGTH + 1];
+        JobHasher hasher;
+        int id;
+
+        worker->ok = job_hasher_init(&hasher);
+        for (id = worker->first; worker->ok && id < worker->last; id++)
+        {
+                job = get_job(worker->chain, id);
+                previous = id > 1 ? get_job(worker->chain, id - 1)->currentHash : GENESIS_PREV_HASH;
+                job_hash_with(&hasher, job, hash);
+
+                worker->status[id - worker->first] =
+                    (memcmp(hash, job->currentHash, sizeof(hash)) ? VERIFY_HASH_BAD : 0) |
+                    (memcmp(previous, job->prevHash, sizeof(hash)) ? VERIFY_LINK_BAD : 0);
+        }
+
+        if (worker->ok)
+                job_hasher_free(&hasher);
+        return (NULL);
+}
+
+/**
+ * check_window - Check a window of listings across threads
+ * @chain: Blockchain
+ * @first: First ID of the window
+ * @last: ID after the last one of the window
+ * @status: Receives one status byte per listing of the window
+ * Return: 1 on success, 0 if a thread could not allocate a hashing context
+ */
+static int check_window(JobBlockchain *chain, int first, int last, unsigned char *status)
+{
+        VerifyWorker workers[VERIFY_MAX_THREADS];
+        pthread_t threads[VERIFY_MAX_THREADS];
+        int started[VERIFY_MAX_THREADS];
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int count = last - first, thread_count, t, ok = 1;
+
+        thread_count = cpus > 0 ? (int)cpus : 1;
+        if (thread_count > VERIFY_MAX_THREADS)
+                thread_count = VERIFY_MAX_THREADS;
+        if (thread_count > (count + VERIFY_MIN_RANGE - 1) / VERIFY_MIN_RANGE)
+                thread_count = (count + VERIFY_MIN_RANGE - 1) / VERIFY_MIN_RANGE;
+
+        for (t = 0; t < thread_count; t++)
+        {
+                workers[t].chain = chain;
+                workers[t].first = first + (int)((long)count * t / thread_count);
+                workers[t].last = first + (int)((long)count * (t + 1) / thread_count);
+                workers[t].status = status + (workers[t].first - first);
+                started[t] = t > 0 && pthread_create(&threads[t], NULL, check_jobs, &workers[t]) == 0;
+        }
+
+        /* The calling thread takes the first range and any that failed to start */
+        for (t = 0; t < thread_count; t++)
+        {
+                if (!started[t])
+                        check_jobs(&workers[t]);
+        }
+        for (t = 0; t < thread_count; t++)
+        {
+                if (started[t])
+                        pthread_join(threads[t], NULL);
+        }
+        for (t = 0; t < thread_count; t++)
+                ok &= workers[t].ok;
+        return (ok);
+}
+
+/**
+ * print_hash - Write a stored hash, masking anything that is not hex
+ * @sink: Stream
+ * @hash: Hash field of HASH_LENGTH + 1 bytes, possibly damaged
+ */
+static void print_hash(FILE *sink, const char *hash)
+{
+        int i;
+
+        for (i = 0; i < HASH_LENGTH && hash[i]; i++)
+                fputc(strchr("0123456789abcdef", hash[i]) ? hash[i] : '?', sink);
+}
+
+/**
+ * report_hash - Report a listing whose stored hash is wrong
+ * @options: Report options
+ * @job: Listing
+ */
+static void report_hash(const VerifyOptions *options, const JobListing *job)
+{
+        char hash[HASH_LENGTH + 1];
+
+        job_hash(job, hash);
+        if (options->format == VERIFY_JSON)
+        {
+                fprintf(options->sink, "{\"block\":%d,\"error\":\"hash\",\"stored\":\"", job->id);
+                print_hash(options->sink, job->currentHash);
+                fprintf(options->sink, "\",\"computed\":\"%s\"}\n", hash);
+                return;
+        }
+
+        fprintf(options->sink, "Block #%d: HASH TAMPERING: Recalculated hash doesn't match stored hash\n",
+                job->id);
+        fprintf(options->sink, "  Stored hash: ");
+        print_hash(options->sink, job->currentHash);
+        fprintf(options->sink, "\n  Recalculated hash: %s\n", hash);
+}
+
+/**
+ * report_link - Report a listing whose prevHash does not match
+ * @options: Report options
+ * @job: Listing
+ * @previous: Stored hash of the listing before it, or the genesis hash
+ */
+static void report_link(const VerifyOptions *options, const JobListing *job, const char *previous)
+{
+        if (options->format == VERIFY_JSON)
+        {
+                fprintf(options->sink, "{\"block\":%d,\"error\":\"link\",\"previous\":\"", job->id);
+                print_hash(options->sink, previous);
+                fprintf(options->sink, "\",\"prevHash\":\"");
+                print_hash(options->sink, job->prevHash);
+                fprintf(options->sink, "\"}\n");
+                return;
+        }
+
+        if (job->id == 1)
+                fprintf(options->sink, "Block #1: HASH MISMATCH: First block does not start the chain\n");
+        else
+                fprintf(options->sink, "Block #%d -> Block #%d: HASH MISMATCH: Chain integrity compromised\n",
+                        job->id - 1, job->id);
+        fprintf(options->sink, "  Previous block hash: ");
+        print_hash(options->sink, previous);
+        fprintf(options->sink, "\n  Block prevHash: ");
+        print_hash(options->sink, job->prevHash);
+        fprintf(options->sink, "\n");
+}
+
+/**
+ * verify_chain - Check every listing's hash and link to the one before
+ * @chain: Blockchain to verify; not modified
+ * @options: Where and how to report, and whether to stop at the first
+ *           failure
+ * Return: 1 if intact, 0 if compromised, -1 if the report could not be
+ *         written or memory ran out
+ */
+int verify_chain(JobBlockchain *chain, const VerifyOptions *options)
+{
+        unsigned char status[VERIFY_WINDOW];
+        const JobListing *job;
+        int first, last, id, checked = 0, failures = 0, stop = 0;
+
+        if (options->format == VERIFY_TEXT)
+                fprintf(options->sink, "=== BLOCKCHAIN INTEGRITY VERIFICATION ===\n\n");
+
+        for (first = 1; first <= chain->count && !stop; first = last)
+        {
+                last = chain->count - first < VERIFY_WINDOW ? chain->count + 1 : first + VERIFY_WINDOW;
+                if (!check_window(chain, first, last, status))
+                {
+                        printf("Error: out of memory while verifying\n");
+                        return (-1);
+                }
+
+                for (id = first; id < last && !stop; id++)
+                {
+                        checked = id;
+                        if (!status[id - first])
+                                continue;
+
+                        job = get_job(chain, id);
+                        if (status[id - first] & VERIFY_HASH_BAD)
+                        {
+                                report_hash(options, job);
+                                failures++;
+                        }
+                        if ((status[id - first] & VERIFY_LINK_BAD) &&
+                            !(options->stop_at_first && failures))
+                        {
+                                report_link(options, job,
+                                            id > 1 ? get_job(chain, id - 1)->currentHash : GENESIS_PREV_HASH);
+                                failures++;
+                        }
+                        stop = options->stop_at_first && failures;
+                }
+        }
+
+        if (options->format == VERIFY_JSON)
+                fprintf(options->sink, "{\"checked\":%d,\"total\":%d,\"failures\":%d,\"intact\":%s}\n",
+                        checked, chain->count, failures, failures ? "false" : "true");
+        else
+        {
+                fprintf(options->sink, "\n=== VERIFICATION SUMMARY ===\n");
+                fprintf(options->sink, "Blocks checked: %d of %d\n", checked, chain->count);
+                fprintf(options->sink, "Failures: %d\n", failures);
+                fprintf(options->sink, "Blockchain integrity: %s\n", failures ? "COMPROMISED" : "INTACT");
+        }
+
+        if (fflush(options->sink) != 0 || ferror(options->sink))
+                return (-1);
+        return (failures == 0);
+}
+
+/**
+ * verify_integrity - Check blockchain integrity and write results to file
+ * @chain: Blockchain to verify
+ * Return: 1 if intact, 0 if compromised, -1 if output.txt cannot be written
+ */
+int verify_integrity(JobBlockchain *chain)
+{
+        VerifyOptions options;
+        int result;
+
+        options.sink = fopen("output.txt", "w");
+        options.format = VERIFY_TEXT;
+        options.stop_at_first = 0;
+        if (options.sink == NULL)
+        {
+                perror("Error opening output.txt");
+                return (-1);
+        }
+
+        result = verify_chain(chain, &options);
+        if (fclose(options.sink) != 0)
+                result = -1;
+        return (result);
+}
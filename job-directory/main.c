@@ -0,0 +1,295 @@
+#include "blockchain_job.h"
+
+/* Search results shown at a time */
+#define JOB_PAGE_SIZE 5
+
+/**
+ * clear_input_buffer - Clears input buffer
+ */
+void clear_input_buffer(void)
+{
+        int c;
+        while ((c = getchar()) != '\n' && c != EOF)
+                ;
+}
+
+/**
+ * get_string_input - Gets string input safely
+ * @prompt: Prompt to display
+ * @buffer: Buffer to store input
+ * @size: Size of buffer
+ */
+void get_string_input(const char *prompt, char *buffer, size_t size)
+{
+        printf("%s", prompt);
+        if (fgets(buffer, size, stdin) != NULL)
+        {
+                size_t len = strlen(buffer);
+                if (len > 0 && buffer[len - 1] == '\n')
+                        buffer[len - 1] = '\0';
+        }
+}
+
+/**
+ * display_menu - Displays main menu
+ */
+void display_menu(void)
+{
+        printf("\n=== Blockchain Job Directory ===\n");
+        printf("1. Add new job listing\n");
+        printf("2. View all job listings\n");
+        printf("3. Search jobs\n");
+        printf("4. Verify blockchain integrity\n");
+        printf("5. Exit\n");
+        printf("Enter your choice (1-5): ");
+}
+
+/**
+ * verify_command - Verify the chain and stream the report to stdout
+ * @chain: Blockchain
+ * @argc: Number of arguments after --verify
+ * @argv: "text" or "json", and "--first" to stop at the first failure
+ * Return: 0 if intact, 1 if compromised or on bad arguments
+ */
+int verify_command(JobBlockchain *chain, int argc, char **argv)
+{
+        VerifyOptions options;
+        int i;
+
+        options.sink = stdout;
+        options.format = VERIFY_TEXT;
+        options.stop_at_first = 0;
+        for (i = 0; i < argc; i++)
+        {
+                if (strcmp(argv[i], "json") == 0)
+                        options.format = VERIFY_JSON;
+                else if (strcmp(argv[i], "--first") == 0)
+                        options.stop_at_first = 1;
+                else if (strcmp(argv[i], "text") != 0)
+                {
+                        printf("Usage: job_directory.exe --verify [text|json] [--first]\n");
+                        return (1);
+                }
+        }
+        return (verify_chain(chain, &options) == 1 ? 0 : 1);
+}
+
+/**
+ * import_command - Import a CSV or JSON Lines feed and report throughput
+ * @chain: Blockchain
+ * @argc: Number of arguments after --import
+ * @argv: Feed file, "-" for standard input, then optionally "csv" or
+ *        "jsonl"; without one, a .jsonl or .ndjson file is JSON Lines
+ * Return: 0 on success, 1 on failure or bad arguments
+ */
+int import_command(JobBlockchain *chain, int argc, char **argv)
+{
+        ImportFormat format = IMPORT_CSV;
+        ImportStats stats;
+        const char *dot;
+        FILE *feed;
+        int ok;
+
+        if (argc < 1 || argc > 2 || (argc == 2 && strcmp(argv[1], "csv") != 0 &&
+                                     strcmp(argv[1], "jsonl") != 0))
+        {
+                printf("Usage: job_directory.exe --import <file|-> [csv|jsonl]\n");
+                return (1);
+        }
+        dot = strrchr(argv[0], '.');
+        if (argc == 2 ? strcmp(argv[1], "jsonl") == 0
+                      : dot != NULL && (strcmp(dot, ".jsonl") == 0 || strcmp(dot, ".ndjson") == 0))
+                format = IMPORT_JSONL;
+
+        feed = strcmp(argv[0], "-") == 0 ? stdin : fopen(argv[0], "r");
+        if (feed == NULL)
+        {
+                perror(argv[0]);
+                return (1);
+        }
+        ok = import_jobs(chain, feed, format, &stats);
+        if (feed != stdin)
+                fclose(feed);
+
+        printf("Imported %d job listings, skipped %d, in %.3f s\n", stats.imported, stats.skipped,
+               stats.total_seconds);
+        if (stats.imported > 0)
+        {
+                /* A small feed can finish within the clock's resolution */
+                if (stats.total_seconds > 0)
+                        printf("  %.0f listings/s, %.2f us per listing\n",
+                               stats.imported / stats.total_seconds,
+                               stats.total_seconds * 1e6 / stats.imported);
+                printf("  parse %.2f us, digest %.2f us, link, store and index %.2f us per listing\n",
+                       stats.parse_seconds * 1e6 / stats.imported,
+                       stats.digest_seconds * 1e6 / stats.imported,
+                       stats.link_seconds * 1e6 / stats.imported);
+        }
+        printf("The chain now holds %d job listings.\n", chain->count);
+        return (ok ? 0 : 1);
+}
+
+/**
+ * main - Entry point
+ * @argc: Argument count
+ * @argv: Arguments; "--verify [text|json] [--first]" verifies the stored
+ *        chain and exits instead of showing the menu; "--import <file>
+ *        [csv|jsonl]" appends a feed of listings and exits
+ * Return: 0 on success, 1 on failure
+ */
+int main(int argc, char **argv)
+{
+        JobBlockchain *chain = open_blockchain(JOB_STORE_PATH);
+        JobListing *page_jobs[JOB_PAGE_SIZE];
+        JobSearch search;
+        JobPage page;
+        size_t i;
+        int choice, id, status;
+        char title[MAX_TITLE_LENGTH];
+        char company[MAX_COMPANY_LENGTH];
+        char location[MAX_LOCATION_LENGTH];
+        char description[MAX_DESCRIPTION_LENGTH];
+        char keyword[100];
+        char text[100];
+        char answer[8];
+
+        if (chain == NULL)
+        {
+                printf("Failed to open blockchain\n");
+                return (1);
+        }
+
+        if (argc > 1 && strcmp(argv[1], "--verify") == 0)
+        {
+                status = verify_command(chain, argc - 2, argv + 2);
+                free_blockchain(chain);
+                return (status);
+        }
+
+        if (argc > 1 && strcmp(argv[1], "--import") == 0)
+        {
+                status = import_command(chain, argc - 2, argv + 2);
+                free_blockchain(chain);
+                return (status);
+        }
+
+        if (chain->count > 0)
+        {
+                printf("Loaded %d job listings from %s.\n", chain->count, JOB_STORE_PATH);
+        }
+        else
+        {
+                /* Initialize with sample job listings */
+                add_job_listing(chain, "Backend Developer", "TechFlow Inc",
+                                "Remote", "Looking for a skilled backend developer with 3+ years of "
+                                          "experience in Python, Django, and PostgreSQL. Knowledge of RESTful "
+                                          "APIs and microservices architecture required.");
+
+                add_job_listing(chain, "Data Engineer", "DataMinds Corp",
+                                "New York, NY", "Seeking experienced data engineer for ETL pipeline "
+                                                "development. Must have strong SQL skills and experience with Apache "
+                                                "Spark and AWS services. Big data experience is a plus.");
+
+                add_job_listing(chain, "DevOps Specialist", "CloudNet Solutions",
+                                "San Francisco, CA", "Join our team as a DevOps specialist. "
+                                                     "Experience with Docker, Kubernetes, and CI/CD pipelines required. "
+                                                     "AWS certification preferred.");
+
+                printf("Initialized blockchain with 3 sample job listings.\n");
+        }
+
+        while (1)
+        {
+                display_menu();
+                if (scanf("%d", &choice) != 1)
+                {
+                        printf("Invalid input. Please enter a number.\n");
+                        clear_input_buffer();
+                        continue;
+                }
+                clear_input_buffer();
+
+                switch (choice)
+                {
+                case 1:
+                        printf("\n=== Add New Job Listing ===\n");
+                        get_string_input("Enter job title: ", title, MAX_TITLE_LENGTH);
+                        get_string_input("Enter company name: ", company, MAX_COMPANY_LENGTH);
+                        get_string_input("Enter location: ", location, MAX_LOCATION_LENGTH);
+                        get_string_input("Enter job description: ", description, MAX_DESCRIPTION_LENGTH);
+
+                        if (add_job_listing(chain, title, company, location, description))
+                                printf("Job listing added successfully!\n");
+                        else
+                                printf("Failed to add job listing.\n");
+                        break;
+
+                case 2:
+                        printf("\n=== All Job Listings ===\n");
+                        if (chain->count == 0)
+                                printf("No job listings found.\n");
+                        for (id = 1; id <= chain->count; id++)
+                                print_job(get_job(chain, id));
+                        break;
+
+                case 3:
+                        printf("\n=== Search Jobs ===\n");
+                        job_search_init(&search);
+                        get_string_input("Enter search keywords (OR, prefix*): ", keyword, sizeof(keyword));
+                        get_string_input("Text to find, even inside words (blank for any): ", text, sizeof(text));
+                        get_string_input("Company (blank for any): ", company, MAX_COMPANY_LENGTH);
+                        get_string_input("Location (blank for any): ", location, MAX_LOCATION_LENGTH);
+                        get_string_input("Posted within the last N days (blank for any): ",
+                                         answer, sizeof(answer));
+                        if (atoi(answer) > 0)
+                                search.from = (int64_t)time(NULL) - (int64_t)atoi(answer) * 86400;
+                        get_string_input("Order: 1. by ID  2. newest first  3. oldest first [1]: ",
+                                         answer, sizeof(answer));
+                        search.query = keyword;
+                        search.contains = text[0] ? text : NULL;
+                        search.company = company[0] ? company : NULL;
+                        search.location = location[0] ? location : NULL;
+                        search.order = answer[0] == '2' ? JOB_ORDER_NEWEST
+                                       : answer[0] == '3' ? JOB_ORDER_OLDEST : JOB_ORDER_ID;
+                        search.limit = JOB_PAGE_SIZE;
+                        page.jobs = page_jobs;
+
+                        do
+                        {
+                                if (!search_jobs(chain, &search, &page))
+                                {
+                                        printf("Search failed: out of memory.\n");
+                                        break;
+                                }
+                                if (search.offset == 0 && page.count == 0)
+                                        printf("No matching jobs found.\n");
+                                for (i = 0; i < page.count; i++)
+                                        print_job(page.jobs[i]);
+                                search.offset += page.count;
+                                answer[0] = '\0';
+                                if (page.more)
+                                        get_string_input("\nShow more results? (y/n): ", answer, sizeof(answer));
+                        } while (answer[0] == 'y' || answer[0] == 'Y');
+                        break;
+
+                case 4:
+                        printf("\n=== Blockchain Integrity Check ===\n");
+                        status = verify_integrity(chain);
+                        if (status == 1)
+                                printf("Blockchain integrity verified: No tampering detected\n");
+                        else if (status == 0)
+                                printf("Warning: Blockchain integrity compromised! See output.txt\n");
+                        else
+                                printf("Could not write the integrity report.\n");
+                        break;
+
+                case 5:
+                        printf("\nExiting program. Goodbye!\n");
+                        free_blockchain(chain);
+                        return (0);
+
+                default:
+                        printf("Invalid choice. Please try again.\n");
+                }
+        }
+}
\ No newline at end of file
@@ -0,0 +1,2 @@
+gcc -Wall -Wextra -I. test/test_job_directory.c blockchain_job.c job_index.c job_store.c job_verify.c job_import.c job_match.c -o test_job_directory -lssl -lcrypto -pthread
+./test_job_directory
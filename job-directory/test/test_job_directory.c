@@ -0,0 +1,429 @@
+#define _XOPEN_SOURCE 700
+#include "blockchain_job.h"
+#include <fcntl.h>
+#include <stddef.h>
+#include <strings.h>
+#include <unistd.h>
+
+/*
+ * Tests for the job store, the verifier, paged search, feed import and
+ * the substring matcher. Every failed check is reported with its line,
+ * and the exit status is the number of tests that failed.
+ */
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static int failed_checks;
+
+/**
+ * check - Record the outcome of one check
+ * @ok: Whether the check passed
+ * @text: The condition, as written
+ * @line: Line of the check
+ */
+static void check(int ok, const char *text, int line)
+{
+        if (ok)
+                return;
+        printf("  line %d: %s\n", line, text);
+        failed_checks++;
+}
+
+/**
+ * store_path - Create a scratch directory and name a store inside it
+ * @directory: mkdtemp() template, replaced by the directory's name
+ * @path: Receives the path of the store
+ * Return: 1 on success, 0 on failure
+ */
+static int store_path(char *directory, char *path)
+{
+        if (mkdtemp(directory) == NULL)
+                return (0);
+        sprintf(path, "%s/%s", directory, JOB_STORE_PATH);
+        return (1);
+}
+
+/**
+ * remove_store - Delete a scratch store and its directory
+ * @directory: Directory from store_path()
+ * @path: Store
+ */
+static void remove_store(const char *directory, const char *path)
+{
+        unlink(path);
+        rmdir(directory);
+}
+
+/**
+ * verify_quietly - Verify a chain, discarding the report
+ * @chain: Blockchain
+ * @format: Report format
+ * @report: Buffer that receives the start of the report, or NULL
+ * @size: Size of @report
+ * Return: verify_chain()'s result
+ */
+static int verify_quietly(JobBlockchain *chain, VerifyFormat format, char *report, size_t size)
+{
+        VerifyOptions options;
+        size_t length;
+        int result;
+
+        options.sink = tmpfile();
+        options.format = format;
+        options.stop_at_first = 0;
+        if (options.sink == NULL)
+                return (-1);
+
+        result = verify_chain(chain, &options);
+        if (report != NULL)
+        {
+                rewind(options.sink);
+                length = fread(report, 1, size - 1, options.sink);
+                report[length] = '\0';
+        }
+        fclose(options.sink);
+        return (result);
+}
+
+/**
+ * test_store_reopens - A reopened store keeps its listings and hashes
+ */
+static void test_store_reopens(void)
+{
+        char directory[] = "/tmp/test_jobsXXXXXX", path[64], title[32];
+        char hashes[4][HASH_LENGTH + 1];
+        const int ids[4] = {1, JOB_CHUNK_SIZE, JOB_CHUNK_SIZE + 1, JOB_CHUNK_SIZE + 44};
+        JobBlockchain *chain;
+        int i;
+
+        CHECK(store_path(directory, path));
+        chain = open_blockchain(path);
+        CHECK(chain != NULL);
+        if (chain == NULL)
+                return;
+
+        /* Enough listings to fill one chunk and start the next */
+        for (i = 1; i <= ids[3]; i++)
+        {
+                sprintf(title, "Engineer %d", i);
+                CHECK(add_job_listing(chain, title, "Acme", "Kigali", "Builds things"));
+        }
+        for (i = 0; i < 4; i++)
+                strcpy(hashes[i], get_job(chain, ids[i])->currentHash);
+        free_blockchain(chain);
+
+        chain = open_blockchain(path);
+        CHECK(chain != NULL);
+        if (chain != NULL)
+        {
+                CHECK(chain->count == ids[3]);
+                for (i = 0; i < 4; i++)
+                {
+                        CHECK(get_job(chain, ids[i])->id == ids[i]);
+                        CHECK(strcmp(get_job(chain, ids[i])->currentHash, hashes[i]) == 0);
+                }
+                CHECK(strcmp(get_job(chain, JOB_CHUNK_SIZE + 1)->title, "Engineer 257") == 0);
+                CHECK(verify_quietly(chain, VERIFY_TEXT, NULL, 0) == 1);
+
+                /* Listings added after a reopen link onto the stored ones */
+                CHECK(add_job_listing(chain, "Late", "Acme", "Kigali", "Joins the chain"));
+                CHECK(strcmp(get_job(chain, ids[3] + 1)->prevHash, hashes[3]) == 0);
+                free_blockchain(chain);
+        }
+        remove_store(directory, path);
+}
+
+/**
+ * test_tampering_detected - verify_chain() finds an edited record
+ */
+static void test_tampering_detected(void)
+{
+        char directory[] = "/tmp/test_jobsXXXXXX", path[64], report[1024];
+        JobBlockchain *chain;
+        off_t offset;
+        int fd, i;
+
+        CHECK(store_path(directory, path));
+        chain = open_blockchain(path);
+        CHECK(chain != NULL);
+        if (chain == NULL)
+                return;
+        for (i = 0; i < 8; i++)
+                CHECK(add_job_listing(chain, "Analyst", "Globex", "Lagos", "Reads numbers"));
+        free_blockchain(chain);
+
+        /* Change the title of listing 5 behind the store's back */
+        offset = JOB_STORE_HEADER_SIZE + 4 * JOB_RECORD_SIZE + offsetof(JobListing, title);
+        fd = open(path, O_WRONLY);
+        CHECK(fd >= 0);
+        CHECK(pwrite(fd, "C", 1, offset) == 1);
+        close(fd);
+
+        chain = open_blockchain(path);
+        CHECK(chain != NULL);
+        if (chain != NULL)
+        {
+                CHECK(strcmp(get_job(chain, 5)->title, "Cnalyst") == 0);
+                CHECK(verify_quietly(chain, VERIFY_JSON, report, sizeof(report)) == 0);
+                CHECK(strstr(report, "{\"block\":5,\"error\":\"hash\"") != NULL);
+                CHECK(strstr(report, "\"block\":4,") == NULL);
+                CHECK(strstr(report, "\"block\":6,") == NULL);
+                CHECK(strstr(report, "\"failures\":1,\"intact\":false") != NULL);
+                free_blockchain(chain);
+        }
+        remove_store(directory, path);
+}
+
+/**
+ * page_ids - Run a search and list the IDs on the page
+ * @chain: Blockchain
+ * @search: Search
+ * @ids: Receives the IDs, as "3,1,2"
+ * Return: The page's more flag, or -1 if the search failed
+ */
+static int page_ids(JobBlockchain *chain, const JobSearch *search, char *ids)
+{
+        JobListing *jobs[16];
+        JobPage page;
+        size_t i;
+
+        page.jobs = jobs;
+        ids[0] = '\0';
+        if (search->limit > 16 || !search_jobs(chain, search, &page))
+                return (-1);
+        for (i = 0; i < page.count; i++)
+                sprintf(ids + strlen(ids), i ? ",%d" : "%d", page.jobs[i]->id);
+        return (page.more);
+}
+
+/**
+ * test_search_pages - Paging, ordering and time filters, with imported
+ *                     listings whose timestamps are out of order
+ */
+static void test_search_pages(void)
+{
+        static const char feed[] =
+                "{\"title\":\"Cook\",\"company\":\"Acme\",\"location\":\"Kigali\",\"description\":\"a\",\"timestamp\":50}\n"
+                "{\"title\":\"Driver\",\"company\":\"Globex\",\"location\":\"Lagos\",\"description\":\"b\",\"timestamp\":10}\n"
+                "{\"title\":\"Cook\",\"company\":\"Globex\",\"location\":\"Kigali\",\"description\":\"c\",\"timestamp\":40}\n"
+                "\n"
+                "{\"title\":\"Nurse\",\"company\":\"Acme\",\"location\":\"Lagos\",\"description\":\"d\",\"timestamp\":20}\n"
+                "{\"title\":\"Tutor\",\"company\":\"Acme\",\"location\":\"Kigali\",\"description\":\"e\",\"timestamp\":30}\n"
+                "{\"title\":\"Cook\",\"company\":\"Initech\",\"location\":\"Accra\",\"description\":\"f\",\"timestamp\":90}\n"
+                "{\"company\":\"Acme\",\"timestamp\":15}\n"
+                "{\"title\":\"Guard\",\"company\":\"Acme\",\"location\":\"Accra\",\"description\":\"g\",\"timestamp\":60}\n"
+                "{\"title\":\"Clerk\",\"company\":\"Globex\",\"location\":\"Kigali\",\"description\":\"h\",\"timestamp\":80}\n"
+                "{\"title\":\"Cook\",\"company\":\"Acme\",\"location\":\"Lagos\",\"description\":\"i\",\"timestamp\":70}\n"
+                "{\"title\":\"Porter\",\"company\":\"Initech\",\"location\":\"Kigali\",\"description\":\"j\",\"timestamp\":0}\n";
+        static const char csv[] = "title,company,location,description,timestamp\n"
+                                  "Welder,Acme,Kigali,\"Joins, cuts\",55\n";
+        JobBlockchain *chain = initialize_blockchain();
+        ImportStats stats;
+        JobSearch search;
+        char ids[128];
+        FILE *input;
+
+        CHECK(chain != NULL);
+        if (chain == NULL)
+                return;
+
+        /* The listing without a title is skipped; IDs 1-10 follow the feed */
+        input = fmemopen((void *)feed, sizeof(feed) - 1, "r");
+        CHECK(input != NULL && import_jobs(chain, input, IMPORT_JSONL, &stats));
+        if (input != NULL)
+                fclose(input);
+        CHECK(stats.imported == 10 && stats.skipped == 1);
+        CHECK(get_job(chain, 10)->timestamp == 0);
+
+        /* ID order pages through every listing */
+        job_search_init(&search);
+        search.limit = 4;
+        CHECK(page_ids(chain, &search, ids) == 1 && strcmp(ids, "1,2,3,4") == 0);
+        search.offset = 8;
+        CHECK(page_ids(chain, &search, ids) == 0 && strcmp(ids, "9,10") == 0);
+        search.offset = 12;
+        CHECK(page_ids(chain, &search, ids) == 0 && strcmp(ids, "") == 0);
+
+        /* Newest first within [20, 80): 70, 60, 50, 40, 30, 20 */
+        search.order = JOB_ORDER_NEWEST;
+        search.from = 20;
+        search.to = 80;
+        search.offset = 0;
+        CHECK(page_ids(chain, &search, ids) == 1 && strcmp(ids, "9,7,1,3") == 0);
+        search.offset = 4;
+        CHECK(page_ids(chain, &search, ids) == 0 && strcmp(ids, "5,4") == 0);
+
+        /* Oldest first, everything, then narrowed by company and word */
+        search.order = JOB_ORDER_OLDEST;
+        search.from = INT64_MIN;
+        search.to = INT64_MAX;
+        search.offset = 0;
+        search.limit = 3;
+        CHECK(page_ids(chain, &search, ids) == 1 && strcmp(ids, "10,2,4") == 0);
+        search.company = "Acme";
+        CHECK(page_ids(chain, &search, ids) == 1 && strcmp(ids, "4,5,1") == 0);
+        search.query = "cook";
+        search.limit = 8;
+        CHECK(page_ids(chain, &search, ids) == 0 && strcmp(ids, "1,9") == 0);
+        search.company = NULL;
+        search.order = JOB_ORDER_NEWEST;
+        search.from = 41;
+        CHECK(page_ids(chain, &search, ids) == 0 && strcmp(ids, "6,9,1") == 0);
+
+        /* A CSV header row is recognised; quoted fields keep their commas */
+        input = fmemopen((void *)csv, sizeof(csv) - 1, "r");
+        CHECK(input != NULL && import_jobs(chain, input, IMPORT_CSV, &stats));
+        if (input != NULL)
+                fclose(input);
+        CHECK(stats.imported == 1 && stats.skipped == 0);
+        CHECK(strcmp(get_job(chain, 11)->description, "Joins, cuts") == 0);
+        job_search_init(&search);
+        search.order = JOB_ORDER_NEWEST;
+        search.from = 50;
+        search.to = 60;
+        search.limit = 4;
+        CHECK(page_ids(chain, &search, ids) == 0 && strcmp(ids, "11,1") == 0);
+        CHECK(verify_quietly(chain, VERIFY_TEXT, NULL, 0) == 1);
+
+        free_blockchain(chain);
+}
+
+/**
+ * test_malformed_json_skipped - Records that are not valid JSON are
+ *                               skipped; valid escapes are decoded
+ */
+static void test_malformed_json_skipped(void)
+{
+        static const char feed[] =
+                "{\"title\":\"Trailing\",}\n"
+                "{\"title\":\"Trailing\", \"company\":\"Acme\" , }\n"
+                "{\"title\":\"High \\uD83D alone\"}\n"
+                "{\"title\":\"Low \\uDE00 alone\"}\n"
+                "{\"title\":\"Reversed \\uDE00\\uD83D\"}\n"
+                "{\"title\":\"Dropped\",\"note\":\"\\uD800\"}\n"
+                "{,\"title\":\"Leading\"}\n"
+                "{}\n"
+                "{\"title\":\"Smile \\uD83D\\uDE00 caf\\u00e9\",\"company\":\"Acme\"}\n";
+        JobBlockchain *chain = initialize_blockchain();
+        ImportStats stats;
+        FILE *input;
+
+        CHECK(chain != NULL);
+        if (chain == NULL)
+                return;
+        input = fmemopen((void *)feed, sizeof(feed) - 1, "r");
+        CHECK(input != NULL && import_jobs(chain, input, IMPORT_JSONL, &stats));
+        if (input != NULL)
+                fclose(input);
+        CHECK(stats.imported == 1 && stats.skipped == 8);
+        CHECK(chain->count == 1);
+        if (chain->count == 1)
+                CHECK(strcmp(get_job(chain, 1)->title, "Smile \xF0\x9F\x98\x80 caf\xC3\xA9") == 0);
+        free_blockchain(chain);
+}
+
+/**
+ * reference_match - Case-insensitive substring search, one byte at a time
+ * @needle: Text to find
+ * @text: Text ending at its first NUL or after @size bytes
+ * @size: Bytes of @text that may be read
+ * Return: First match, or NULL
+ */
+static const char *reference_match(const char *needle, const char *text, size_t size)
+{
+        size_t length = strnlen(text, size), n = strlen(needle), i;
+
+        for (i = 0; n <= length && i <= length - n; i++)
+        {
+                if (strncasecmp(text + i, needle, n) == 0)
+                        return (text + i);
+        }
+        return (NULL);
+}
+
+/**
+ * test_matcher_agrees - Every kernel matches like the reference, on texts
+ *                       and needles that cross vector boundaries
+ */
+static void test_matcher_agrees(void)
+{
+        /* '@' and '`' differ only in bit 0x20, like a letter's two cases */
+        static const char alphabet[] = "aAbB@`-";
+        JobMatchKernel kernel, best = job_match_best_kernel();
+        JobMatcher matcher;
+        char needle[48], *text;
+        size_t size, length, n, start;
+        unsigned int seed = 1;
+        int round, mismatches = 0;
+
+        for (round = 0; round < 4000; round++)
+        {
+                size = 1 + (size_t)(rand_r(&seed) % 100);
+                length = (size_t)(rand_r(&seed) % (size + 1));
+                n = (size_t)(rand_r(&seed) % (round % 4 ? 4 : 40));
+
+                /* Text of exactly @size bytes, NUL-terminated only if shorter */
+                text = malloc(size);
+                if (text == NULL)
+                        break;
+                memset(text, 0, size);
+                for (start = 0; start < length; start++)
+                        text[start] = alphabet[rand_r(&seed) % 7];
+                for (start = 0; start < n; start++)
+                        needle[start] = alphabet[rand_r(&seed) % 7];
+                needle[n] = '\0';
+
+                /* Half the needles are lifted from the text itself */
+                if (round % 2 && n <= length)
+                {
+                        start = (size_t)(rand_r(&seed) % (length - n + 1));
+                        memcpy(needle, text + start, n);
+                }
+
+                job_matcher_init(&matcher, needle);
+                for (kernel = JOB_MATCH_SCALAR; kernel <= best; kernel++)
+                {
+                        matcher.kernel = kernel;
+                        if (job_match(&matcher, text, size) != reference_match(needle, text, size))
+                                mismatches++;
+                }
+                free(text);
+        }
+        CHECK(mismatches == 0);
+
+        /* A needle longer than the text never matches */
+        job_matcher_init(&matcher, "engineer");
+        CHECK(job_match(&matcher, "engine", 6) == NULL);
+        CHECK(job_match(&matcher, "Senior ENGINEER", 16) != NULL);
+}
+
+/**
+ * main - Run every test
+ * Return: Number of tests that failed
+ */
+int main(void)
+{
+        static const struct
+        {
+                const char *name;
+                void (*run)(void);
+        } tests[] = {
+                {"store_reopens", test_store_reopens},
+                {"tampering_detected", test_tampering_detected},
+                {"search_pages", test_search_pages},
+                {"malformed_json_skipped", test_malformed_json_skipped},
+                {"matcher_agrees", test_matcher_agrees},
+        };
+        size_t i;
+        int failed, failed_tests = 0;
+
+        for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+        {
+                failed = failed_checks;
+                tests[i].run();
+                printf("%s: %s\n", tests[i].name, failed_checks == failed ? "PASS" : "FAIL");
+                failed_tests += failed_checks != failed;
+        }
+        printf("%d test(s), %d failed\n", (int)i, failed_tests);
+        return (failed_tests);
+}